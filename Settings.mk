@@ -22,7 +22,7 @@ CUDA_LIBS?=-lcudnn -lcurand -lcusparse -lcublas -lcudart
 NETCDF_LIBS?=-lnetcdf
 MATIO_LIBS?=-lmatio
 
-CPP_HW_ARCHITECTURE?=-march=native # set this to -march=corei7 if you see AVX related errors
+CPP_HW_ARCHITECTURE?=-mtune=generic # plain backend picks SSE2/AVX2/AVX-512 kernels at run time, set this to -march=native for a build tuned to the local machine only
 CPP_FLAGS_COMMON?=-ffast-math $(CPP_HW_ARCHITECTURE) -mfpmath=sse -msse2 # -mavx
 CPP_FLAGS_DEBUG_MODE?=-g
 CPP_FLAGS_RELEASE_MODE?=-O3
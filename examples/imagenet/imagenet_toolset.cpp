@@ -21,6 +21,8 @@
 #include <boost/algorithm/string.hpp>
 #include <regex>
 #include <iostream>
+#include <thread>
+#include <exception>
 
 #include <nnforge/rnd.h>
 
@@ -98,48 +100,25 @@ void imagenet_toolset::prepare_true_randomized_training_data()
 	unsigned int total_training_image_count = static_cast<unsigned int>(ilsvrc2014id_localid_pair_list.size());
 	std::cout << "Training images found: " << total_training_image_count << std::endl;
 
+	// Randomize the order of entries once, so that the dataset could be read sequentially
 	nnforge::random_generator gen = nnforge::rnd::get_random_generator();
-
-	nnforge::varying_data_stream_writer::ptr training_images_data_writer;
+	for(unsigned int i = total_training_image_count; i > 1; --i)
 	{
-		boost::filesystem::path training_images_file_path = get_working_data_folder() / "training_images.dt";
-		std::cout << "Writing randomized training data (images) to " << training_images_file_path.string() << "..." << std::endl;
-		std::shared_ptr<std::ofstream> training_images_file_stream(new boost::filesystem::ofstream(training_images_file_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc));
-		training_images_data_writer = nnforge::varying_data_stream_writer::ptr(new nnforge::varying_data_stream_writer(training_images_file_stream));
+		std::uniform_int_distribution<unsigned int> dist(0, i - 1);
+		std::swap(ilsvrc2014id_localid_pair_list[i - 1], ilsvrc2014id_localid_pair_list[dist(gen)]);
 	}
 
-	nnforge::structured_data_writer::ptr training_labels_data_writer;
+	std::vector<std::pair<boost::filesystem::path, unsigned int> > image_file_path_class_id_list;
+	for(std::vector<std::pair<std::string, unsigned int> >::const_iterator it = ilsvrc2014id_localid_pair_list.begin(); it != ilsvrc2014id_localid_pair_list.end(); ++it)
 	{
-		boost::filesystem::path training_labels_file_path = get_working_data_folder() / "training_labels.dt";
-		std::cout << "Writing randomized training data (labels) to " << training_labels_file_path.string() << "..." << std::endl;
-		std::shared_ptr<std::ofstream> training_labels_file_stream(new boost::filesystem::ofstream(training_labels_file_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc));
-		nnforge::layer_configuration_specific config(class_count, std::vector<unsigned int>(2, 1));
-		training_labels_data_writer = nnforge::structured_data_writer::ptr(new nnforge::structured_data_stream_writer(training_labels_file_stream, config));
+		std::string filename = (boost::format("%1%_%2%.JPEG") % it->first % it->second).str();
+		boost::filesystem::path image_file_path = training_images_folder_path / it->first / filename;
+		unsigned int class_id = get_classid_by_wnid(get_wnid_by_ilsvrc2014id(it->first));
+		image_file_path_class_id_list.push_back(std::make_pair(image_file_path, class_id));
 	}
 
-	for(unsigned int entry_written_count = 0; entry_written_count < total_training_image_count; ++entry_written_count)
-	{
-		std::uniform_int_distribution<unsigned int> dist(0, static_cast<unsigned int>(ilsvrc2014id_localid_pair_list.size()) - 1);
-		unsigned int index = dist(gen);
-
-		std::pair<std::string, unsigned int> ilsvrc2014id_localid_pair = ilsvrc2014id_localid_pair_list[index];
-		ilsvrc2014id_localid_pair_list[index] = ilsvrc2014id_localid_pair_list[ilsvrc2014id_localid_pair_list.size() - 1];
-		ilsvrc2014id_localid_pair_list.pop_back();
-
-		std::string filename = (boost::format("%1%_%2%.JPEG") % ilsvrc2014id_localid_pair.first % ilsvrc2014id_localid_pair.second).str();
-		boost::filesystem::path image_file_path = training_images_folder_path / ilsvrc2014id_localid_pair.first / filename;
-		int class_id = get_classid_by_wnid(get_wnid_by_ilsvrc2014id(ilsvrc2014id_localid_pair.first));
-
-		write_supervised_data(
-			image_file_path,
-			*training_images_data_writer,
-			class_id,
-			*training_labels_data_writer);
-
-		if (((entry_written_count + 1) % 50000) == 0)
-			std::cout << (entry_written_count + 1) << " entries written" << std::endl;
-	}
-	std::cout << total_training_image_count << " entries written" << std::endl;
+	std::cout << "Writing randomized training data..." << std::endl;
+	write_supervised_dataset("training", image_file_path_class_id_list);
 }
 
 void imagenet_toolset::prepare_validating_data()
@@ -165,37 +144,84 @@ void imagenet_toolset::prepare_validating_data()
 	}
 	std::cout << classid_list.size() << " labels read\n";
 
-	nnforge::varying_data_stream_writer::ptr validating_images_data_writer;
+	std::vector<std::pair<boost::filesystem::path, unsigned int> > image_file_path_class_id_list;
+	boost::filesystem::path validating_images_folder_path = get_input_data_folder() / validating_images_folder_name;
+	for(int i = 0; i < classid_list.size(); ++i)
 	{
-		boost::filesystem::path validating_images_file_path = get_working_data_folder() / "validating_images.dt";
-		std::cout << "Writing validating data (images) to " << validating_images_file_path.string() << "..." << std::endl;
-		std::shared_ptr<std::ofstream> validating_images_file_stream(new boost::filesystem::ofstream(validating_images_file_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc));
-		validating_images_data_writer = nnforge::varying_data_stream_writer::ptr(new nnforge::varying_data_stream_writer(validating_images_file_stream));
+		unsigned int class_id = classid_list[i];
+		unsigned int image_id = i + 1;
+		boost::filesystem::path image_file_path = validating_images_folder_path / (boost::format("ILSVRC2012_val_%|1$08d|.JPEG") % image_id).str();
+		image_file_path_class_id_list.push_back(std::make_pair(image_file_path, class_id));
 	}
 
-	nnforge::structured_data_writer::ptr validating_labels_data_writer;
+	std::cout << "Writing validating data..." << std::endl;
+	write_supervised_dataset("validating", image_file_path_class_id_list);
+}
+
+void imagenet_toolset::write_supervised_dataset(
+	const std::string& dataset_name,
+	const std::vector<std::pair<boost::filesystem::path, unsigned int> >& image_file_path_class_id_list)
+{
+	unsigned int entry_count = static_cast<unsigned int>(image_file_path_class_id_list.size());
+	unsigned int shard_count = std::max(std::min(static_cast<unsigned int>(std::max(prepare_shard_count, 1)), entry_count), 1U);
+
+	// Shard i gets contiguous range of entries, shards are written in parallel
+	std::vector<unsigned int> shard_entry_count_list(shard_count);
+	std::vector<unsigned int> first_entry_id_list(shard_count);
+	for(unsigned int shard_id = 0; shard_id < shard_count; ++shard_id)
 	{
-		boost::filesystem::path validating_labels_file_path = get_working_data_folder() / "validating_labels.dt";
-		std::cout << "Writing validating data (labels) to " << validating_labels_file_path.string() << "..." << std::endl;
-		std::shared_ptr<std::ofstream> validating_labels_file_stream(new boost::filesystem::ofstream(validating_labels_file_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc));
-		nnforge::layer_configuration_specific config(class_count, std::vector<unsigned int>(2, 1));
-		validating_labels_data_writer = nnforge::structured_data_writer::ptr(new nnforge::structured_data_stream_writer(validating_labels_file_stream, config));
+		shard_entry_count_list[shard_id] = entry_count / shard_count + ((shard_id < entry_count % shard_count) ? 1 : 0);
+		first_entry_id_list[shard_id] = (shard_id > 0) ? first_entry_id_list[shard_id - 1] + shard_entry_count_list[shard_id - 1] : 0;
 	}
 
-	boost::filesystem::path validating_images_folder_path = get_input_data_folder() / validating_images_folder_name;
-	for(int i = 0; i < classid_list.size(); ++i)
+	std::vector<std::exception_ptr> error_list(shard_count);
+	std::vector<std::thread> thread_list;
+	for(unsigned int shard_id = 0; shard_id < shard_count; ++shard_id)
 	{
-		unsigned int class_id = classid_list[i];
-		unsigned int image_id = i + 1;
-		boost::filesystem::path image_file_path = validating_images_folder_path / (boost::format("ILSVRC2012_val_%|1$08d|.JPEG") % image_id).str();
+		thread_list.push_back(std::thread([&, shard_id] ()
+		{
+			try
+			{
+				std::string shard_dataset_name = (shard_count > 1) ? get_shard_dataset_name(dataset_name, shard_id) : dataset_name;
+
+				boost::filesystem::path images_file_path = get_working_data_folder() / (shard_dataset_name + "_images.dt");
+				std::shared_ptr<std::ofstream> images_file_stream(new boost::filesystem::ofstream(images_file_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc));
+				nnforge::varying_data_stream_writer images_data_writer(images_file_stream);
+
+				boost::filesystem::path labels_file_path = get_working_data_folder() / (shard_dataset_name + "_labels.dt");
+				std::shared_ptr<std::ofstream> labels_file_stream(new boost::filesystem::ofstream(labels_file_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc));
+				nnforge::layer_configuration_specific config(class_count, std::vector<unsigned int>(2, 1));
+				nnforge::structured_data_stream_writer labels_data_writer(labels_file_stream, config);
 
-		write_supervised_data(
-			image_file_path,
-			*validating_images_data_writer,
-			class_id,
-			*validating_labels_data_writer);
+				for(unsigned int entry_id = first_entry_id_list[shard_id]; entry_id < first_entry_id_list[shard_id] + shard_entry_count_list[shard_id]; ++entry_id)
+				{
+					write_supervised_data(
+						image_file_path_class_id_list[entry_id].first,
+						images_data_writer,
+						image_file_path_class_id_list[entry_id].second,
+						labels_data_writer);
+				}
+
+				std::cout << (boost::format("%1% entries written to %2% and %3%\n") % shard_entry_count_list[shard_id] % images_file_path.string() % labels_file_path.string()).str() << std::flush;
+			}
+			catch (...)
+			{
+				error_list[shard_id] = std::current_exception();
+			}
+		}));
 	}
-	std::cout << classid_list.size() << " entries written" << std::endl;
+	for(std::vector<std::thread>::iterator it = thread_list.begin(); it != thread_list.end(); ++it)
+		it->join();
+	for(std::vector<std::exception_ptr>::const_iterator it = error_list.begin(); it != error_list.end(); ++it)
+		if (*it)
+			std::rethrow_exception(*it);
+
+	// The index is written last, stale one is removed when writing the single file dataset
+	if (shard_count > 1)
+		write_sharded_dataset_index(dataset_name, shard_entry_count_list);
+	else
+		boost::filesystem::remove(get_sharded_dataset_index_file_path(dataset_name));
+	std::cout << entry_count << " entries written" << std::endl;
 }
 
 void imagenet_toolset::write_supervised_data(
@@ -335,11 +361,16 @@ nnforge::structured_data_reader::ptr imagenet_toolset::get_structured_reader(
 	const std::string& dataset_name,
 	const std::string& layer_name,
 	dataset_usage usage,
+	const boost::filesystem::path& file_path,
 	std::shared_ptr<std::istream> in) const
 {
 	if (layer_name == "images")
 	{
-		nnforge::raw_data_reader::ptr raw_reader(new nnforge::varying_data_stream_reader(in));
+		nnforge::raw_data_reader::ptr raw_reader;
+		if (map_data_files)
+			raw_reader = nnforge::raw_data_reader::ptr(new nnforge::varying_data_mapped_reader(file_path));
+		else
+			raw_reader = nnforge::raw_data_reader::ptr(new nnforge::varying_data_stream_reader(in));
 		nnforge::raw_to_structured_data_transformer::ptr transformer;
 		if (dataset_name == "training")
 		{
@@ -398,10 +429,10 @@ nnforge::structured_data_reader::ptr imagenet_toolset::get_structured_reader(
 				training_target_image_height,
 				position_list));
 		}
-		return nnforge::structured_data_reader::ptr(new nnforge::structured_from_raw_data_reader(raw_reader, transformer));
+		return nnforge::structured_data_reader::ptr(new nnforge::structured_from_raw_data_reader(raw_reader, transformer, static_cast<unsigned int>(data_transformer_seed)));
 	}
 	else
-		return toolset::get_structured_reader(dataset_name, layer_name, usage, in);
+		return toolset::get_structured_reader(dataset_name, layer_name, usage, file_path, in);
 }
 
 std::vector<nnforge::data_transformer::ptr> imagenet_toolset::get_data_transformer_list(
@@ -40,6 +40,7 @@ protected:
 		const std::string& dataset_name,
 		const std::string& layer_name,
 		dataset_usage usage,
+		const boost::filesystem::path& file_path,
 		std::shared_ptr<std::istream> in) const;
 
 	virtual std::vector<nnforge::bool_option> get_bool_options();
@@ -62,6 +63,11 @@ private:
 
 	void prepare_validating_data();
 
+	// Writes images and labels of the dataset in the order specified, split into prepare_shard_count shards written in parallel
+	void write_supervised_dataset(
+		const std::string& dataset_name,
+		const std::vector<std::pair<boost::filesystem::path, unsigned int> >& image_file_path_class_id_list);
+
 	unsigned int get_wnid_by_ilsvrc2014id(const std::string& ilsvrc2014id);
 
 	unsigned int get_classid_by_wnid(unsigned int wnid) const;
@@ -33,7 +33,6 @@ training_imagenet_raw_to_structured_data_transformer::training_imagenet_raw_to_s
 	float max_elastic_deformation_smoothness)
 	: target_image_width(target_image_width)
 	, target_image_height(target_image_height)
-	, gen(nnforge::rnd::get_random_generator())
 	, dist_relative_target_area(min_relative_target_area, max_relative_target_area)
 	, dist_log_aspect_ratio(-logf(max_aspect_ratio_change), logf(max_aspect_ratio_change))
 	, dist_alpha(min_elastic_deformation_intensity * static_cast<float>(std::min(target_image_width, target_image_height)), max_elastic_deformation_intensity * static_cast<float>(std::min(target_image_width, target_image_height)))
@@ -51,7 +50,20 @@ void training_imagenet_raw_to_structured_data_transformer::transform(
 	const std::vector<unsigned char>& raw_data,
 	float * structured_data)
 {
-	cv::Mat3b original_image = cv::imdecode(raw_data, CV_LOAD_IMAGE_COLOR);
+	nnforge::counter_random_generator gen = nnforge::rnd::get_counter_random_generator();
+	transform(sample_id, &raw_data[0], raw_data.size(), structured_data, gen);
+}
+
+void training_imagenet_raw_to_structured_data_transformer::transform(
+	unsigned int sample_id,
+	const unsigned char * raw_data,
+	size_t raw_data_length,
+	float * structured_data,
+	nnforge::counter_random_generator& gen)
+{
+	// Decode straight from the reader's memory, no copy is made
+	cv::Mat1b encoded_image(1, static_cast<int>(raw_data_length), const_cast<unsigned char *>(raw_data));
+	cv::Mat3b original_image = cv::imdecode(encoded_image, CV_LOAD_IMAGE_COLOR);
 
 	// Defaults to center crop
 	unsigned int source_crop_image_width = std::min(original_image.rows, original_image.cols);
@@ -62,44 +74,41 @@ void training_imagenet_raw_to_structured_data_transformer::transform(
 	float alpha;
 	float sigma;
 	int ksize;
-	{
-		std::lock_guard<std::mutex> lock(gen_mutex);
 
-		alpha = dist_alpha.min();
-		if (dist_alpha.max() > dist_alpha.min())
-			alpha = dist_alpha(gen);
-		sigma = dist_sigma.min();
-		if (dist_sigma.max() > dist_sigma.min())
-			sigma = dist_sigma(gen);
-		ksize = static_cast<int>((sigma - 0.8F) * 3.0F + 1.0F) * 2 + 1;
+	alpha = dist_alpha.min();
+	if (dist_alpha.max() > dist_alpha.min())
+		alpha = dist_alpha(gen);
+	sigma = dist_sigma.min();
+	if (dist_sigma.max() > dist_sigma.min())
+		sigma = dist_sigma(gen);
+	ksize = static_cast<int>((sigma - 0.8F) * 3.0F + 1.0F) * 2 + 1;
 
-		for(int attempt = 0; attempt < 100; ++attempt)
-		{
-			float local_area = static_cast<float>(original_image.rows * original_image.cols);
-			float relative_target_area = dist_relative_target_area.min();
-			if (dist_relative_target_area.max() > dist_relative_target_area.min())
-				relative_target_area = dist_relative_target_area(gen);
-			float target_area = local_area * relative_target_area;
-			float aspect_ratio = expf(dist_log_aspect_ratio(gen));
+	for(int attempt = 0; attempt < 100; ++attempt)
+	{
+		float local_area = static_cast<float>(original_image.rows * original_image.cols);
+		float relative_target_area = dist_relative_target_area.min();
+		if (dist_relative_target_area.max() > dist_relative_target_area.min())
+			relative_target_area = dist_relative_target_area(gen);
+		float target_area = local_area * relative_target_area;
+		float aspect_ratio = expf(dist_log_aspect_ratio(gen));
 
-			unsigned int new_source_crop_image_width = std::max(static_cast<unsigned int>(sqrtf(target_area * aspect_ratio) + 0.5F), 1U);
-			unsigned int new_source_crop_image_height = std::max(static_cast<unsigned int>(sqrtf(target_area / aspect_ratio) + 0.5F), 1U);
+		unsigned int new_source_crop_image_width = std::max(static_cast<unsigned int>(sqrtf(target_area * aspect_ratio) + 0.5F), 1U);
+		unsigned int new_source_crop_image_height = std::max(static_cast<unsigned int>(sqrtf(target_area / aspect_ratio) + 0.5F), 1U);
 
-			if ((new_source_crop_image_width < static_cast<unsigned int>(original_image.cols)) && (new_source_crop_image_height < static_cast<unsigned int>(original_image.rows)))
-			{
-				source_crop_image_width = new_source_crop_image_width;
-				source_crop_image_height = new_source_crop_image_height;
-				std::uniform_int_distribution<unsigned int> x_dist(0, original_image.cols - source_crop_image_width);
-				std::uniform_int_distribution<unsigned int> y_dist(0, original_image.rows - source_crop_image_height);
-				x = x_dist.min();
-				if (x_dist.max() > x_dist.min())
-					x = x_dist(gen);
-				y = y_dist.min();
-				if (y_dist.max() > y_dist.min())
-					y = y_dist(gen);
-
-				break;
-			}
+		if ((new_source_crop_image_width < static_cast<unsigned int>(original_image.cols)) && (new_source_crop_image_height < static_cast<unsigned int>(original_image.rows)))
+		{
+			source_crop_image_width = new_source_crop_image_width;
+			source_crop_image_height = new_source_crop_image_height;
+			std::uniform_int_distribution<unsigned int> x_dist(0, original_image.cols - source_crop_image_width);
+			std::uniform_int_distribution<unsigned int> y_dist(0, original_image.rows - source_crop_image_height);
+			x = x_dist.min();
+			if (x_dist.max() > x_dist.min())
+				x = x_dist(gen);
+			y = y_dist.min();
+			if (y_dist.max() > y_dist.min())
+				y = y_dist(gen);
+
+			break;
 		}
 	}
 
@@ -108,22 +117,19 @@ void training_imagenet_raw_to_structured_data_transformer::transform(
 	{
 		cv::Mat1f x_disp(target_image_height, target_image_width);
 		cv::Mat1f y_disp(target_image_height, target_image_width);
-		{
-			std::lock_guard<std::mutex> lock(gen_mutex);
 
-			for(int row_id = 0; row_id < x_disp.rows; ++row_id)
-			{
-				float * row_ptr = x_disp.ptr<float>(row_id);
-				for(int column_id = 0; column_id < x_disp.cols; ++column_id)
-					row_ptr[column_id] = displacement_distribution(gen);
-			}
+		for(int row_id = 0; row_id < x_disp.rows; ++row_id)
+		{
+			float * row_ptr = x_disp.ptr<float>(row_id);
+			for(int column_id = 0; column_id < x_disp.cols; ++column_id)
+				row_ptr[column_id] = displacement_distribution(gen);
+		}
 
-			for(int row_id = 0; row_id < y_disp.rows; ++row_id)
-			{
-				float * row_ptr = y_disp.ptr<float>(row_id);
-				for(int column_id = 0; column_id < y_disp.cols; ++column_id)
-					row_ptr[column_id] = displacement_distribution(gen);
-			}
+		for(int row_id = 0; row_id < y_disp.rows; ++row_id)
+		{
+			float * row_ptr = y_disp.ptr<float>(row_id);
+			for(int column_id = 0; column_id < y_disp.cols; ++column_id)
+				row_ptr[column_id] = displacement_distribution(gen);
 		}
 
 		{
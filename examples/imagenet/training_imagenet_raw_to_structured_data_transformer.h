@@ -19,8 +19,6 @@
 #include <nnforge/raw_to_structured_data_transformer.h>
 #include <nnforge/rnd.h>
 
-#include <mutex>
-
 class training_imagenet_raw_to_structured_data_transformer : public nnforge::raw_to_structured_data_transformer
 {
 public:
@@ -42,14 +40,19 @@ public:
 		const std::vector<unsigned char>& raw_data,
 		float * structured_data);
 
+	virtual void transform(
+		unsigned int sample_id,
+		const unsigned char * raw_data,
+		size_t raw_data_length,
+		float * structured_data,
+		nnforge::counter_random_generator& gen);
+
 	virtual nnforge::layer_configuration_specific get_configuration() const;
 
 protected:
 	unsigned int target_image_width;
 	unsigned int target_image_height;
 
-	std::mutex gen_mutex;
-	nnforge::random_generator gen;
 	std::uniform_real_distribution<float> dist_relative_target_area;
 	std::uniform_real_distribution<float> dist_log_aspect_ratio;
 	std::uniform_real_distribution<float> displacement_distribution;
@@ -40,7 +40,20 @@ void validating_imagenet_raw_to_structured_data_transformer::transform(
 	const std::vector<unsigned char>& raw_data,
 	float * structured_data)
 {
-	cv::Mat3b original_image = cv::imdecode(raw_data, CV_LOAD_IMAGE_COLOR);
+	nnforge::counter_random_generator gen = nnforge::counter_random_generator(0);
+	transform(sample_id, &raw_data[0], raw_data.size(), structured_data, gen);
+}
+
+void validating_imagenet_raw_to_structured_data_transformer::transform(
+	unsigned int sample_id,
+	const unsigned char * raw_data,
+	size_t raw_data_length,
+	float * structured_data,
+	nnforge::counter_random_generator& gen)
+{
+	// Decode straight from the reader's memory, no copy is made
+	cv::Mat1b encoded_image(1, static_cast<int>(raw_data_length), const_cast<unsigned char *>(raw_data));
+	cv::Mat3b original_image = cv::imdecode(encoded_image, CV_LOAD_IMAGE_COLOR);
 
 	float scale = static_cast<float>(std::min(original_image.rows, original_image.cols)) / image_size;
 
@@ -34,6 +34,13 @@ public:
 		const std::vector<unsigned char>& raw_data,
 		float * structured_data);
 
+	virtual void transform(
+		unsigned int sample_id,
+		const unsigned char * raw_data,
+		size_t raw_data_length,
+		float * structured_data,
+		nnforge::counter_random_generator& gen);
+
 	virtual nnforge::layer_configuration_specific get_configuration() const;
 
 	virtual unsigned int get_sample_count() const;
@@ -0,0 +1,163 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "average_data_bunch_writer.h"
+
+#include <cstring>
+
+namespace nnforge
+{
+	const unsigned int average_data_bunch_writer::entry_count_per_block = 16;
+
+	average_data_bunch_writer::average_data_bunch_writer()
+		: next_block_id(0)
+	{
+		total_sum.entry_count = 0;
+	}
+
+	void average_data_bunch_writer::set_config_map(const std::map<std::string, layer_configuration_specific> config_map)
+	{
+		std::lock_guard<std::mutex> lock(block_mutex);
+
+		this->config_map = config_map;
+		block_id_to_pending_block_map.clear();
+		block_id_to_sum_map.clear();
+		total_sum.layer_name_to_sum_map.clear();
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+			total_sum.layer_name_to_sum_map.insert(std::make_pair(it->first, std::vector<double>(it->second.get_neuron_count(), 0.0)));
+		total_sum.entry_count = 0;
+		next_block_id = 0;
+	}
+
+	std::shared_ptr<average_data_bunch_writer::pending_block> average_data_bunch_writer::get_pending_block(unsigned int block_id)
+	{
+		std::lock_guard<std::mutex> lock(block_mutex);
+
+		std::shared_ptr<pending_block>& res = block_id_to_pending_block_map[block_id];
+		if (!res)
+		{
+			res = std::shared_ptr<pending_block>(new pending_block());
+			for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+				res->layer_name_to_data_map.insert(std::make_pair(it->first, std::vector<float>(it->second.get_neuron_count() * entry_count_per_block)));
+			res->entry_written_list.resize(entry_count_per_block, 0);
+			res->written_entry_count = 0;
+		}
+
+		return res;
+	}
+
+	void average_data_bunch_writer::write(
+		unsigned int entry_id,
+		const std::map<std::string, const float *>& data_map)
+	{
+		unsigned int block_id = entry_id / entry_count_per_block;
+		unsigned int entry_id_within_block = entry_id - block_id * entry_count_per_block;
+		std::shared_ptr<pending_block> block = get_pending_block(block_id);
+
+		// Each entry is written by a single thread, so the threads write to the disjoint parts of the block
+		for(std::map<std::string, const float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+		{
+			std::vector<float>& layer_data = block->layer_name_to_data_map.find(it->first)->second;
+			size_t neuron_count = layer_data.size() / entry_count_per_block;
+			memcpy(&layer_data[entry_id_within_block * neuron_count], it->second, neuron_count * sizeof(float));
+		}
+		block->entry_written_list[entry_id_within_block] = 1;
+
+		// The thread writing the last entry of the block sums it, the atomic increment makes the other entries visible to it
+		if (++block->written_entry_count < entry_count_per_block)
+			return;
+
+		block_sum sum = get_block_sum(*block);
+
+		std::lock_guard<std::mutex> lock(block_mutex);
+
+		block_id_to_pending_block_map.erase(block_id);
+		block_id_to_sum_map.insert(std::make_pair(block_id, sum));
+		while (true)
+		{
+			std::map<unsigned int, block_sum>::iterator it = block_id_to_sum_map.find(next_block_id);
+			if (it == block_id_to_sum_map.end())
+				break;
+			add_block_sum(total_sum, it->second);
+			block_id_to_sum_map.erase(it);
+			++next_block_id;
+		}
+	}
+
+	average_data_bunch_writer::block_sum average_data_bunch_writer::get_block_sum(const pending_block& block) const
+	{
+		block_sum res;
+		res.entry_count = 0;
+		for(std::map<std::string, std::vector<float> >::const_iterator it = block.layer_name_to_data_map.begin(); it != block.layer_name_to_data_map.end(); ++it)
+		{
+			size_t neuron_count = it->second.size() / entry_count_per_block;
+			std::vector<double>& layer_sum = res.layer_name_to_sum_map.insert(std::make_pair(it->first, std::vector<double>(neuron_count, 0.0))).first->second;
+			for(unsigned int entry_id_within_block = 0; entry_id_within_block < entry_count_per_block; ++entry_id_within_block)
+			{
+				if (!block.entry_written_list[entry_id_within_block])
+					continue;
+				const float * data = &it->second[entry_id_within_block * neuron_count];
+				for(size_t i = 0; i < neuron_count; ++i)
+					layer_sum[i] += static_cast<double>(data[i]);
+			}
+		}
+		for(std::vector<char>::const_iterator it = block.entry_written_list.begin(); it != block.entry_written_list.end(); ++it)
+			if (*it)
+				++res.entry_count;
+
+		return res;
+	}
+
+	void average_data_bunch_writer::add_block_sum(
+		block_sum& dst,
+		const block_sum& src) const
+	{
+		for(std::map<std::string, std::vector<double> >::iterator it = dst.layer_name_to_sum_map.begin(); it != dst.layer_name_to_sum_map.end(); ++it)
+		{
+			const std::vector<double>& src_sum = src.layer_name_to_sum_map.find(it->first)->second;
+			for(size_t i = 0; i < it->second.size(); ++i)
+				it->second[i] += src_sum[i];
+		}
+		dst.entry_count += src.entry_count;
+	}
+
+	std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > average_data_bunch_writer::get_average_map() const
+	{
+		std::lock_guard<std::mutex> lock(block_mutex);
+
+		// Blocks left are the ones after a gap or not filled entirely, they are added in block order as well
+		std::map<unsigned int, block_sum> block_id_to_remaining_sum_map(block_id_to_sum_map);
+		for(std::map<unsigned int, std::shared_ptr<pending_block> >::const_iterator it = block_id_to_pending_block_map.begin(); it != block_id_to_pending_block_map.end(); ++it)
+			block_id_to_remaining_sum_map.insert(std::make_pair(it->first, get_block_sum(*it->second)));
+		block_sum sum = total_sum;
+		for(std::map<unsigned int, block_sum>::const_iterator it = block_id_to_remaining_sum_map.begin(); it != block_id_to_remaining_sum_map.end(); ++it)
+			add_block_sum(sum, it->second);
+
+		double mult = 1.0 / static_cast<double>(sum.entry_count);
+
+		std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > res;
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+		{
+			std::shared_ptr<std::vector<double> > average(new std::vector<double>(sum.layer_name_to_sum_map.find(it->first)->second));
+			for(std::vector<double>::iterator it2 = average->begin(); it2 != average->end(); ++it2)
+				*it2 *= mult;
+
+			res.insert(std::make_pair(it->first, std::make_pair(it->second, average)));
+		}
+
+		return res;
+	}
+}
@@ -0,0 +1,86 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_bunch_writer.h"
+
+#include <map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+
+namespace nnforge
+{
+	// Keeps running sums of the entries written instead of the entries themselves, so that memory footprint doesn't depend on entry count.
+	// Entries are grouped into blocks of consecutive entry IDs, each block is summed in entry order once all its entries are written,
+	// block sums are added to the running sums in block order. The averages don't depend on the threads writing entries and the order they do it in
+	class average_data_bunch_writer : public structured_data_bunch_writer
+	{
+	public:
+		typedef std::shared_ptr<average_data_bunch_writer> ptr;
+
+		average_data_bunch_writer();
+
+		virtual ~average_data_bunch_writer() = default;
+
+		virtual void set_config_map(const std::map<std::string, layer_configuration_specific> config_map);
+
+		virtual void write(
+			unsigned int entry_id,
+			const std::map<std::string, const float *>& data_map);
+
+		// Element-wise averages across all the entries written, per layer
+		std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > get_average_map() const;
+
+	private:
+		struct pending_block
+		{
+			// Entries of the block, entry_count_per_block * neuron_count elements per layer
+			std::map<std::string, std::vector<float> > layer_name_to_data_map;
+			std::vector<char> entry_written_list;
+			std::atomic<unsigned int> written_entry_count;
+		};
+
+		struct block_sum
+		{
+			std::map<std::string, std::vector<double> > layer_name_to_sum_map;
+			unsigned int entry_count;
+		};
+
+		std::shared_ptr<pending_block> get_pending_block(unsigned int block_id);
+
+		// Sums the entries written in entry order
+		block_sum get_block_sum(const pending_block& block) const;
+
+		void add_block_sum(
+			block_sum& dst,
+			const block_sum& src) const;
+
+	private:
+		std::map<std::string, layer_configuration_specific> config_map;
+		std::map<unsigned int, std::shared_ptr<pending_block> > block_id_to_pending_block_map;
+		// Blocks summed but not added to total_sum yet, as some of the preceding blocks are pending
+		std::map<unsigned int, block_sum> block_id_to_sum_map;
+		// Sums of the blocks [0, next_block_id)
+		block_sum total_sum;
+		unsigned int next_block_id;
+		mutable std::mutex block_mutex;
+
+		static const unsigned int entry_count_per_block;
+	};
+}
@@ -161,9 +161,18 @@ namespace nnforge
 
 	void backward_propagation::update_flops()
 	{
+		std::map<layer_name_with_action, float> flops_per_action = get_flops_per_action();
+		double total_flops = 0.0;
+		for(std::map<layer_name_with_action, float>::const_iterator it = flops_per_action.begin(); it != flops_per_action.end(); ++it)
+			total_flops += static_cast<double>(it->second);
+		flops = static_cast<float>(total_flops);
 		if (profile->is_profile())
-			action_flops_per_entry = action_schema->get_flops_per_action(layer_config_map, cumulative_tiling_factor_map);
-		flops = action_schema->get_flops(layer_config_map, cumulative_tiling_factor_map);
+			action_flops_per_entry = flops_per_action;
+	}
+
+	std::map<layer_name_with_action, float> backward_propagation::get_flops_per_action() const
+	{
+		return action_schema->get_flops_per_action(layer_config_map, cumulative_tiling_factor_map);
 	}
 
 	backward_propagation::stat backward_propagation::run(
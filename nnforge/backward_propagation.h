@@ -102,6 +102,10 @@ namespace nnforge
 
 		virtual float get_max_flops() const;
 
+		// Default impl returns flops reported by layers, multiplied by tiling factors
+		// Backends running layers with algorithms of different complexity override it
+		virtual std::map<layer_name_with_action, float> get_flops_per_action() const;
+
 	protected:
 		network_schema::const_ptr schema;
 		network_action_schema::const_ptr action_schema;
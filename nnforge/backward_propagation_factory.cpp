@@ -18,4 +18,21 @@
 
 namespace nnforge
 {
+	backward_propagation::ptr backward_propagation_factory::create_concurrent(
+		const network_schema& schema,
+		const std::vector<std::string>& output_layer_names,
+		const std::vector<std::string>& error_source_layer_names,
+		const std::vector<std::string>& exclude_data_update_layer_names,
+		debug_state::ptr debug,
+		profile_state::ptr profile,
+		unsigned int concurrent_count) const
+	{
+		return create(
+			schema,
+			output_layer_names,
+			error_source_layer_names,
+			exclude_data_update_layer_names,
+			debug,
+			profile);
+	}
 }
@@ -42,6 +42,17 @@ namespace nnforge
 			debug_state::ptr debug,
 			profile_state::ptr profile) const = 0;
 
+		// Creates one of concurrent_count objects running at the same time, backends split the cores and the memory among them.
+		// The default implementation calls create
+		virtual backward_propagation::ptr create_concurrent(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			const std::vector<std::string>& error_source_layer_names,
+			const std::vector<std::string>& exclude_data_update_layer_names,
+			debug_state::ptr debug,
+			profile_state::ptr profile,
+			unsigned int concurrent_count) const;
+
 	protected:
 		backward_propagation_factory() = default;
 	};
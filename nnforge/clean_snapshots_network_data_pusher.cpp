@@ -27,9 +27,11 @@ namespace nnforge
 	
 	clean_snapshots_network_data_pusher::clean_snapshots_network_data_pusher(
 		const boost::filesystem::path& folder_path,
-		unsigned int keep_frequency)
+		unsigned int keep_frequency,
+		network_data_async_writer::ptr writer)
 		: folder_path(folder_path)
 		, keep_frequency(keep_frequency)
+		, writer(writer)
 	{
 	}
 
@@ -44,7 +46,9 @@ namespace nnforge
 			unsigned int current_index = task_state.index_peeked;
 			std::string snapshot_folder_name = (boost::format("ann_trained_%|1$03d|_epoch_%|2$05d|") % current_index % previous_epoch).str();
 			boost::filesystem::path folder_path_to_clean = folder_path / snapshot_folder_name;
-			if (boost::filesystem::exists(folder_path_to_clean))
+			if (writer)
+				writer->remove(folder_path_to_clean);
+			else if (boost::filesystem::exists(folder_path_to_clean))
 				boost::filesystem::remove_all(folder_path_to_clean);
 		}
 	}
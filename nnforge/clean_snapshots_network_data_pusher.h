@@ -17,6 +17,7 @@
 #pragma once
 
 #include "network_data_pusher.h"
+#include "network_data_async_writer.h"
 
 #include <boost/filesystem.hpp>
 
@@ -27,7 +28,8 @@ namespace nnforge
 	public:
 		clean_snapshots_network_data_pusher(
 			const boost::filesystem::path& folder_path,
-			unsigned int keep_frequency);
+			unsigned int keep_frequency,
+			network_data_async_writer::ptr writer = network_data_async_writer::ptr());
 
 		virtual ~clean_snapshots_network_data_pusher() = default;
 
@@ -38,6 +40,8 @@ namespace nnforge
 	private:
 		boost::filesystem::path folder_path;
 		unsigned int keep_frequency;
+		// When set, snapshots are removed through the writer, after the pending writes of the same snapshots
+		network_data_async_writer::ptr writer;
 
 		static const char * snapshot_ann_index_extractor_pattern;
 	};
@@ -27,4 +27,22 @@ namespace nnforge
 	{
 		return 1;
 	}
+
+	void data_transformer::transform(
+		const float * data,
+		float * data_transformed,
+		const layer_configuration_specific& original_config,
+		unsigned int sample_id,
+		counter_random_generator& gen)
+	{
+		transform(data, data_transformed, original_config, sample_id);
+	}
+
+	bool data_transformer::get_elementwise_affine_map(
+		const layer_configuration_specific& original_config,
+		counter_random_generator& gen,
+		elementwise_affine_map& map) const
+	{
+		return false;
+	}
 }
@@ -17,11 +17,24 @@
 #pragma once
 
 #include "layer_configuration_specific.h"
+#include "rnd.h"
 
 #include <memory>
+#include <vector>
+#include <random>
 
 namespace nnforge
 {
+	// Element x of feature map i is mapped to x * mult_list[i] + add_list[i],
+	// then, if apply_noise is set, a value drawn from noise_distribution is added to each element
+	struct elementwise_affine_map
+	{
+		std::vector<float> mult_list;
+		std::vector<float> add_list;
+		bool apply_noise;
+		std::uniform_real_distribution<float> noise_distribution;
+	};
+
 	class data_transformer
 	{
 	public:
@@ -35,10 +48,27 @@ namespace nnforge
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id) = 0;
 
+		// Randomized transformers override this one and draw all the random parameters from gen,
+		// which is private to the entry being transformed. The default implementation ignores gen
+		virtual void transform(
+			const float * data,
+			float * data_transformed,
+			const layer_configuration_specific& original_config,
+			unsigned int sample_id,
+			counter_random_generator& gen);
+
 		virtual layer_configuration_specific get_transformed_configuration(const layer_configuration_specific& original_config) const;
 
 		virtual unsigned int get_sample_count() const;
 
+		// Transformers which map each element independently of the others return true and fill map,
+		// drawing the random parameters from gen in the same order transform does, noise excluded.
+		// Consecutive transformers of this kind are then applied in a single pass. The default implementation returns false
+		virtual bool get_elementwise_affine_map(
+			const layer_configuration_specific& original_config,
+			counter_random_generator& gen,
+			elementwise_affine_map& map) const;
+
 	protected:
 		data_transformer() = default;
 
@@ -44,8 +44,6 @@ namespace nnforge
 		, apply_stretch_distribution(max_stretch_factor > 1.0F)
 		, apply_perspective_reverse_distance_distribution(min_perspective_distance != std::numeric_limits<float>::max())
 	{
-		generator = rnd::get_random_generator();
-
 		rotate_angle_distribution = std::uniform_real_distribution<float>(-max_absolute_rotation_angle_in_degrees, max_absolute_rotation_angle_in_degrees + (apply_rotate_angle_distribution ? 0.0F : 1.0F));
 		scale_distribution = std::uniform_real_distribution<float>(1.0F / max_scale_factor, max_scale_factor + (apply_scale_distribution ? 0.0F : 1.0F));
 		shift_x_distribution = std::uniform_real_distribution<float>(min_shift_right_x, max_shift_right_x + (apply_shift_x_distribution ? 0.0F : 1.0F));
@@ -63,6 +61,17 @@ namespace nnforge
 		float * data_transformed,
 		const layer_configuration_specific& original_config,
 		unsigned int sample_id)
+	{
+		counter_random_generator gen = rnd::get_counter_random_generator();
+		transform(data, data_transformed, original_config, sample_id, gen);
+	}
+
+	void distort_2d_data_transformer::transform(
+		const float * data,
+		float * data_transformed,
+		const layer_configuration_specific& original_config,
+		unsigned int sample_id,
+		counter_random_generator& gen)
 	{
 		if (original_config.dimension_sizes.size() < 2)
 			throw neural_network_exception((boost::format("distort_2d_data_transformer is processing at least 2d data, data is passed with number of dimensions %1%") % original_config.dimension_sizes.size()).str());
@@ -79,32 +88,28 @@ namespace nnforge
 		float perspective_distance = std::numeric_limits<float>::max();
 		float perspective_angle = perspective_angle_distribution.min();
 
+		if (apply_rotate_angle_distribution)
+			rotation_angle = rotate_angle_distribution(gen);
+		if (apply_scale_distribution)
+			scale = scale_distribution(gen);
+		if (apply_shift_x_distribution)
+			shift_x = shift_x_distribution(gen);
+		if (apply_shift_y_distribution)
+			shift_y = shift_y_distribution(gen);
+		if (flip_around_x_distribution.max() > flip_around_x_distribution.min())
+			flip_around_x_axis = (flip_around_x_distribution(gen) == 1);
+		if (flip_around_y_distribution.max() > flip_around_y_distribution.min())
+			flip_around_y_axis = (flip_around_y_distribution(gen) == 1);
+		if (apply_stretch_distribution)
+			stretch = stretch_distribution(gen);
+		stretch_angle = stretch_angle_distribution(gen);
+		if (apply_perspective_reverse_distance_distribution)
 		{
-			std::lock_guard<std::mutex> lock(gen_stream_mutex);
-
-			if (apply_rotate_angle_distribution)
-				rotation_angle = rotate_angle_distribution(generator);
-			if (apply_scale_distribution)
-				scale = scale_distribution(generator);
-			if (apply_shift_x_distribution)
-				shift_x = shift_x_distribution(generator);
-			if (apply_shift_y_distribution)
-				shift_y = shift_y_distribution(generator);
-			if (flip_around_x_distribution.max() > flip_around_x_distribution.min())
-				flip_around_x_axis = (flip_around_x_distribution(generator) == 1);
-			if (flip_around_y_distribution.max() > flip_around_y_distribution.min())
-				flip_around_y_axis = (flip_around_y_distribution(generator) == 1);
-			if (apply_stretch_distribution)
-				stretch = stretch_distribution(generator);
-			stretch_angle = stretch_angle_distribution(generator);
-			if (apply_perspective_reverse_distance_distribution)
-			{
-				perspective_reverse_distance = perspective_reverse_distance_distribution(generator);
-				if (perspective_reverse_distance > 0.0F)
-					perspective_distance = 1.0F / perspective_reverse_distance;
-			}
-			perspective_angle = perspective_angle_distribution(generator);
+			perspective_reverse_distance = perspective_reverse_distance_distribution(gen);
+			if (perspective_reverse_distance > 0.0F)
+				perspective_distance = 1.0F / perspective_reverse_distance;
 		}
+		perspective_angle = perspective_angle_distribution(gen);
 
 		unsigned int neuron_count_per_image = original_config.dimension_sizes[0] * original_config.dimension_sizes[1];
 		unsigned int image_count = original_config.get_neuron_count() / neuron_count_per_image;
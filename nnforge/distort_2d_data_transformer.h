@@ -19,7 +19,6 @@
 #include "data_transformer.h"
 #include "rnd.h"
 
-#include <mutex>
 #include <random>
 
 namespace nnforge
@@ -47,13 +46,17 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual void transform(
+			const float * data,
+			float * data_transformed,
+			const layer_configuration_specific& original_config,
+			unsigned int sample_id,
+			counter_random_generator& gen);
 			
 	protected:
 		float border_value;
 
-		random_generator generator;
-		std::mutex gen_stream_mutex;
-
 		bool apply_rotate_angle_distribution;
 		std::uniform_real_distribution<float> rotate_angle_distribution;
 
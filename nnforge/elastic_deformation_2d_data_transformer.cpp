@@ -31,7 +31,6 @@ namespace nnforge
 		: alpha(alpha)
 		, sigma(sigma)
 		, border_value(border_value)
-		, gen(rnd::get_random_generator())
 		, displacement_distribution(std::uniform_real_distribution<float>(-1.0F, 1.0F))
 	{
 	}
@@ -41,6 +40,17 @@ namespace nnforge
 		float * data_transformed,
 		const layer_configuration_specific& original_config,
 		unsigned int sample_id)
+	{
+		counter_random_generator gen = rnd::get_counter_random_generator();
+		transform(data, data_transformed, original_config, sample_id, gen);
+	}
+
+	void elastic_deformation_2d_data_transformer::transform(
+		const float * data,
+		float * data_transformed,
+		const layer_configuration_specific& original_config,
+		unsigned int sample_id,
+		counter_random_generator& gen)
 	{
 		if (original_config.dimension_sizes.size() < 2)
 			throw neural_network_exception((boost::format("intensity_2d_data_transformer is processing at least 2d data, data is passed with number of dimensions %1%") % original_config.dimension_sizes.size()).str());
@@ -50,22 +60,18 @@ namespace nnforge
 		cv::Mat1f x_disp(original_config.dimension_sizes[1], original_config.dimension_sizes[0]);
 		cv::Mat1f y_disp(original_config.dimension_sizes[1], original_config.dimension_sizes[0]);
 
+		for(int row_id = 0; row_id < x_disp.rows; ++row_id)
 		{
-			std::lock_guard<std::mutex> lock(gen_stream_mutex);
-
-			for(int row_id = 0; row_id < x_disp.rows; ++row_id)
-			{
-				float * row_ptr = x_disp.ptr<float>(row_id);
-				for(int column_id = 0; column_id < x_disp.cols; ++column_id)
-					row_ptr[column_id] = displacement_distribution(gen);
-			}
+			float * row_ptr = x_disp.ptr<float>(row_id);
+			for(int column_id = 0; column_id < x_disp.cols; ++column_id)
+				row_ptr[column_id] = displacement_distribution(gen);
+		}
 
-			for(int row_id = 0; row_id < y_disp.rows; ++row_id)
-			{
-				float * row_ptr = y_disp.ptr<float>(row_id);
-				for(int column_id = 0; column_id < y_disp.cols; ++column_id)
-					row_ptr[column_id] = displacement_distribution(gen);
-			}
+		for(int row_id = 0; row_id < y_disp.rows; ++row_id)
+		{
+			float * row_ptr = y_disp.ptr<float>(row_id);
+			for(int column_id = 0; column_id < y_disp.cols; ++column_id)
+				row_ptr[column_id] = displacement_distribution(gen);
 		}
 
 		smooth(x_disp, ksize, sigma, alpha, true);
@@ -20,7 +20,6 @@
 #include "rnd.h"
 
 #include <opencv2/core/core.hpp>
-#include <mutex>
 #include <random>
 
 namespace nnforge
@@ -40,6 +39,13 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual void transform(
+			const float * data,
+			float * data_transformed,
+			const layer_configuration_specific& original_config,
+			unsigned int sample_id,
+			counter_random_generator& gen);
 			
 		static void smooth(
 			cv::Mat1f disp,
@@ -55,8 +61,6 @@ namespace nnforge
 		float sigma;
 		float border_value;
 
-		random_generator gen;
-		std::mutex gen_stream_mutex;
 		std::uniform_real_distribution<float> displacement_distribution;
 	};
 }
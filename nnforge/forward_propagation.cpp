@@ -129,9 +129,18 @@ namespace nnforge
 
 	void forward_propagation::update_flops()
 	{
+		std::map<layer_name_with_action, float> flops_per_action = get_flops_per_action();
+		double total_flops = 0.0;
+		for(std::map<layer_name_with_action, float>::const_iterator it = flops_per_action.begin(); it != flops_per_action.end(); ++it)
+			total_flops += static_cast<double>(it->second);
+		flops = static_cast<float>(total_flops);
 		if (profile->is_profile())
-			action_flops_per_entry = action_schema->get_flops_per_action(layer_config_map, cumulative_tiling_factor_map);
-		flops = action_schema->get_flops(layer_config_map, cumulative_tiling_factor_map);
+			action_flops_per_entry = flops_per_action;
+	}
+
+	std::map<layer_name_with_action, float> forward_propagation::get_flops_per_action() const
+	{
+		return action_schema->get_flops_per_action(layer_config_map, cumulative_tiling_factor_map);
 	}
 
 	forward_propagation::stat forward_propagation::run(
@@ -159,7 +168,7 @@ namespace nnforge
 		if (profile->is_profile() && !action_seconds.empty())
 		{
 			std::map<std::string, std::string> layer_name_to_layer_type_map;
-			std::vector<layer::const_ptr> layer_list = schema->get_layers();
+			std::vector<layer::const_ptr> layer_list = get_executed_schema()->get_layers();
 			for(std::vector<layer::const_ptr>::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
 				layer_name_to_layer_type_map.insert(std::make_pair((*it)->instance_name, (*it)->get_type_name()));
 			profile_util::dump_layer_action_performance(
@@ -176,6 +185,11 @@ namespace nnforge
 		return res;
 	}
 
+	network_schema::const_ptr forward_propagation::get_executed_schema() const
+	{
+		return schema;
+	}
+
 	float forward_propagation::get_max_flops() const
 	{
 		throw neural_network_exception("get_max_flops not implemented");
@@ -93,6 +93,14 @@ namespace nnforge
 
 		virtual float get_max_flops() const;
 
+		// Default impl returns flops reported by layers, multiplied by tiling factors
+		// Backends running layers with algorithms of different complexity override it
+		virtual std::map<layer_name_with_action, float> get_flops_per_action() const;
+
+		// Returns the schema the actions run are built from, layer types reported in profiles are taken from it
+		// Default impl returns schema, backends fusing layers override it
+		virtual network_schema::const_ptr get_executed_schema() const;
+
 	protected:
 		network_schema::const_ptr schema;
 		network_action_schema::ptr action_schema;
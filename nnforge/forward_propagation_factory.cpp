@@ -18,4 +18,31 @@
 
 namespace nnforge
 {
+	forward_propagation::ptr forward_propagation_factory::create_concurrent(
+		const network_schema& schema,
+		const std::vector<std::string>& output_layer_names,
+		debug_state::ptr debug,
+		profile_state::ptr profile,
+		unsigned int concurrent_count) const
+	{
+		return create(
+			schema,
+			output_layer_names,
+			debug,
+			profile);
+	}
+
+	forward_propagation::ptr forward_propagation_factory::create_coexisting(
+		const network_schema& schema,
+		const std::vector<std::string>& output_layer_names,
+		debug_state::ptr debug,
+		profile_state::ptr profile,
+		unsigned int coexisting_count) const
+	{
+		return create(
+			schema,
+			output_layer_names,
+			debug,
+			profile);
+	}
 }
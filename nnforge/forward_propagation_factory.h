@@ -41,6 +41,24 @@ namespace nnforge
 			debug_state::ptr debug,
 			profile_state::ptr profile) const = 0;
 
+		// Creates one of concurrent_count objects running at the same time, backends split the cores and the memory among them.
+		// The default implementation calls create
+		virtual forward_propagation::ptr create_concurrent(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			debug_state::ptr debug,
+			profile_state::ptr profile,
+			unsigned int concurrent_count) const;
+
+		// Creates one of coexisting_count objects holding their buffers at the same time while being run one after another,
+		// backends split the memory among them. The default implementation calls create
+		virtual forward_propagation::ptr create_coexisting(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			debug_state::ptr debug,
+			profile_state::ptr profile,
+			unsigned int coexisting_count) const;
+
 	protected:
 		forward_propagation_factory() = default;
 	};
@@ -30,8 +30,6 @@ namespace nnforge
 		: apply_contrast_distribution(max_contrast_factor > 1.0F)
 		, apply_brightness_shift_distribution(apply_brightness_shift_distribution != 0.0F)
 	{
-		generator = rnd::get_random_generator();
-
 		contrast_distribution = std::uniform_real_distribution<float>(1.0F / max_contrast_factor, max_contrast_factor + (apply_contrast_distribution ? 0.0F: 1.0F));
 		brightness_shift_distribution = std::uniform_real_distribution<float>(-max_absolute_brightness_shift, max_absolute_brightness_shift + (apply_brightness_shift_distribution ? 0.0F : 1.0F));
 	}
@@ -41,6 +39,17 @@ namespace nnforge
 		float * data_transformed,
 		const layer_configuration_specific& original_config,
 		unsigned int sample_id)
+	{
+		counter_random_generator gen = rnd::get_counter_random_generator();
+		transform(data, data_transformed, original_config, sample_id, gen);
+	}
+
+	void intensity_2d_data_transformer::transform(
+		const float * data,
+		float * data_transformed,
+		const layer_configuration_specific& original_config,
+		unsigned int sample_id,
+		counter_random_generator& gen)
 	{
 		if (original_config.dimension_sizes.size() < 2)
 			throw neural_network_exception((boost::format("intensity_2d_data_transformer is processing at least 2d data, data is passed with number of dimensions %1%") % original_config.dimension_sizes.size()).str());
@@ -48,14 +57,10 @@ namespace nnforge
 		float contrast = contrast_distribution.min();
 		float brightness_shift = brightness_shift_distribution.min();
 
-		{
-			std::lock_guard<std::mutex> lock(gen_stream_mutex);
-
-			if (apply_contrast_distribution)
-				contrast = contrast_distribution(generator);
-			if (apply_brightness_shift_distribution)
-				brightness_shift = brightness_shift_distribution(generator);
-		}
+		if (apply_contrast_distribution)
+			contrast = contrast_distribution(gen);
+		if (apply_brightness_shift_distribution)
+			brightness_shift = brightness_shift_distribution(gen);
 
 		unsigned int neuron_count_per_image = original_config.dimension_sizes[0] * original_config.dimension_sizes[1];
 		unsigned int image_count = original_config.get_neuron_count() / neuron_count_per_image;
@@ -71,4 +76,30 @@ namespace nnforge
 				brightness_shift);
 		}
 	}
+
+	bool intensity_2d_data_transformer::get_elementwise_affine_map(
+		const layer_configuration_specific& original_config,
+		counter_random_generator& gen,
+		elementwise_affine_map& map) const
+	{
+		if (original_config.dimension_sizes.size() < 2)
+			throw neural_network_exception((boost::format("intensity_2d_data_transformer is processing at least 2d data, data is passed with number of dimensions %1%") % original_config.dimension_sizes.size()).str());
+
+		std::uniform_real_distribution<float> contrast_dist(contrast_distribution.param());
+		std::uniform_real_distribution<float> brightness_shift_dist(brightness_shift_distribution.param());
+
+		float contrast = contrast_dist.min();
+		float brightness_shift = brightness_shift_dist.min();
+
+		if (apply_contrast_distribution)
+			contrast = contrast_dist(gen);
+		if (apply_brightness_shift_distribution)
+			brightness_shift = brightness_shift_dist(gen);
+
+		map.mult_list.assign(original_config.feature_map_count, contrast);
+		map.add_list.assign(original_config.feature_map_count, brightness_shift);
+		map.apply_noise = false;
+
+		return true;
+	}
 }
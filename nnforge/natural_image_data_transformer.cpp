@@ -20,6 +20,7 @@
 
 #include <opencv2/core/core.hpp>
 #include <boost/format.hpp>
+#include <cstring>
 
 namespace nnforge
 {
@@ -28,8 +29,7 @@ namespace nnforge
 		float contrast,
 		float saturation,
 		float lighting)
-		: generator(rnd::get_random_generator())
-		, apply_brightness_distribution(brightness > 0.0F)
+		: apply_brightness_distribution(brightness > 0.0F)
 		, apply_contrast_distribution(contrast > 0.0F)
 		, apply_saturation_distribution(saturation > 0.0F)
 		, apply_lighting(lighting > 0.0F)
@@ -50,6 +50,17 @@ namespace nnforge
 		float * data_transformed,
 		const layer_configuration_specific& original_config,
 		unsigned int sample_id)
+	{
+		counter_random_generator gen = rnd::get_counter_random_generator();
+		transform(data, data_transformed, original_config, sample_id, gen);
+	}
+
+	void natural_image_data_transformer::transform(
+		const float * data,
+		float * data_transformed,
+		const layer_configuration_specific& original_config,
+		unsigned int sample_id,
+		counter_random_generator& gen)
 	{
 		if (original_config.feature_map_count != 3)
 			throw neural_network_exception((boost::format("natural_image_data_transformer is provided with %1% feature maps while it can work with RGB data only") % original_config.feature_map_count).str());
@@ -61,40 +72,41 @@ namespace nnforge
 		float alpha_lighting_1st_eigen;
 		float alpha_lighting_2nd_eigen;
 		float alpha_lighting_3rd_eigen;
+
+		alpha_brightness = 1.0F;
+		if (apply_brightness_distribution)
+			alpha_brightness = brightness_distribution(gen);
+
+		alpha_contrast = 1.0F;
+		if (apply_contrast_distribution)
+			alpha_contrast = contrast_distribution(gen);
+
+		alpha_saturation = 1.0F;
+		if (apply_saturation_distribution)
+			alpha_saturation = saturation_distribution(gen);
+
+		if (alpha_brightness != 1.0F)
+			augmentations.push_back(augmentation_brightness);
+		if (alpha_contrast != 1.0F)
+			augmentations.push_back(augmentation_contrast);
+		if (alpha_saturation != 1.0F)
+			augmentations.push_back(augmentation_saturation);
+		for(int i = static_cast<int>(augmentations.size()) - 1; i > 0; --i)
 		{
-			std::lock_guard<std::mutex> lock(gen_mutex);
-
-			alpha_brightness = 1.0F;
-			if (apply_brightness_distribution)
-				alpha_brightness = brightness_distribution(generator);
-
-			alpha_contrast = 1.0F;
-			if (apply_contrast_distribution)
-				alpha_contrast = contrast_distribution(generator);
-
-			alpha_saturation = 1.0F;
-			if (apply_saturation_distribution)
-				alpha_saturation = saturation_distribution(generator);
-
-			if (alpha_brightness != 1.0F)
-				augmentations.push_back(augmentation_brightness);
-			if (alpha_contrast != 1.0F)
-				augmentations.push_back(augmentation_contrast);
-			if (alpha_saturation != 1.0F)
-				augmentations.push_back(augmentation_saturation);
-			for(int i = static_cast<int>(augmentations.size()) - 1; i > 0; --i)
-			{
-				std::uniform_int_distribution<int> dist(0, i);
-				int elem_id = dist(generator);
-				std::swap(augmentations[elem_id], augmentations[i]);
-			}
+			std::uniform_int_distribution<int> dist(0, i);
+			int elem_id = dist(gen);
+			std::swap(augmentations[elem_id], augmentations[i]);
+		}
 
-			if (apply_lighting)
-			{
-				alpha_lighting_1st_eigen = lighting_1st_eigen_alpha_distribution(generator);
-				alpha_lighting_2nd_eigen = lighting_2nd_eigen_alpha_distribution(generator);
-				alpha_lighting_3rd_eigen = lighting_3rd_eigen_alpha_distribution(generator);
-			}
+		if (apply_lighting)
+		{
+			// normal_distribution keeps state between calls, so concurrent calls use their own copies
+			std::normal_distribution<float> local_lighting_1st_eigen_alpha_distribution(lighting_1st_eigen_alpha_distribution.param());
+			std::normal_distribution<float> local_lighting_2nd_eigen_alpha_distribution(lighting_2nd_eigen_alpha_distribution.param());
+			std::normal_distribution<float> local_lighting_3rd_eigen_alpha_distribution(lighting_3rd_eigen_alpha_distribution.param());
+			alpha_lighting_1st_eigen = local_lighting_1st_eigen_alpha_distribution(gen);
+			alpha_lighting_2nd_eigen = local_lighting_2nd_eigen_alpha_distribution(gen);
+			alpha_lighting_3rd_eigen = local_lighting_3rd_eigen_alpha_distribution(gen);
 		}
 
 		unsigned int neuron_count_per_feature_map = original_config.get_neuron_count_per_feature_map();
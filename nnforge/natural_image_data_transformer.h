@@ -20,7 +20,6 @@
 #include "rnd.h"
 
 #include <vector>
-#include <mutex>
 
 namespace nnforge
 {
@@ -40,6 +39,13 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual void transform(
+			const float * data,
+			float * data_transformed,
+			const layer_configuration_specific& original_config,
+			unsigned int sample_id,
+			counter_random_generator& gen);
 			
 	private:
 		enum augmentation_type
@@ -50,9 +56,6 @@ namespace nnforge
 		};
 
 	protected:
-		random_generator generator;
-		std::mutex gen_mutex;
-
 		bool apply_brightness_distribution;
 		std::uniform_real_distribution<float> brightness_distribution;
 
@@ -103,6 +103,8 @@ namespace nnforge
 		// buffers contains all the buffers which should be distributed across sets
 		// dependencies lists off buffers each action depends on
 		// input_index_layer_can_write_output_map contains info on whether the action is able to write the output to one of its input
+		// Buffers share a set only when one's lifetime ends before the other's starts along the dependencies of the schema,
+		// so the sets stay valid when actions not ordered by dependencies run concurrently
 		std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > get_buffer_set(
 			const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > >& buffers,
 			const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies_and_overwrites,
@@ -17,6 +17,7 @@
 #include "network_data.h"
 
 #include "neural_network_exception.h"
+#include "packed_network_data.h"
 
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/format.hpp>
@@ -67,6 +68,14 @@ namespace nnforge
 
 	void network_data::read(const boost::filesystem::path& folder_path)
 	{
+		if (packed_network_data::is_packed(folder_path))
+		{
+			network_data::ptr packed_data = packed_network_data(folder_path).get_network_data();
+			data_list = packed_data->data_list;
+			data_custom_list = packed_data->data_custom_list;
+			return;
+		}
+
 		data_list.read(folder_path);
 		data_custom_list.read(folder_path);
 	}
@@ -52,6 +52,7 @@ namespace nnforge
 
 		void write(const boost::filesystem::path& folder_path) const;
 
+		// folder_path might also point to a file written by packed_network_data
 		void read(const boost::filesystem::path& folder_path);
 
 		// The method throws exception in case the data is not suitable for the layers
@@ -0,0 +1,241 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "network_data_async_writer.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <chrono>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace nnforge
+{
+	network_data_async_writer::network_data_async_writer(unsigned int max_pending_task_count)
+		: max_pending_task_count(std::max(max_pending_task_count, 1U))
+		, stop(false)
+	{
+		writer_thread = std::thread(&network_data_async_writer::run, this);
+	}
+
+	network_data_async_writer::~network_data_async_writer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			stop = true;
+		}
+		task_submitted_condition.notify_one();
+		writer_thread.join();
+	}
+
+	float network_data_async_writer::write(
+		const network_data& data,
+		const boost::filesystem::path& folder_path)
+	{
+		task t;
+		t.data = copy(data);
+		t.folder_path = folder_path;
+		return submit(t);
+	}
+
+	float network_data_async_writer::remove(const boost::filesystem::path& folder_path)
+	{
+		task t;
+		t.folder_path = folder_path;
+		return submit(t);
+	}
+
+	float network_data_async_writer::submit(const task& t)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			rethrow_error();
+			while (task_queue.size() >= max_pending_task_count)
+			{
+				task_completed_condition.wait(lock);
+				rethrow_error();
+			}
+			task_queue.push_back(t);
+		}
+		task_submitted_condition.notify_one();
+		std::chrono::duration<float> sec = std::chrono::high_resolution_clock::now() - start;
+		return sec.count();
+	}
+
+	void network_data_async_writer::wait()
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		while (!task_queue.empty() && !error)
+			task_completed_condition.wait(lock);
+		rethrow_error();
+	}
+
+	void network_data_async_writer::rethrow_error()
+	{
+		if (error)
+		{
+			std::exception_ptr e = error;
+			error = std::exception_ptr();
+			std::rethrow_exception(e);
+		}
+	}
+
+	void network_data_async_writer::run()
+	{
+		while (true)
+		{
+			task t;
+			{
+				std::unique_lock<std::mutex> lock(queue_mutex);
+				while (task_queue.empty() && !stop)
+					task_submitted_condition.wait(lock);
+				if (task_queue.empty())
+					break;
+				t = task_queue.front();
+			}
+
+			std::exception_ptr task_error;
+			try
+			{
+				run_task(t);
+			}
+			catch (...)
+			{
+				task_error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(queue_mutex);
+				task_queue.pop_front();
+				if (task_error)
+				{
+					// Tasks submitted after the failed one are dropped, the caller gets the error instead
+					error = task_error;
+					task_queue.clear();
+				}
+			}
+			task_completed_condition.notify_all();
+		}
+	}
+
+	void network_data_async_writer::run_task(const task& t) const
+	{
+		boost::filesystem::path old_folder_path = get_old_folder_path(t.folder_path);
+
+		if (!t.data)
+		{
+			if (boost::filesystem::exists(t.folder_path))
+				boost::filesystem::remove_all(t.folder_path);
+			if (boost::filesystem::exists(old_folder_path))
+				boost::filesystem::remove_all(old_folder_path);
+			return;
+		}
+
+		boost::filesystem::path temp_folder_path = t.folder_path;
+		temp_folder_path += ".temp";
+		if (boost::filesystem::exists(temp_folder_path))
+			boost::filesystem::remove_all(temp_folder_path);
+
+		t.data->write(temp_folder_path);
+		sync_folder(temp_folder_path);
+
+		// The old folder left by the interrupted replacement is kept until the new folder is in place, unless the final one exists
+		if (boost::filesystem::exists(t.folder_path))
+		{
+			if (boost::filesystem::exists(old_folder_path))
+				boost::filesystem::remove_all(old_folder_path);
+			boost::filesystem::rename(t.folder_path, old_folder_path);
+		}
+		boost::filesystem::rename(temp_folder_path, t.folder_path);
+		sync_path(t.folder_path.parent_path());
+
+		if (boost::filesystem::exists(old_folder_path))
+			boost::filesystem::remove_all(old_folder_path);
+	}
+
+	boost::filesystem::path network_data_async_writer::get_old_folder_path(const boost::filesystem::path& folder_path)
+	{
+		boost::filesystem::path res = folder_path;
+		res += ".old";
+		return res;
+	}
+
+	boost::filesystem::path network_data_async_writer::get_recovered_folder_path(const boost::filesystem::path& folder_path)
+	{
+		if (boost::filesystem::exists(folder_path))
+			return folder_path;
+
+		boost::filesystem::path old_folder_path = get_old_folder_path(folder_path);
+		if (boost::filesystem::exists(old_folder_path))
+			return old_folder_path;
+
+		return folder_path;
+	}
+
+	void network_data_async_writer::sync_folder(const boost::filesystem::path& folder_path)
+	{
+		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(folder_path); it != boost::filesystem::directory_iterator(); ++it)
+		{
+			if (it->status().type() == boost::filesystem::regular_file)
+				sync_path(it->path());
+		}
+		sync_path(folder_path);
+	}
+
+	void network_data_async_writer::sync_path(const boost::filesystem::path& path)
+	{
+		#ifdef _WIN32
+		// Directories cannot be flushed on Windows, renames are journaled by NTFS anyway
+		if (boost::filesystem::is_directory(path))
+			return;
+		int fd = _open(path.string().c_str(), _O_RDWR | _O_BINARY);
+		if (fd == -1)
+			throw neural_network_exception((boost::format("Unable to open %1% to sync it to disk") % path.string()).str());
+		int res = _commit(fd);
+		_close(fd);
+		#else
+		int fd = open(path.string().c_str(), O_RDONLY);
+		if (fd == -1)
+			throw neural_network_exception((boost::format("Unable to open %1% to sync it to disk") % path.string()).str());
+		int res = fsync(fd);
+		close(fd);
+		#endif
+		if (res != 0)
+			throw neural_network_exception((boost::format("Unable to sync %1% to disk") % path.string()).str());
+	}
+
+	network_data::ptr network_data_async_writer::copy(const network_data& data)
+	{
+		network_data::ptr res(new network_data());
+
+		std::vector<std::string> data_name_list = data.data_list.get_data_layer_name_list();
+		for(std::vector<std::string>::const_iterator it = data_name_list.begin(); it != data_name_list.end(); ++it)
+			res->data_list.add(*it, layer_data::ptr(new layer_data(*data.data_list.get(*it))));
+
+		std::vector<std::string> data_custom_name_list = data.data_custom_list.get_data_custom_layer_name_list();
+		for(std::vector<std::string>::const_iterator it = data_custom_name_list.begin(); it != data_custom_name_list.end(); ++it)
+			res->data_custom_list.add(*it, layer_data_custom::ptr(new layer_data_custom(*data.data_custom_list.get(*it))));
+
+		return res;
+	}
+}
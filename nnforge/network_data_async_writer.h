@@ -0,0 +1,100 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "network_data.h"
+
+#include <boost/filesystem.hpp>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace nnforge
+{
+	// Writes network_data folders and removes folders in a background thread, in the order the tasks were submitted.
+	// Each folder is written to a temporary folder and synced to disk. The existing folder, if any, is renamed aside
+	// to the one with ".old" suffix, the temporary folder is renamed to the final name, then the old folder is removed.
+	// A crash leaves either the final folder or the old one in place, see get_recovered_folder_path.
+	// Errors from the background thread are rethrown from the next write, remove or wait call
+	class network_data_async_writer
+	{
+	public:
+		typedef std::shared_ptr<network_data_async_writer> ptr;
+
+		// Submitting tasks blocks while max_pending_task_count tasks are waiting or being run
+		network_data_async_writer(unsigned int max_pending_task_count);
+
+		// Waits for the pending tasks, errors are discarded
+		~network_data_async_writer();
+
+		// The data is copied before the call returns, so the caller is free to modify it afterwards.
+		// Returns the number of seconds spent waiting for the writer to make room for the task
+		float write(
+			const network_data& data,
+			const boost::filesystem::path& folder_path);
+
+		// Returns the number of seconds spent waiting for the writer to make room for the task
+		float remove(const boost::filesystem::path& folder_path);
+
+		// Waits for all the tasks submitted so far to complete
+		void wait();
+
+		static network_data::ptr copy(const network_data& data);
+
+		// Returns folder_path if it exists, otherwise the old folder left by the interrupted replacement, if it exists
+		static boost::filesystem::path get_recovered_folder_path(const boost::filesystem::path& folder_path);
+
+		static boost::filesystem::path get_old_folder_path(const boost::filesystem::path& folder_path);
+
+	private:
+		struct task
+		{
+			network_data::const_ptr data;
+			boost::filesystem::path folder_path;
+		};
+
+		float submit(const task& t);
+
+		void run();
+
+		void run_task(const task& t) const;
+
+		static void sync_folder(const boost::filesystem::path& folder_path);
+
+		static void sync_path(const boost::filesystem::path& path);
+
+		void rethrow_error();
+
+	private:
+		unsigned int max_pending_task_count;
+		// The task at the front of the queue stays there while it is being run
+		std::deque<task> task_queue;
+		bool stop;
+		std::exception_ptr error;
+		std::mutex queue_mutex;
+		std::condition_variable task_submitted_condition;
+		std::condition_variable task_completed_condition;
+		std::thread writer_thread;
+
+	private:
+		network_data_async_writer(const network_data_async_writer&) = delete;
+		network_data_async_writer& operator =(const network_data_async_writer&) = delete;
+	};
+}
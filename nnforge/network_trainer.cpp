@@ -18,9 +18,13 @@
 
 #include <vector>
 #include <iostream>
+#include <thread>
+#include <exception>
+#include <boost/format.hpp>
 
 #include "neural_network_exception.h"
 #include "exponential_learning_rate_decay_policy.h"
+#include "structured_data_bunch_shared_reader.h"
 
 namespace nnforge
 {
@@ -37,6 +41,7 @@ namespace nnforge
 		, learning_rate(0.02F)
 		, lr_policy(new exponential_learning_rate_decay_policy())
 		, batch_size(1)
+		, shared_reader_max_cache_mb(1024)
 	{
 	}
 
@@ -48,13 +53,39 @@ namespace nnforge
 	{
 		initialize_train(reader);
 
+		unsigned int concurrent_task_count = get_concurrent_task_count();
+		while(true)
+		{
+			std::vector<training_task_state> task_list;
+			while (task_list.size() < concurrent_task_count)
+			{
+				training_task_state new_task;
+				if (!peek_task(peeker, new_task))
+					break;
+				task_list.push_back(new_task);
+			}
+			if (task_list.empty())
+				break;
+
+			train_tasks(
+				reader,
+				task_list,
+				progress_pusher,
+				pusher);
+		}
+	}
+
+	bool network_trainer::peek_task(
+		network_data_peeker& peeker,
+		training_task_state& new_task)
+	{
 		while(true)
 		{
 			network_data_peek_entry entry_peeked = peeker.peek(schema);
 			if (entry_peeked.data == 0)
-				break;
+				return false;
 
-			training_task_state new_task;
+			new_task = training_task_state();
 			new_task.index_peeked = entry_peeked.index;
 			new_task.data = entry_peeked.data;
 			new_task.initial_epoch = entry_peeked.start_epoch;
@@ -103,37 +134,113 @@ namespace nnforge
 				std::cout << ", Starting with the 2nd empty momentum";
 			std::cout << std::endl;
 
-			unsigned int reader_epoch_id = new_task.initial_epoch;
+			return true;
+		}
+	}
+
+	void network_trainer::train_tasks(
+		structured_data_bunch_reader& reader,
+		std::vector<training_task_state>& task_list,
+		network_data_pusher& progress_pusher,
+		network_data_pusher& pusher)
+	{
+		// Task ID is its slot ID
+		std::vector<unsigned int> running_task_id_list;
+		for(unsigned int task_id = 0; task_id < static_cast<unsigned int>(task_list.size()); ++task_id)
+			running_task_id_list.push_back(task_id);
+
+		while (!running_task_id_list.empty())
+		{
+			// Tasks resumed from different epochs read different epochs of the data
+			std::map<unsigned int, std::vector<unsigned int> > epoch_to_task_id_list_map;
+			for(std::vector<unsigned int>::const_iterator it = running_task_id_list.begin(); it != running_task_id_list.end(); ++it)
+				epoch_to_task_id_list_map[task_list[*it].get_current_epoch()].push_back(*it);
 
-			while(true)
+			for(std::map<unsigned int, std::vector<unsigned int> >::const_iterator it = epoch_to_task_id_list_map.begin(); it != epoch_to_task_id_list_map.end(); ++it)
 			{
-				std::cout << "---------- NN # " << new_task.index_peeked << ", Epoch " << new_task.get_current_epoch() + 1 << " ----------" << std::endl;
+				unsigned int reader_epoch_id = it->first;
+				const std::vector<unsigned int>& task_id_list = it->second;
 
-				reader.set_epoch(reader_epoch_id);
+				for(std::vector<unsigned int>::const_iterator it2 = task_id_list.begin(); it2 != task_id_list.end(); ++it2)
+					std::cout << "---------- NN # " << task_list[*it2].index_peeked << ", Epoch " << reader_epoch_id + 1 << " ----------" << std::endl;
+
+				if (task_id_list.size() == 1)
+				{
+					reader.set_epoch(reader_epoch_id);
 
-				train_step(
-					reader,
-					new_task);
+					train_step(
+						reader,
+						task_list[task_id_list.front()],
+						task_id_list.front());
+				}
+				else
+				{
+					structured_data_bunch_shared_reader shared_reader(reader, static_cast<unsigned int>(task_id_list.size()), shared_reader_max_cache_mb);
+					shared_reader.set_epoch(reader_epoch_id);
 
-				++reader_epoch_id;
+					std::vector<std::exception_ptr> error_list(task_id_list.size());
+					{
+						std::vector<std::thread> thread_list;
+						for(unsigned int i = 0; i < static_cast<unsigned int>(task_id_list.size()); ++i)
+						{
+							thread_list.push_back(std::thread([&, i] ()
+							{
+								try
+								{
+									structured_data_bunch_reader::ptr consumer_reader = shared_reader.get_consumer_reader(i);
+									train_step(
+										*consumer_reader,
+										task_list[task_id_list[i]],
+										task_id_list[i]);
+								}
+								catch (...)
+								{
+									error_list[i] = std::current_exception();
+								}
+							}));
+						}
+						for(std::vector<std::thread>::iterator it2 = thread_list.begin(); it2 != thread_list.end(); ++it2)
+							it2->join();
+					}
+					for(std::vector<std::exception_ptr>::const_iterator it2 = error_list.begin(); it2 != error_list.end(); ++it2)
+						if (*it2)
+							std::rethrow_exception(*it2);
 
-				progress_pusher.push(new_task, *schema);
+					std::pair<unsigned int, unsigned int> read_count = shared_reader.get_read_count();
+					std::cout << (boost::format("%1% networks trained concurrently, %2% entries read for %3% entries consumed") % task_id_list.size() % read_count.first % read_count.second).str() << std::endl;
+				}
+			}
 
-				if (is_broken(new_task))
+			std::vector<unsigned int> new_running_task_id_list;
+			for(std::vector<unsigned int>::const_iterator it = running_task_id_list.begin(); it != running_task_id_list.end(); ++it)
+			{
+				training_task_state& task = task_list[*it];
+
+				progress_pusher.push(task, *schema);
+
+				if (is_broken(task))
 				{
-					std::cout << "# " << new_task.index_peeked << " - broken weights while training, discarding it." << std::endl;
-					break;
+					std::cout << "# " << task.index_peeked << " - broken weights while training, discarding it." << std::endl;
+					continue;
 				}
 
-				if (is_last_epoch(new_task))
+				if (is_last_epoch(task))
 				{
-					pusher.push(new_task, *schema);
-					break;
+					pusher.push(task, *schema);
+					continue;
 				}
+
+				new_running_task_id_list.push_back(*it);
 			}
+			running_task_id_list = new_running_task_id_list;
 		}
 	}
 
+	unsigned int network_trainer::get_concurrent_task_count() const
+	{
+		return 1;
+	}
+
 	bool network_trainer::is_last_epoch(const training_task_state& state) const
 	{
 		return (state.get_current_epoch() >= epoch_count);
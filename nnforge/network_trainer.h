@@ -25,6 +25,7 @@
 #include "learning_rate_decay_policy.h"
 
 #include <map>
+#include <vector>
 #include <memory>
 
 namespace nnforge
@@ -44,6 +45,8 @@ namespace nnforge
 
 		unsigned int epoch_count;
 		unsigned int batch_size;
+		// Each entry is kept in memory until all the networks trained concurrently read it, see structured_data_bunch_shared_reader
+		unsigned int shared_reader_max_cache_mb;
 		float learning_rate;
 		learning_rate_decay_policy::const_ptr lr_policy;
 		float weight_decay;
@@ -60,10 +63,15 @@ namespace nnforge
 
 		virtual void initialize_train(structured_data_bunch_reader& reader) = 0;
 
-		// The method should add testing result to the training history of each element
+		// The amount of networks trained concurrently, sharing the data read
+		virtual unsigned int get_concurrent_task_count() const;
+
+		// The method should add testing result to the training history of each element.
+		// Concurrent tasks are run with distinct slot_id values in the [0, get_concurrent_task_count()) range
 		virtual void train_step(
 			structured_data_bunch_reader& reader,
-			training_task_state& task) = 0;
+			training_task_state& task,
+			unsigned int slot_id) = 0;
 
 		network_schema::ptr schema;
 		std::vector<std::string> output_layer_names;
@@ -71,6 +79,18 @@ namespace nnforge
 		std::vector<std::string> exclude_data_update_layer_names;
 
 	private:
+		// Returns false when the peeker has no more tasks
+		bool peek_task(
+			network_data_peeker& peeker,
+			training_task_state& new_task);
+
+		// Runs train steps of the tasks in lockstep until all of them are either complete or broken
+		void train_tasks(
+			structured_data_bunch_reader& reader,
+			std::vector<training_task_state>& task_list,
+			network_data_pusher& progress_pusher,
+			network_data_pusher& pusher);
+
 		bool is_last_epoch(const training_task_state& state) const;
 
 		bool is_broken(const training_task_state& state) const;
@@ -21,7 +21,7 @@
 #include <limits>
 
 #include "neural_network_exception.h"
-#include "neuron_value_set_data_bunch_writer.h"
+#include "average_data_bunch_writer.h"
 
 namespace nnforge
 {
@@ -30,21 +30,24 @@ namespace nnforge
 		const std::vector<std::string>& output_layer_names,
 		const std::vector<std::string>& error_source_layer_names,
 		const std::vector<std::string>& exclude_data_update_layer_names,
-		backward_propagation::ptr backprop)
+		const std::vector<backward_propagation::ptr>& backprop_list)
 		: network_trainer(schema, output_layer_names, error_source_layer_names, exclude_data_update_layer_names)
-		, backprop(backprop)
+		, backprop_list(backprop_list)
 	{
+		if (backprop_list.empty())
+			throw neural_network_exception("network_trainer_sgd requires at least one backward propagation");
 	}
 
 	void network_trainer_sgd::train_step(
 		structured_data_bunch_reader& reader,
-		training_task_state& task)
+		training_task_state& task,
+		unsigned int slot_id)
 	{
 		std::pair<std::map<std::string, std::vector<float> >, std::string> lr_and_comment = prepare_learning_rates(task.get_current_epoch(), task.data);
 		task.comments.push_back(lr_and_comment.second);
 
-		neuron_value_set_data_bunch_writer writer;
-		backward_propagation::stat training_stat = backprop->run(
+		average_data_bunch_writer writer;
+		backward_propagation::stat training_stat = backprop_list[slot_id]->run(
 			reader,
 			writer,
 			*task.data,
@@ -55,9 +58,7 @@ namespace nnforge
 			weight_decay,
 			momentum,
 			task.get_current_epoch());
-		std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > output_data_average_results;
-		for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = writer.layer_name_to_config_and_value_set_map.begin(); it != writer.layer_name_to_config_and_value_set_map.end(); ++it)
-			output_data_average_results.insert(std::make_pair(it->first, std::make_pair(it->second.first, it->second.second->get_average())));
+		std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > output_data_average_results = writer.get_average_map();
 
 		task.history.push_back(std::make_pair(training_stat, output_data_average_results));
 	}
@@ -85,6 +86,12 @@ namespace nnforge
 
 	void network_trainer_sgd::initialize_train(structured_data_bunch_reader& reader)
 	{
-		backprop->set_input_configuration_specific(reader.get_config_map());
+		for(std::vector<backward_propagation::ptr>::const_iterator it = backprop_list.begin(); it != backprop_list.end(); ++it)
+			(*it)->set_input_configuration_specific(reader.get_config_map());
+	}
+
+	unsigned int network_trainer_sgd::get_concurrent_task_count() const
+	{
+		return static_cast<unsigned int>(backprop_list.size());
 	}
 }
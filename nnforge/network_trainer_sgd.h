@@ -24,6 +24,7 @@
 namespace nnforge
 {
 	// Stochastic Gradient Descent
+	// Networks are trained concurrently, one per backward propagation in the list
 	class network_trainer_sgd : public network_trainer
 	{
 	public:
@@ -34,7 +35,7 @@ namespace nnforge
 			const std::vector<std::string>& output_layer_names,
 			const std::vector<std::string>& error_source_layer_names,
 			const std::vector<std::string>& exclude_data_update_layer_names,
-			backward_propagation::ptr backprop);
+			const std::vector<backward_propagation::ptr>& backprop_list);
 
 		virtual ~network_trainer_sgd() = default;
 
@@ -42,16 +43,19 @@ namespace nnforge
 		// The method should add testing result to the training history of each element
 		virtual void train_step(
 			structured_data_bunch_reader& reader,
-			training_task_state& task);
+			training_task_state& task,
+			unsigned int slot_id);
 
 		virtual void initialize_train(structured_data_bunch_reader& reader);
 
+		virtual unsigned int get_concurrent_task_count() const;
+
 	private:
 		std::pair<std::map<std::string, std::vector<float> >, std::string> prepare_learning_rates(
 			unsigned int epoch,
 			network_data::const_ptr data);
 
 	private:
-		backward_propagation::ptr backprop;
+		std::vector<backward_propagation::ptr> backprop_list;
 	};
 }
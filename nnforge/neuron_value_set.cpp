@@ -19,15 +19,26 @@
 #include "neural_network_exception.h"
 
 #include <cstring>
+#include <cstdlib>
 #include <algorithm>
-#include <functional>
+#include <thread>
 #include <boost/format.hpp>
-#include <boost/uuid/uuid_io.hpp>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 namespace nnforge
 {
+	const size_t neuron_value_set::alignment = 64;
+	const size_t neuron_value_set::min_elem_count_per_thread = 64 * 1024;
+
 	neuron_value_set::neuron_value_set(unsigned int neuron_count)
 		: neuron_count(neuron_count)
+		, neuron_value_list(*this)
+		, buf(0)
+		, entry_count(0)
+		, capacity_entry_count(0)
 	{
 	}
 
@@ -35,55 +46,63 @@ namespace nnforge
 		unsigned int neuron_count,
 		unsigned int entry_count)
 		: neuron_count(neuron_count)
-		, neuron_value_list(entry_count)
+		, neuron_value_list(*this)
+		, buf(0)
+		, entry_count(0)
+		, capacity_entry_count(0)
 	{
-		for(unsigned int i = 0; i < entry_count; ++i)
-			neuron_value_list[i] = std::shared_ptr<std::vector<float> >(new std::vector<float>(neuron_count));
+		reserve(entry_count);
+		memset(buf, 0, static_cast<size_t>(entry_count) * neuron_count * sizeof(float));
+		this->entry_count = entry_count;
 	}
 
 	neuron_value_set::neuron_value_set(
 		const std::vector<neuron_value_set::const_ptr>& source_neuron_value_set_list,
 		merge_type_enum merge_type)
-		: neuron_count(static_cast<unsigned int>(source_neuron_value_set_list[0]->neuron_value_list[0]->size()))
-		, neuron_value_list(source_neuron_value_set_list[0]->neuron_value_list.size())
+		: neuron_count(source_neuron_value_set_list[0]->neuron_count)
+		, neuron_value_list(*this)
+		, buf(0)
+		, entry_count(0)
+		, capacity_entry_count(0)
 	{
-		for(unsigned int i = 0; i < static_cast<unsigned int>(neuron_value_list.size()); ++i)
-			neuron_value_list[i] = std::shared_ptr<std::vector<float> >(new std::vector<float>(neuron_count));
+		unsigned int new_entry_count = source_neuron_value_set_list[0]->get_entry_count();
+		reserve(new_entry_count);
+		entry_count = new_entry_count;
 
 		if (merge_type == merge_average)
 		{
 			float mult = 1.0F / static_cast<float>(source_neuron_value_set_list.size());
-			for(unsigned int entry_id = 0; entry_id < neuron_value_list.size(); entry_id++)
+			for(unsigned int entry_id = 0; entry_id < entry_count; entry_id++)
 			{
-				std::vector<float>& neuron_value_list_for_single_entry = *neuron_value_list[entry_id];
-				for(unsigned int neuron_id = 0; neuron_id < neuron_value_list_for_single_entry.size(); neuron_id++)
+				float * dst = get_entry(entry_id);
+				for(unsigned int neuron_id = 0; neuron_id < neuron_count; neuron_id++)
 				{
 					float sum = 0.0F;
 					for(std::vector<neuron_value_set::const_ptr>::const_iterator it = source_neuron_value_set_list.begin();
 						it != source_neuron_value_set_list.end();
 						it++)
 					{
-						sum += (*it)->neuron_value_list[entry_id]->at(neuron_id);
+						sum += (*it)->get_entry(entry_id)[neuron_id];
 					}
 
-					neuron_value_list[entry_id]->at(neuron_id) = sum * mult;
+					dst[neuron_id] = sum * mult;
 				}
 			}
 		}
 		else if (merge_type == merge_median)
 		{
 			std::vector<float> val_list;
-			for(unsigned int entry_id = 0; entry_id < neuron_value_list.size(); entry_id++)
+			for(unsigned int entry_id = 0; entry_id < entry_count; entry_id++)
 			{
-				std::vector<float>& neuron_value_list_for_single_entry = *neuron_value_list[entry_id];
-				for(unsigned int neuron_id = 0; neuron_id < neuron_value_list_for_single_entry.size(); neuron_id++)
+				float * dst = get_entry(entry_id);
+				for(unsigned int neuron_id = 0; neuron_id < neuron_count; neuron_id++)
 				{
 					val_list.clear();
 					for(std::vector<neuron_value_set::const_ptr>::const_iterator it = source_neuron_value_set_list.begin();
 						it != source_neuron_value_set_list.end();
 						it++)
 					{
-						val_list.push_back((*it)->neuron_value_list[entry_id]->at(neuron_id));
+						val_list.push_back((*it)->get_entry(entry_id)[neuron_id]);
 					}
 					std::sort(val_list.begin(), val_list.end());
 					unsigned int elem_count = static_cast<unsigned int>(val_list.size());
@@ -93,65 +112,181 @@ namespace nnforge
 					else
 						val = (val_list[elem_count >> 1] + val_list[(elem_count >> 1) - 1]) * 0.5F;
 
-					neuron_value_list[entry_id]->at(neuron_id) = val;
+					dst[neuron_id] = val;
 				}
 			}
 		}
 	}
 
 	neuron_value_set::neuron_value_set(const std::vector<std::pair<neuron_value_set::const_ptr, float> >& source_neuron_value_set_list)
-		: neuron_count(static_cast<unsigned int>(source_neuron_value_set_list[0].first->neuron_value_list[0]->size()))
-		, neuron_value_list(source_neuron_value_set_list[0].first->neuron_value_list.size())
+		: neuron_count(source_neuron_value_set_list[0].first->neuron_count)
+		, neuron_value_list(*this)
+		, buf(0)
+		, entry_count(0)
+		, capacity_entry_count(0)
 	{
-		for(unsigned int entry_id = 0; entry_id < neuron_value_list.size(); entry_id++)
+		unsigned int new_entry_count = source_neuron_value_set_list[0].first->get_entry_count();
+		reserve(new_entry_count);
+		entry_count = new_entry_count;
+
+		for(unsigned int entry_id = 0; entry_id < entry_count; entry_id++)
 		{
-			std::vector<float>& neuron_value_list_for_single_entry = *neuron_value_list[entry_id];
-			for(unsigned int neuron_id = 0; neuron_id < neuron_value_list_for_single_entry.size(); neuron_id++)
+			float * dst = get_entry(entry_id);
+			for(unsigned int neuron_id = 0; neuron_id < neuron_count; neuron_id++)
 			{
 				float sum = 0.0F;
 				for(std::vector<std::pair<neuron_value_set::const_ptr, float> >::const_iterator it = source_neuron_value_set_list.begin();
 					it != source_neuron_value_set_list.end();
 					it++)
 				{
-					sum += it->first->neuron_value_list[entry_id]->at(neuron_id) * it->second;
+					sum += it->first->get_entry(entry_id)[neuron_id] * it->second;
 				}
 
-				neuron_value_list[entry_id]->at(neuron_id) = sum;
+				dst[neuron_id] = sum;
 			}
 		}
 	}
 
+	neuron_value_set::~neuron_value_set()
+	{
+		#ifdef _WIN32
+		_aligned_free(buf);
+		#else
+		free(buf);
+		#endif
+	}
+
+	void neuron_value_set::reserve(unsigned int new_capacity_entry_count)
+	{
+		if (new_capacity_entry_count <= capacity_entry_count)
+			return;
+
+		size_t size = std::max(static_cast<size_t>(new_capacity_entry_count) * neuron_count * sizeof(float), alignment);
+		void * new_buf;
+		#ifdef _WIN32
+		new_buf = _aligned_malloc(size, alignment);
+		#else
+		if (posix_memalign(&new_buf, alignment, size) != 0)
+			new_buf = 0;
+		#endif
+		if (new_buf == 0)
+			throw neural_network_exception((boost::format("Failed to allocate %1% bytes for neuron_value_set of %2% entries") % size % new_capacity_entry_count).str());
+
+		if (entry_count > 0)
+			memcpy(new_buf, buf, static_cast<size_t>(entry_count) * neuron_count * sizeof(float));
+		#ifdef _WIN32
+		_aligned_free(buf);
+		#else
+		free(buf);
+		#endif
+
+		buf = static_cast<float *>(new_buf);
+		capacity_entry_count = new_capacity_entry_count;
+	}
+
 	void neuron_value_set::add_entry(const float * new_data)
 	{
-		neuron_value_list.push_back(std::shared_ptr<std::vector<float> >(new std::vector<float>(neuron_count)));
-		memcpy(&neuron_value_list.back()->at(0), new_data, neuron_count * sizeof(float));
+		set_entry(entry_count, new_data);
 	}
 
 	void neuron_value_set::set_entry(
 		unsigned int entry_id,
 		const float * new_data)
 	{
-		if (neuron_value_list.size() <= entry_id)
+		if (entry_count <= entry_id)
+		{
+			if (capacity_entry_count <= entry_id)
+				reserve(std::max(entry_id + 1, capacity_entry_count * 2));
+			resize(entry_id + 1);
+		}
+		memcpy(get_entry(entry_id), new_data, neuron_count * sizeof(float));
+	}
+
+	neuron_value_set::neuron_value_list_view::neuron_value_list_view(const neuron_value_set& owner)
+		: owner(owner)
+	{
+	}
+
+	size_t neuron_value_set::neuron_value_list_view::size() const
+	{
+		return owner.get_entry_count();
+	}
+
+	bool neuron_value_set::neuron_value_list_view::empty() const
+	{
+		return (owner.get_entry_count() == 0);
+	}
+
+	std::shared_ptr<const std::vector<float> > neuron_value_set::neuron_value_list_view::operator [](size_t entry_id) const
+	{
+		const float * src = owner.get_entry(static_cast<unsigned int>(entry_id));
+		return std::shared_ptr<const std::vector<float> >(new std::vector<float>(src, src + owner.neuron_count));
+	}
+
+	neuron_value_set::neuron_value_list_view::operator std::vector<std::shared_ptr<const std::vector<float> > >() const
+	{
+		std::vector<std::shared_ptr<const std::vector<float> > > res;
+		for(unsigned int entry_id = 0; entry_id < owner.get_entry_count(); ++entry_id)
+			res.push_back((*this)[entry_id]);
+		return res;
+	}
+
+	unsigned int neuron_value_set::get_entry_count() const
+	{
+		return entry_count;
+	}
+
+	void neuron_value_set::resize(unsigned int new_entry_count)
+	{
+		if (new_entry_count > entry_count)
 		{
-			neuron_value_list.resize(entry_id + 1);
-			neuron_value_list[entry_id] = std::shared_ptr<std::vector<float> >(new std::vector<float>(neuron_count));
+			reserve(new_entry_count);
+			memset(buf + static_cast<size_t>(entry_count) * neuron_count, 0, static_cast<size_t>(new_entry_count - entry_count) * neuron_count * sizeof(float));
 		}
-		memcpy(&neuron_value_list[entry_id]->at(0), new_data, neuron_count * sizeof(float));
+		entry_count = new_entry_count;
+	}
+
+	float * neuron_value_set::get_entry(unsigned int entry_id)
+	{
+		return buf + static_cast<size_t>(entry_id) * neuron_count;
+	}
+
+	const float * neuron_value_set::get_entry(unsigned int entry_id) const
+	{
+		return buf + static_cast<size_t>(entry_id) * neuron_count;
 	}
 
 	std::shared_ptr<std::vector<double> > neuron_value_set::get_average() const
 	{
+		// Each chunk of entries is summed into its own row, rows are reduced in chunk order, so the result doesn't depend on timing
+		size_t min_entry_count_per_chunk = std::max(min_elem_count_per_thread / std::max(neuron_count, 1U), static_cast<size_t>(1));
+		std::vector<double> partial_sums(static_cast<size_t>(get_max_chunk_count(entry_count, min_entry_count_per_chunk)) * neuron_count, 0.0);
+		unsigned int chunk_count = run_parallel(
+			entry_count,
+			min_entry_count_per_chunk,
+			[this, &partial_sums] (unsigned int chunk_id, size_t start, size_t end)
+			{
+				double * sum = &partial_sums[0] + static_cast<size_t>(chunk_id) * neuron_count;
+				for(size_t entry_id = start; entry_id < end; ++entry_id)
+				{
+					const float * src = buf + entry_id * neuron_count;
+					for(unsigned int i = 0; i < neuron_count; ++i)
+						sum[i] += static_cast<double>(src[i]);
+				}
+			});
+
 		std::shared_ptr<std::vector<double> > res(new std::vector<double>(neuron_count, 0.0));
-		for(std::vector<std::shared_ptr<std::vector<float> > >::const_iterator it = neuron_value_list.begin(); it != neuron_value_list.end(); ++it)
+		double * dst = &res->at(0);
+		for(unsigned int chunk_id = 0; chunk_id < chunk_count; ++chunk_id)
 		{
-			std::shared_ptr<std::vector<float> > current_item = *it;
+			const double * sum = &partial_sums[0] + static_cast<size_t>(chunk_id) * neuron_count;
 			for(unsigned int i = 0; i < neuron_count; ++i)
-				res->at(i) += static_cast<double>(current_item->at(i));
+				dst[i] += sum[i];
 		}
 
-		double mult = 1.0 / static_cast<double>(neuron_value_list.size());
+		double mult = 1.0 / static_cast<double>(entry_count);
 		for(unsigned int i = 0; i < neuron_count; ++i)
-			res->at(i) *= mult;
+			dst[i] *= mult;
 
 		return res;
 	}
@@ -161,13 +296,16 @@ namespace nnforge
 		float alpha,
 		float beta)
 	{
-		for(unsigned int entry_id = 0; entry_id < neuron_value_list.size(); entry_id++)
-		{
-			const std::vector<float>& src = *other.neuron_value_list[entry_id];
-			std::vector<float>& dst = *neuron_value_list[entry_id];
-			for(unsigned int neuron_id = 0; neuron_id < neuron_count; ++neuron_id)
-				dst[neuron_id] = alpha * dst[neuron_id] + beta * src[neuron_id];
-		}
+		float * dst = buf;
+		const float * src = other.buf;
+		run_parallel(
+			static_cast<size_t>(entry_count) * neuron_count,
+			min_elem_count_per_thread,
+			[dst, src, alpha, beta] (unsigned int chunk_id, size_t start, size_t end)
+			{
+				for(size_t i = start; i < end; ++i)
+					dst[i] = alpha * dst[i] + beta * src[i];
+			});
 	}
 
 	void neuron_value_set::compact(unsigned int sample_count)
@@ -175,24 +313,62 @@ namespace nnforge
 		if (sample_count == 1)
 			return;
 
-		unsigned int new_entry_count = static_cast<unsigned int>(neuron_value_list.size() / sample_count);
-		if ((new_entry_count * sample_count) != neuron_value_list.size())
-			throw neural_network_exception((boost::format("neuron_value_set::compact cannot operate on %1% entries no evenly divisible by sample count %2%") % neuron_value_list.size() % sample_count).str());
+		unsigned int new_entry_count = entry_count / sample_count;
+		if ((new_entry_count * sample_count) != entry_count)
+			throw neural_network_exception((boost::format("neuron_value_set::compact cannot operate on %1% entries no evenly divisible by sample count %2%") % entry_count % sample_count).str());
 
+		// Destination entry i never overlaps source entries of the entries following it, so the block is compacted in place
 		float mult = 1.0F / static_cast<float>(sample_count);
+		std::vector<float> sum(neuron_count);
 		for(unsigned int dst_entry_id = 0; dst_entry_id < new_entry_count; ++dst_entry_id)
 		{
-			std::vector<float>& dst = *neuron_value_list[dst_entry_id];
-
-			for(unsigned int neuron_id = 0; neuron_id < neuron_count; ++neuron_id)
+			const float * src = get_entry(dst_entry_id * sample_count);
+			memcpy(&sum[0], src, neuron_count * sizeof(float));
+			for(unsigned int sample_id = 1; sample_id < sample_count; ++sample_id)
 			{
-				float sum = 0.0F;
-				for(unsigned int sample_id = 0; sample_id < sample_count; ++sample_id)
-					sum += neuron_value_list[dst_entry_id * sample_count + sample_id]->at(neuron_id);
-				dst[neuron_id] = mult * sum;
+				src += neuron_count;
+				for(unsigned int neuron_id = 0; neuron_id < neuron_count; ++neuron_id)
+					sum[neuron_id] += src[neuron_id];
 			}
+
+			float * dst = get_entry(dst_entry_id);
+			for(unsigned int neuron_id = 0; neuron_id < neuron_count; ++neuron_id)
+				dst[neuron_id] = mult * sum[neuron_id];
+		}
+
+		entry_count = new_entry_count;
+	}
+
+	unsigned int neuron_value_set::get_max_chunk_count(
+		size_t item_count,
+		size_t min_item_count_per_chunk)
+	{
+		size_t thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+		return static_cast<unsigned int>(std::max(std::min(thread_count, item_count / min_item_count_per_chunk), static_cast<size_t>(1)));
+	}
+
+	unsigned int neuron_value_set::run_parallel(
+		size_t item_count,
+		size_t min_item_count_per_chunk,
+		const std::function<void(unsigned int, size_t, size_t)>& func)
+	{
+		unsigned int chunk_count = get_max_chunk_count(item_count, min_item_count_per_chunk);
+		if (chunk_count == 1)
+		{
+			func(0, 0, item_count);
+			return 1;
+		}
+
+		std::vector<std::thread> thread_list;
+		for(unsigned int chunk_id = 0; chunk_id < chunk_count; ++chunk_id)
+		{
+			size_t start = item_count * chunk_id / chunk_count;
+			size_t end = item_count * (chunk_id + 1) / chunk_count;
+			thread_list.push_back(std::thread(func, chunk_id, start, end));
 		}
+		for(std::vector<std::thread>::iterator it = thread_list.begin(); it != thread_list.end(); ++it)
+			it->join();
 
-		neuron_value_list.resize(new_entry_count);
+		return chunk_count;
 	}
 }
@@ -20,9 +20,11 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <functional>
 
 namespace nnforge
 {
+	// All the entries are stored back to back in a single aligned buffer, which grows geometrically
 	class neuron_value_set
 	{
 	public:
@@ -35,6 +37,30 @@ namespace nnforge
 		typedef std::shared_ptr<neuron_value_set> ptr;
 		typedef std::shared_ptr<const neuron_value_set> const_ptr;
 
+		// Read-only view keeping the code written against the former per-entry list neuron_value_list working.
+		// Each access copies the entry, entries are const so code writing through the view fails to compile.
+		// New code should use get_entry_count and get_entry instead
+		class neuron_value_list_view
+		{
+		public:
+			neuron_value_list_view(const neuron_value_set& owner);
+
+			size_t size() const;
+
+			bool empty() const;
+
+			std::shared_ptr<const std::vector<float> > operator [](size_t entry_id) const;
+
+			operator std::vector<std::shared_ptr<const std::vector<float> > >() const;
+
+		private:
+			const neuron_value_set& owner;
+
+		private:
+			neuron_value_list_view(const neuron_value_list_view&) = delete;
+			neuron_value_list_view& operator =(const neuron_value_list_view&) = delete;
+		};
+
 		neuron_value_set(unsigned int neuron_count);
 
 		neuron_value_set(
@@ -48,12 +74,25 @@ namespace nnforge
 		neuron_value_set(
 			const std::vector<std::pair<neuron_value_set::const_ptr, float> >& source_neuron_value_set_list);
 
+		~neuron_value_set();
+
 		void add_entry(const float * new_data);
 
+		// Entries between the last one and entry_id, if any, are zero-filled
 		void set_entry(
 			unsigned int entry_id,
 			const float * new_data);
 
+		unsigned int get_entry_count() const;
+
+		// New entries, if any, are zero-filled
+		void resize(unsigned int new_entry_count);
+
+		// The pointer is invalidated when the set grows
+		float * get_entry(unsigned int entry_id);
+
+		const float * get_entry(unsigned int entry_id) const;
+
 		std::shared_ptr<std::vector<double> > get_average() const;
 
 		void add(
@@ -65,6 +104,32 @@ namespace nnforge
 
 	public:
 		unsigned int neuron_count;
-		std::vector<std::shared_ptr<std::vector<float> > > neuron_value_list;
+		const neuron_value_list_view neuron_value_list;
+
+	private:
+		void reserve(unsigned int new_capacity_entry_count);
+
+		// Splits [0, item_count) into contiguous chunks of at least min_item_count_per_chunk items,
+		// runs func(chunk_id, start, end) for each of them in a separate thread. Returns the number of chunks
+		static unsigned int run_parallel(
+			size_t item_count,
+			size_t min_item_count_per_chunk,
+			const std::function<void(unsigned int, size_t, size_t)>& func);
+
+		static unsigned int get_max_chunk_count(
+			size_t item_count,
+			size_t min_item_count_per_chunk);
+
+	private:
+		float * buf;
+		unsigned int entry_count;
+		unsigned int capacity_entry_count;
+
+		static const size_t alignment;
+		static const size_t min_elem_count_per_thread;
+
+	private:
+		neuron_value_set(const neuron_value_set&) = delete;
+		neuron_value_set& operator =(const neuron_value_set&) = delete;
 	};
 }
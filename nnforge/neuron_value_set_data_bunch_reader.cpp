@@ -41,11 +41,9 @@ namespace nnforge
 		for(std::map<std::string, float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
 		{
 			const std::pair<layer_configuration_specific, neuron_value_set::ptr>& nvs = layer_name_to_config_and_value_set_map.find(it->first)->second;
-			if (entry_id >= nvs.second->neuron_value_list.size())
+			if (entry_id >= nvs.second->get_entry_count())
 				return false;
-			std::shared_ptr<std::vector<float> > src_data = nvs.second->neuron_value_list[entry_id];
-			float * src_ptr = &src_data->at(0);
-			memcpy(it->second, src_ptr, nvs.first.get_neuron_count() * sizeof(float));
+			memcpy(it->second, nvs.second->get_entry(entry_id), nvs.first.get_neuron_count() * sizeof(float));
 		}
 		return true;
 	}
@@ -56,7 +54,7 @@ namespace nnforge
 
 	int neuron_value_set_data_bunch_reader::get_entry_count() const
 	{
-		return static_cast<int>(layer_name_to_config_and_value_set_map.begin()->second.second->neuron_value_list.size());
+		return static_cast<int>(layer_name_to_config_and_value_set_map.begin()->second.second->get_entry_count());
 	}
 
 	structured_data_bunch_reader::ptr neuron_value_set_data_bunch_reader::get_narrow_reader(const std::set<std::string>& layer_names) const
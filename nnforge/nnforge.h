@@ -54,13 +54,22 @@
 #include "rnd.h"
 
 #include "structured_data_stream_writer.h"
+#include "structured_data_mapped_reader.h"
+#include "structured_data_quantized_reader.h"
+#include "structured_data_quantized_stream_writer.h"
+#include "structured_data_sharded_reader.h"
+#include "sharded_dataset_index.h"
+#include "packed_network_data.h"
 #include "varying_data_stream_reader.h"
+#include "varying_data_mapped_reader.h"
 #include "varying_data_stream_writer.h"
 #include "structured_from_raw_data_reader.h"
 #include "structured_data_bunch_mix_reader.h"
+#include "structured_data_bunch_shared_reader.h"
 #include "neuron_value_set_data_bunch_reader.h"
 
 #include "data_transformer_util.h"
+#include "quantization_util.h"
 
 #include "convert_to_polar_data_transformer.h"
 #include "distort_2d_data_transformer.h"
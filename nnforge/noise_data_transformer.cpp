@@ -25,8 +25,6 @@ namespace nnforge
 {
 	noise_data_transformer::noise_data_transformer(float max_noise)
 	{
-		generator = rnd::get_random_generator();
-
 		max_noise_distribution = std::uniform_real_distribution<float>(-max_noise, max_noise);
 	}
 
@@ -35,19 +33,39 @@ namespace nnforge
 		float * data_transformed,
 		const layer_configuration_specific& original_config,
 		unsigned int sample_id)
+	{
+		counter_random_generator gen = rnd::get_counter_random_generator();
+		transform(data, data_transformed, original_config, sample_id, gen);
+	}
+
+	void noise_data_transformer::transform(
+		const float * data,
+		float * data_transformed,
+		const layer_configuration_specific& original_config,
+		unsigned int sample_id,
+		counter_random_generator& gen)
 	{
 		unsigned int elem_count = original_config.get_neuron_count();
 
+		for(unsigned int elem_id = 0; elem_id < elem_count; ++elem_id)
 		{
-			std::lock_guard<std::mutex> lock(gen_stream_mutex);
-
-			for(unsigned int elem_id = 0; elem_id < elem_count; ++elem_id)
-			{
-				float shift = max_noise_distribution.min();
-				if (max_noise_distribution.max() > max_noise_distribution.min())
-					shift = max_noise_distribution(generator);
-				data_transformed[elem_id] = data[elem_id] + shift;
-			}
+			float shift = max_noise_distribution.min();
+			if (max_noise_distribution.max() > max_noise_distribution.min())
+				shift = max_noise_distribution(gen);
+			data_transformed[elem_id] = data[elem_id] + shift;
 		}
 	}
+
+	bool noise_data_transformer::get_elementwise_affine_map(
+		const layer_configuration_specific& original_config,
+		counter_random_generator& gen,
+		elementwise_affine_map& map) const
+	{
+		map.apply_noise = (max_noise_distribution.max() > max_noise_distribution.min());
+		map.mult_list.assign(original_config.feature_map_count, 1.0F);
+		map.add_list.assign(original_config.feature_map_count, map.apply_noise ? 0.0F : max_noise_distribution.min());
+		map.noise_distribution = max_noise_distribution;
+
+		return true;
+	}
 }
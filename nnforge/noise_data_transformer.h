@@ -19,7 +19,6 @@
 #include "data_transformer.h"
 #include "rnd.h"
 
-#include <mutex>
 #include <random>
 
 namespace nnforge
@@ -36,11 +35,20 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual void transform(
+			const float * data,
+			float * data_transformed,
+			const layer_configuration_specific& original_config,
+			unsigned int sample_id,
+			counter_random_generator& gen);
+
+		virtual bool get_elementwise_affine_map(
+			const layer_configuration_specific& original_config,
+			counter_random_generator& gen,
+			elementwise_affine_map& map) const;
 			
 	protected:
-		random_generator generator;
-		std::mutex gen_stream_mutex;
-
 		std::uniform_real_distribution<float> max_noise_distribution;
 	};
 }
@@ -76,6 +76,26 @@ namespace nnforge
 			std::transform(data, data + elem_count_per_feature_map, data_transformed, [mul_add_it] (float x) { return x * mul_add_it->first + mul_add_it->second; });
 	}
 
+	bool normalize_data_transformer::get_elementwise_affine_map(
+		const layer_configuration_specific& original_config,
+		counter_random_generator& gen,
+		elementwise_affine_map& map) const
+	{
+		if (original_config.feature_map_count != mul_add_list.size())
+			throw neural_network_exception((boost::format("normalize_data_transformer was initialized with %1% feature maps and data provided has %2% feature maps") % mul_add_list.size() % original_config.feature_map_count).str());
+
+		map.mult_list.resize(mul_add_list.size());
+		map.add_list.resize(mul_add_list.size());
+		for(unsigned int feature_map_id = 0; feature_map_id < mul_add_list.size(); ++feature_map_id)
+		{
+			map.mult_list[feature_map_id] = mul_add_list[feature_map_id].first;
+			map.add_list[feature_map_id] = mul_add_list[feature_map_id].second;
+		}
+		map.apply_noise = false;
+
+		return true;
+	}
+
 	void normalize_data_transformer::write_proto(std::ostream& stream_to_write_to) const
 	{
 		protobuf::DataNormalizer normalizer;
@@ -40,6 +40,11 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual bool get_elementwise_affine_map(
+			const layer_configuration_specific& original_config,
+			counter_random_generator& gen,
+			elementwise_affine_map& map) const;
 			
 		void write_proto(std::ostream& stream_to_write_to) const;
 
@@ -0,0 +1,254 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "packed_network_data.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <boost/format.hpp>
+#include <set>
+#include <cstring>
+
+namespace nnforge
+{
+	// {6E0C3E7A-2F5B-4C1D-A8D4-93B1E05F7C62}
+	const boost::uuids::uuid packed_network_data::packed_network_data_guid =
+	{ 0x6e, 0x0c, 0x3e, 0x7a
+	, 0x2f, 0x5b
+	, 0x4c, 0x1d
+	, 0xa8, 0xd4
+	, 0x93, 0xb1, 0xe0, 0x5f, 0x7c, 0x62 };
+
+	const size_t packed_network_data::alignment = 64;
+
+	const char * packed_network_data::file_extension = ".nnd";
+
+	namespace
+	{
+		unsigned long long align_offset(unsigned long long offset, size_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		class header_cursor
+		{
+		public:
+			header_cursor(
+				const unsigned char * begin,
+				size_t size,
+				const boost::filesystem::path& file_path)
+				: begin(begin)
+				, size(size)
+				, offset(0)
+				, file_path(file_path)
+			{
+			}
+
+			const unsigned char * read(size_t byte_count)
+			{
+				if (size - offset < byte_count)
+					throw neural_network_exception((boost::format("Unexpected end of header in packed network data %1%") % file_path.string()).str());
+				const unsigned char * res = begin + offset;
+				offset += byte_count;
+				return res;
+			}
+
+			template<typename value_type>
+			value_type read_value()
+			{
+				value_type res;
+				memcpy(&res, read(sizeof(value_type)), sizeof(value_type));
+				return res;
+			}
+
+		private:
+			const unsigned char * begin;
+			size_t size;
+			size_t offset;
+			const boost::filesystem::path& file_path;
+		};
+	}
+
+	packed_network_data::packed_network_data(const boost::filesystem::path& file_path)
+	{
+		if (!boost::filesystem::exists(file_path) || !boost::filesystem::is_regular_file(file_path))
+			throw neural_network_exception((boost::format("Packed network data %1% doesn't exist") % file_path.string()).str());
+
+		mapping = boost::interprocess::file_mapping(file_path.string().c_str(), boost::interprocess::read_only);
+		region = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only);
+		const unsigned char * begin = static_cast<const unsigned char *>(region.get_address());
+		size_t size = region.get_size();
+
+		header_cursor cursor(begin, size, file_path);
+
+		boost::uuids::uuid guid_read;
+		memcpy(guid_read.data, cursor.read(sizeof(guid_read.data)), sizeof(guid_read.data));
+		if (guid_read != packed_network_data_guid)
+			throw neural_network_exception((boost::format("Unknown packed network data GUID encountered in %1%: %2%") % file_path.string() % guid_read).str());
+
+		unsigned int layer_count = cursor.read_value<unsigned int>();
+		for(unsigned int layer_id = 0; layer_id < layer_count; ++layer_id)
+		{
+			unsigned int name_length = cursor.read_value<unsigned int>();
+			const unsigned char * name = cursor.read(name_length);
+			std::string instance_name(reinterpret_cast<const char *>(name), name_length);
+
+			layer_location& location = instance_name_to_location_map[instance_name];
+			location.part_list.resize(cursor.read_value<unsigned int>());
+			location.custom_part_list.resize(cursor.read_value<unsigned int>());
+			for(int i = 0; i < 2; ++i)
+			{
+				std::vector<part_location>& part_list = (i == 0) ? location.part_list : location.custom_part_list;
+				for(std::vector<part_location>::iterator it = part_list.begin(); it != part_list.end(); ++it)
+				{
+					it->offset = cursor.read_value<unsigned long long>();
+					it->elem_count = cursor.read_value<unsigned long long>();
+					if ((it->offset % alignment != 0) || (it->offset > size) || ((size - it->offset) / sizeof(float) < it->elem_count))
+						throw neural_network_exception((boost::format("Part of layer %1% is out of bounds in packed network data %2%") % instance_name % file_path.string()).str());
+				}
+			}
+		}
+
+		region.advise(boost::interprocess::mapped_region::advice_sequential);
+	}
+
+	bool packed_network_data::is_packed(const boost::filesystem::path& file_path)
+	{
+		if (!boost::filesystem::is_regular_file(file_path))
+			return false;
+
+		boost::filesystem::ifstream in(file_path, std::ios_base::in | std::ios_base::binary);
+		boost::uuids::uuid guid_read;
+		in.read(reinterpret_cast<char*>(guid_read.data), sizeof(guid_read.data));
+		return in && (guid_read == packed_network_data_guid);
+	}
+
+	void packed_network_data::write(
+		const network_data& data,
+		const boost::filesystem::path& file_path)
+	{
+		std::vector<std::string> data_name_list = data.data_list.get_data_layer_name_list();
+		std::vector<std::string> data_custom_name_list = data.data_custom_list.get_data_custom_layer_name_list();
+		std::set<std::string> instance_name_set(data_name_list.begin(), data_name_list.end());
+		instance_name_set.insert(data_custom_name_list.begin(), data_custom_name_list.end());
+
+		std::vector<std::pair<layer_data::const_ptr, layer_data_custom::const_ptr> > layer_list;
+		unsigned long long header_size = sizeof(packed_network_data_guid.data) + sizeof(unsigned int);
+		for(std::set<std::string>::const_iterator it = instance_name_set.begin(); it != instance_name_set.end(); ++it)
+		{
+			layer_data::const_ptr d = data.data_list.find(*it);
+			layer_data_custom::const_ptr dc = data.data_custom_list.find(*it);
+			layer_list.push_back(std::make_pair(d, dc));
+			size_t part_count = (d ? d->size() : 0) + (dc ? dc->size() : 0);
+			header_size += sizeof(unsigned int) + it->length() + sizeof(unsigned int) * 2 + part_count * sizeof(unsigned long long) * 2;
+		}
+
+		// Parts are laid out in the same order they are listed in the header
+		std::vector<std::pair<const void *, unsigned long long> > part_list;
+		std::vector<unsigned long long> part_offset_list;
+		unsigned long long offset = header_size;
+		for(std::vector<std::pair<layer_data::const_ptr, layer_data_custom::const_ptr> >::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
+		{
+			if (it->first)
+				for(layer_data::const_iterator it2 = it->first->begin(); it2 != it->first->end(); ++it2)
+					part_list.push_back(std::make_pair(static_cast<const void *>(it2->data()), static_cast<unsigned long long>(it2->size())));
+			if (it->second)
+				for(layer_data_custom::const_iterator it2 = it->second->begin(); it2 != it->second->end(); ++it2)
+					part_list.push_back(std::make_pair(static_cast<const void *>(it2->data()), static_cast<unsigned long long>(it2->size())));
+		}
+		for(std::vector<std::pair<const void *, unsigned long long> >::const_iterator it = part_list.begin(); it != part_list.end(); ++it)
+		{
+			offset = align_offset(offset, alignment);
+			part_offset_list.push_back(offset);
+			offset += it->second * sizeof(float);
+		}
+
+		boost::filesystem::path temp_file_path = file_path;
+		temp_file_path += ".tmp";
+		{
+			boost::filesystem::ofstream out(temp_file_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			out.exceptions(std::ostream::eofbit | std::ostream::failbit | std::ostream::badbit);
+
+			out.write(reinterpret_cast<const char*>(packed_network_data_guid.data), sizeof(packed_network_data_guid.data));
+			unsigned int layer_count = static_cast<unsigned int>(layer_list.size());
+			out.write(reinterpret_cast<const char*>(&layer_count), sizeof(layer_count));
+			unsigned int part_id = 0;
+			std::set<std::string>::const_iterator name_it = instance_name_set.begin();
+			for(std::vector<std::pair<layer_data::const_ptr, layer_data_custom::const_ptr> >::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it, ++name_it)
+			{
+				unsigned int name_length = static_cast<unsigned int>(name_it->length());
+				out.write(reinterpret_cast<const char*>(&name_length), sizeof(name_length));
+				out.write(name_it->data(), name_length);
+				unsigned int layer_part_count = it->first ? static_cast<unsigned int>(it->first->size()) : 0;
+				unsigned int layer_custom_part_count = it->second ? static_cast<unsigned int>(it->second->size()) : 0;
+				out.write(reinterpret_cast<const char*>(&layer_part_count), sizeof(layer_part_count));
+				out.write(reinterpret_cast<const char*>(&layer_custom_part_count), sizeof(layer_custom_part_count));
+				for(unsigned int i = 0; i < layer_part_count + layer_custom_part_count; ++i, ++part_id)
+				{
+					out.write(reinterpret_cast<const char*>(&part_offset_list[part_id]), sizeof(unsigned long long));
+					out.write(reinterpret_cast<const char*>(&part_list[part_id].second), sizeof(unsigned long long));
+				}
+			}
+
+			const char padding[64] = { 0 };
+			offset = header_size;
+			for(part_id = 0; part_id < static_cast<unsigned int>(part_list.size()); ++part_id)
+			{
+				out.write(padding, static_cast<std::streamsize>(part_offset_list[part_id] - offset));
+				out.write(static_cast<const char*>(part_list[part_id].first), static_cast<std::streamsize>(part_list[part_id].second * sizeof(float)));
+				offset = part_offset_list[part_id] + part_list[part_id].second * sizeof(float);
+			}
+		}
+
+		boost::filesystem::rename(temp_file_path, file_path);
+	}
+
+	network_data::ptr packed_network_data::get_network_data() const
+	{
+		network_data::ptr res(new network_data());
+
+		const unsigned char * begin = static_cast<const unsigned char *>(region.get_address());
+		for(std::map<std::string, layer_location>::const_iterator it = instance_name_to_location_map.begin(); it != instance_name_to_location_map.end(); ++it)
+		{
+			if (!it->second.part_list.empty())
+			{
+				layer_data::ptr d(new layer_data());
+				for(std::vector<part_location>::const_iterator it2 = it->second.part_list.begin(); it2 != it->second.part_list.end(); ++it2)
+				{
+					const float * part = reinterpret_cast<const float *>(begin + it2->offset);
+					d->push_back(std::vector<float>(part, part + it2->elem_count));
+				}
+				res->data_list.add(it->first, d);
+			}
+
+			if (!it->second.custom_part_list.empty())
+			{
+				layer_data_custom::ptr d(new layer_data_custom());
+				for(std::vector<part_location>::const_iterator it2 = it->second.custom_part_list.begin(); it2 != it->second.custom_part_list.end(); ++it2)
+				{
+					const int * part = reinterpret_cast<const int *>(begin + it2->offset);
+					d->push_back(std::vector<int>(part, part + it2->elem_count));
+				}
+				res->data_custom_list.add(it->first, d);
+			}
+		}
+
+		return res;
+	}
+}
@@ -0,0 +1,84 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "network_data.h"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <memory>
+#include <map>
+#include <vector>
+#include <string>
+
+namespace nnforge
+{
+	// network_data packed into a single file: the header with layer names and part offsets followed by the parts,
+	// each part starting at a 64-byte aligned offset. The file is read through a read-only memory mapping,
+	// the parts are copied out of it into network_data
+	class packed_network_data
+	{
+	public:
+		typedef std::shared_ptr<packed_network_data> ptr;
+		typedef std::shared_ptr<const packed_network_data> const_ptr;
+
+		packed_network_data(const boost::filesystem::path& file_path);
+
+		~packed_network_data() = default;
+
+		// The file is written through a temporary file which is then renamed
+		static void write(
+			const network_data& data,
+			const boost::filesystem::path& file_path);
+
+		// Returns true if the path is a regular file starting with the packed network data GUID
+		static bool is_packed(const boost::filesystem::path& file_path);
+
+		// Copies the parts from the mapping
+		network_data::ptr get_network_data() const;
+
+	public:
+		static const char * file_extension;
+
+	private:
+		struct part_location
+		{
+			unsigned long long offset;
+			unsigned long long elem_count;
+		};
+
+		struct layer_location
+		{
+			std::vector<part_location> part_list;
+			std::vector<part_location> custom_part_list;
+		};
+
+	private:
+		boost::interprocess::file_mapping mapping;
+		boost::interprocess::mapped_region region;
+		std::map<std::string, layer_location> instance_name_to_location_map;
+
+		static const boost::uuids::uuid packed_network_data_guid;
+		static const size_t alignment;
+
+	private:
+		packed_network_data(const packed_network_data&) = delete;
+		packed_network_data& operator =(const packed_network_data&) = delete;
+	};
+}
@@ -17,7 +17,9 @@
 #include "add_layer_tester_plain.h"
 
 #include "../add_layer.h"
+#include "simd_kernels_plain.h"
 
+#include <algorithm>
 #include <cstring>
 
 namespace nnforge
@@ -51,13 +53,22 @@ namespace nnforge
 			const float alpha = layer_derived->alpha;
 			const int src_ptr_count = static_cast<int>(in_list.size());
 			const int elem_count = static_cast<int>(entry_count * output_configuration_specific.get_neuron_count());
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+			const int chunk_size = simd_kernels_plain::elementwise_chunk_elem_count;
+			const int chunk_count = (elem_count + chunk_size - 1) / chunk_size;
+
+			#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
 			{
-				float sum = 0.0F;
-				for(int j = 0; j < src_ptr_count; ++j)
-					sum += in_ptr_list[j][i];
-				out[i] = sum * alpha;
+				std::vector<const float *> chunk_in_list(src_ptr_count);
+
+				#pragma omp for schedule(guided)
+				for(int chunk_id = 0; chunk_id < chunk_count; ++chunk_id)
+				{
+					int start = chunk_id * chunk_size;
+					for(int j = 0; j < src_ptr_count; ++j)
+						chunk_in_list[j] = in_ptr_list[j] + start;
+					kernels.sum_scaled(out + start, &chunk_in_list[0], src_ptr_count, std::min(chunk_size, elem_count - start), alpha);
+				}
 			}
 		}
 
@@ -17,8 +17,14 @@
 #include "average_subsampling_layer_tester_plain.h"
 
 #include "../average_subsampling_layer.h"
+#include "simd_kernels_plain.h"
 
 #include <array>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace nnforge
 {
@@ -100,14 +106,30 @@ namespace nnforge
 				}
 			}
 
+			// The window is reduced in two steps: whole rows along the 1st dimension are summed with vector kernels
+			// into a per-thread buffer first, then each output neuron sums its few neighbouring elements of that buffer
+			const unsigned int row_window_size = subsampling_sizes[0];
+			const unsigned int window_row_count = const_subsampling_elem_count / row_window_size;
+			const unsigned int output_row_elem_count = output_dimension_sizes[0];
+			const int row_elem_count = static_cast<int>(output_row_elem_count * row_window_size);
+			const unsigned int row_buffer_elem_count = input_dimension_sizes[0];
+			float * const row_buffers = *temporary_working_fixed_buffer;
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+
 			const int total_workload = entry_count * output_configuration_specific.feature_map_count;
 			const std::vector<unsigned int>::const_iterator dimension_sizes_it = output_dimension_sizes.begin();
 			const std::vector<unsigned int>::const_iterator subsampling_sizes_it = subsampling_sizes.begin();
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
 			{
+				int thread_id = 0;
+				#ifdef _OPENMP
+				thread_id = omp_get_thread_num();
+				#endif
+
+				float * const row_buffer = row_buffers + thread_id * row_buffer_elem_count;
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
 				#pragma omp for schedule(guided)
@@ -120,23 +142,30 @@ namespace nnforge
 					float * out_it_base = out_it_global + (output_entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
 
 					std::fill_n(current_output_position.begin(), spatial_dimension_count, 0);
-					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it)
+					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; out_it += output_row_elem_count)
 					{
-						// Define the starting position of the first input elem
+						// Define the starting position of the first input elem of the row
 						int in_it_offset = 0;
 
-						for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+						for(unsigned int i = 1; i < spatial_dimension_count; ++i)
 							in_it_offset += current_output_position[i] * (*(subsampling_sizes_it + i)) * (*(input_slices_it + i));
 
-						float sum = 0.0F;
-						for(unsigned int i = 0; i < const_subsampling_elem_count; ++i)
+						const float * in_it = in_it_base + in_it_offset;
+						std::copy(in_it, in_it + row_elem_count, row_buffer);
+						for(unsigned int window_row_id = 1; window_row_id < window_row_count; ++window_row_id)
+							kernels.add_accumulate(row_buffer, in_it + (*(offset_list_it + window_row_id * row_window_size)), row_elem_count);
+
+						for(unsigned int x = 0; x < output_row_elem_count; ++x)
 						{
-							sum += *(in_it_base + (in_it_offset + (*(offset_list_it + i))));
+							const float * window_it = row_buffer + x * row_window_size;
+							float sum = 0.0F;
+							for(unsigned int i = 0; i < row_window_size; ++i)
+								sum += window_it[i];
+							out_it[x] = sum * mult;
 						}
-						*out_it = sum * mult;
 
-						// Go to the next output element
-						for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+						// Go to the next output row
+						for(unsigned int i = 1; i < spatial_dimension_count; ++i)
 						{
 							if ((++current_output_position[i]) < *( dimension_sizes_it + i))
 								break;
@@ -146,5 +175,16 @@ namespace nnforge
 				}
 			}
 		}
+
+		size_t average_subsampling_layer_tester_plain::get_temporary_working_fixed_buffer_size(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			// A row of partially reduced windows per thread
+			unsigned int row_elem_count = input_configuration_specific_list[0].dimension_sizes.empty() ? 1 : input_configuration_specific_list[0].dimension_sizes[0];
+			return row_elem_count * plain_config->openmp_thread_count * sizeof(float);
+		}
 	}
 }
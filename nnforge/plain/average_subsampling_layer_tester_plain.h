@@ -44,6 +44,12 @@ namespace nnforge
 				const layer_configuration_specific& output_configuration_specific,
 				unsigned int entry_count) const;
 
+			virtual size_t get_temporary_working_fixed_buffer_size(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 		private:
 			static const int max_dimension_count;
 		};
@@ -17,11 +17,16 @@
 #include "backward_propagation_plain.h"
 
 #include "layer_updater_plain_factory.h"
+#include "data_pipeline_plain.h"
+#include "simd_kernels_plain.h"
+#include "convolution_winograd_plain.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <chrono>
+#include <algorithm>
+#include <cmath>
 
 #include "../neural_network_exception.h"
 
@@ -40,6 +45,8 @@ namespace nnforge
 			: backward_propagation(schema, output_layer_names, error_source_layer_names, exclude_data_update_layer_names, debug, profile)
 			, plain_config(plain_config)
 			, temporary_working_fixed_size(0)
+			, arena(plain_config->use_huge_pages)
+			, worker_id(0)
 		{
 			actions_in_execution_order = action_schema->get_actions_in_execution_order();
 
@@ -95,12 +102,17 @@ namespace nnforge
 			float& idle_seconds)
 		{
 			std::map<std::string, std::vector<double> > updates_accumulated;
+			std::map<std::string, size_t> weight_count_map;
 			std::vector<std::string> data_layer_list = data.data_list.get_data_layer_name_list();
 			for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
 			{
 				const std::string& layer_name = *it;
 				layer_data::ptr d = data.data_list.get(layer_name);
 				updates_accumulated.insert(std::make_pair(layer_name, std::vector<double>(d->size(), 0.0)));
+				size_t weight_count = 0;
+				for(layer_data::const_iterator it2 = d->begin(); it2 != d->end(); ++it2)
+					weight_count += it2->size();
+				weight_count_map.insert(std::make_pair(layer_name, weight_count));
 			}
 
 			std::vector<layer::const_ptr> layer_list;
@@ -148,12 +160,30 @@ namespace nnforge
 			if (max_entry_count == 0)
 				throw neural_network_exception("Insufficient memory to do forward-backward prop for even one sample");
 
+			// Workers sum their slices of the batch and of the entry count, so that all of them see the same batches
+			unsigned int global_batch_size = batch_size;
+			int epoch_entry_count = reader.get_entry_count();
+			if (communicator)
+			{
+				double counts[2] = {static_cast<double>(batch_size), static_cast<double>(epoch_entry_count)};
+				communicator->reduce_all("batch_size", worker_id, counts, 2);
+				global_batch_size = static_cast<unsigned int>(counts[0]);
+				if (epoch_entry_count >= 0)
+					epoch_entry_count = static_cast<int>(counts[1]);
+			}
+
+			// Workers split their slices into the same number of chunks, as each chunk is a collective step
+			unsigned int max_batch_slice_size = batch_size;
+			if (communicator)
+				max_batch_slice_size = (global_batch_size + communicator->get_worker_count() - 1) / communicator->get_worker_count();
 			std::vector<unsigned int> entry_read_count_list;
-			if (batch_size <= max_entry_count)
+			if (max_batch_slice_size <= max_entry_count)
 				entry_read_count_list.push_back(batch_size);
 			else
 			{
-				unsigned int chunk_count = (batch_size + max_entry_count - 1) / max_entry_count;
+				unsigned int chunk_count = (max_batch_slice_size + max_entry_count - 1) / max_entry_count;
+				if (chunk_count > batch_size)
+					throw neural_network_exception((boost::format("Batch slice of %1% entries cannot be split into %2% chunks") % batch_size % chunk_count).str());
 				unsigned int chunk_min_size = batch_size / chunk_count;
 				unsigned int plus1_chunk_count = batch_size % chunk_count;
 				entry_read_count_list.resize(chunk_count);
@@ -175,24 +205,32 @@ namespace nnforge
 			}
 			unsigned int max_chunk_size = *std::max_element(entry_read_count_list.begin(), entry_read_count_list.end());
 
-			std::map<std::string, plain_buffer::ptr> dedicated_buffers;
-			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
-				dedicated_buffers.insert(std::make_pair(it->first, plain_buffer::ptr(new plain_buffer(it->second * max_chunk_size))));
+			arena.reset(buffer_config_without_data_and_momentum, max_chunk_size);
+
+			data_pipeline_plain pipeline(
+				reader,
+				writer,
+				plain_config,
+				arena,
+				dedicated_per_entry_data_name_to_size_map,
+				data_layer_names,
+				output_layer_names,
+				output_layers_tiling_factor,
+				max_chunk_size);
 
 			plain_buffer::ptr temporary_working_fixed_buffer;
 			if (temporary_working_fixed_size > 0)
-				temporary_working_fixed_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
+				temporary_working_fixed_buffer = arena.allocate(temporary_working_fixed_size);
 
 			std::vector<plain_buffer::ptr> layer_buffers;
 			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
-				layer_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * max_chunk_size)));
+				layer_buffers.push_back(arena.allocate(*it * max_chunk_size));
 
 			unsigned int base_iteration_count = 0;
 			if (momentum.type == training_momentum::adam_momentum)
 			{
-				int epoch_entry_count = reader.get_entry_count();
 				if (epoch_entry_count >= 0)
-					base_iteration_count = epoch_id * ((epoch_entry_count + batch_size - 1) / batch_size);
+					base_iteration_count = epoch_id * ((epoch_entry_count + global_batch_size - 1) / global_batch_size);
 				else
 					throw neural_network_exception("Training data reader doesn't report entry_count, which is required for ADAM momentum");
 			}
@@ -202,34 +240,45 @@ namespace nnforge
 			unsigned int gradient_accumulated_entry_count = 0;
 			unsigned int gradient_applied_count = 0;
 			double total_idel_sec = 0.0;
+			std::map<layer_name_with_action, double> action_seconds_accumulated;
+			double total_update_sec = 0.0;
+			double updated_weight_count = 0.0;
+
+			// Chunks read ahead follow the same cyclic order of sizes
+			unsigned int chunk_to_read_index = 0;
+			for(unsigned int i = 0; i < plain_config->pipeline_depth; ++i)
+			{
+				pipeline.start_read(entry_read_count_list[chunk_to_read_index]);
+				chunk_to_read_index = (chunk_to_read_index + 1) % entry_read_count_list.size();
+			}
 
 			while(true)
 			{
 				const int current_max_entry_count_const = entry_read_count_list[chunk_index];
-				int entry_read_count = 0;
+				std::map<std::string, plain_buffer::ptr> dedicated_buffers;
 				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
-				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count) reduction(+:entry_read_count)
-				{
-					#pragma omp for schedule(dynamic)
-					for(int entry_id = 0; entry_id < current_max_entry_count_const; ++entry_id)
-					{
-						std::map<std::string, float *> data_map;
-						for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
-							data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float))));
-						if (reader.read(entry_processed_count + entry_id, data_map))
-							++entry_read_count;
-					}
-				}
+				int entry_read_count = static_cast<int>(pipeline.wait_read(dedicated_buffers));
 				std::chrono::duration<double> idle_sec = std::chrono::high_resolution_clock::now() - start;
 				total_idel_sec += idle_sec.count();
 
-				if (entry_read_count == 0)
+				unsigned int global_entry_read_count = static_cast<unsigned int>(entry_read_count);
+				bool is_last_chunk = (entry_read_count < current_max_entry_count_const);
+				if (communicator)
+				{
+					// A worker might run out of entries while others still have some, it takes part in weight updates then
+					double counts[2] = {static_cast<double>(entry_read_count), static_cast<double>(current_max_entry_count_const)};
+					communicator->reduce_all("entry_read_count", worker_id, counts, 2);
+					global_entry_read_count = static_cast<unsigned int>(counts[0]);
+					is_last_chunk = (counts[0] < counts[1]);
+				}
+
+				if (global_entry_read_count == 0)
 					break;
 
-				gradient_accumulated_entry_count += entry_read_count;
+				gradient_accumulated_entry_count += global_entry_read_count;
 				bool is_apply_gradient = false;
 				float gradient_normalizer;
-				if (gradient_accumulated_entry_count >= batch_size)
+				if (gradient_accumulated_entry_count >= global_batch_size)
 				{
 					is_apply_gradient = true;
 					gradient_normalizer = 1.0F / static_cast<float>(gradient_accumulated_entry_count);
@@ -247,6 +296,8 @@ namespace nnforge
 					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 					layer_action action = current_layer_name_with_action.get_action();
+					if ((entry_read_count == 0) && (action.get_action_type() != layer_action::update_weights))
+						continue;
 					layer::const_ptr current_layer = schema->find_layer(layer_name);
 					const std::set<layer_action>& actions = layer_name_to_action_set_map[layer_name];
 					unsigned int tiling_factor = cumulative_tiling_factor_map[layer_name];
@@ -258,6 +309,7 @@ namespace nnforge
 							temporary_working_per_entry_buffer = layer_buffers[it->second];
 					}
 
+					std::chrono::high_resolution_clock::time_point action_start = std::chrono::high_resolution_clock::now();
 					switch (action.get_action_type())
 					{
 					case layer_action::forward:
@@ -373,6 +425,75 @@ namespace nnforge
 								entry_read_count * tiling_factor);
 						}
 						break;
+					case layer_action::backward_data_and_weights:
+						{
+							plain_buffer::ptr output_buffer = layer_buffers[layer_buffer_action_to_set_map[current_layer_name_with_action]];
+
+							std::vector<plain_buffer::const_ptr> input_neurons_buffers;
+							unsigned int data_input_index = 0;
+							for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it, ++data_input_index)
+							{
+								if (updaters[layer_name]->is_backward_data_and_weights_dependent_on_input_buffer(data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+								{
+									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
+									if (it != layer_buffer_action_to_set_map.end())
+										input_neurons_buffers.push_back(layer_buffers[it->second]);
+									else
+										input_neurons_buffers.push_back(dedicated_buffers[*input_layer_name_it]);
+								}
+								else
+									input_neurons_buffers.push_back(plain_buffer::const_ptr());
+							}
+
+							plain_buffer::ptr temporary_per_entry_buffer;
+							{
+								if (updaters[layer_name]->is_backward_data_and_weights_dependent_on_temporary_per_entry_buffer(actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+								{
+									std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
+									if (it != temporary_per_entry_data_action_to_set_map.end())
+										temporary_per_entry_buffer = layer_buffers[it->second];
+								}
+							}
+
+							plain_buffer::const_ptr output_neurons_buffer;
+							{
+								if (updaters[layer_name]->is_backward_data_and_weights_dependent_on_output_buffer(actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+								{
+									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
+									if (it != layer_buffer_action_to_set_map.end())
+										output_neurons_buffer = layer_buffers[it->second];
+									else
+										output_neurons_buffer = dedicated_buffers[layer_name];
+								}
+							}
+
+							plain_buffer::const_ptr output_errors_buffer;
+							{
+								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator it = gradient_to_producing_actions_map.find(layer_name);
+								if (it != gradient_to_producing_actions_map.end())
+									output_errors_buffer = layer_buffers[layer_buffer_action_to_set_map[it->second.front()]];
+							}
+
+							updaters.find(layer_name)->second->run_backward_data_and_weights_propagation(
+								output_buffer,
+								output_errors_buffer,
+								input_neurons_buffers,
+								output_neurons_buffer,
+								temporary_working_fixed_buffer,
+								temporary_working_per_entry_buffer,
+								temporary_per_entry_buffer,
+								plain_config,
+								current_layer,
+								data.data_list.find(layer_name),
+								gradient->find(layer_name),
+								data.data_custom_list.find(layer_name),
+								input_layer_configuration_specific_list,
+								output_layer_configuration_specific,
+								add_output_actions.find(current_layer_name_with_action) != add_output_actions.end(),
+								actions,
+								entry_read_count * tiling_factor);
+						}
+						break;
 					case layer_action::backward_weights:
 						{
 							std::vector<plain_buffer::const_ptr> input_neurons_buffers;
@@ -434,6 +555,7 @@ namespace nnforge
 								layer_data::ptr previous_upd2;
 								if (momentum.is_momentum_data2())
 									previous_upd2 = momentum_data2->data_list.find(layer_name);
+								std::chrono::high_resolution_clock::time_point update_start = std::chrono::high_resolution_clock::now();
 								apply_gradient(
 									layer_name,
 									data.data_list.find(layer_name),
@@ -446,34 +568,47 @@ namespace nnforge
 									weight_decay,
 									momentum,
 									base_iteration_count + gradient_applied_count);
+								std::chrono::duration<double> update_sec = std::chrono::high_resolution_clock::now() - update_start;
+								total_update_sec += update_sec.count();
+								updated_weight_count += static_cast<double>(weight_count_map[layer_name]);
 							}
 						}
 						break;
 					}
+					std::chrono::duration<double> action_sec = std::chrono::high_resolution_clock::now() - action_start;
+					action_seconds_accumulated.insert(std::make_pair(current_layer_name_with_action, 0.0)).first->second += action_sec.count();
 				}
 
-				for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
-				{
-					std::map<std::string, const float *> data_map;
-					for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
-						data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float) / output_layers_tiling_factor)));
-					writer.write(entry_processed_count + entry_id, data_map);
-				}
+				start = std::chrono::high_resolution_clock::now();
+				pipeline.start_write(entry_read_count);
+				idle_sec = std::chrono::high_resolution_clock::now() - start;
+				total_idel_sec += idle_sec.count();
 
 				entry_processed_count += entry_read_count;
 				chunk_index = (chunk_index + 1) % entry_read_count_list.size();
 
-				if (entry_read_count < current_max_entry_count_const)
+				if (is_last_chunk)
 					break;
+
+				pipeline.start_read(entry_read_count_list[chunk_to_read_index]);
+				chunk_to_read_index = (chunk_to_read_index + 1) % entry_read_count_list.size();
+			}
+
+			{
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				pipeline.finish_write();
+				std::chrono::duration<double> idle_sec = std::chrono::high_resolution_clock::now() - start;
+				total_idel_sec += idle_sec.count();
 			}
 
 			if (gradient_accumulated_entry_count > 0)
 			{
-				float gradient_normalizer = 1.0F / static_cast<float>(batch_size);
+				float gradient_normalizer = 1.0F / static_cast<float>(global_batch_size);
 				gradient_applied_count++;
 				for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
 				{
 					const std::string& layer_name = it->first;
+					std::chrono::high_resolution_clock::time_point action_start = std::chrono::high_resolution_clock::now();
 					layer_data::ptr previous_upd;
 					if (momentum.is_momentum_data())
 						previous_upd = momentum_data->data_list.find(layer_name);
@@ -492,6 +627,12 @@ namespace nnforge
 						weight_decay,
 						momentum,
 						base_iteration_count + gradient_applied_count);
+					std::chrono::duration<double> action_sec = std::chrono::high_resolution_clock::now() - action_start;
+					total_update_sec += action_sec.count();
+					updated_weight_count += static_cast<double>(weight_count_map[layer_name]);
+					std::map<layer_name_with_action, double>::iterator seconds_it = action_seconds_accumulated.find(layer_name_with_action(layer_name, layer_action::update_weights));
+					if (seconds_it != action_seconds_accumulated.end())
+						seconds_it->second += action_sec.count();
 				}
 			}
 
@@ -506,8 +647,17 @@ namespace nnforge
 						f.push_back(static_cast<float>(*it2) * mult / static_cast<float>(it_data->size()));
 				}
 			}
+			if (profile->is_profile() && (updated_weight_count > 0.0))
+			{
+				std::stringstream profile_str;
+				profile_str << (boost::format("plain weight update: %|1$.3f| ms per million weights, %|2$.0f| weights updated in %|3$.3f| seconds") % (total_update_sec * 1.0e+9 / updated_weight_count) % updated_weight_count % total_update_sec).str();
+				profile->output_message(profile_str.str().c_str());
+			}
+
 			entries_processed = entry_processed_count;
 			action_seconds.clear();
+			for(std::map<layer_name_with_action, double>::const_iterator it = action_seconds_accumulated.begin(); it != action_seconds_accumulated.end(); ++it)
+				action_seconds.insert(std::make_pair(it->first, static_cast<float>(it->second)));
 			idle_seconds = static_cast<float>(total_idel_sec);
 		}
 
@@ -520,6 +670,27 @@ namespace nnforge
 			setup_temporary_working_fixed_buffer_sizes();
 
 			update_buffer_config();
+
+			if (debug->is_debug())
+			{
+				for(std::map<std::string, std::set<layer_action> >::const_iterator it = layer_name_to_action_set_map.begin(); it != layer_name_to_action_set_map.end(); ++it)
+				{
+					std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(schema->get_layer(it->first));
+					if ((!layer_derived) || (!convolution_winograd_plain::is_applicable(layer_derived)))
+						continue;
+					for(std::set<layer_action>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+					{
+						if ((it2->get_action_type() == layer_action::forward) || (it2->get_action_type() == layer_action::backward_data))
+							convolution_winograd_plain::check_against_gemm(
+								debug,
+								plain_config,
+								layer_derived,
+								layer_config_map[layer_derived->input_layer_instance_names.front()],
+								layer_config_map[it->first],
+								it2->get_action_type() == layer_action::backward_data);
+					}
+				}
+			}
 		}
 
 		void backward_propagation_plain::setup_dedicated_buffer_sizes()
@@ -606,6 +777,15 @@ namespace nnforge
 								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
 							}
 							break;
+						case layer_action::backward_data_and_weights:
+							{
+								if (schema->get_layer(layer_name)->input_layer_instance_names.size() != 1)
+									throw neural_network_exception((boost::format("setup_layer_buffer_sizes cannot handle multiple output buffers for action %1% for layer %2%") % it->get_action().str() % it->get_name()).str());
+								const std::string& previous_layer_name = schema->get_layer(layer_name)->input_layer_instance_names[0];
+								size_t buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
+								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
+							}
+							break;
 						}
 
 						{
@@ -697,6 +877,25 @@ namespace nnforge
 									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
 							}
 							break;
+						case layer_action::backward_data_and_weights:
+							{
+								unsigned int data_input_index = 0;
+								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
+								{
+									const std::string& previous_layer_name = *it2;
+									if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) && updater->is_backward_data_and_weights_dependent_on_input_buffer(data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+								}
+								if (updater->is_backward_data_and_weights_dependent_on_output_buffer(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = gradient_to_producing_actions_map.find(l->instance_name);
+								if (input_to_all_output_it != gradient_to_producing_actions_map.end())
+									for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
+										current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == 0)));
+								if (updater->is_backward_data_and_weights_dependent_on_temporary_per_entry_buffer(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
+							}
+							break;
 						}
 					}
 
@@ -754,6 +953,12 @@ namespace nnforge
 								buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
 							}
 							break;
+						case layer_action::backward_data_and_weights:
+							{
+								const std::string& previous_layer_name = schema->get_layer(layer_name)->input_layer_instance_names[0];
+								buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
+							}
+							break;
 						default:
 							throw neural_network_exception((boost::format("Unexpected buffer lifetime %1% encountered for layer %2% action %3%") % it->second.str() % it->first.get_name() % it->first.get_action().str()).str());
 						}
@@ -809,8 +1014,7 @@ namespace nnforge
 			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
 				buffer_configuration.add_per_entry_buffer(*it);
 
-			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
-				buffer_configuration.add_per_entry_buffer(it->second);
+			buffer_configuration.add_per_entry_buffer(data_pipeline_plain::get_per_entry_buffer_size(plain_config, dedicated_per_entry_data_name_to_size_map, data_layer_names, output_layer_names));
 
 			buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
 
@@ -830,143 +1034,130 @@ namespace nnforge
 			training_momentum momentum,
 			unsigned int iteration_id) const
 		{
-			switch (momentum.type)
+			if (communicator)
 			{
-			case training_momentum::no_momentum:
-				{
-					layer_data::iterator gradient_it = gradient->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					double accum = 0.0;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
-					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						float learning_rate = *learning_rate_it;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2)
-						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float upd = learning_rate * (gr * normalizer - current_weight * actual_weight_decay);
-							accum += static_cast<double>(fabsf(upd));
-							float new_weight = current_weight + upd;
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-						}
-						*updates_accumulated_it += accum;
-					}
-				}
-				break;
-			case training_momentum::vanilla_momentum:
-				{
-					layer_data::iterator gradient_it = gradient->begin();
-					layer_data::iterator previous_upd_it = previous_upd->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++previous_upd_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
-					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						std::vector<float>::iterator previous_upd_it2 = previous_upd_it->begin();
-						float learning_rate = *learning_rate_it;
-						double accum = 0.0;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2, ++previous_upd_it2)
-						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float prev_upd = *previous_upd_it2;
-							float upd = prev_upd * momentum.momentum_val + learning_rate * (gr * normalizer - current_weight * actual_weight_decay);
-							accum += static_cast<double>(fabsf(upd));
-							float new_weight = current_weight + upd;
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-							*previous_upd_it2 = upd;
-						}
-						*updates_accumulated_it += accum;
-					}
-				}
-				break;
-			case training_momentum::nesterov_momentum:
-				{
-					layer_data::iterator gradient_it = gradient->begin();
-					layer_data::iterator previous_upd_it = previous_upd->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++previous_upd_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
-					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						std::vector<float>::iterator previous_upd_it2 = previous_upd_it->begin();
-						float learning_rate = *learning_rate_it;
-						double accum = 0.0;
-						float mp1 = momentum.momentum_val + 1.0F;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2, ++previous_upd_it2)
-						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float prev_upd = *previous_upd_it2;
-							float new_upd = prev_upd * momentum.momentum_val + learning_rate * (gr * normalizer - current_weight * actual_weight_decay);
-							float upd = mp1 * new_upd - momentum.momentum_val * prev_upd;
-							accum += static_cast<double>(fabsf(upd));
-							float new_weight = current_weight + upd;
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-							*previous_upd_it2 = new_upd;
-						}
-						*updates_accumulated_it += accum;
-					}
-				}
-				break;
-			case training_momentum::adam_momentum:
+				for(layer_data::iterator it = gradient->begin(); it != gradient->end(); ++it)
+					if (!it->empty())
+						communicator->reduce_all(layer_name.c_str(), worker_id, &it->at(0), it->size());
+			}
+
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+			std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
+
+			// Parts are split into chunks, so that both a single large part and many small ones keep all the threads busy
+			std::vector<std::pair<unsigned int, int> > chunk_list;
+			for(unsigned int part_id = 0; part_id < static_cast<unsigned int>(data->size()); ++part_id)
+			{
+				int elem_count = static_cast<int>(data->at(part_id).size());
+				for(int offset = 0; offset < elem_count; offset += simd_kernels_plain::elementwise_chunk_elem_count)
+					chunk_list.push_back(std::make_pair(part_id, offset));
+			}
+			const int chunk_count = static_cast<int>(chunk_list.size());
+			std::vector<double> chunk_updates(chunk_count);
+
+			float one_minus_beta1t_inverted = 0.0F;
+			float one_minus_beta2t_inverted = 0.0F;
+			if (momentum.type == training_momentum::adam_momentum)
+			{
+				one_minus_beta1t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val, static_cast<float>(iteration_id)));
+				one_minus_beta2t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val2, static_cast<float>(iteration_id)));
+			}
+			const float epsilon = 1.0e-8F;
+
+			#pragma omp parallel for default(shared) schedule(dynamic) num_threads(std::max(std::min(plain_config->openmp_thread_count, chunk_count), 1))
+			for(int chunk_id = 0; chunk_id < chunk_count; ++chunk_id)
+			{
+				unsigned int part_id = chunk_list[chunk_id].first;
+				int offset = chunk_list[chunk_id].second;
+				std::vector<float>& weights = data->at(part_id);
+				int elem_count = std::min(static_cast<int>(weights.size()) - offset, simd_kernels_plain::elementwise_chunk_elem_count);
+				float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
+				float learning_rate = learning_rates[part_id];
+				float * weights_it = &weights[0] + offset;
+				float * gradient_it = &gradient->at(part_id)[0] + offset;
+
+				switch (momentum.type)
 				{
-					layer_data::iterator gradient_it = gradient->begin();
-					layer_data::iterator previous_upd_it = previous_upd->begin();
-					layer_data::iterator previous_upd2_it = previous_upd2->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					float one_minus_beta1t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val, static_cast<float>(iteration_id)));
-					float one_minus_beta2t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val2, static_cast<float>(iteration_id)));
-					float epsilon = 1.0e-8F;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++previous_upd_it, ++previous_upd2_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
-					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						std::vector<float>::iterator previous_upd_it2 = previous_upd_it->begin();
-						std::vector<float>::iterator previous_upd2_it2 = previous_upd2_it->begin();
-						float learning_rate = *learning_rate_it;
-						double accum = 0.0;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2, ++previous_upd_it2, ++previous_upd2_it2)
-						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float previous_biased_first_momentum = *previous_upd_it2;
-							float previous_biased_second_momentum = *previous_upd2_it2;
-							float total_gradient = gr * normalizer - current_weight * weight_decay;
-							float new_biased_first_momentum = momentum.momentum_val * previous_biased_first_momentum + (1.0F - momentum.momentum_val) * total_gradient;
-							float new_biased_second_momentum = momentum.momentum_val2 * previous_biased_second_momentum + (1.0F - momentum.momentum_val2) * total_gradient * total_gradient;
-							float unbiased_first_momentum = new_biased_first_momentum * one_minus_beta1t_inverted;
-							float unbiased_second_momentum = new_biased_second_momentum * one_minus_beta2t_inverted;
-							float upd = (learning_rate * unbiased_first_momentum) / (sqrtf(unbiased_second_momentum) + epsilon);
-							float new_weight = current_weight + upd;
-							accum += static_cast<double>(fabsf(upd));
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-							*previous_upd_it2 = new_biased_first_momentum;
-							*previous_upd2_it2 = new_biased_second_momentum;
-						}
-						*updates_accumulated_it += accum;
-					}
+				case training_momentum::no_momentum:
+					chunk_updates[chunk_id] = kernels.apply_gradient(
+						weights_it,
+						gradient_it,
+						elem_count,
+						learning_rate,
+						normalizer,
+						actual_weight_decay);
+					break;
+				case training_momentum::vanilla_momentum:
+					chunk_updates[chunk_id] = kernels.apply_gradient_with_vanilla_momentum(
+						weights_it,
+						gradient_it,
+						&previous_upd->at(part_id)[0] + offset,
+						elem_count,
+						learning_rate,
+						normalizer,
+						actual_weight_decay,
+						momentum.momentum_val);
+					break;
+				case training_momentum::nesterov_momentum:
+					chunk_updates[chunk_id] = kernels.apply_gradient_with_nesterov_momentum(
+						weights_it,
+						gradient_it,
+						&previous_upd->at(part_id)[0] + offset,
+						elem_count,
+						learning_rate,
+						normalizer,
+						actual_weight_decay,
+						momentum.momentum_val);
+					break;
+				case training_momentum::adam_momentum:
+					chunk_updates[chunk_id] = kernels.apply_gradient_with_adam_momentum(
+						weights_it,
+						gradient_it,
+						&previous_upd->at(part_id)[0] + offset,
+						&previous_upd2->at(part_id)[0] + offset,
+						elem_count,
+						learning_rate,
+						normalizer,
+						actual_weight_decay,
+						momentum.momentum_val,
+						momentum.momentum_val2,
+						one_minus_beta1t_inverted,
+						one_minus_beta2t_inverted,
+						epsilon);
+					break;
 				}
-				break;
 			}
+
+			// Summed in a fixed order, so the statistic doesn't depend on thread scheduling
+			for(int chunk_id = 0; chunk_id < chunk_count; ++chunk_id)
+				updates_accumulated[chunk_list[chunk_id].first] += chunk_updates[chunk_id];
+		}
+
+		float backward_propagation_plain::get_max_flops() const
+		{
+			return plain_config->get_flops();
+		}
+
+		std::map<layer_name_with_action, float> backward_propagation_plain::get_flops_per_action() const
+		{
+			std::map<layer_name_with_action, float> res;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				const std::string& layer_name = it->get_name();
+				layer::const_ptr l = schema->get_layer(layer_name);
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map.find(*it2)->second);
+				float flops_per_entry = updaters.find(layer_name)->second->get_flops_per_entry(
+					it->get_action(),
+					layer_name_to_action_set_map.find(layer_name)->second,
+					plain_config,
+					l,
+					input_layer_configuration_specific_list,
+					layer_config_map.find(layer_name)->second);
+				res.insert(std::make_pair(*it, flops_per_entry * static_cast<float>(cumulative_tiling_factor_map.find(layer_name)->second)));
+			}
+			return res;
 		}
 	}
 }
@@ -20,6 +20,8 @@
 
 #include "plain_running_configuration.h"
 #include "layer_updater_plain.h"
+#include "plain_buffer_arena.h"
+#include "plain_communicator.h"
 
 #include <map>
 
@@ -42,6 +44,8 @@ namespace nnforge
 			virtual ~backward_propagation_plain() = default;
 
 		protected:
+			friend class backward_propagation_plain_data_parallel;
+
 			// schema, network data and data are guaranteed to be compatible
 			// The function should set average absolute updates, the number of entries processed, and optionally time it takes to run each action
 			virtual void actual_run(
@@ -64,6 +68,10 @@ namespace nnforge
 			// The layer_config_map is guaranteed to be compatible with schema
 			virtual void layer_config_map_modified();
 
+			virtual float get_max_flops() const;
+
+			virtual std::map<layer_name_with_action, float> get_flops_per_action() const;
+
 		private:
 			void setup_dedicated_buffer_sizes();
 
@@ -105,6 +113,15 @@ namespace nnforge
 
 			buffer_plain_size_configuration buffer_config_without_data_and_momentum;
 
+			// Layer, temporary and pipeline buffers, kept between runs
+			plain_buffer_arena arena;
+
+			// Set when the object is one of the workers of backward_propagation_plain_data_parallel.
+			// The reader serves the worker's slice of each batch, batch_size being the size of the slice;
+			// entry counts and gradients are summed across the workers so that all of them apply the same updates
+			plain_communicator::ptr communicator;
+			unsigned int worker_id;
+
 		private:
 			backward_propagation_plain(const backward_propagation_plain&) = delete;
 			backward_propagation_plain& operator =(const backward_propagation_plain&) = delete;
@@ -0,0 +1,380 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include "backward_propagation_plain_data_parallel.h"
+
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		backward_propagation_plain_data_parallel::backward_propagation_plain_data_parallel(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			const std::vector<std::string>& error_source_layer_names,
+			const std::vector<std::string>& exclude_data_update_layer_names,
+			debug_state::ptr debug,
+			profile_state::ptr profile,
+			plain_running_configuration::const_ptr plain_config)
+			: backward_propagation(schema, output_layer_names, error_source_layer_names, exclude_data_update_layer_names, debug, profile)
+			, plain_config(plain_config)
+		{
+			unsigned int worker_count = plain_config->worker_count;
+			plain_running_configuration::const_ptr worker_plain_config(new plain_running_configuration(
+				*plain_config,
+				std::max(plain_config->openmp_thread_count / static_cast<int>(worker_count), 1),
+				1.0F / static_cast<float>(worker_count)));
+			for(unsigned int worker_id = 0; worker_id < worker_count; ++worker_id)
+			{
+				std::shared_ptr<backward_propagation_plain> worker(new backward_propagation_plain(
+					schema,
+					output_layer_names,
+					error_source_layer_names,
+					exclude_data_update_layer_names,
+					debug,
+					profile,
+					worker_plain_config));
+				worker->worker_id = worker_id;
+				worker_list.push_back(worker);
+			}
+
+			worker_cpu_list.resize(worker_count);
+			#ifdef __linux__
+			{
+				// CPUs are ordered by socket first, so that contiguous groups don't span sockets when hyper-threads are numbered after all the cores
+				std::vector<std::pair<int, int> > socket_and_cpu_list;
+				cpu_set_t cpu_set;
+				CPU_ZERO(&cpu_set);
+				if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0)
+				{
+					for(int cpu_id = 0; cpu_id < CPU_SETSIZE; ++cpu_id)
+					{
+						if (!CPU_ISSET(cpu_id, &cpu_set))
+							continue;
+						int socket_id = 0;
+						std::ifstream in((boost::format("/sys/devices/system/cpu/cpu%1%/topology/physical_package_id") % cpu_id).str().c_str());
+						if (!(in >> socket_id))
+							socket_id = 0;
+						socket_and_cpu_list.push_back(std::make_pair(socket_id, cpu_id));
+					}
+				}
+				std::sort(socket_and_cpu_list.begin(), socket_and_cpu_list.end());
+
+				// Workers are left unpinned when there are fewer CPUs than workers
+				if (socket_and_cpu_list.size() >= worker_count)
+				{
+					for(unsigned int worker_id = 0; worker_id < worker_count; ++worker_id)
+					{
+						size_t start = socket_and_cpu_list.size() * worker_id / worker_count;
+						size_t end = socket_and_cpu_list.size() * (worker_id + 1) / worker_count;
+						for(size_t i = start; i < end; ++i)
+							worker_cpu_list[worker_id].push_back(socket_and_cpu_list[i].second);
+					}
+				}
+			}
+			#endif
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain data parallel, " << worker_count << " workers with " << worker_plain_config->openmp_thread_count << " OpenMP threads each";
+				for(unsigned int worker_id = 0; worker_id < worker_count; ++worker_id)
+				{
+					debug_str << ((worker_id == 0) ? ", CPUs: " : "; ");
+					for(std::vector<int>::const_iterator it = worker_cpu_list[worker_id].begin(); it != worker_cpu_list[worker_id].end(); ++it)
+					{
+						if (it != worker_cpu_list[worker_id].begin())
+							debug_str << " ";
+						debug_str << *it;
+					}
+				}
+				debug->output_message(debug_str.str().c_str());
+			}
+		}
+
+		void backward_propagation_plain_data_parallel::actual_run(
+			structured_data_bunch_reader& reader,
+			structured_data_bunch_writer& writer,
+			network_data& data,
+			network_data::ptr momentum_data,
+			network_data::ptr momentum_data2,
+			const std::map<std::string, std::vector<float> >& learning_rates,
+			unsigned int batch_size,
+			float weight_decay,
+			training_momentum momentum,
+			unsigned int epoch_id,
+			std::map<std::string, std::vector<float> >& average_absolute_updates,
+			unsigned int& entries_processed,
+			std::map<layer_name_with_action, float>& action_seconds,
+			float& idle_seconds)
+		{
+			unsigned int worker_count = static_cast<unsigned int>(worker_list.size());
+			if (batch_size < worker_count)
+				throw neural_network_exception((boost::format("Batch size %1% is smaller than the number of plain workers %2%") % batch_size % worker_count).str());
+
+			plain_communicator::ptr communicator(new plain_communicator(worker_count, worker_list.front()->plain_config->openmp_thread_count));
+			std::mutex writer_mutex;
+
+			std::vector<network_data::ptr> worker_data_list(worker_count);
+			std::vector<std::map<std::string, std::vector<float> > > worker_average_absolute_updates_list(worker_count);
+			std::vector<unsigned int> worker_entries_processed_list(worker_count, 0);
+			std::vector<std::map<layer_name_with_action, float> > worker_action_seconds_list(worker_count);
+			std::vector<float> worker_idle_seconds_list(worker_count, 0.0F);
+			std::exception_ptr error;
+			std::mutex error_mutex;
+
+			std::vector<std::thread> thread_list;
+			unsigned int slice_offset = 0;
+			for(unsigned int worker_id = 0; worker_id < worker_count; ++worker_id)
+			{
+				unsigned int slice_size = batch_size / worker_count + ((worker_id < batch_size % worker_count) ? 1 : 0);
+				thread_list.push_back(std::thread([&, worker_id, slice_offset, slice_size] ()
+				{
+					try
+					{
+						bind_to_worker_cpus(worker_id);
+
+						// Copies are made by the worker thread, so that their pages are allocated on the worker's NUMA node
+						network_data::ptr worker_data;
+						network_data::ptr worker_momentum_data = momentum_data;
+						network_data::ptr worker_momentum_data2 = momentum_data2;
+						if (worker_id > 0)
+						{
+							worker_data = copy(data);
+							if (momentum_data)
+								worker_momentum_data = copy(*momentum_data);
+							if (momentum_data2)
+								worker_momentum_data2 = copy(*momentum_data2);
+							worker_data_list[worker_id] = worker_data;
+						}
+
+						batch_slice_reader slice_reader(reader, batch_size, slice_offset, slice_size);
+						batch_slice_writer slice_writer(writer, writer_mutex, batch_size, slice_offset, slice_size, output_layers_tiling_factor);
+						backward_propagation_plain& worker = *worker_list[worker_id];
+						worker.communicator = communicator;
+						worker.actual_run(
+							slice_reader,
+							slice_writer,
+							(worker_id > 0) ? *worker_data : data,
+							worker_momentum_data,
+							worker_momentum_data2,
+							learning_rates,
+							slice_size,
+							weight_decay,
+							momentum,
+							epoch_id,
+							worker_average_absolute_updates_list[worker_id],
+							worker_entries_processed_list[worker_id],
+							worker_action_seconds_list[worker_id],
+							worker_idle_seconds_list[worker_id]);
+					}
+					catch (...)
+					{
+						{
+							// The first error is the cause, the workers failing after it are aborted by the communicator
+							std::lock_guard<std::mutex> lock(error_mutex);
+							if (!error)
+								error = std::current_exception();
+						}
+						communicator->abort();
+					}
+				}));
+				slice_offset += slice_size;
+			}
+			for(std::vector<std::thread>::iterator it = thread_list.begin(); it != thread_list.end(); ++it)
+				it->join();
+			for(std::vector<std::shared_ptr<backward_propagation_plain> >::iterator it = worker_list.begin(); it != worker_list.end(); ++it)
+				(*it)->communicator.reset();
+			if (error)
+				std::rethrow_exception(error);
+
+			if (debug->is_debug())
+			{
+				for(unsigned int worker_id = 1; worker_id < worker_count; ++worker_id)
+					if (!is_equal(data, *worker_data_list[worker_id]))
+						throw neural_network_exception((boost::format("Weights of plain worker %1% differ from those of worker 0") % worker_id).str());
+				debug->output_message("Weights of all plain workers are identical");
+			}
+
+			// Updates are the same on all the workers
+			average_absolute_updates = worker_average_absolute_updates_list.front();
+			entries_processed = 0;
+			for(std::vector<unsigned int>::const_iterator it = worker_entries_processed_list.begin(); it != worker_entries_processed_list.end(); ++it)
+				entries_processed += *it;
+			action_seconds = worker_action_seconds_list.front();
+			idle_seconds = worker_idle_seconds_list.front();
+		}
+
+		void backward_propagation_plain_data_parallel::layer_config_map_modified()
+		{
+			for(std::vector<std::shared_ptr<backward_propagation_plain> >::iterator it = worker_list.begin(); it != worker_list.end(); ++it)
+				(*it)->set_input_configuration_specific(layer_config_map);
+		}
+
+		float backward_propagation_plain_data_parallel::get_max_flops() const
+		{
+			return plain_config->get_flops();
+		}
+
+		std::map<layer_name_with_action, float> backward_propagation_plain_data_parallel::get_flops_per_action() const
+		{
+			// Flops are updated before layer_config_map_modified is called, so the first worker is configured here
+			worker_list.front()->set_input_configuration_specific(layer_config_map);
+			return worker_list.front()->get_flops_per_action();
+		}
+
+		void backward_propagation_plain_data_parallel::bind_to_worker_cpus(unsigned int worker_id) const
+		{
+			#ifdef __linux__
+			const std::vector<int>& cpu_list = worker_cpu_list[worker_id];
+			if (cpu_list.empty())
+				return;
+
+			cpu_set_t cpu_set;
+			CPU_ZERO(&cpu_set);
+			for(std::vector<int>::const_iterator it = cpu_list.begin(); it != cpu_list.end(); ++it)
+				CPU_SET(*it, &cpu_set);
+			// OpenMP threads started by the worker thread inherit the affinity
+			if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0)
+				throw neural_network_exception((boost::format("Unable to pin plain worker %1% to its CPUs") % worker_id).str());
+			#endif
+		}
+
+		network_data::ptr backward_propagation_plain_data_parallel::copy(const network_data& data)
+		{
+			network_data::ptr res(new network_data());
+
+			std::vector<std::string> data_name_list = data.data_list.get_data_layer_name_list();
+			for(std::vector<std::string>::const_iterator it = data_name_list.begin(); it != data_name_list.end(); ++it)
+				res->data_list.add(*it, layer_data::ptr(new layer_data(*data.data_list.get(*it))));
+
+			std::vector<std::string> data_custom_name_list = data.data_custom_list.get_data_custom_layer_name_list();
+			for(std::vector<std::string>::const_iterator it = data_custom_name_list.begin(); it != data_custom_name_list.end(); ++it)
+				res->data_custom_list.add(*it, layer_data_custom::ptr(new layer_data_custom(*data.data_custom_list.get(*it))));
+
+			return res;
+		}
+
+		bool backward_propagation_plain_data_parallel::is_equal(
+			const network_data& data1,
+			const network_data& data2)
+		{
+			std::vector<std::string> data_name_list = data1.data_list.get_data_layer_name_list();
+			for(std::vector<std::string>::const_iterator it = data_name_list.begin(); it != data_name_list.end(); ++it)
+			{
+				layer_data::ptr d1 = data1.data_list.get(*it);
+				layer_data::ptr d2 = data2.data_list.find(*it);
+				if (!d2 || (d1->size() != d2->size()))
+					return false;
+				for(size_t part_id = 0; part_id < d1->size(); ++part_id)
+				{
+					const std::vector<float>& p1 = d1->at(part_id);
+					const std::vector<float>& p2 = d2->at(part_id);
+					// Compared bitwise, NaNs included
+					if ((p1.size() != p2.size()) || (!p1.empty() && (memcmp(&p1[0], &p2[0], p1.size() * sizeof(float)) != 0)))
+						return false;
+				}
+			}
+			return true;
+		}
+
+		backward_propagation_plain_data_parallel::batch_slice_reader::batch_slice_reader(
+			structured_data_bunch_reader& original_reader,
+			unsigned int batch_size,
+			unsigned int slice_offset,
+			unsigned int slice_size)
+			: original_reader(original_reader)
+			, batch_size(batch_size)
+			, slice_offset(slice_offset)
+			, slice_size(slice_size)
+		{
+		}
+
+		std::map<std::string, layer_configuration_specific> backward_propagation_plain_data_parallel::batch_slice_reader::get_config_map() const
+		{
+			return original_reader.get_config_map();
+		}
+
+		bool backward_propagation_plain_data_parallel::batch_slice_reader::read(
+			unsigned int entry_id,
+			const std::map<std::string, float *>& data_map)
+		{
+			return original_reader.read((entry_id / slice_size) * batch_size + slice_offset + entry_id % slice_size, data_map);
+		}
+
+		void backward_propagation_plain_data_parallel::batch_slice_reader::set_epoch(unsigned int epoch_id)
+		{
+		}
+
+		int backward_propagation_plain_data_parallel::batch_slice_reader::get_entry_count() const
+		{
+			int original_entry_count = original_reader.get_entry_count();
+			if (original_entry_count < 0)
+				return original_entry_count;
+
+			unsigned int full_batch_count = static_cast<unsigned int>(original_entry_count) / batch_size;
+			unsigned int last_batch_entry_count = static_cast<unsigned int>(original_entry_count) % batch_size;
+			unsigned int last_batch_slice_entry_count = (last_batch_entry_count > slice_offset) ? std::min(last_batch_entry_count - slice_offset, slice_size) : 0;
+			return static_cast<int>(full_batch_count * slice_size + last_batch_slice_entry_count);
+		}
+
+		backward_propagation_plain_data_parallel::batch_slice_writer::batch_slice_writer(
+			structured_data_bunch_writer& original_writer,
+			std::mutex& original_writer_mutex,
+			unsigned int batch_size,
+			unsigned int slice_offset,
+			unsigned int slice_size,
+			unsigned int tiling_factor)
+			: original_writer(original_writer)
+			, original_writer_mutex(original_writer_mutex)
+			, batch_size(batch_size)
+			, slice_offset(slice_offset)
+			, slice_size(slice_size)
+			, tiling_factor(tiling_factor)
+		{
+		}
+
+		void backward_propagation_plain_data_parallel::batch_slice_writer::set_config_map(const std::map<std::string, layer_configuration_specific> config_map)
+		{
+		}
+
+		void backward_propagation_plain_data_parallel::batch_slice_writer::write(
+			unsigned int entry_id,
+			const std::map<std::string, const float *>& data_map)
+		{
+			unsigned int slice_entry_id = entry_id / tiling_factor;
+			unsigned int original_entry_id = (slice_entry_id / slice_size) * batch_size + slice_offset + slice_entry_id % slice_size;
+
+			std::lock_guard<std::mutex> lock(original_writer_mutex);
+			original_writer.write(original_entry_id * tiling_factor + entry_id % tiling_factor, data_map);
+		}
+	}
+}
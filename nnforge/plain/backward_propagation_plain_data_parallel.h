@@ -0,0 +1,158 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include "../backward_propagation.h"
+
+#include "plain_running_configuration.h"
+#include "backward_propagation_plain.h"
+
+#include <vector>
+#include <mutex>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Data-parallel training on worker_count thread groups, each of them being a backward_propagation_plain
+		// with its own share of OpenMP threads and memory, pinned to its own contiguous subset of the CPUs the process is allowed to run on.
+		// Each worker trains on a disjoint slice of every batch and on its own copy of the weights,
+		// gradients are summed with plain_communicator before they are applied, so the copies stay bit-identical
+		class backward_propagation_plain_data_parallel : public backward_propagation
+		{
+		public:
+			backward_propagation_plain_data_parallel(
+				const network_schema& schema,
+				const std::vector<std::string>& output_layer_names,
+				const std::vector<std::string>& error_source_layer_names,
+				const std::vector<std::string>& exclude_data_update_layer_names,
+				debug_state::ptr debug,
+				profile_state::ptr profile,
+				plain_running_configuration::const_ptr plain_config);
+
+			virtual ~backward_propagation_plain_data_parallel() = default;
+
+		protected:
+			// schema, network data and data are guaranteed to be compatible
+			// The function should set average absolute updates, the number of entries processed, and optionally time it takes to run each action
+			virtual void actual_run(
+				structured_data_bunch_reader& reader,
+				structured_data_bunch_writer& writer,
+				network_data& data,
+				network_data::ptr momentum_data,
+				network_data::ptr momentum_data2,
+				const std::map<std::string, std::vector<float> >& learning_rates,
+				unsigned int batch_size,
+				float weight_decay,
+				training_momentum momentum,
+				unsigned int epoch_id,
+				std::map<std::string, std::vector<float> >& average_absolute_updates,
+				unsigned int& entries_processed,
+				std::map<layer_name_with_action, float>& action_seconds,
+				float& idle_seconds);
+
+			// The method is called when client calls set_input_configuration_specific and the configuration is modified.
+			// The layer_config_map is guaranteed to be compatible with schema
+			virtual void layer_config_map_modified();
+
+			virtual float get_max_flops() const;
+
+			virtual std::map<layer_name_with_action, float> get_flops_per_action() const;
+
+		private:
+			// Serves entries [slice_offset, slice_offset + slice_size) of each batch of the original reader
+			class batch_slice_reader : public structured_data_bunch_reader
+			{
+			public:
+				batch_slice_reader(
+					structured_data_bunch_reader& original_reader,
+					unsigned int batch_size,
+					unsigned int slice_offset,
+					unsigned int slice_size);
+
+				virtual ~batch_slice_reader() = default;
+
+				virtual std::map<std::string, layer_configuration_specific> get_config_map() const;
+
+				virtual bool read(
+					unsigned int entry_id,
+					const std::map<std::string, float *>& data_map);
+
+				// The epoch is set on the original reader
+				virtual void set_epoch(unsigned int epoch_id);
+
+				virtual int get_entry_count() const;
+
+			private:
+				structured_data_bunch_reader& original_reader;
+				unsigned int batch_size;
+				unsigned int slice_offset;
+				unsigned int slice_size;
+			};
+
+			// Writes entries of the batch slice at their positions in the original entry order, the writes of all the workers are serialized
+			class batch_slice_writer : public structured_data_bunch_writer
+			{
+			public:
+				batch_slice_writer(
+					structured_data_bunch_writer& original_writer,
+					std::mutex& original_writer_mutex,
+					unsigned int batch_size,
+					unsigned int slice_offset,
+					unsigned int slice_size,
+					unsigned int tiling_factor);
+
+				virtual ~batch_slice_writer() = default;
+
+				// The config map is set on the original writer
+				virtual void set_config_map(const std::map<std::string, layer_configuration_specific> config_map);
+
+				virtual void write(
+					unsigned int entry_id,
+					const std::map<std::string, const float *>& data_map);
+
+			private:
+				structured_data_bunch_writer& original_writer;
+				std::mutex& original_writer_mutex;
+				unsigned int batch_size;
+				unsigned int slice_offset;
+				unsigned int slice_size;
+				unsigned int tiling_factor;
+			};
+
+			// Restricts the calling thread to the CPUs of the worker, does nothing where affinity is not supported
+			void bind_to_worker_cpus(unsigned int worker_id) const;
+
+			static network_data::ptr copy(const network_data& data);
+
+			static bool is_equal(
+				const network_data& data1,
+				const network_data& data2);
+
+		private:
+			plain_running_configuration::const_ptr plain_config;
+
+			std::vector<std::shared_ptr<backward_propagation_plain> > worker_list;
+			std::vector<std::vector<int> > worker_cpu_list;
+
+		private:
+			backward_propagation_plain_data_parallel(const backward_propagation_plain_data_parallel&) = delete;
+			backward_propagation_plain_data_parallel& operator =(const backward_propagation_plain_data_parallel&) = delete;
+		};
+	}
+}
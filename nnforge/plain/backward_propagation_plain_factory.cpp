@@ -17,6 +17,7 @@
 #include "backward_propagation_plain_factory.h"
 
 #include "backward_propagation_plain.h"
+#include "backward_propagation_plain_data_parallel.h"
 
 namespace nnforge
 {
@@ -35,6 +36,72 @@ namespace nnforge
 			debug_state::ptr debug,
 			profile_state::ptr profile) const
 		{
+			return create_with_config(
+				schema,
+				output_layer_names,
+				error_source_layer_names,
+				exclude_data_update_layer_names,
+				debug,
+				profile,
+				plain_config);
+		}
+
+		backward_propagation::ptr backward_propagation_plain_factory::create_concurrent(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			const std::vector<std::string>& error_source_layer_names,
+			const std::vector<std::string>& exclude_data_update_layer_names,
+			debug_state::ptr debug,
+			profile_state::ptr profile,
+			unsigned int concurrent_count) const
+		{
+			if (concurrent_count <= 1)
+				return create_with_config(
+					schema,
+					output_layer_names,
+					error_source_layer_names,
+					exclude_data_update_layer_names,
+					debug,
+					profile,
+					plain_config);
+
+			// Concurrent actions split the resources of the object further.
+			// Data parallel workers pin themselves to the same CPU groups in each object, so each object runs a single worker
+			std::shared_ptr<plain_running_configuration> concurrent_plain_config(new plain_running_configuration(
+				*plain_config,
+				plain_config->openmp_thread_count / static_cast<int>(concurrent_count),
+				1.0F / static_cast<float>(concurrent_count)));
+			concurrent_plain_config->concurrent_action_count = plain_config->concurrent_action_count;
+
+			return create_with_config(
+				schema,
+				output_layer_names,
+				error_source_layer_names,
+				exclude_data_update_layer_names,
+				debug,
+				profile,
+				concurrent_plain_config);
+		}
+
+		backward_propagation::ptr backward_propagation_plain_factory::create_with_config(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			const std::vector<std::string>& error_source_layer_names,
+			const std::vector<std::string>& exclude_data_update_layer_names,
+			debug_state::ptr debug,
+			profile_state::ptr profile,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			if (plain_config->worker_count > 1)
+				return backward_propagation::ptr(new backward_propagation_plain_data_parallel(
+					schema,
+					output_layer_names,
+					error_source_layer_names,
+					exclude_data_update_layer_names,
+					debug,
+					profile,
+					plain_config));
+
 			return backward_propagation::ptr(new backward_propagation_plain(
 				schema,
 				output_layer_names,
@@ -38,6 +38,26 @@ namespace nnforge
 				debug_state::ptr debug,
 				profile_state::ptr profile) const;
 
+			// Each object gets concurrent_count-th part of the OpenMP threads and of the memory limit
+			virtual backward_propagation::ptr create_concurrent(
+				const network_schema& schema,
+				const std::vector<std::string>& output_layer_names,
+				const std::vector<std::string>& error_source_layer_names,
+				const std::vector<std::string>& exclude_data_update_layer_names,
+				debug_state::ptr debug,
+				profile_state::ptr profile,
+				unsigned int concurrent_count) const;
+
+		protected:
+			static backward_propagation::ptr create_with_config(
+				const network_schema& schema,
+				const std::vector<std::string>& output_layer_names,
+				const std::vector<std::string>& error_source_layer_names,
+				const std::vector<std::string>& exclude_data_update_layer_names,
+				debug_state::ptr debug,
+				profile_state::ptr profile,
+				plain_running_configuration::const_ptr plain_config);
+
 		protected:
 			plain_running_configuration::const_ptr plain_config;
 		};
@@ -17,6 +17,7 @@
 #include "batch_norm_layer_tester_plain.h"
 
 #include "../batch_norm_layer.h"
+#include "simd_kernels_plain.h"
 
 namespace nnforge
 {
@@ -50,8 +51,9 @@ namespace nnforge
 			const std::vector<float>::const_iterator beta = (*data)[1].begin();
 			const std::vector<float>::const_iterator mean = (*data)[2].begin();
 			const std::vector<float>::const_iterator inverse_sigma = (*data)[3].begin();
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
 			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
 				int entry_id = workload_id / feature_map_count;
@@ -61,16 +63,9 @@ namespace nnforge
 				float add = beta[feature_map_id] - mult * mean[feature_map_id];
 
 				const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-				const float * current_in_it_end = current_in_it + neuron_count_per_feature_map;
-
 				float * current_out_it = out_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
 
-				for(; current_in_it != current_in_it_end; ++current_in_it, ++current_out_it)
-				{
-					float input_val = *current_in_it;
-					float output_val = input_val * mult + add;
-					*current_out_it = output_val;
-				}
+				kernels.scale_shift(current_out_it, current_in_it, neuron_count_per_feature_map, mult, add);
 			}
 		}
 
@@ -0,0 +1,387 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "batch_norm_layer_updater_plain.h"
+
+#include "../batch_norm_layer.h"
+#include "simd_kernels_plain.h"
+
+#include <cmath>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const float batch_norm_layer_updater_plain::mean_and_variance_gradient_slope = 1.0F; // As if it were MSE/2
+
+		std::string batch_norm_layer_updater_plain::get_type_name() const
+		{
+			return batch_norm_layer::layer_type_name;
+		}
+
+		void batch_norm_layer_updater_plain::run_forward_propagation(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			std::shared_ptr<const batch_norm_layer> layer_derived = std::dynamic_pointer_cast<const batch_norm_layer>(layer_schema);
+			const bool batch_statistics = (actions.find(layer_action(layer_action::backward_data_and_weights)) != actions.end());
+
+			const int total_workload = static_cast<int>(entry_count * output_configuration_specific.feature_map_count);
+			float * const out_it = *output_buffer;
+			const float * const in_it = *input_buffers[0];
+			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
+			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const unsigned int feature_map_count = output_configuration_specific.feature_map_count;
+			const std::vector<float>::const_iterator gamma = (*data)[0].begin();
+			const std::vector<float>::const_iterator beta = (*data)[1].begin();
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+
+			const float * mean = &(*data)[2][0];
+			const float * inverse_sigma = &(*data)[3][0];
+			if (batch_statistics)
+			{
+				float * const partial_stats = *temporary_working_per_entry_buffer;
+				float * const batch_stats = *temporary_per_entry_buffer;
+				const double inverse_neuron_count_per_feature_map = 1.0 / static_cast<double>(neuron_count_per_feature_map);
+
+				// Mean and sum of squared deviations for each feature map of each entry,
+				// the second loop runs over data which is still in cache, so the input is effectively read once
+				#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					int entry_id = workload_id / feature_map_count;
+					int feature_map_id = workload_id - entry_id * feature_map_count;
+
+					const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+
+					double sum = 0.0;
+					for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+						sum += static_cast<double>(current_in_it[i]);
+					double local_mean = sum * inverse_neuron_count_per_feature_map;
+
+					double sum_squared_deviations = 0.0;
+					for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+					{
+						double deviation = static_cast<double>(current_in_it[i]) - local_mean;
+						sum_squared_deviations += deviation * deviation;
+					}
+
+					partial_stats[workload_id * 2] = static_cast<float>(local_mean);
+					partial_stats[workload_id * 2 + 1] = static_cast<float>(sum_squared_deviations);
+				}
+
+				// Chan et al. merge of equally sized groups, done in the order of entries so the result is deterministic
+				const int const_feature_map_count = static_cast<int>(feature_map_count);
+				const double epsilon = static_cast<double>(layer_derived->epsilon);
+				#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				for(int feature_map_id = 0; feature_map_id < const_feature_map_count; ++feature_map_id)
+				{
+					double mean_sum = 0.0;
+					for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+						mean_sum += static_cast<double>(partial_stats[(entry_id * feature_map_count + feature_map_id) * 2]);
+					double batch_mean = mean_sum / static_cast<double>(entry_count);
+
+					double sum_squared_deviations = 0.0;
+					for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+					{
+						const float * current_partial_stats = partial_stats + (entry_id * feature_map_count + feature_map_id) * 2;
+						double mean_deviation = static_cast<double>(current_partial_stats[0]) - batch_mean;
+						sum_squared_deviations += static_cast<double>(current_partial_stats[1]) + mean_deviation * mean_deviation * static_cast<double>(neuron_count_per_feature_map);
+					}
+					double batch_variance = sum_squared_deviations / (static_cast<double>(entry_count) * static_cast<double>(neuron_count_per_feature_map));
+
+					batch_stats[feature_map_id] = static_cast<float>(batch_mean);
+					batch_stats[feature_map_count + feature_map_id] = static_cast<float>(1.0 / sqrt(batch_variance + epsilon));
+				}
+
+				mean = batch_stats;
+				inverse_sigma = batch_stats + feature_map_count;
+			}
+
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / feature_map_count;
+				int feature_map_id = workload_id - entry_id * feature_map_count;
+
+				float mult = gamma[feature_map_id] * inverse_sigma[feature_map_id];
+				float add = beta[feature_map_id] - mult * mean[feature_map_id];
+
+				const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+				float * current_out_it = out_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+
+				kernels.scale_shift(current_out_it, current_in_it, neuron_count_per_feature_map, mult, add);
+			}
+		}
+
+		void batch_norm_layer_updater_plain::run_backward_data_propagation(
+			unsigned int input_index,
+			plain_buffer::ptr input_errors_buffer,
+			plain_buffer::const_ptr output_errors_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+			plain_buffer::const_ptr output_neurons_buffer,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const bool add_update_to_destination,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			const int total_workload = static_cast<int>(entry_count * output_configuration_specific.feature_map_count);
+			float * const in_errors_it = *input_errors_buffer;
+			const float * const out_errors_it = *output_errors_buffer;
+			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
+			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const unsigned int feature_map_count = output_configuration_specific.feature_map_count;
+			const std::vector<float>::const_iterator gamma = (*data)[0].begin();
+			const std::vector<float>::const_iterator inverse_sigma = (*data)[3].begin();
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / feature_map_count;
+				int feature_map_id = workload_id - entry_id * feature_map_count;
+
+				float mult = gamma[feature_map_id] * inverse_sigma[feature_map_id];
+
+				const float * current_out_errors_it = out_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+				float * current_in_errors_it = in_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+
+				kernels.scale(current_in_errors_it, current_out_errors_it, neuron_count_per_feature_map, mult, add_update_to_destination);
+			}
+		}
+
+		void batch_norm_layer_updater_plain::run_backward_data_and_weights_propagation(
+			plain_buffer::ptr input_errors_buffer,
+			plain_buffer::const_ptr output_errors_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+			plain_buffer::const_ptr output_neurons_buffer,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_buffer::ptr temporary_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data::ptr gradient,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			const bool add_update_to_destination,
+			const std::set<layer_action>& actions,
+			unsigned int entry_count) const
+		{
+			const int total_workload = static_cast<int>(entry_count * output_configuration_specific.feature_map_count);
+			float * const in_errors_it = *input_errors_buffer;
+			const float * const out_errors_it = *output_errors_buffer;
+			const float * const in_neurons_it = *input_neurons_buffers[0];
+			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
+			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const unsigned int feature_map_count = output_configuration_specific.feature_map_count;
+			const std::vector<float>::const_iterator gamma = (*data)[0].begin();
+			const std::vector<float>::const_iterator running_mean = (*data)[2].begin();
+			const std::vector<float>::const_iterator running_inverse_sigma = (*data)[3].begin();
+			const std::vector<float>::iterator gradient_gamma = (*gradient)[0].begin();
+			const std::vector<float>::iterator gradient_beta = (*gradient)[1].begin();
+			const std::vector<float>::iterator gradient_mean = (*gradient)[2].begin();
+			const std::vector<float>::iterator gradient_inverse_sigma = (*gradient)[3].begin();
+			float * const partial_sums = *temporary_working_per_entry_buffer;
+			const float * const batch_mean = *temporary_per_entry_buffer;
+			const float * const batch_inverse_sigma = batch_mean + feature_map_count;
+
+			// Sums of errors and of errors multiplied by normalized input for each feature map of each entry
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / feature_map_count;
+				int feature_map_id = workload_id - entry_id * feature_map_count;
+
+				const float * current_in_neurons_it = in_neurons_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+				const float * current_out_errors_it = out_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+				float mean = batch_mean[feature_map_id];
+				float inverse_sigma = batch_inverse_sigma[feature_map_id];
+
+				double sum_errors = 0.0;
+				double sum_errors_by_normalized = 0.0;
+				for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+				{
+					float output_err = current_out_errors_it[i];
+					float normalized = (current_in_neurons_it[i] - mean) * inverse_sigma;
+					sum_errors += static_cast<double>(output_err);
+					sum_errors_by_normalized += static_cast<double>(output_err * normalized);
+				}
+
+				partial_sums[workload_id * 2] = static_cast<float>(sum_errors);
+				partial_sums[workload_id * 2 + 1] = static_cast<float>(sum_errors_by_normalized);
+			}
+
+			// Gradients for gamma and beta, running mean and inverse sigma are pulled towards batch statistics.
+			// Coefficients for the input errors are stored to the partial sums of the 1st entry, each feature map overwrites its own slot only
+			const int const_feature_map_count = static_cast<int>(feature_map_count);
+			const double total_neuron_count_per_feature_map = static_cast<double>(entry_count) * static_cast<double>(neuron_count_per_feature_map);
+			const float statistics_mult = mean_and_variance_gradient_slope * static_cast<float>(entry_count);
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			for(int feature_map_id = 0; feature_map_id < const_feature_map_count; ++feature_map_id)
+			{
+				double sum_errors = 0.0;
+				double sum_errors_by_normalized = 0.0;
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+				{
+					const float * current_partial_sums = partial_sums + (entry_id * feature_map_count + feature_map_id) * 2;
+					sum_errors += static_cast<double>(current_partial_sums[0]);
+					sum_errors_by_normalized += static_cast<double>(current_partial_sums[1]);
+				}
+
+				float mean = batch_mean[feature_map_id];
+				float inverse_sigma = batch_inverse_sigma[feature_map_id];
+
+				gradient_gamma[feature_map_id] += static_cast<float>(sum_errors_by_normalized);
+				gradient_beta[feature_map_id] += static_cast<float>(sum_errors);
+				gradient_mean[feature_map_id] += statistics_mult * (mean - running_mean[feature_map_id]);
+				gradient_inverse_sigma[feature_map_id] += statistics_mult * (inverse_sigma - running_inverse_sigma[feature_map_id]);
+
+				// input_err = mult * (output_err - average(output_err) - normalized * average(output_err * normalized)),
+				// rewritten as mult * output_err + input_mult * input + add
+				double mult = static_cast<double>(gamma[feature_map_id]) * static_cast<double>(inverse_sigma);
+				double errors_add = mult * sum_errors / total_neuron_count_per_feature_map;
+				double normalized_mult = mult * sum_errors_by_normalized / total_neuron_count_per_feature_map * static_cast<double>(inverse_sigma);
+				partial_sums[feature_map_id * 2] = static_cast<float>(-normalized_mult);
+				partial_sums[feature_map_id * 2 + 1] = static_cast<float>(normalized_mult * static_cast<double>(mean) - errors_add);
+			}
+
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / feature_map_count;
+				int feature_map_id = workload_id - entry_id * feature_map_count;
+
+				const float * current_in_neurons_it = in_neurons_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+				const float * current_out_errors_it = out_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+				float * current_in_errors_it = in_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+				float mult = gamma[feature_map_id] * batch_inverse_sigma[feature_map_id];
+				float input_mult = partial_sums[feature_map_id * 2];
+				float add = partial_sums[feature_map_id * 2 + 1];
+
+				if (add_update_to_destination)
+				{
+					for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+						current_in_errors_it[i] += current_out_errors_it[i] * mult + current_in_neurons_it[i] * input_mult + add;
+				}
+				else
+				{
+					for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+						current_in_errors_it[i] = current_out_errors_it[i] * mult + current_in_neurons_it[i] * input_mult + add;
+				}
+			}
+		}
+
+		int batch_norm_layer_updater_plain::get_input_index_layer_can_write(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			// Input neurons are needed to back propagate through batch statistics
+			if ((action.get_action_type() == layer_action::forward) && (actions.find(layer_action(layer_action::backward_data_and_weights)) != actions.end()))
+				return -1;
+			else
+				return 0;
+		}
+
+		size_t batch_norm_layer_updater_plain::get_temporary_working_per_entry_buffer_size(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			if (actions.find(layer_action(layer_action::backward_data_and_weights)) == actions.end())
+				return 0;
+
+			if ((action.get_action_type() == layer_action::forward) || (action.get_action_type() == layer_action::backward_data_and_weights))
+				return output_configuration_specific.feature_map_count * 2 * sizeof(float);
+			else
+				return 0;
+		}
+
+		size_t batch_norm_layer_updater_plain::get_temporary_per_entry_buffer_size(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			// Batch mean and inverse sigma occupy the beginning of the buffer, it is never smaller than that
+			if (actions.find(layer_action(layer_action::backward_data_and_weights)) != actions.end())
+				return output_configuration_specific.feature_map_count * 2 * sizeof(float);
+			else
+				return 0;
+		}
+
+		bool batch_norm_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
+			unsigned int action_input_index,
+			unsigned int data_input_index,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return false;
+		}
+
+		bool batch_norm_layer_updater_plain::is_backward_data_dependent_on_output_buffer(
+			unsigned int action_input_index,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return false;
+		}
+
+		bool batch_norm_layer_updater_plain::is_backward_data_and_weights_dependent_on_output_buffer(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return false;
+		}
+	}
+}
@@ -16,6 +16,8 @@
 
 #include "buffer_plain_size_configuration.h"
 
+#include "plain_buffer.h"
+
 namespace nnforge
 {
 	namespace plain
@@ -28,12 +30,12 @@ namespace nnforge
 
 		void buffer_plain_size_configuration::add_constant_buffer(size_t buffer_size)
 		{
-			constant_buffer_size += buffer_size;
+			constant_buffer_size += plain_buffer::get_aligned_size(buffer_size);
 		}
 
 		void buffer_plain_size_configuration::add_per_entry_buffer(size_t buffer_size)
 		{
-			per_entry_buffer_size += buffer_size;
+			per_entry_buffer_size += plain_buffer::get_aligned_size(buffer_size);
 		}
 	}
 }
@@ -27,6 +27,7 @@ namespace nnforge
 		public:
 			buffer_plain_size_configuration();
 
+			// Sizes are rounded up to plain_buffer::alignment, so the totals are enough to place all the buffers one after another
 			void add_constant_buffer(size_t buffer_size);
 
 			void add_per_entry_buffer(size_t buffer_size);
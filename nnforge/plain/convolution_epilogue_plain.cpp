@@ -0,0 +1,56 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_epilogue_plain.h"
+
+#include "simd_kernels_plain.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		convolution_epilogue_plain::convolution_epilogue_plain()
+			: residual(0)
+			, relu(false)
+		{
+		}
+
+		convolution_epilogue_plain::convolution_epilogue_plain(
+			const float * residual,
+			bool relu)
+			: residual(residual)
+			, relu(relu)
+		{
+		}
+
+		bool convolution_epilogue_plain::is_empty() const
+		{
+			return (!residual) && (!relu);
+		}
+
+		void convolution_epilogue_plain::apply(
+			float * output,
+			size_t offset,
+			int elem_count) const
+		{
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+			if (residual)
+				kernels.add_accumulate(output, residual + offset, elem_count);
+			if (relu)
+				kernels.relu(output, output, elem_count);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Elementwise tail of the forward convolution applied to the output while it is still in cache:
+		// output = max(output + residual, 0), both parts are optional, residual has the same layout as the output.
+		// Default constructed epilogue does nothing
+		class convolution_epilogue_plain
+		{
+		public:
+			convolution_epilogue_plain();
+
+			convolution_epilogue_plain(
+				const float * residual,
+				bool relu);
+
+			bool is_empty() const;
+
+			// Applies to elem_count consecutive output elements starting at output, offset is their position in the whole output
+			void apply(
+				float * output,
+				size_t offset,
+				int elem_count) const;
+
+			// Returns the value for a single output element, offset is its position in the whole output
+			inline float apply(
+				float val,
+				size_t offset) const
+			{
+				if (residual)
+					val += residual[offset];
+				if (relu && (val < 0.0F))
+					val = 0.0F;
+				return val;
+			}
+
+		public:
+			const float * residual;
+			bool relu;
+		};
+	}
+}
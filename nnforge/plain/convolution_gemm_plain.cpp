@@ -0,0 +1,666 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_gemm_plain.h"
+
+#include "gemm_plain.h"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const int convolution_gemm_plain::min_gemm_dimension = 4;
+		const int convolution_gemm_plain::max_unrolled_tile_elem_count = 1 << 18;
+
+		convolution_gemm_plain::geometry::geometry(
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific)
+		{
+			dimension_count = static_cast<unsigned int>(layer_derived->window_sizes.size());
+			window_sizes.fill(1);
+			strides.fill(1);
+			left_zero_padding.fill(0);
+			input_dimension_sizes.fill(1);
+			output_dimension_sizes.fill(1);
+			for(unsigned int i = 0; i < dimension_count; ++i)
+			{
+				window_sizes[i] = layer_derived->window_sizes[i];
+				strides[i] = layer_derived->strides[i];
+				left_zero_padding[i] = layer_derived->left_zero_padding[i];
+				input_dimension_sizes[i] = input_configuration_specific.dimension_sizes[i];
+				output_dimension_sizes[i] = output_configuration_specific.dimension_sizes[i];
+			}
+			input_slices[0] = 1;
+			for(unsigned int i = 1; i < max_dimension_count; ++i)
+				input_slices[i] = input_slices[i - 1] * input_dimension_sizes[i - 1];
+
+			input_feature_map_count = static_cast<int>(input_configuration_specific.feature_map_count);
+			output_feature_map_count = static_cast<int>(output_configuration_specific.feature_map_count);
+			input_neuron_count_per_feature_map = static_cast<int>(input_configuration_specific.get_neuron_count_per_feature_map());
+			output_neuron_count_per_feature_map = static_cast<int>(output_configuration_specific.get_neuron_count_per_feature_map());
+			window_elem_count = 1;
+			for(unsigned int i = 0; i < dimension_count; ++i)
+				window_elem_count *= static_cast<int>(window_sizes[i]);
+			unrolled_row_count = input_feature_map_count * window_elem_count;
+
+			bool no_padding = true;
+			bool unit_window = true;
+			bool unit_stride = true;
+			bool window_covers_input = true;
+			for(unsigned int i = 0; i < dimension_count; ++i)
+			{
+				no_padding = no_padding && (layer_derived->left_zero_padding[i] == 0) && (layer_derived->right_zero_padding[i] == 0);
+				unit_window = unit_window && (window_sizes[i] == 1);
+				unit_stride = unit_stride && (strides[i] == 1);
+				window_covers_input = window_covers_input && (window_sizes[i] == input_dimension_sizes[i]);
+			}
+
+			// With no padding and the window covering the whole input the unrolled matrix of an entry is the entry itself
+			if (no_padding && window_covers_input)
+				lowering = lowering_fully_connected;
+			else if (no_padding && unit_window && unit_stride)
+				lowering = lowering_pointwise;
+			else
+				lowering = lowering_im2col;
+
+			column_tile_size = std::max(gemm_plain::nr, max_unrolled_tile_elem_count / std::max(unrolled_row_count, 1));
+			column_tile_size = std::min(column_tile_size, output_neuron_count_per_feature_map);
+		}
+
+		bool convolution_gemm_plain::is_applicable(
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific)
+		{
+			if (layer_derived->window_sizes.size() > max_dimension_count)
+				return false;
+
+			geometry g(layer_derived, input_configuration_specific, output_configuration_specific);
+
+			// Degenerate matrix shapes gain nothing from packing and blocking
+			if ((g.output_feature_map_count < min_gemm_dimension) || (g.unrolled_row_count < min_gemm_dimension))
+				return false;
+
+			return true;
+		}
+
+		size_t convolution_gemm_plain::get_workspace_elem_count_per_thread(const geometry& g)
+		{
+			size_t res = gemm_plain::get_workspace_elem_count();
+			if (g.lowering == lowering_im2col)
+				res += static_cast<size_t>(g.unrolled_row_count) * static_cast<size_t>(g.column_tile_size);
+			return res;
+		}
+
+		size_t convolution_gemm_plain::get_temporary_working_fixed_buffer_size(
+			plain_running_configuration::const_ptr plain_config,
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific)
+		{
+			geometry g(layer_derived, input_configuration_specific, output_configuration_specific);
+			return get_workspace_elem_count_per_thread(g) * plain_config->openmp_thread_count * sizeof(float);
+		}
+
+		void convolution_gemm_plain::run_forward_propagation(
+			float * output,
+			const float * input,
+			const float * weights,
+			const float * biases,
+			const convolution_epilogue_plain& epilogue,
+			float * workspace,
+			plain_running_configuration::const_ptr plain_config,
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count)
+		{
+			const geometry g(layer_derived, input_configuration_specific, output_configuration_specific);
+			const int output_neuron_count = g.output_feature_map_count * g.output_neuron_count_per_feature_map;
+			const int input_neuron_count = g.input_feature_map_count * g.input_neuron_count_per_feature_map;
+
+			if (g.lowering == lowering_fully_connected)
+			{
+				// The whole batch is a single product: output (entries x ofm) = input (entries x K) * weights^T
+				gemm_plain::run_parallel(
+					plain_config->openmp_thread_count,
+					false,
+					true,
+					static_cast<int>(entry_count),
+					g.output_feature_map_count,
+					g.unrolled_row_count,
+					1.0F,
+					input,
+					input_neuron_count,
+					weights,
+					g.unrolled_row_count,
+					0.0F,
+					output,
+					output_neuron_count,
+					workspace);
+
+				if (biases || (!epilogue.is_empty()))
+				{
+					const int const_entry_count = static_cast<int>(entry_count);
+					#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+					for(int entry_id = 0; entry_id < const_entry_count; ++entry_id)
+					{
+						float * out_it_base = output + entry_id * output_neuron_count;
+						if (biases)
+						{
+							for(int i = 0; i < output_neuron_count; ++i)
+								out_it_base[i] += biases[i];
+						}
+						epilogue.apply(out_it_base, static_cast<size_t>(entry_id * output_neuron_count), output_neuron_count);
+					}
+				}
+			}
+			else
+			{
+				const int tile_count = (g.output_neuron_count_per_feature_map + g.column_tile_size - 1) / g.column_tile_size;
+				const int total_workload = static_cast<int>(entry_count) * tile_count;
+				const size_t workspace_elem_count_per_thread = get_workspace_elem_count_per_thread(g);
+
+				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+				{
+					int thread_id = 0;
+					#ifdef _OPENMP
+					thread_id = omp_get_thread_num();
+					#endif
+
+					float * gemm_workspace = workspace + thread_id * workspace_elem_count_per_thread;
+					float * unrolled = gemm_workspace + gemm_plain::get_workspace_elem_count();
+
+					#pragma omp for schedule(dynamic)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						int entry_id = workload_id / tile_count;
+						int tile_id = workload_id - (entry_id * tile_count);
+						int column_start = tile_id * g.column_tile_size;
+						int column_count = std::min(g.column_tile_size, g.output_neuron_count_per_feature_map - column_start);
+						const float * in_it_base = input + entry_id * input_neuron_count;
+
+						const float * b;
+						int ldb;
+						if (g.lowering == lowering_pointwise)
+						{
+							b = in_it_base + column_start;
+							ldb = g.input_neuron_count_per_feature_map;
+						}
+						else
+						{
+							im2col(g, in_it_base, unrolled, 0, g.unrolled_row_count, column_start, column_start + column_count);
+							b = unrolled;
+							ldb = column_count;
+						}
+
+						gemm_plain::run(
+							false,
+							false,
+							g.output_feature_map_count,
+							column_count,
+							g.unrolled_row_count,
+							1.0F,
+							weights,
+							g.unrolled_row_count,
+							b,
+							ldb,
+							0.0F,
+							output + entry_id * output_neuron_count + column_start,
+							g.output_neuron_count_per_feature_map,
+							gemm_workspace);
+
+						// The tile is still in cache
+						if (biases || (!epilogue.is_empty()))
+						{
+							for(int output_feature_map_id = 0; output_feature_map_id < g.output_feature_map_count; ++output_feature_map_id)
+							{
+								int offset = entry_id * output_neuron_count + output_feature_map_id * g.output_neuron_count_per_feature_map + column_start;
+								float * out_it_base = output + offset;
+								if (biases)
+								{
+									float bias = biases[output_feature_map_id];
+									for(int i = 0; i < column_count; ++i)
+										out_it_base[i] += bias;
+								}
+								epilogue.apply(out_it_base, static_cast<size_t>(offset), column_count);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		void convolution_gemm_plain::run_backward_data_propagation(
+			float * input_errors,
+			const float * output_errors,
+			const float * weights,
+			float * workspace,
+			plain_running_configuration::const_ptr plain_config,
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			bool add_update_to_destination,
+			unsigned int entry_count)
+		{
+			const geometry g(layer_derived, input_configuration_specific, output_configuration_specific);
+			const int output_neuron_count = g.output_feature_map_count * g.output_neuron_count_per_feature_map;
+			const int input_neuron_count = g.input_feature_map_count * g.input_neuron_count_per_feature_map;
+			const float beta = add_update_to_destination ? 1.0F : 0.0F;
+
+			if (g.lowering == lowering_fully_connected)
+			{
+				// input errors (entries x K) = output errors (entries x ofm) * weights
+				gemm_plain::run_parallel(
+					plain_config->openmp_thread_count,
+					false,
+					false,
+					static_cast<int>(entry_count),
+					g.unrolled_row_count,
+					g.output_feature_map_count,
+					1.0F,
+					output_errors,
+					output_neuron_count,
+					weights,
+					g.unrolled_row_count,
+					beta,
+					input_errors,
+					input_neuron_count,
+					workspace);
+				return;
+			}
+
+			const size_t workspace_elem_count_per_thread = get_workspace_elem_count_per_thread(g);
+			const int tile_count = (g.output_neuron_count_per_feature_map + g.column_tile_size - 1) / g.column_tile_size;
+
+			if (g.lowering == lowering_pointwise)
+			{
+				// Columns of input errors map to columns of output errors one to one, tiles are independent
+				const int total_workload = static_cast<int>(entry_count) * tile_count;
+				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+				{
+					int thread_id = 0;
+					#ifdef _OPENMP
+					thread_id = omp_get_thread_num();
+					#endif
+
+					float * gemm_workspace = workspace + thread_id * workspace_elem_count_per_thread;
+
+					#pragma omp for schedule(dynamic)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						int entry_id = workload_id / tile_count;
+						int tile_id = workload_id - (entry_id * tile_count);
+						int column_start = tile_id * g.column_tile_size;
+						int column_count = std::min(g.column_tile_size, g.output_neuron_count_per_feature_map - column_start);
+
+						gemm_plain::run(
+							true,
+							false,
+							g.unrolled_row_count,
+							column_count,
+							g.output_feature_map_count,
+							1.0F,
+							weights,
+							g.unrolled_row_count,
+							output_errors + entry_id * output_neuron_count + column_start,
+							g.output_neuron_count_per_feature_map,
+							beta,
+							input_errors + entry_id * input_neuron_count + column_start,
+							g.input_neuron_count_per_feature_map,
+							gemm_workspace);
+					}
+				}
+				return;
+			}
+
+			// Overlapping windows scatter into the same input elements, so tiles of the same entry are processed by the same thread
+			const int total_workload = static_cast<int>(entry_count);
+			#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+			{
+				int thread_id = 0;
+				#ifdef _OPENMP
+				thread_id = omp_get_thread_num();
+				#endif
+
+				float * gemm_workspace = workspace + thread_id * workspace_elem_count_per_thread;
+				float * unrolled = gemm_workspace + gemm_plain::get_workspace_elem_count();
+
+				#pragma omp for schedule(dynamic)
+				for(int entry_id = 0; entry_id < total_workload; ++entry_id)
+				{
+					float * in_err_it_base = input_errors + entry_id * input_neuron_count;
+					if (!add_update_to_destination)
+						std::fill_n(in_err_it_base, input_neuron_count, 0.0F);
+
+					for(int tile_id = 0; tile_id < tile_count; ++tile_id)
+					{
+						int column_start = tile_id * g.column_tile_size;
+						int column_count = std::min(g.column_tile_size, g.output_neuron_count_per_feature_map - column_start);
+
+						gemm_plain::run(
+							true,
+							false,
+							g.unrolled_row_count,
+							column_count,
+							g.output_feature_map_count,
+							1.0F,
+							weights,
+							g.unrolled_row_count,
+							output_errors + entry_id * output_neuron_count + column_start,
+							g.output_neuron_count_per_feature_map,
+							0.0F,
+							unrolled,
+							column_count,
+							gemm_workspace);
+
+						col2im(g, unrolled, in_err_it_base, column_start, column_start + column_count);
+					}
+				}
+			}
+		}
+
+		void convolution_gemm_plain::run_backward_weights_propagation(
+			float * gradient_weights,
+			float * gradient_biases,
+			const float * input_neurons,
+			const float * output_errors,
+			float * workspace,
+			plain_running_configuration::const_ptr plain_config,
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count)
+		{
+			const geometry g(layer_derived, input_configuration_specific, output_configuration_specific);
+			const int output_neuron_count = g.output_feature_map_count * g.output_neuron_count_per_feature_map;
+			const int input_neuron_count = g.input_feature_map_count * g.input_neuron_count_per_feature_map;
+
+			if (g.lowering == lowering_fully_connected)
+			{
+				// gradient (ofm x K) += output errors^T (ofm x entries) * input (entries x K)
+				gemm_plain::run_parallel(
+					plain_config->openmp_thread_count,
+					true,
+					false,
+					g.output_feature_map_count,
+					g.unrolled_row_count,
+					static_cast<int>(entry_count),
+					1.0F,
+					output_errors,
+					output_neuron_count,
+					input_neurons,
+					input_neuron_count,
+					1.0F,
+					gradient_weights,
+					g.unrolled_row_count,
+					workspace);
+			}
+			else
+			{
+				// Each workload owns a block of the gradient matrix, no reduction across threads is needed
+				int block_m = 64;
+				int block_k = 256;
+				while (true)
+				{
+					int block_count = ((g.output_feature_map_count + block_m - 1) / block_m) * ((g.unrolled_row_count + block_k - 1) / block_k);
+					if (block_count >= plain_config->openmp_thread_count)
+						break;
+					if (block_m > 8)
+						block_m /= 2;
+					else if (block_k > 32)
+						block_k /= 2;
+					else
+						break;
+				}
+				const int block_m_count = (g.output_feature_map_count + block_m - 1) / block_m;
+				const int total_workload = block_m_count * ((g.unrolled_row_count + block_k - 1) / block_k);
+				const int tile_count = (g.output_neuron_count_per_feature_map + g.column_tile_size - 1) / g.column_tile_size;
+				const size_t workspace_elem_count_per_thread = get_workspace_elem_count_per_thread(g);
+				const int const_entry_count = static_cast<int>(entry_count);
+
+				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+				{
+					int thread_id = 0;
+					#ifdef _OPENMP
+					thread_id = omp_get_thread_num();
+					#endif
+
+					float * gemm_workspace = workspace + thread_id * workspace_elem_count_per_thread;
+					float * unrolled = gemm_workspace + gemm_plain::get_workspace_elem_count();
+
+					#pragma omp for schedule(dynamic)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						int block_k_id = workload_id / block_m_count;
+						int block_m_id = workload_id - (block_k_id * block_m_count);
+						int m_start = block_m_id * block_m;
+						int m_count = std::min(block_m, g.output_feature_map_count - m_start);
+						int k_start = block_k_id * block_k;
+						int k_count = std::min(block_k, g.unrolled_row_count - k_start);
+
+						for(int entry_id = 0; entry_id < const_entry_count; ++entry_id)
+						{
+							const float * in_it_base = input_neurons + entry_id * input_neuron_count;
+							const float * out_err_it_base = output_errors + entry_id * output_neuron_count + m_start * g.output_neuron_count_per_feature_map;
+
+							if (g.lowering == lowering_pointwise)
+							{
+								gemm_plain::run(
+									false,
+									true,
+									m_count,
+									k_count,
+									g.output_neuron_count_per_feature_map,
+									1.0F,
+									out_err_it_base,
+									g.output_neuron_count_per_feature_map,
+									in_it_base + k_start * g.input_neuron_count_per_feature_map,
+									g.input_neuron_count_per_feature_map,
+									1.0F,
+									gradient_weights + m_start * g.unrolled_row_count + k_start,
+									g.unrolled_row_count,
+									gemm_workspace);
+							}
+							else
+							{
+								for(int tile_id = 0; tile_id < tile_count; ++tile_id)
+								{
+									int column_start = tile_id * g.column_tile_size;
+									int column_count = std::min(g.column_tile_size, g.output_neuron_count_per_feature_map - column_start);
+
+									im2col(g, in_it_base, unrolled, k_start, k_start + k_count, column_start, column_start + column_count);
+
+									gemm_plain::run(
+										false,
+										true,
+										m_count,
+										k_count,
+										column_count,
+										1.0F,
+										out_err_it_base + column_start,
+										g.output_neuron_count_per_feature_map,
+										unrolled,
+										column_count,
+										1.0F,
+										gradient_weights + m_start * g.unrolled_row_count + k_start,
+										g.unrolled_row_count,
+										gemm_workspace);
+								}
+							}
+						}
+					}
+				}
+			}
+
+			if (gradient_biases)
+			{
+				const int output_feature_map_count = g.output_feature_map_count;
+				const int output_neuron_count_per_feature_map = g.output_neuron_count_per_feature_map;
+				const int const_entry_count = static_cast<int>(entry_count);
+				#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				for(int output_feature_map_id = 0; output_feature_map_id < output_feature_map_count; ++output_feature_map_id)
+				{
+					float sum = 0.0F;
+					for(int entry_id = 0; entry_id < const_entry_count; ++entry_id)
+					{
+						float local_sum = 0.0F;
+						const float * out_err_it_base = output_errors + entry_id * output_neuron_count + output_feature_map_id * output_neuron_count_per_feature_map;
+						for(int i = 0; i < output_neuron_count_per_feature_map; ++i)
+							local_sum += out_err_it_base[i];
+						sum += local_sum;
+					}
+					gradient_biases[output_feature_map_id] += sum;
+				}
+			}
+		}
+
+		void convolution_gemm_plain::im2col(
+			const geometry& g,
+			const float * input,
+			float * unrolled,
+			int row_start,
+			int row_end,
+			int column_start,
+			int column_end)
+		{
+			const int column_count = column_end - column_start;
+			const int output_width = static_cast<int>(g.output_dimension_sizes[0]);
+			const int input_width = static_cast<int>(g.input_dimension_sizes[0]);
+			const int stride_x = static_cast<int>(g.strides[0]);
+			const int padding_x = static_cast<int>(g.left_zero_padding[0]);
+
+			for(int row_id = row_start; row_id < row_end; ++row_id)
+			{
+				int input_feature_map_id = row_id / g.window_elem_count;
+				int window_elem_id = row_id - (input_feature_map_id * g.window_elem_count);
+				std::array<int, max_dimension_count> window_position;
+				for(unsigned int i = 0; i < max_dimension_count; ++i)
+				{
+					window_position[i] = window_elem_id % static_cast<int>(g.window_sizes[i]);
+					window_elem_id /= static_cast<int>(g.window_sizes[i]);
+				}
+				const float * in_it_base = input + input_feature_map_id * g.input_neuron_count_per_feature_map;
+				float * dst = unrolled + (row_id - row_start) * column_count;
+
+				// Walk output positions row by row, checking the higher dimensions once per output row
+				int column_id = column_start;
+				while (column_id < column_end)
+				{
+					std::array<int, max_dimension_count> output_position;
+					int rem = column_id;
+					for(unsigned int i = 0; i < max_dimension_count; ++i)
+					{
+						output_position[i] = rem % static_cast<int>(g.output_dimension_sizes[i]);
+						rem /= static_cast<int>(g.output_dimension_sizes[i]);
+					}
+					int run_length = std::min(output_width - output_position[0], column_end - column_id);
+
+					bool fit = true;
+					int in_offset = 0;
+					for(unsigned int i = 1; i < max_dimension_count; ++i)
+					{
+						int input_position = output_position[i] * static_cast<int>(g.strides[i]) - static_cast<int>(g.left_zero_padding[i]) + window_position[i];
+						fit = fit && (static_cast<unsigned int>(input_position) < g.input_dimension_sizes[i]);
+						in_offset += input_position * static_cast<int>(g.input_slices[i]);
+					}
+
+					if (fit)
+					{
+						const float * in_it = in_it_base + in_offset;
+						int x = output_position[0] * stride_x - padding_x + window_position[0];
+						for(int j = 0; j < run_length; ++j, x += stride_x)
+							dst[j] = (static_cast<unsigned int>(x) < static_cast<unsigned int>(input_width)) ? in_it[x] : 0.0F;
+					}
+					else
+						std::fill_n(dst, run_length, 0.0F);
+
+					dst += run_length;
+					column_id += run_length;
+				}
+			}
+		}
+
+		void convolution_gemm_plain::col2im(
+			const geometry& g,
+			const float * unrolled,
+			float * input_errors,
+			int column_start,
+			int column_end)
+		{
+			const int column_count = column_end - column_start;
+			const int output_width = static_cast<int>(g.output_dimension_sizes[0]);
+			const int input_width = static_cast<int>(g.input_dimension_sizes[0]);
+			const int stride_x = static_cast<int>(g.strides[0]);
+			const int padding_x = static_cast<int>(g.left_zero_padding[0]);
+
+			for(int row_id = 0; row_id < g.unrolled_row_count; ++row_id)
+			{
+				int input_feature_map_id = row_id / g.window_elem_count;
+				int window_elem_id = row_id - (input_feature_map_id * g.window_elem_count);
+				std::array<int, max_dimension_count> window_position;
+				for(unsigned int i = 0; i < max_dimension_count; ++i)
+				{
+					window_position[i] = window_elem_id % static_cast<int>(g.window_sizes[i]);
+					window_elem_id /= static_cast<int>(g.window_sizes[i]);
+				}
+				float * in_err_it_base = input_errors + input_feature_map_id * g.input_neuron_count_per_feature_map;
+				const float * src = unrolled + row_id * column_count;
+
+				int column_id = column_start;
+				while (column_id < column_end)
+				{
+					std::array<int, max_dimension_count> output_position;
+					int rem = column_id;
+					for(unsigned int i = 0; i < max_dimension_count; ++i)
+					{
+						output_position[i] = rem % static_cast<int>(g.output_dimension_sizes[i]);
+						rem /= static_cast<int>(g.output_dimension_sizes[i]);
+					}
+					int run_length = std::min(output_width - output_position[0], column_end - column_id);
+
+					bool fit = true;
+					int in_offset = 0;
+					for(unsigned int i = 1; i < max_dimension_count; ++i)
+					{
+						int input_position = output_position[i] * static_cast<int>(g.strides[i]) - static_cast<int>(g.left_zero_padding[i]) + window_position[i];
+						fit = fit && (static_cast<unsigned int>(input_position) < g.input_dimension_sizes[i]);
+						in_offset += input_position * static_cast<int>(g.input_slices[i]);
+					}
+
+					if (fit)
+					{
+						float * in_err_it = in_err_it_base + in_offset;
+						int x = output_position[0] * stride_x - padding_x + window_position[0];
+						for(int j = 0; j < run_length; ++j, x += stride_x)
+							if (static_cast<unsigned int>(x) < static_cast<unsigned int>(input_width))
+								in_err_it[x] += src[j];
+					}
+
+					src += run_length;
+					column_id += run_length;
+				}
+			}
+		}
+	}
+}
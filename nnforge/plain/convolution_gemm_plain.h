@@ -0,0 +1,155 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../convolution_layer.h"
+#include "../layer_configuration_specific.h"
+
+#include "plain_running_configuration.h"
+#include "convolution_epilogue_plain.h"
+
+#include <array>
+#include <memory>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Lowers convolution to matrix products handled by gemm_plain.
+		// Weights are treated as output_feature_map_count x (input_feature_map_count * window_elem_count) matrix,
+		// input of each entry is unrolled (im2col) into (input_feature_map_count * window_elem_count) x output_neuron_count_per_feature_map matrix.
+		// 1x1 stride 1 unpadded convolutions and fully connected convolutions use input buffers directly without unrolling.
+		class convolution_gemm_plain
+		{
+		public:
+			// Returns false for the cases the direct implementation handles better
+			static bool is_applicable(
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific);
+
+			static size_t get_temporary_working_fixed_buffer_size(
+				plain_running_configuration::const_ptr plain_config,
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific);
+
+			// Biases and the epilogue are applied to each block of the output right after it is computed
+			static void run_forward_propagation(
+				float * output,
+				const float * input,
+				const float * weights,
+				const float * biases,
+				const convolution_epilogue_plain& epilogue,
+				float * workspace,
+				plain_running_configuration::const_ptr plain_config,
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count);
+
+			static void run_backward_data_propagation(
+				float * input_errors,
+				const float * output_errors,
+				const float * weights,
+				float * workspace,
+				plain_running_configuration::const_ptr plain_config,
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				bool add_update_to_destination,
+				unsigned int entry_count);
+
+			// Accumulates weight and bias (if gradient_biases is not null) gradients
+			static void run_backward_weights_propagation(
+				float * gradient_weights,
+				float * gradient_biases,
+				const float * input_neurons,
+				const float * output_errors,
+				float * workspace,
+				plain_running_configuration::const_ptr plain_config,
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count);
+
+		private:
+			static const int max_dimension_count = 4;
+
+			enum lowering_type
+			{
+				lowering_im2col,
+				lowering_pointwise,
+				lowering_fully_connected
+			};
+
+			struct geometry
+			{
+				geometry(
+					std::shared_ptr<const convolution_layer> layer_derived,
+					const layer_configuration_specific& input_configuration_specific,
+					const layer_configuration_specific& output_configuration_specific);
+
+				lowering_type lowering;
+				unsigned int dimension_count;
+				std::array<unsigned int, max_dimension_count> window_sizes;
+				std::array<unsigned int, max_dimension_count> strides;
+				std::array<unsigned int, max_dimension_count> left_zero_padding;
+				std::array<unsigned int, max_dimension_count> input_dimension_sizes;
+				std::array<unsigned int, max_dimension_count> output_dimension_sizes;
+				std::array<unsigned int, max_dimension_count> input_slices;
+				int input_feature_map_count;
+				int output_feature_map_count;
+				int window_elem_count;
+				int input_neuron_count_per_feature_map;
+				int output_neuron_count_per_feature_map;
+				// Rows of the unrolled input matrix
+				int unrolled_row_count;
+				// Columns of the unrolled input matrix processed at once
+				int column_tile_size;
+			};
+
+			// Writes rows [row_start, row_end) and columns [column_start, column_end) of the unrolled input of a single entry
+			static void im2col(
+				const geometry& g,
+				const float * input,
+				float * unrolled,
+				int row_start,
+				int row_end,
+				int column_start,
+				int column_end);
+
+			// Adds the unrolled errors matrix (all rows, columns [column_start, column_end)) to the input errors of a single entry
+			static void col2im(
+				const geometry& g,
+				const float * unrolled,
+				float * input_errors,
+				int column_start,
+				int column_end);
+
+			static size_t get_workspace_elem_count_per_thread(const geometry& g);
+
+			static const int min_gemm_dimension;
+			static const int max_unrolled_tile_elem_count;
+
+		private:
+			convolution_gemm_plain() = delete;
+			convolution_gemm_plain(const convolution_gemm_plain&) = delete;
+			convolution_gemm_plain& operator =(const convolution_gemm_plain&) = delete;
+		};
+	}
+}
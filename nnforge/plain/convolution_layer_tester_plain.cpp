@@ -17,6 +17,9 @@
 #include "convolution_layer_tester_plain.h"
 
 #include "../convolution_layer.h"
+#include "convolution_gemm_plain.h"
+#include "convolution_winograd_plain.h"
+#include "fused_convolution_layer_plain.h"
 
 #include <array>
 
@@ -52,6 +55,49 @@ namespace nnforge
 			const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
 
+			// Layers fused for inference take the residual from the second input
+			convolution_epilogue_plain epilogue;
+			fused_convolution_layer_plain::const_ptr fused_layer = std::dynamic_pointer_cast<const fused_convolution_layer_plain>(layer_schema);
+			if (fused_layer)
+				epilogue = convolution_epilogue_plain(fused_layer->residual ? static_cast<const float *>(*input_buffers[1]) : 0, fused_layer->relu);
+
+			if (convolution_winograd_plain::is_applicable(layer_derived))
+			{
+				// data holds weights transformed for both tile sizes followed by biases, see get_transformed_data
+				int tile_size = convolution_winograd_plain::get_tile_size(output_configuration_specific);
+				convolution_winograd_plain::run_forward_propagation(
+					out_it_global,
+					in_it_global,
+					0,
+					&(*data)[(tile_size == 4) ? 1 : 0][0],
+					layer_derived->bias ? &(*data)[2][0] : 0,
+					epilogue,
+					*temporary_working_fixed_buffer,
+					plain_config,
+					layer_derived,
+					input_configuration_specific_list[0],
+					output_configuration_specific,
+					entry_count);
+				return;
+			}
+
+			if (convolution_gemm_plain::is_applicable(layer_derived, input_configuration_specific_list[0], output_configuration_specific))
+			{
+				convolution_gemm_plain::run_forward_propagation(
+					out_it_global,
+					in_it_global,
+					&(*data)[0][0],
+					layer_derived->bias ? &(*data)[1][0] : 0,
+					epilogue,
+					*temporary_working_fixed_buffer,
+					plain_config,
+					layer_derived,
+					input_configuration_specific_list[0],
+					output_configuration_specific,
+					entry_count);
+				return;
+			}
+
 			const bool bias = layer_derived->bias;
 
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
@@ -107,12 +153,13 @@ namespace nnforge
 			const unsigned int output_feature_map_count = output_configuration_specific.feature_map_count;
 			const unsigned int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
 			const int total_workload = entry_count * output_feature_map_count;
+			const bool apply_epilogue = !epilogue.is_empty();
 			const std::vector<unsigned int>::const_iterator output_dimension_sizes_it = output_configuration_specific.dimension_sizes.begin();
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes,epilogue)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
@@ -168,7 +215,7 @@ namespace nnforge
 								}
 							}
 						}
-						*out_it = sum;
+						*out_it = apply_epilogue ? epilogue.apply(sum, static_cast<size_t>(out_it - out_it_global)) : sum;
 
 						// Go to the next output element
 						for(unsigned int i = 0; i < dimension_count; ++i)
@@ -181,5 +228,66 @@ namespace nnforge
 				}
 			}
 		}
+
+		size_t convolution_layer_tester_plain::get_temporary_working_fixed_buffer_size(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
+			if (convolution_winograd_plain::is_applicable(layer_derived))
+				return convolution_winograd_plain::get_temporary_working_fixed_buffer_size(plain_config, layer_derived, input_configuration_specific_list[0], output_configuration_specific, false, false);
+			else if (convolution_gemm_plain::is_applicable(layer_derived, input_configuration_specific_list[0], output_configuration_specific))
+				return convolution_gemm_plain::get_temporary_working_fixed_buffer_size(plain_config, layer_derived, input_configuration_specific_list[0], output_configuration_specific);
+			else
+				return 0;
+		}
+
+		layer_data::const_ptr convolution_layer_tester_plain::get_transformed_data(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data) const
+		{
+			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
+			if (!convolution_winograd_plain::is_applicable(layer_derived))
+				return layer_data::const_ptr();
+
+			// Tile size depends on the input configuration, so weights are transformed for both
+			const int output_feature_map_count = static_cast<int>(layer_derived->output_feature_map_count);
+			const int input_feature_map_count = static_cast<int>(layer_derived->input_feature_map_count);
+			layer_data::ptr res(new layer_data());
+			res->resize(layer_derived->bias ? 3 : 2);
+			for(int i = 0; i < 2; ++i)
+			{
+				int tile_size = (i == 0) ? 2 : 4;
+				(*res)[i].resize(convolution_winograd_plain::get_transformed_weights_elem_count(tile_size, output_feature_map_count, input_feature_map_count));
+				convolution_winograd_plain::transform_weights(
+					&(*res)[i][0],
+					&(*data)[0][0],
+					tile_size,
+					output_feature_map_count,
+					input_feature_map_count,
+					false,
+					plain_config);
+			}
+			if (layer_derived->bias)
+				(*res)[2] = (*data)[1];
+
+			return res;
+		}
+
+		float convolution_layer_tester_plain::get_flops_per_entry(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
+			if (convolution_winograd_plain::is_applicable(layer_derived))
+				return convolution_winograd_plain::get_flops_per_entry(layer_derived, input_configuration_specific_list[0], output_configuration_specific, false);
+			else
+				return layer_schema->get_flops_per_entry(input_configuration_specific_list, layer_action(layer_action::forward));
+		}
 	}
 }
@@ -17,6 +17,8 @@
 #include "convolution_layer_updater_plain.h"
 
 #include "../convolution_layer.h"
+#include "convolution_gemm_plain.h"
+#include "convolution_winograd_plain.h"
 
 #include <array>
 
@@ -54,6 +56,42 @@ namespace nnforge
 			float * const out_it_global = *output_buffer;
 			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
 
+			if (convolution_winograd_plain::is_applicable(layer_derived))
+			{
+				// Weights change every batch, they are transformed into the working buffer
+				convolution_winograd_plain::run_forward_propagation(
+					out_it_global,
+					in_it_global,
+					&(*data)[0][0],
+					0,
+					layer_derived->bias ? &(*data)[1][0] : 0,
+					convolution_epilogue_plain(),
+					*temporary_working_fixed_buffer,
+					plain_config,
+					layer_derived,
+					input_configuration_specific_list[0],
+					output_configuration_specific,
+					entry_count);
+				return;
+			}
+
+			if (convolution_gemm_plain::is_applicable(layer_derived, input_configuration_specific_list[0], output_configuration_specific))
+			{
+				convolution_gemm_plain::run_forward_propagation(
+					out_it_global,
+					in_it_global,
+					&(*data)[0][0],
+					layer_derived->bias ? &(*data)[1][0] : 0,
+					convolution_epilogue_plain(),
+					*temporary_working_fixed_buffer,
+					plain_config,
+					layer_derived,
+					input_configuration_specific_list[0],
+					output_configuration_specific,
+					entry_count);
+				return;
+			}
+
 			const bool bias = layer_derived->bias;
 
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
@@ -211,6 +249,38 @@ namespace nnforge
 			const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
 
+			if (convolution_winograd_plain::is_applicable(layer_derived))
+			{
+				convolution_winograd_plain::run_backward_data_propagation(
+					in_err_it_global,
+					out_err_it_global,
+					&(*data)[0][0],
+					*temporary_working_fixed_buffer,
+					plain_config,
+					layer_derived,
+					input_configuration_specific_list[0],
+					output_configuration_specific,
+					add_update_to_destination,
+					entry_count);
+				return;
+			}
+
+			if (convolution_gemm_plain::is_applicable(layer_derived, input_configuration_specific_list[0], output_configuration_specific))
+			{
+				convolution_gemm_plain::run_backward_data_propagation(
+					in_err_it_global,
+					out_err_it_global,
+					&(*data)[0][0],
+					*temporary_working_fixed_buffer,
+					plain_config,
+					layer_derived,
+					input_configuration_specific_list[0],
+					output_configuration_specific,
+					add_update_to_destination,
+					entry_count);
+				return;
+			}
+
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
 			window_sizes_extended.resize(max_dimension_count, 1);
 			const std::vector<unsigned int>& window_sizes = window_sizes_extended;
@@ -369,6 +439,22 @@ namespace nnforge
 
 			const bool bias = layer_derived->bias;
 
+			if (convolution_gemm_plain::is_applicable(layer_derived, input_configuration_specific_list[0], output_configuration_specific))
+			{
+				convolution_gemm_plain::run_backward_weights_propagation(
+					&(*gradient)[0][0],
+					bias ? &(*gradient)[1][0] : 0,
+					in_it_global,
+					out_err_it_global,
+					*temporary_working_fixed_buffer,
+					plain_config,
+					layer_derived,
+					input_configuration_specific_list[0],
+					output_configuration_specific,
+					entry_count);
+				return;
+			}
+
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
 			window_sizes_extended.resize(max_dimension_count, 1);
 			const std::vector<unsigned int>& window_sizes = window_sizes_extended;
@@ -552,6 +638,46 @@ namespace nnforge
 			return false;
 		}
 
+		size_t convolution_layer_updater_plain::get_temporary_working_fixed_buffer_size(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			switch (action.get_action_type())
+			{
+			case layer_action::forward:
+			case layer_action::backward_data:
+				{
+					std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
+					if (convolution_winograd_plain::is_applicable(layer_derived))
+						return convolution_winograd_plain::get_temporary_working_fixed_buffer_size(
+							plain_config,
+							layer_derived,
+							input_configuration_specific_list[0],
+							output_configuration_specific,
+							action.get_action_type() == layer_action::backward_data,
+							true);
+					else if (convolution_gemm_plain::is_applicable(layer_derived, input_configuration_specific_list[0], output_configuration_specific))
+						return convolution_gemm_plain::get_temporary_working_fixed_buffer_size(plain_config, layer_derived, input_configuration_specific_list[0], output_configuration_specific);
+					else
+						return 0;
+				}
+			case layer_action::backward_weights:
+				{
+					std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
+					if (convolution_gemm_plain::is_applicable(layer_derived, input_configuration_specific_list[0], output_configuration_specific))
+						return convolution_gemm_plain::get_temporary_working_fixed_buffer_size(plain_config, layer_derived, input_configuration_specific_list[0], output_configuration_specific);
+					else
+						return 0;
+				}
+			default:
+				return 0;
+			}
+		}
+
 		bool convolution_layer_updater_plain::is_backward_weights_dependent_on_input_buffer(
 			unsigned int data_input_index,
 			const std::set<layer_action>& actions,
@@ -562,5 +688,31 @@ namespace nnforge
 		{
 			return true;
 		}
+
+		float convolution_layer_updater_plain::get_flops_per_entry(
+			const layer_action& action,
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
+			switch (action.get_action_type())
+			{
+			case layer_action::forward:
+			case layer_action::backward_data:
+				if (convolution_winograd_plain::is_applicable(layer_derived))
+					return convolution_winograd_plain::get_flops_per_entry(
+						layer_derived,
+						input_configuration_specific_list[0],
+						output_configuration_specific,
+						action.get_action_type() == layer_action::backward_data);
+				else
+					return layer_schema->get_flops_per_entry(input_configuration_specific_list, action);
+			default:
+				return layer_schema->get_flops_per_entry(input_configuration_specific_list, action);
+			}
+		}
 	}
 }
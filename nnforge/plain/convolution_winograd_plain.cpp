@@ -0,0 +1,618 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_winograd_plain.h"
+
+#include "gemm_plain.h"
+#include "convolution_gemm_plain.h"
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const int convolution_winograd_plain::min_feature_map_count = 4;
+		const int convolution_winograd_plain::max_transformed_block_elem_count = 1 << 20;
+		// F(4x4,3x3) transforms lose about 2 decimal digits compared to the direct sum, measured differences stay around 1e-5
+		const float convolution_winograd_plain::max_relative_difference_to_gemm = 1.0e-4F;
+
+		template<>
+		struct convolution_winograd_plain::transform_matrices<2>
+		{
+			static const float bt[4][4];
+			static const float g[4][3];
+			static const float at[2][4];
+		};
+
+		const float convolution_winograd_plain::transform_matrices<2>::bt[4][4] = {
+			{ 1.0F,  0.0F, -1.0F,  0.0F },
+			{ 0.0F,  1.0F,  1.0F,  0.0F },
+			{ 0.0F, -1.0F,  1.0F,  0.0F },
+			{ 0.0F,  1.0F,  0.0F, -1.0F } };
+
+		const float convolution_winograd_plain::transform_matrices<2>::g[4][3] = {
+			{ 1.0F,  0.0F, 0.0F },
+			{ 0.5F,  0.5F, 0.5F },
+			{ 0.5F, -0.5F, 0.5F },
+			{ 0.0F,  0.0F, 1.0F } };
+
+		const float convolution_winograd_plain::transform_matrices<2>::at[2][4] = {
+			{ 1.0F, 1.0F,  1.0F,  0.0F },
+			{ 0.0F, 1.0F, -1.0F, -1.0F } };
+
+		template<>
+		struct convolution_winograd_plain::transform_matrices<4>
+		{
+			static const float bt[6][6];
+			static const float g[6][3];
+			static const float at[4][6];
+		};
+
+		const float convolution_winograd_plain::transform_matrices<4>::bt[6][6] = {
+			{ 4.0F,  0.0F, -5.0F,  0.0F, 1.0F, 0.0F },
+			{ 0.0F, -4.0F, -4.0F,  1.0F, 1.0F, 0.0F },
+			{ 0.0F,  4.0F, -4.0F, -1.0F, 1.0F, 0.0F },
+			{ 0.0F, -2.0F, -1.0F,  2.0F, 1.0F, 0.0F },
+			{ 0.0F,  2.0F, -1.0F, -2.0F, 1.0F, 0.0F },
+			{ 0.0F,  4.0F,  0.0F, -5.0F, 0.0F, 1.0F } };
+
+		const float convolution_winograd_plain::transform_matrices<4>::g[6][3] = {
+			{ 1.0F / 4.0F,   0.0F,          0.0F },
+			{ -1.0F / 6.0F,  -1.0F / 6.0F,  -1.0F / 6.0F },
+			{ -1.0F / 6.0F,  1.0F / 6.0F,   -1.0F / 6.0F },
+			{ 1.0F / 24.0F,  1.0F / 12.0F,  1.0F / 6.0F },
+			{ 1.0F / 24.0F,  -1.0F / 12.0F, 1.0F / 6.0F },
+			{ 0.0F,          0.0F,          1.0F } };
+
+		const float convolution_winograd_plain::transform_matrices<4>::at[4][6] = {
+			{ 1.0F, 1.0F,  1.0F, 1.0F,  1.0F, 0.0F },
+			{ 0.0F, 1.0F, -1.0F, 2.0F, -2.0F, 0.0F },
+			{ 0.0F, 1.0F,  1.0F, 4.0F,  4.0F, 0.0F },
+			{ 0.0F, 1.0F, -1.0F, 8.0F, -8.0F, 1.0F } };
+
+		convolution_winograd_plain::geometry::geometry(
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			bool backward_data)
+		{
+			const layer_configuration_specific& source_configuration_specific = backward_data ? output_configuration_specific : input_configuration_specific;
+			const layer_configuration_specific& destination_configuration_specific = backward_data ? input_configuration_specific : output_configuration_specific;
+
+			tile_size = get_tile_size(destination_configuration_specific);
+			transformed_tile_elem_count = (tile_size + 2) * (tile_size + 2);
+			source_feature_map_count = static_cast<int>(source_configuration_specific.feature_map_count);
+			destination_feature_map_count = static_cast<int>(destination_configuration_specific.feature_map_count);
+			source_width = static_cast<int>(source_configuration_specific.dimension_sizes[0]);
+			source_height = static_cast<int>(source_configuration_specific.dimension_sizes[1]);
+			destination_width = static_cast<int>(destination_configuration_specific.dimension_sizes[0]);
+			destination_height = static_cast<int>(destination_configuration_specific.dimension_sizes[1]);
+
+			// Backward data propagation is the convolution of output errors with the flipped window,
+			// left padding becomes window size - 1 - left padding, right padding is implied by the sizes
+			left_zero_padding_x = static_cast<int>(layer_derived->left_zero_padding[0]);
+			left_zero_padding_y = static_cast<int>(layer_derived->left_zero_padding[1]);
+			if (backward_data)
+			{
+				left_zero_padding_x = 2 - left_zero_padding_x;
+				left_zero_padding_y = 2 - left_zero_padding_y;
+			}
+
+			tile_count_x = (destination_width + tile_size - 1) / tile_size;
+			tile_count_per_entry = tile_count_x * ((destination_height + tile_size - 1) / tile_size);
+
+			tile_block_size = std::max(gemm_plain::nr, max_transformed_block_elem_count / (transformed_tile_elem_count * (source_feature_map_count + destination_feature_map_count)));
+			tile_block_size = std::min(tile_block_size, tile_count_per_entry);
+		}
+
+		bool convolution_winograd_plain::is_applicable(std::shared_ptr<const convolution_layer> layer_derived)
+		{
+			if (layer_derived->window_sizes.size() != 2)
+				return false;
+
+			for(unsigned int i = 0; i < 2; ++i)
+			{
+				if ((layer_derived->window_sizes[i] != 3) || (layer_derived->strides[i] != 1))
+					return false;
+				if ((layer_derived->left_zero_padding[i] > 2) || (layer_derived->right_zero_padding[i] > 2))
+					return false;
+			}
+
+			// Transforms would dominate products for few feature maps
+			if ((layer_derived->input_feature_map_count < static_cast<unsigned int>(min_feature_map_count)) || (layer_derived->output_feature_map_count < static_cast<unsigned int>(min_feature_map_count)))
+				return false;
+
+			return true;
+		}
+
+		int convolution_winograd_plain::get_tile_size(const layer_configuration_specific& output_configuration_specific)
+		{
+			int width = static_cast<int>(output_configuration_specific.dimension_sizes[0]);
+			int height = static_cast<int>(output_configuration_specific.dimension_sizes[1]);
+			int multiplication_count_2 = ((width + 1) / 2) * ((height + 1) / 2) * 16;
+			int multiplication_count_4 = ((width + 3) / 4) * ((height + 3) / 4) * 36;
+			return (multiplication_count_4 < multiplication_count_2) ? 4 : 2;
+		}
+
+		size_t convolution_winograd_plain::get_transformed_weights_elem_count(
+			int tile_size,
+			int output_feature_map_count,
+			int input_feature_map_count)
+		{
+			return static_cast<size_t>((tile_size + 2) * (tile_size + 2)) * static_cast<size_t>(output_feature_map_count) * static_cast<size_t>(input_feature_map_count);
+		}
+
+		void convolution_winograd_plain::transform_weights(
+			float * transformed_weights,
+			const float * weights,
+			int tile_size,
+			int output_feature_map_count,
+			int input_feature_map_count,
+			bool flip,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const int pair_count = output_feature_map_count * input_feature_map_count;
+
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			for(int pair_id = 0; pair_id < pair_count; ++pair_id)
+			{
+				int output_feature_map_id = pair_id / input_feature_map_count;
+				int input_feature_map_id = pair_id - (output_feature_map_id * input_feature_map_count);
+				float * dst = transformed_weights + (flip ? (input_feature_map_id * output_feature_map_count + output_feature_map_id) : pair_id);
+				const float * window = weights + pair_id * 9;
+				if (tile_size == 4)
+					transform_weights_window<4>(dst, window, pair_count, flip);
+				else
+					transform_weights_window<2>(dst, window, pair_count, flip);
+			}
+		}
+
+		template<int tile_size>
+		void convolution_winograd_plain::transform_weights_window(
+			float * transformed_weights,
+			const float * window,
+			int elem_stride,
+			bool flip)
+		{
+			const int alpha = tile_size + 2;
+			const float (&g)[alpha][3] = transform_matrices<tile_size>::g;
+
+			float w[3][3];
+			for(int y = 0; y < 3; ++y)
+				for(int x = 0; x < 3; ++x)
+					w[y][x] = flip ? window[(2 - y) * 3 + (2 - x)] : window[y * 3 + x];
+
+			float tmp[alpha][3];
+			for(int i = 0; i < alpha; ++i)
+				for(int x = 0; x < 3; ++x)
+					tmp[i][x] = g[i][0] * w[0][x] + g[i][1] * w[1][x] + g[i][2] * w[2][x];
+
+			for(int i = 0; i < alpha; ++i)
+				for(int j = 0; j < alpha; ++j)
+					transformed_weights[(i * alpha + j) * elem_stride] = tmp[i][0] * g[j][0] + tmp[i][1] * g[j][1] + tmp[i][2] * g[j][2];
+		}
+
+		template<int tile_size>
+		void convolution_winograd_plain::transform_source_block(
+			float * transformed_source,
+			const float * source,
+			const geometry& g,
+			int tile_start,
+			int tile_count)
+		{
+			const int alpha = tile_size + 2;
+			const float (&bt)[alpha][alpha] = transform_matrices<tile_size>::bt;
+			const int source_elem_count_per_feature_map = g.source_width * g.source_height;
+			const int matrix_elem_count = g.source_feature_map_count * g.tile_block_size;
+
+			for(int source_feature_map_id = 0; source_feature_map_id < g.source_feature_map_count; ++source_feature_map_id)
+			{
+				const float * src = source + source_feature_map_id * source_elem_count_per_feature_map;
+				float * dst_base = transformed_source + source_feature_map_id * g.tile_block_size;
+				for(int t = 0; t < tile_count; ++t)
+				{
+					int tile_id = tile_start + t;
+					int tile_y = tile_id / g.tile_count_x;
+					int tile_x = tile_id - (tile_y * g.tile_count_x);
+					int y0 = tile_y * tile_size - g.left_zero_padding_y;
+					int x0 = tile_x * tile_size - g.left_zero_padding_x;
+
+					float d[alpha][alpha];
+					if ((y0 >= 0) && (x0 >= 0) && (y0 + alpha <= g.source_height) && (x0 + alpha <= g.source_width))
+					{
+						for(int y = 0; y < alpha; ++y)
+						{
+							const float * src_row = src + (y0 + y) * g.source_width + x0;
+							for(int x = 0; x < alpha; ++x)
+								d[y][x] = src_row[x];
+						}
+					}
+					else
+					{
+						for(int y = 0; y < alpha; ++y)
+						{
+							int yy = y0 + y;
+							bool row_inside = (yy >= 0) && (yy < g.source_height);
+							for(int x = 0; x < alpha; ++x)
+							{
+								int xx = x0 + x;
+								d[y][x] = (row_inside && (xx >= 0) && (xx < g.source_width)) ? src[yy * g.source_width + xx] : 0.0F;
+							}
+						}
+					}
+
+					float tmp[alpha][alpha];
+					for(int i = 0; i < alpha; ++i)
+						for(int x = 0; x < alpha; ++x)
+						{
+							float sum = 0.0F;
+							for(int k = 0; k < alpha; ++k)
+								sum += bt[i][k] * d[k][x];
+							tmp[i][x] = sum;
+						}
+
+					float * dst = dst_base + t;
+					for(int i = 0; i < alpha; ++i)
+						for(int j = 0; j < alpha; ++j)
+						{
+							float sum = 0.0F;
+							for(int k = 0; k < alpha; ++k)
+								sum += tmp[i][k] * bt[j][k];
+							dst[(i * alpha + j) * matrix_elem_count] = sum;
+						}
+				}
+			}
+		}
+
+		template<int tile_size>
+		void convolution_winograd_plain::transform_destination_block(
+			float * destination,
+			const float * products,
+			const float * biases,
+			const convolution_epilogue_plain& epilogue,
+			size_t destination_offset,
+			const geometry& g,
+			int tile_start,
+			int tile_count,
+			bool add_to_destination)
+		{
+			const int alpha = tile_size + 2;
+			const float (&at)[tile_size][alpha] = transform_matrices<tile_size>::at;
+			const int destination_elem_count_per_feature_map = g.destination_width * g.destination_height;
+			const int matrix_elem_count = g.destination_feature_map_count * g.tile_block_size;
+			const bool apply_epilogue = !epilogue.is_empty();
+
+			for(int destination_feature_map_id = 0; destination_feature_map_id < g.destination_feature_map_count; ++destination_feature_map_id)
+			{
+				float * dst = destination + destination_feature_map_id * destination_elem_count_per_feature_map;
+				const float * src_base = products + destination_feature_map_id * g.tile_block_size;
+				const float bias = biases ? biases[destination_feature_map_id] : 0.0F;
+				for(int t = 0; t < tile_count; ++t)
+				{
+					int tile_id = tile_start + t;
+					int tile_y = tile_id / g.tile_count_x;
+					int tile_x = tile_id - (tile_y * g.tile_count_x);
+					int y0 = tile_y * tile_size;
+					int x0 = tile_x * tile_size;
+
+					const float * src = src_base + t;
+					float m[alpha][alpha];
+					for(int i = 0; i < alpha; ++i)
+						for(int j = 0; j < alpha; ++j)
+							m[i][j] = src[(i * alpha + j) * matrix_elem_count];
+
+					float tmp[tile_size][alpha];
+					for(int i = 0; i < tile_size; ++i)
+						for(int x = 0; x < alpha; ++x)
+						{
+							float sum = 0.0F;
+							for(int k = 0; k < alpha; ++k)
+								sum += at[i][k] * m[k][x];
+							tmp[i][x] = sum;
+						}
+
+					int y_count = std::min(tile_size, g.destination_height - y0);
+					int x_count = std::min(tile_size, g.destination_width - x0);
+					for(int i = 0; i < y_count; ++i)
+					{
+						float * dst_row = dst + (y0 + i) * g.destination_width + x0;
+						for(int j = 0; j < x_count; ++j)
+						{
+							float sum = bias;
+							for(int k = 0; k < alpha; ++k)
+								sum += tmp[i][k] * at[j][k];
+							if (apply_epilogue)
+								sum = epilogue.apply(sum, destination_offset + static_cast<size_t>(dst_row + j - destination));
+							if (add_to_destination)
+								dst_row[j] += sum;
+							else
+								dst_row[j] = sum;
+						}
+					}
+				}
+			}
+		}
+
+		size_t convolution_winograd_plain::get_workspace_elem_count_per_thread(const geometry& g)
+		{
+			return gemm_plain::get_workspace_elem_count()
+				+ static_cast<size_t>(g.transformed_tile_elem_count) * static_cast<size_t>(g.tile_block_size) * static_cast<size_t>(g.source_feature_map_count + g.destination_feature_map_count);
+		}
+
+		size_t convolution_winograd_plain::get_temporary_working_fixed_buffer_size(
+			plain_running_configuration::const_ptr plain_config,
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			bool backward_data,
+			bool transform_weights_in_workspace)
+		{
+			geometry g(layer_derived, input_configuration_specific, output_configuration_specific, backward_data);
+			size_t res = get_workspace_elem_count_per_thread(g) * plain_config->openmp_thread_count;
+			if (transform_weights_in_workspace)
+				res += get_transformed_weights_elem_count(g.tile_size, g.destination_feature_map_count, g.source_feature_map_count);
+			return res * sizeof(float);
+		}
+
+		void convolution_winograd_plain::run_forward_propagation(
+			float * output,
+			const float * input,
+			const float * weights,
+			const float * transformed_weights,
+			const float * biases,
+			const convolution_epilogue_plain& epilogue,
+			float * workspace,
+			plain_running_configuration::const_ptr plain_config,
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count)
+		{
+			const geometry g(layer_derived, input_configuration_specific, output_configuration_specific, false);
+
+			float * run_workspace = workspace;
+			if (!transformed_weights)
+			{
+				transform_weights(workspace, weights, g.tile_size, g.destination_feature_map_count, g.source_feature_map_count, false, plain_config);
+				transformed_weights = workspace;
+				run_workspace += get_transformed_weights_elem_count(g.tile_size, g.destination_feature_map_count, g.source_feature_map_count);
+			}
+
+			run(output, input, transformed_weights, biases, epilogue, run_workspace, plain_config, g, false, entry_count);
+		}
+
+		void convolution_winograd_plain::run_backward_data_propagation(
+			float * input_errors,
+			const float * output_errors,
+			const float * weights,
+			float * workspace,
+			plain_running_configuration::const_ptr plain_config,
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			bool add_update_to_destination,
+			unsigned int entry_count)
+		{
+			const geometry g(layer_derived, input_configuration_specific, output_configuration_specific, true);
+
+			transform_weights(workspace, weights, g.tile_size, g.source_feature_map_count, g.destination_feature_map_count, true, plain_config);
+
+			run(
+				input_errors,
+				output_errors,
+				workspace,
+				0,
+				convolution_epilogue_plain(),
+				workspace + get_transformed_weights_elem_count(g.tile_size, g.destination_feature_map_count, g.source_feature_map_count),
+				plain_config,
+				g,
+				add_update_to_destination,
+				entry_count);
+		}
+
+		void convolution_winograd_plain::run(
+			float * destination,
+			const float * source,
+			const float * transformed_weights,
+			const float * biases,
+			const convolution_epilogue_plain& epilogue,
+			float * workspace,
+			plain_running_configuration::const_ptr plain_config,
+			const geometry& g,
+			bool add_to_destination,
+			unsigned int entry_count)
+		{
+			const int source_elem_count_per_entry = g.source_feature_map_count * g.source_width * g.source_height;
+			const int destination_elem_count_per_entry = g.destination_feature_map_count * g.destination_width * g.destination_height;
+			const int weight_matrix_elem_count = g.destination_feature_map_count * g.source_feature_map_count;
+			const size_t workspace_elem_count_per_thread = get_workspace_elem_count_per_thread(g);
+
+			// Smaller blocks for small batches so that all the threads get work
+			const int total_tile_count = static_cast<int>(entry_count) * g.tile_count_per_entry;
+			const int block_size = std::min(g.tile_block_size, std::max(gemm_plain::nr, (total_tile_count + plain_config->openmp_thread_count - 1) / plain_config->openmp_thread_count));
+			const int block_count = (g.tile_count_per_entry + block_size - 1) / block_size;
+			const int total_workload = static_cast<int>(entry_count) * block_count;
+
+			#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
+			{
+				int thread_id = 0;
+				#ifdef _OPENMP
+				thread_id = omp_get_thread_num();
+				#endif
+
+				float * gemm_workspace = workspace + thread_id * workspace_elem_count_per_thread;
+				float * transformed_source = gemm_workspace + gemm_plain::get_workspace_elem_count();
+				float * products = transformed_source + g.transformed_tile_elem_count * g.source_feature_map_count * g.tile_block_size;
+
+				#pragma omp for schedule(dynamic)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					int entry_id = workload_id / block_count;
+					int block_id = workload_id - (entry_id * block_count);
+					int tile_start = block_id * block_size;
+					int tile_count = std::min(block_size, g.tile_count_per_entry - tile_start);
+					const float * src = source + entry_id * source_elem_count_per_entry;
+					float * dst = destination + entry_id * destination_elem_count_per_entry;
+
+					if (g.tile_size == 4)
+						transform_source_block<4>(transformed_source, src, g, tile_start, tile_count);
+					else
+						transform_source_block<2>(transformed_source, src, g, tile_start, tile_count);
+
+					for(int elem_id = 0; elem_id < g.transformed_tile_elem_count; ++elem_id)
+						gemm_plain::run(
+							false,
+							false,
+							g.destination_feature_map_count,
+							tile_count,
+							g.source_feature_map_count,
+							1.0F,
+							transformed_weights + elem_id * weight_matrix_elem_count,
+							g.source_feature_map_count,
+							transformed_source + elem_id * g.source_feature_map_count * g.tile_block_size,
+							g.tile_block_size,
+							0.0F,
+							products + elem_id * g.destination_feature_map_count * g.tile_block_size,
+							g.tile_block_size,
+							gemm_workspace);
+
+					if (g.tile_size == 4)
+						transform_destination_block<4>(dst, products, biases, epilogue, static_cast<size_t>(entry_id) * destination_elem_count_per_entry, g, tile_start, tile_count, add_to_destination);
+					else
+						transform_destination_block<2>(dst, products, biases, epilogue, static_cast<size_t>(entry_id) * destination_elem_count_per_entry, g, tile_start, tile_count, add_to_destination);
+				}
+			}
+		}
+
+		template<int tile_size>
+		float convolution_winograd_plain::get_transform_flops(const geometry& g)
+		{
+			const int alpha = tile_size + 2;
+			int bt_nonzero_count = 0;
+			for(int i = 0; i < alpha; ++i)
+				for(int j = 0; j < alpha; ++j)
+					if (transform_matrices<tile_size>::bt[i][j] != 0.0F)
+						++bt_nonzero_count;
+			int at_nonzero_count = 0;
+			for(int i = 0; i < tile_size; ++i)
+				for(int j = 0; j < alpha; ++j)
+					if (transform_matrices<tile_size>::at[i][j] != 0.0F)
+						++at_nonzero_count;
+
+			// B^T d B for each source feature map and A^T m A for each destination feature map, a multiply-add is 2 flops
+			float source_flops = static_cast<float>(4 * alpha * bt_nonzero_count);
+			float destination_flops = static_cast<float>(2 * (alpha + tile_size) * at_nonzero_count);
+			return static_cast<float>(g.tile_count_per_entry) * (source_flops * static_cast<float>(g.source_feature_map_count) + destination_flops * static_cast<float>(g.destination_feature_map_count));
+		}
+
+		float convolution_winograd_plain::get_flops_per_entry(
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			bool backward_data)
+		{
+			const geometry g(layer_derived, input_configuration_specific, output_configuration_specific, backward_data);
+
+			float res = static_cast<float>(g.tile_count_per_entry) * static_cast<float>(g.transformed_tile_elem_count)
+				* static_cast<float>(g.source_feature_map_count) * static_cast<float>(g.destination_feature_map_count) * 2.0F;
+			res += (g.tile_size == 4) ? get_transform_flops<4>(g) : get_transform_flops<2>(g);
+			if ((!backward_data) && layer_derived->bias)
+				res += static_cast<float>(output_configuration_specific.get_neuron_count());
+
+			return res;
+		}
+
+		void convolution_winograd_plain::check_against_gemm(
+			debug_state::ptr debug,
+			plain_running_configuration::const_ptr plain_config,
+			std::shared_ptr<const convolution_layer> layer_derived,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			bool backward_data)
+		{
+			const unsigned int input_neuron_count = input_configuration_specific.get_neuron_count();
+			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
+
+			std::mt19937 gen(12345);
+			std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+			std::vector<float> weights(static_cast<size_t>(layer_derived->input_feature_map_count) * layer_derived->output_feature_map_count * 9);
+			for(std::vector<float>::iterator it = weights.begin(); it != weights.end(); ++it)
+				*it = dist(gen);
+			std::vector<float> biases(layer_derived->output_feature_map_count);
+			for(std::vector<float>::iterator it = biases.begin(); it != biases.end(); ++it)
+				*it = dist(gen);
+			std::vector<float> source(backward_data ? output_neuron_count : input_neuron_count);
+			for(std::vector<float>::iterator it = source.begin(); it != source.end(); ++it)
+				*it = dist(gen);
+
+			std::vector<float> winograd_destination(backward_data ? input_neuron_count : output_neuron_count);
+			std::vector<float> gemm_destination(winograd_destination.size());
+			std::vector<float> winograd_workspace(get_temporary_working_fixed_buffer_size(
+				plain_config, layer_derived, input_configuration_specific, output_configuration_specific, backward_data, true) / sizeof(float) + 1);
+			std::vector<float> gemm_workspace(convolution_gemm_plain::get_temporary_working_fixed_buffer_size(
+				plain_config, layer_derived, input_configuration_specific, output_configuration_specific) / sizeof(float) + 1);
+
+			if (backward_data)
+			{
+				run_backward_data_propagation(
+					&winograd_destination[0], &source[0], &weights[0], &winograd_workspace[0],
+					plain_config, layer_derived, input_configuration_specific, output_configuration_specific, false, 1);
+				convolution_gemm_plain::run_backward_data_propagation(
+					&gemm_destination[0], &source[0], &weights[0], &gemm_workspace[0],
+					plain_config, layer_derived, input_configuration_specific, output_configuration_specific, false, 1);
+			}
+			else
+			{
+				const float * bias_data = layer_derived->bias ? &biases[0] : 0;
+				run_forward_propagation(
+					&winograd_destination[0], &source[0], &weights[0], 0, bias_data, convolution_epilogue_plain(), &winograd_workspace[0],
+					plain_config, layer_derived, input_configuration_specific, output_configuration_specific, 1);
+				convolution_gemm_plain::run_forward_propagation(
+					&gemm_destination[0], &source[0], &weights[0], bias_data, convolution_epilogue_plain(), &gemm_workspace[0],
+					plain_config, layer_derived, input_configuration_specific, output_configuration_specific, 1);
+			}
+
+			float max_abs_value = 0.0F;
+			float max_abs_difference = 0.0F;
+			for(size_t i = 0; i < gemm_destination.size(); ++i)
+			{
+				max_abs_value = std::max(max_abs_value, fabsf(gemm_destination[i]));
+				max_abs_difference = std::max(max_abs_difference, fabsf(winograd_destination[i] - gemm_destination[i]));
+			}
+			float relative_difference = (max_abs_value > 0.0F) ? max_abs_difference / max_abs_value : max_abs_difference;
+
+			std::string message = (boost::format("Winograd F(%1%x%1%,3x3) %2% for %3%: max relative difference to GEMM %4%")
+				% geometry(layer_derived, input_configuration_specific, output_configuration_specific, backward_data).tile_size
+				% (backward_data ? "backward data" : "forward")
+				% layer_derived->instance_name
+				% relative_difference).str();
+			debug->output_message(message.c_str());
+
+			// NaN fails the check as well
+			if (!(relative_difference <= max_relative_difference_to_gemm))
+				throw neural_network_exception((boost::format("%1% exceeds %2%") % message % max_relative_difference_to_gemm).str());
+		}
+	}
+}
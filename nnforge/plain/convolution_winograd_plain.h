@@ -0,0 +1,203 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../convolution_layer.h"
+#include "../layer_configuration_specific.h"
+#include "../debug_state.h"
+
+#include "plain_running_configuration.h"
+#include "convolution_epilogue_plain.h"
+
+#include <memory>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Winograd minimal filtering F(2x2,3x3) and F(4x4,3x3) for 2D 3x3 stride 1 convolutions.
+		// The output is split into tile_size x tile_size tiles, each input tile (tile_size + 2)^2 is transformed with B^T d B,
+		// weights are transformed with G g G^T, which turns convolution into (tile_size + 2)^2 independent matrix products
+		// output_feature_map_count x input_feature_map_count by input_feature_map_count x tile_count done by gemm_plain,
+		// the products are transformed back with A^T m A.
+		// Transformed weights are (tile_size + 2)^2 row-major output_feature_map_count x input_feature_map_count matrices.
+		class convolution_winograd_plain
+		{
+		public:
+			// Depends on layer only, so that weights may be transformed before the configuration is known
+			static bool is_applicable(std::shared_ptr<const convolution_layer> layer_derived);
+
+			// Returns 2 or 4, whichever needs fewer multiplications for the output specified
+			static int get_tile_size(const layer_configuration_specific& output_configuration_specific);
+
+			static size_t get_transformed_weights_elem_count(
+				int tile_size,
+				int output_feature_map_count,
+				int input_feature_map_count);
+
+			// With flip set, the window is rotated by 180 degrees and input and output feature maps are swapped,
+			// the result is the transformed weights for backward data propagation
+			static void transform_weights(
+				float * transformed_weights,
+				const float * weights,
+				int tile_size,
+				int output_feature_map_count,
+				int input_feature_map_count,
+				bool flip,
+				plain_running_configuration::const_ptr plain_config);
+
+			static size_t get_temporary_working_fixed_buffer_size(
+				plain_running_configuration::const_ptr plain_config,
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				bool backward_data,
+				bool transform_weights_in_workspace);
+
+			// transformed_weights should be transformed for get_tile_size(output_configuration_specific) tile size,
+			// if transformed_weights is null weights are transformed into the workspace first.
+			// The epilogue is applied as each output element is produced by the inverse transform
+			static void run_forward_propagation(
+				float * output,
+				const float * input,
+				const float * weights,
+				const float * transformed_weights,
+				const float * biases,
+				const convolution_epilogue_plain& epilogue,
+				float * workspace,
+				plain_running_configuration::const_ptr plain_config,
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count);
+
+			// Weights are transformed into the workspace
+			static void run_backward_data_propagation(
+				float * input_errors,
+				const float * output_errors,
+				const float * weights,
+				float * workspace,
+				plain_running_configuration::const_ptr plain_config,
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				bool add_update_to_destination,
+				unsigned int entry_count);
+
+			// Counts matrix products and transforms actually done
+			static float get_flops_per_entry(
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				bool backward_data);
+
+			// Runs a single entry of random data through both Winograd and convolution_gemm_plain with random weights,
+			// reports the largest difference relative to the largest absolute value of the GEMM result to debug
+			// and throws if it exceeds max_relative_difference_to_gemm
+			static void check_against_gemm(
+				debug_state::ptr debug,
+				plain_running_configuration::const_ptr plain_config,
+				std::shared_ptr<const convolution_layer> layer_derived,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				bool backward_data);
+
+		private:
+			// Source is convolved into destination, for backward data propagation source is output errors and destination is input errors
+			struct geometry
+			{
+				geometry(
+					std::shared_ptr<const convolution_layer> layer_derived,
+					const layer_configuration_specific& input_configuration_specific,
+					const layer_configuration_specific& output_configuration_specific,
+					bool backward_data);
+
+				int tile_size;
+				int transformed_tile_elem_count;
+				int source_feature_map_count;
+				int destination_feature_map_count;
+				int source_width;
+				int source_height;
+				int destination_width;
+				int destination_height;
+				int left_zero_padding_x;
+				int left_zero_padding_y;
+				int tile_count_x;
+				int tile_count_per_entry;
+				// Tiles transformed and multiplied at once
+				int tile_block_size;
+			};
+
+			static void run(
+				float * destination,
+				const float * source,
+				const float * transformed_weights,
+				const float * biases,
+				const convolution_epilogue_plain& epilogue,
+				float * workspace,
+				plain_running_configuration::const_ptr plain_config,
+				const geometry& g,
+				bool add_to_destination,
+				unsigned int entry_count);
+
+			static size_t get_workspace_elem_count_per_thread(const geometry& g);
+
+			template<int tile_size>
+			struct transform_matrices;
+
+			template<int tile_size>
+			static void transform_weights_window(
+				float * transformed_weights,
+				const float * window,
+				int elem_stride,
+				bool flip);
+
+			template<int tile_size>
+			static void transform_source_block(
+				float * transformed_source,
+				const float * source,
+				const geometry& g,
+				int tile_start,
+				int tile_count);
+
+			template<int tile_size>
+			// destination_offset is the position of destination in the whole output, the epilogue is indexed with it
+			static void transform_destination_block(
+				float * destination,
+				const float * products,
+				const float * biases,
+				const convolution_epilogue_plain& epilogue,
+				size_t destination_offset,
+				const geometry& g,
+				int tile_start,
+				int tile_count,
+				bool add_to_destination);
+
+			template<int tile_size>
+			static float get_transform_flops(const geometry& g);
+
+			static const int min_feature_map_count;
+			static const int max_transformed_block_elem_count;
+			static const float max_relative_difference_to_gemm;
+
+		private:
+			convolution_winograd_plain() = delete;
+			convolution_winograd_plain(const convolution_winograd_plain&) = delete;
+			convolution_winograd_plain& operator =(const convolution_winograd_plain&) = delete;
+		};
+	}
+}
@@ -0,0 +1,255 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "data_pipeline_plain.h"
+
+#include "../neural_network_exception.h"
+
+#include <algorithm>
+#include <functional>
+#include <cstring>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		data_pipeline_plain::data_pipeline_plain(
+			structured_data_bunch_reader& reader,
+			structured_data_bunch_writer& writer,
+			plain_running_configuration::const_ptr plain_config,
+			plain_buffer_arena& arena,
+			const std::map<std::string, size_t>& per_entry_size_map,
+			const std::set<std::string>& input_layer_names,
+			const std::vector<std::string>& output_layer_names,
+			unsigned int output_layers_tiling_factor,
+			unsigned int max_entry_count)
+			: reader(reader)
+			, writer(writer)
+			, plain_config(plain_config)
+			, per_entry_size_map(per_entry_size_map)
+			, input_layer_names(input_layer_names)
+			, output_layer_names(output_layer_names)
+			, output_layers_tiling_factor(output_layers_tiling_factor)
+			, next_read_set_to_start(0)
+			, next_read_set_to_wait(0)
+			, current_read_set(0)
+			, next_entry_to_read_id(0)
+			, current_output_set(0)
+			, next_entry_to_write_id(0)
+			, write_pending(false)
+		{
+			for(unsigned int i = 0; i < plain_config->pipeline_depth; ++i)
+			{
+				std::shared_ptr<read_set> new_set(new read_set());
+				for(std::set<std::string>::const_iterator it = input_layer_names.begin(); it != input_layer_names.end(); ++it)
+					new_set->buffers.insert(std::make_pair(*it, arena.allocate(per_entry_size_map.find(*it)->second * max_entry_count)));
+				new_set->first_entry_id = 0;
+				new_set->entry_count = 0;
+				new_set->next_entry_index = 0;
+				new_set->pending_job_count = 0;
+				read_set_list.push_back(new_set);
+			}
+
+			// Outputs are put into one set while the other one is being written
+			output_set_list.resize(2);
+			for(std::vector<std::map<std::string, plain_buffer::ptr> >::iterator it = output_set_list.begin(); it != output_set_list.end(); ++it)
+				for(std::vector<std::string>::const_iterator it2 = output_layer_names.begin(); it2 != output_layer_names.end(); ++it2)
+					it->insert(std::make_pair(*it2, arena.allocate(per_entry_size_map.find(*it2)->second * max_entry_count)));
+		}
+
+		data_pipeline_plain::~data_pipeline_plain()
+		{
+			// Jobs reference buffers and the reader, they should finish before those go away
+			for(std::vector<std::shared_ptr<read_set> >::iterator it = read_set_list.begin(); it != read_set_list.end(); ++it)
+				wait_for_read_set(**it);
+			wait_for_write();
+		}
+
+		size_t data_pipeline_plain::get_per_entry_buffer_size(
+			plain_running_configuration::const_ptr plain_config,
+			const std::map<std::string, size_t>& per_entry_size_map,
+			const std::set<std::string>& input_layer_names,
+			const std::vector<std::string>& output_layer_names)
+		{
+			size_t res = 0;
+			for(std::set<std::string>::const_iterator it = input_layer_names.begin(); it != input_layer_names.end(); ++it)
+				res += plain_buffer::get_aligned_size(per_entry_size_map.find(*it)->second) * plain_config->pipeline_depth;
+			for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
+				res += plain_buffer::get_aligned_size(per_entry_size_map.find(*it)->second) * 2;
+			return res;
+		}
+
+		void data_pipeline_plain::start_read(unsigned int entry_count)
+		{
+			read_set& set = *read_set_list[next_read_set_to_start];
+			next_read_set_to_start = (next_read_set_to_start + 1) % static_cast<unsigned int>(read_set_list.size());
+
+			set.first_entry_id = next_entry_to_read_id;
+			set.entry_count = entry_count;
+			set.next_entry_index = 0;
+			set.entry_read_list.assign(entry_count, 0);
+			set.error_message.clear();
+			next_entry_to_read_id += entry_count;
+
+			// Each job keeps picking entries until none is left, which balances uneven read times
+			int job_count = static_cast<int>(std::min(plain_config->get_job_runner()->thread_count, entry_count));
+			set.pending_job_count = job_count;
+			for(int i = 0; i < job_count; ++i)
+				plain_config->get_job_runner()->service.post(std::bind(read_entries_static, this, &set));
+		}
+
+		unsigned int data_pipeline_plain::wait_read(std::map<std::string, plain_buffer::ptr>& dedicated_buffers)
+		{
+			current_read_set = next_read_set_to_wait;
+			next_read_set_to_wait = (next_read_set_to_wait + 1) % static_cast<unsigned int>(read_set_list.size());
+			read_set& set = *read_set_list[current_read_set];
+
+			wait_for_read_set(set);
+			if (!set.error_message.empty())
+				throw neural_network_exception(set.error_message);
+
+			unsigned int entry_read_count = 0;
+			while ((entry_read_count < set.entry_count) && (set.entry_read_list[entry_read_count] != 0))
+				++entry_read_count;
+
+			dedicated_buffers = output_set_list[current_output_set];
+			for(std::map<std::string, plain_buffer::ptr>::const_iterator it = set.buffers.begin(); it != set.buffers.end(); ++it)
+				dedicated_buffers[it->first] = it->second;
+
+			return entry_read_count;
+		}
+
+		void data_pipeline_plain::start_write(unsigned int entry_count)
+		{
+			wait_for_write();
+			if (!write_error_message.empty())
+				throw neural_network_exception(write_error_message);
+
+			// Input layers written to the output are copied, as the input set gets reused for reading
+			const read_set& set = *read_set_list[current_read_set];
+			std::map<std::string, plain_buffer::ptr>& output_set = output_set_list[current_output_set];
+			for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
+			{
+				std::map<std::string, plain_buffer::ptr>::const_iterator input_it = set.buffers.find(*it);
+				if (input_it != set.buffers.end())
+					memcpy((void *)(*output_set[*it]), (const void *)(*input_it->second), per_entry_size_map.find(*it)->second * entry_count);
+			}
+
+			if (!output_layer_names.empty())
+			{
+				{
+					std::lock_guard<std::mutex> lock(write_pending_mutex);
+					write_pending = true;
+				}
+				plain_config->get_job_runner()->service.post(std::bind(write_entries_static, this, current_output_set, next_entry_to_write_id, entry_count));
+			}
+
+			next_entry_to_write_id += entry_count;
+			current_output_set = 1 - current_output_set;
+		}
+
+		void data_pipeline_plain::finish_write()
+		{
+			wait_for_write();
+			if (!write_error_message.empty())
+				throw neural_network_exception(write_error_message);
+		}
+
+		void data_pipeline_plain::read_entries_static(data_pipeline_plain * self, read_set * set)
+		{
+			self->read_entries(*set);
+		}
+
+		void data_pipeline_plain::read_entries(read_set& set)
+		{
+			std::string error_message;
+			try
+			{
+				while (true)
+				{
+					unsigned int entry_index = set.next_entry_index++;
+					if (entry_index >= set.entry_count)
+						break;
+
+					std::map<std::string, float *> data_map;
+					for(std::map<std::string, plain_buffer::ptr>::const_iterator it = set.buffers.begin(); it != set.buffers.end(); ++it)
+						data_map.insert(std::make_pair(it->first, ((float *)(*it->second)) + entry_index * (per_entry_size_map.find(it->first)->second / sizeof(float))));
+					if (reader.read(set.first_entry_id + entry_index, data_map))
+						set.entry_read_list[entry_index] = 1;
+				}
+			}
+			catch (const std::exception& e)
+			{
+				error_message = e.what();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(set.pending_job_mutex);
+				if (set.error_message.empty())
+					set.error_message = error_message;
+				--set.pending_job_count;
+				// Notify under the lock, the waiter may destroy the pipeline as soon as it sees the count drop
+				set.pending_job_finished_condition.notify_all();
+			}
+		}
+
+		void data_pipeline_plain::write_entries_static(data_pipeline_plain * self, unsigned int output_set_id, unsigned int first_entry_id, unsigned int entry_count)
+		{
+			self->write_entries(output_set_id, first_entry_id, entry_count);
+		}
+
+		void data_pipeline_plain::write_entries(unsigned int output_set_id, unsigned int first_entry_id, unsigned int entry_count)
+		{
+			std::string error_message;
+			try
+			{
+				const std::map<std::string, plain_buffer::ptr>& output_set = output_set_list[output_set_id];
+				for(unsigned int entry_id = 0; entry_id < entry_count * output_layers_tiling_factor; ++entry_id)
+				{
+					std::map<std::string, const float *> data_map;
+					for(std::map<std::string, plain_buffer::ptr>::const_iterator it = output_set.begin(); it != output_set.end(); ++it)
+						data_map.insert(std::make_pair(it->first, ((const float *)(*it->second)) + entry_id * (per_entry_size_map.find(it->first)->second / sizeof(float) / output_layers_tiling_factor)));
+					writer.write(first_entry_id + entry_id, data_map);
+				}
+			}
+			catch (const std::exception& e)
+			{
+				error_message = e.what();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(write_pending_mutex);
+				write_error_message = error_message;
+				write_pending = false;
+				write_finished_condition.notify_all();
+			}
+		}
+
+		void data_pipeline_plain::wait_for_read_set(read_set& set)
+		{
+			std::unique_lock<std::mutex> lock(set.pending_job_mutex);
+			while (set.pending_job_count > 0)
+				set.pending_job_finished_condition.wait(lock);
+		}
+
+		void data_pipeline_plain::wait_for_write()
+		{
+			std::unique_lock<std::mutex> lock(write_pending_mutex);
+			while (write_pending)
+				write_finished_condition.wait(lock);
+		}
+	}
+}
@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../structured_data_bunch_reader.h"
+#include "../structured_data_bunch_writer.h"
+
+#include "plain_running_configuration.h"
+#include "plain_buffer.h"
+#include "plain_buffer_arena.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Reads entries on the job runner threads into a ring of pipeline_depth buffer sets ahead of the computation
+		// and writes outputs from a pair of buffer sets in the background, one batch at a time and in order.
+		// Typical loop: start_read pipeline_depth times, then wait_read, compute, start_write, start_read for each batch.
+		class data_pipeline_plain
+		{
+		public:
+			// per_entry_size_map has the size in bytes of a single entry for each of the input and output layers,
+			// buffers are allocated from arena
+			data_pipeline_plain(
+				structured_data_bunch_reader& reader,
+				structured_data_bunch_writer& writer,
+				plain_running_configuration::const_ptr plain_config,
+				plain_buffer_arena& arena,
+				const std::map<std::string, size_t>& per_entry_size_map,
+				const std::set<std::string>& input_layer_names,
+				const std::vector<std::string>& output_layer_names,
+				unsigned int output_layers_tiling_factor,
+				unsigned int max_entry_count);
+
+			// Waits for the jobs still running
+			~data_pipeline_plain();
+
+			// Schedules reading of the next entry_count entries into the oldest buffer set,
+			// the caller should be done with the buffers of that set
+			void start_read(unsigned int entry_count);
+
+			// Waits for the oldest scheduled read, returns the number of entries read before the first missing one.
+			// Buffers of input layers and buffers to put output layers to are stored into dedicated_buffers
+			unsigned int wait_read(std::map<std::string, plain_buffer::ptr>& dedicated_buffers);
+
+			// Schedules writing of the first entry_count entries of the output buffers returned by the last wait_read,
+			// waits for the previous write to finish first
+			void start_write(unsigned int entry_count);
+
+			// Waits for the last write to finish
+			void finish_write();
+
+			// The size in bytes of all the buffers the pipeline allocates per entry, each buffer is aligned
+			static size_t get_per_entry_buffer_size(
+				plain_running_configuration::const_ptr plain_config,
+				const std::map<std::string, size_t>& per_entry_size_map,
+				const std::set<std::string>& input_layer_names,
+				const std::vector<std::string>& output_layer_names);
+
+		private:
+			class read_set
+			{
+			public:
+				read_set() = default;
+
+				std::map<std::string, plain_buffer::ptr> buffers;
+				unsigned int first_entry_id;
+				unsigned int entry_count;
+				std::atomic<unsigned int> next_entry_index;
+				std::vector<unsigned char> entry_read_list;
+
+				int pending_job_count;
+				std::mutex pending_job_mutex;
+				std::condition_variable pending_job_finished_condition;
+				std::string error_message;
+
+			private:
+				read_set(const read_set&) = delete;
+				read_set& operator =(const read_set&) = delete;
+			};
+
+			static void read_entries_static(data_pipeline_plain * self, read_set * set);
+			void read_entries(read_set& set);
+
+			static void write_entries_static(data_pipeline_plain * self, unsigned int output_set_id, unsigned int first_entry_id, unsigned int entry_count);
+			void write_entries(unsigned int output_set_id, unsigned int first_entry_id, unsigned int entry_count);
+
+			void wait_for_read_set(read_set& set);
+
+			void wait_for_write();
+
+		private:
+			structured_data_bunch_reader& reader;
+			structured_data_bunch_writer& writer;
+			plain_running_configuration::const_ptr plain_config;
+			std::map<std::string, size_t> per_entry_size_map;
+			std::set<std::string> input_layer_names;
+			std::vector<std::string> output_layer_names;
+			unsigned int output_layers_tiling_factor;
+
+			std::vector<std::shared_ptr<read_set> > read_set_list;
+			unsigned int next_read_set_to_start;
+			unsigned int next_read_set_to_wait;
+			unsigned int current_read_set;
+			unsigned int next_entry_to_read_id;
+
+			std::vector<std::map<std::string, plain_buffer::ptr> > output_set_list;
+			unsigned int current_output_set;
+			unsigned int next_entry_to_write_id;
+
+			bool write_pending;
+			std::mutex write_pending_mutex;
+			std::condition_variable write_finished_condition;
+			std::string write_error_message;
+
+		private:
+			data_pipeline_plain() = delete;
+			data_pipeline_plain(const data_pipeline_plain&) = delete;
+			data_pipeline_plain& operator =(const data_pipeline_plain&) = delete;
+		};
+	}
+}
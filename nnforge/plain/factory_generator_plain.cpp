@@ -19,7 +19,9 @@
 #include "forward_propagation_plain_factory.h"
 #include "backward_propagation_plain_factory.h"
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -31,9 +33,21 @@ namespace nnforge
 	{
 		factory_generator_plain::factory_generator_plain(
 			float plain_max_global_memory_usage,
-			int plain_openmp_thread_count)
+			int plain_openmp_thread_count,
+			int plain_reader_thread_count,
+			int plain_pipeline_depth,
+			bool plain_huge_pages,
+			int plain_concurrent_action_count,
+			bool plain_layer_fusion,
+			int plain_worker_count)
 			: plain_max_global_memory_usage(plain_max_global_memory_usage)
 			, plain_openmp_thread_count(plain_openmp_thread_count)
+			, plain_reader_thread_count(plain_reader_thread_count)
+			, plain_pipeline_depth(plain_pipeline_depth)
+			, plain_huge_pages(plain_huge_pages)
+			, plain_concurrent_action_count(plain_concurrent_action_count)
+			, plain_layer_fusion(plain_layer_fusion)
+			, plain_worker_count(plain_worker_count)
 		{
 		}
 
@@ -41,7 +55,13 @@ namespace nnforge
 		{
 			plain_config = plain_running_configuration::const_ptr(new plain_running_configuration(
 				plain_openmp_thread_count,
-				plain_max_global_memory_usage));
+				plain_max_global_memory_usage,
+				plain_reader_thread_count,
+				plain_pipeline_depth,
+				plain_huge_pages,
+				plain_concurrent_action_count,
+				plain_layer_fusion,
+				plain_worker_count));
 		}
 
 		forward_propagation_factory::ptr factory_generator_plain::create_forward_propagation_factory() const
@@ -54,6 +74,16 @@ namespace nnforge
 			return backward_propagation_factory::ptr(new backward_propagation_plain_factory(plain_config));
 		}
 
+		std::vector<bool_option> factory_generator_plain::get_bool_options()
+		{
+			std::vector<bool_option> res;
+
+			res.push_back(bool_option("plain_huge_pages", &plain_huge_pages, false, "Back large buffers with huge pages where OS supports it."));
+			res.push_back(bool_option("plain_layer_fusion", &plain_layer_fusion, true, "Fuse convolutions with following batch norm, add and ReLU layers in inference."));
+
+			return res;
+		}
+
 		std::vector<float_option> factory_generator_plain::get_float_options()
 		{
 			std::vector<float_option> res;
@@ -70,6 +100,10 @@ namespace nnforge
 			#ifdef _OPENMP
 			res.push_back(int_option("plain_openmp_thread_count", &plain_openmp_thread_count, omp_get_max_threads(), "count of threads to be used in OpenMP."));
 			#endif
+			res.push_back(int_option("plain_reader_thread_count", &plain_reader_thread_count, std::max(static_cast<int>(std::thread::hardware_concurrency()), 1), "count of threads reading and transforming input data while layers are computed."));
+			res.push_back(int_option("plain_pipeline_depth", &plain_pipeline_depth, 2, "count of batches read ahead, 1 reads the next batch after the current one is processed."));
+			res.push_back(int_option("plain_concurrent_action_count", &plain_concurrent_action_count, 1, "count of independent layer actions run concurrently in forward prop, 1 runs all the actions in a single chain."));
+			res.push_back(int_option("plain_worker_count", &plain_worker_count, 1, "count of thread groups training on disjoint slices of each batch, each pinned to its own subset of the CPUs, gradients are summed across the groups."));
 
 			return res;
 		}
@@ -28,7 +28,13 @@ namespace nnforge
 		public:
 			factory_generator_plain(
 				float plain_max_global_memory_usage,
-				int plain_openmp_thread_count);
+				int plain_openmp_thread_count,
+				int plain_reader_thread_count,
+				int plain_pipeline_depth,
+				bool plain_huge_pages,
+				int plain_concurrent_action_count,
+				bool plain_layer_fusion,
+				int plain_worker_count);
 
 			factory_generator_plain() = default;
 
@@ -42,6 +48,8 @@ namespace nnforge
 
 			virtual void info() const;
 
+			virtual std::vector<bool_option> get_bool_options();
+
 			virtual std::vector<float_option> get_float_options();
 
 			virtual std::vector<int_option> get_int_options();
@@ -49,6 +57,12 @@ namespace nnforge
 		protected:
 			float plain_max_global_memory_usage;
 			int plain_openmp_thread_count;
+			int plain_reader_thread_count;
+			int plain_pipeline_depth;
+			bool plain_huge_pages;
+			int plain_concurrent_action_count;
+			bool plain_layer_fusion;
+			int plain_worker_count;
 
 			plain_running_configuration::const_ptr plain_config;
 		};
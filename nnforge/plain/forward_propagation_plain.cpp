@@ -17,6 +17,9 @@
 #include "forward_propagation_plain.h"
 
 #include "layer_tester_plain_factory.h"
+#include "data_pipeline_plain.h"
+#include "layer_fusion_plain.h"
+#include "convolution_winograd_plain.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
@@ -41,46 +44,104 @@ namespace nnforge
 			, plain_config(plain_config)
 			, max_entry_count(0)
 			, temporary_working_fixed_size(0)
+			, arena(plain_config->use_huge_pages)
 		{
+			if (plain_config->fuse_layers)
+			{
+				fused_schema = network_schema::const_ptr(new network_schema(layer_fusion_plain::get_fused_layers(*this->schema, output_layer_names)));
+				action_schema = fused_schema->get_actions_for_forward_propagation(output_layer_names);
+				if (debug->is_debug())
+				{
+					boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_schema_fused", "gv"), std::ios_base::out | std::ios_base::trunc);
+					fused_schema->write_gv(out);
+				}
+			}
+			else
+			{
+				fused_schema = this->schema;
+			}
+
 			actions_in_execution_order = action_schema->get_actions_in_execution_order();
 
-			// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
-			network_action_schema::ptr sequential_action_schema(new network_action_schema());
+			if (plain_config->concurrent_action_count > 1)
 			{
-				std::vector<layer_name_with_action> dependencies;
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				// Keep the real dependencies so that independent branches run concurrently.
+				// Buffer sets are built on the same schema, actions not ordered by dependencies never share buffers
+				std::map<layer_name_with_action, unsigned int> action_to_id_map;
+				for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(actions_in_execution_order.size()); ++action_id)
+					action_to_id_map.insert(std::make_pair(actions_in_execution_order[action_id], action_id));
+				std::vector<std::vector<unsigned int> > dependencies(actions_in_execution_order.size());
+				for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(actions_in_execution_order.size()); ++action_id)
 				{
-					sequential_action_schema->add_action(
-						this->schema->get_layer(it->get_name()),
-						it->get_action(),
-						dependencies);
-					dependencies.clear();
-					dependencies.push_back(*it);
+					std::vector<layer_name_with_action> action_dependencies = action_schema->get_dependencies(actions_in_execution_order[action_id]);
+					for(std::vector<layer_name_with_action>::const_iterator it = action_dependencies.begin(); it != action_dependencies.end(); ++it)
+						dependencies[action_id].push_back(action_to_id_map.find(*it)->second);
 				}
-			}
-			action_schema = sequential_action_schema;
+				scheduler = task_scheduler_plain::ptr(new task_scheduler_plain(plain_config->concurrent_action_count, dependencies));
 
-			if (debug->is_debug())
+				for(unsigned int concurrency = 1; concurrency <= plain_config->concurrent_action_count; ++concurrency)
+					concurrent_plain_configs.push_back(plain_running_configuration::const_ptr(new plain_running_configuration(*plain_config, plain_config->openmp_thread_count / static_cast<int>(concurrency))));
+			}
+			else
 			{
-				boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
-				action_schema->write_gv(out);
+				// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
+				network_action_schema::ptr sequential_action_schema(new network_action_schema());
+				{
+					std::vector<layer_name_with_action> dependencies;
+					for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					{
+						sequential_action_schema->add_action(
+							fused_schema->get_layer(it->get_name()),
+							it->get_action(),
+							dependencies);
+						dependencies.clear();
+						dependencies.push_back(*it);
+					}
+				}
+				action_schema = sequential_action_schema;
+
+				if (debug->is_debug())
+				{
+					boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
+					action_schema->write_gv(out);
+				}
 			}
 
 			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
 				testers.insert(
 					std::make_pair(
 						it->get_name(),
-						layer_tester_plain_factory::get_singleton().get_tester_plain_layer(this->schema->get_layer(it->get_name())->get_type_name())));
+						layer_tester_plain_factory::get_singleton().get_tester_plain_layer(fused_schema->get_layer(it->get_name())->get_type_name())));
 		}
 
 		void forward_propagation_plain::actual_set_data(network_data::const_ptr data)
 		{
 			net_data = data;
+
+			transformed_data_map.clear();
+			for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
+			{
+				layer::const_ptr l = fused_schema->get_layer(it->first);
+				fused_convolution_layer_plain::const_ptr fused_layer = std::dynamic_pointer_cast<const fused_convolution_layer_plain>(l);
+				layer_data::const_ptr d;
+				if (fused_layer)
+					d = layer_fusion_plain::get_fused_data(*fused_layer, *net_data);
+				else
+					d = net_data->data_list.find(it->first);
+				if (!d)
+					continue;
+				layer_data::const_ptr transformed_data = it->second->get_transformed_data(plain_config, l, d);
+				if (transformed_data)
+					transformed_data_map.insert(std::make_pair(it->first, transformed_data));
+				else if (fused_layer)
+					transformed_data_map.insert(std::make_pair(it->first, d));
+			}
 		}
 
 		void forward_propagation_plain::actual_clear_data()
 		{
 			net_data.reset();
+			transformed_data_map.clear();
 		}
 
 		void forward_propagation_plain::actual_run(
@@ -97,113 +158,176 @@ namespace nnforge
 			current_max_entry_count = std::min(current_max_entry_count, max_max_entry_count);
 			const int current_max_entry_count_const = static_cast<int>(current_max_entry_count);
 
-			std::map<std::string, plain_buffer::ptr> dedicated_buffers;
-			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
-				dedicated_buffers.insert(std::make_pair(it->first, plain_buffer::ptr(new plain_buffer(it->second * current_max_entry_count))));
+			arena.reset(buffer_config_without_data, current_max_entry_count);
+
+			data_pipeline_plain pipeline(
+				reader,
+				writer,
+				plain_config,
+				arena,
+				dedicated_per_entry_data_name_to_size_map,
+				data_layer_names,
+				output_layer_names,
+				output_layers_tiling_factor,
+				current_max_entry_count);
 
-			plain_buffer::ptr temporary_working_fixed_buffer;
+			std::vector<plain_buffer::ptr> temporary_working_fixed_buffers(get_worker_count());
 			if (temporary_working_fixed_size > 0)
-				temporary_working_fixed_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
+			{
+				for(std::vector<plain_buffer::ptr>::iterator it = temporary_working_fixed_buffers.begin(); it != temporary_working_fixed_buffers.end(); ++it)
+					*it = arena.allocate(temporary_working_fixed_size);
+			}
 
 			std::vector<plain_buffer::ptr> layer_buffers;
 			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
-				layer_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * current_max_entry_count)));
+				layer_buffers.push_back(arena.allocate(*it * current_max_entry_count));
 
 			unsigned int entry_processed_count = 0;
 			double total_idel_sec = 0.0;
+			// Indexed by position in actions_in_execution_order, an action is never run by two workers at once
+			std::vector<double> action_seconds_accumulated(actions_in_execution_order.size(), 0.0);
+
+			for(unsigned int i = 0; i < plain_config->pipeline_depth; ++i)
+				pipeline.start_read(current_max_entry_count);
 
 			while(true)
 			{
-				int entry_read_count = 0;
+				std::map<std::string, plain_buffer::ptr> dedicated_buffers;
 				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
-				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count) reduction(+:entry_read_count)
-				{
-					#pragma omp for schedule(dynamic)
-					for(int entry_id = 0; entry_id < current_max_entry_count_const; ++entry_id)
-					{
-						std::map<std::string, float *> data_map;
-						for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
-							data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float))));
-						if (reader.read(entry_processed_count + entry_id, data_map))
-							++entry_read_count;
-					}
-				}
+				int entry_read_count = static_cast<int>(pipeline.wait_read(dedicated_buffers));
 				std::chrono::duration<double> idle_sec = std::chrono::high_resolution_clock::now() - start;
 				total_idel_sec += idle_sec.count();
 
 				if (entry_read_count == 0)
 					break;
 
-				for(std::vector<layer_name_with_action>::const_iterator action_it = actions_in_execution_order.begin(); action_it  != actions_in_execution_order.end(); ++action_it)
+				if (scheduler)
 				{
-					const layer_name_with_action& current_layer_name_with_action = *action_it;
-					std::string layer_name = current_layer_name_with_action.get_name();;
-					layer_action action = current_layer_name_with_action.get_action();
-					layer::const_ptr current_layer = schema->find_layer(layer_name);
-
-					plain_buffer::ptr output_buffer;
-					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
-						if (it != layer_buffer_action_to_set_map.end())
-							output_buffer = layer_buffers[it->second];
-						else
-							output_buffer = dedicated_buffers.find(layer_name)->second;
-					}
-
-					std::vector<plain_buffer::const_ptr> input_buffers;
-					for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it)
-					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
-						if (it != layer_buffer_action_to_set_map.end())
-							input_buffers.push_back(layer_buffers[it->second]);
-						else
-							input_buffers.push_back(dedicated_buffers.find(*input_layer_name_it)->second);
-					}
-
-					plain_buffer::ptr temporary_working_per_entry_buffer;
-					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_working_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
-						if (it != temporary_working_per_entry_data_action_to_set_map.end())
-							temporary_working_per_entry_buffer = layer_buffers[it->second];
-					}
-
-					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
-					for(std::vector<std::string>::const_iterator it2 = current_layer->input_layer_instance_names.begin(); it2 != current_layer->input_layer_instance_names.end(); ++it2)
-						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
-
-					testers.find(layer_name)->second->run_forward_propagation(
-						output_buffer,
-						input_buffers,
-						temporary_working_fixed_buffer,
-						temporary_working_per_entry_buffer,
-						plain_config,
-						current_layer,
-						net_data->data_list.find(layer_name),
-						net_data->data_custom_list.find(layer_name),
-						input_layer_configuration_specific_list,
-						layer_config_map[layer_name],
-						entry_read_count * cumulative_tiling_factor_map[layer_name]);
+					scheduler->run(
+						[&] (unsigned int action_id, unsigned int worker_id, unsigned int concurrency)
+						{
+							action_seconds_accumulated[action_id] += run_action(
+								actions_in_execution_order[action_id],
+								dedicated_buffers,
+								layer_buffers,
+								temporary_working_fixed_buffers[worker_id],
+								concurrent_plain_configs[concurrency - 1],
+								static_cast<unsigned int>(entry_read_count));
+						});
 				}
-
-				for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
+				else
 				{
-					std::map<std::string, const float *> data_map;
-					for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
-						data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float) / output_layers_tiling_factor)));
-					writer.write(entry_processed_count + entry_id, data_map);
+					for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(actions_in_execution_order.size()); ++action_id)
+						action_seconds_accumulated[action_id] += run_action(
+							actions_in_execution_order[action_id],
+							dedicated_buffers,
+							layer_buffers,
+							temporary_working_fixed_buffers.front(),
+							plain_config,
+							static_cast<unsigned int>(entry_read_count));
 				}
 
+				start = std::chrono::high_resolution_clock::now();
+				pipeline.start_write(entry_read_count);
+				idle_sec = std::chrono::high_resolution_clock::now() - start;
+				total_idel_sec += idle_sec.count();
+
 				entry_processed_count += entry_read_count;
 
 				if (entry_read_count < current_max_entry_count_const)
 					break;
+
+				pipeline.start_read(current_max_entry_count);
+			}
+
+			{
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				pipeline.finish_write();
+				std::chrono::duration<double> idle_sec = std::chrono::high_resolution_clock::now() - start;
+				total_idel_sec += idle_sec.count();
 			}
 
 			entries_processed = entry_processed_count;
 			action_seconds.clear();
+			for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(actions_in_execution_order.size()); ++action_id)
+				action_seconds.insert(std::make_pair(actions_in_execution_order[action_id], static_cast<float>(action_seconds_accumulated[action_id])));
 			idle_seconds = static_cast<float>(total_idel_sec);
 		}
 
+		double forward_propagation_plain::run_action(
+			const layer_name_with_action& current_layer_name_with_action,
+			const std::map<std::string, plain_buffer::ptr>& dedicated_buffers,
+			const std::vector<plain_buffer::ptr>& layer_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_running_configuration::const_ptr action_plain_config,
+			unsigned int entry_count) const
+		{
+			std::string layer_name = current_layer_name_with_action.get_name();
+			layer::const_ptr current_layer = fused_schema->find_layer(layer_name);
+
+			plain_buffer::ptr output_buffer;
+			{
+				std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
+				if (it != layer_buffer_action_to_set_map.end())
+					output_buffer = layer_buffers[it->second];
+				else
+					output_buffer = dedicated_buffers.find(layer_name)->second;
+			}
+
+			std::vector<plain_buffer::const_ptr> input_buffers;
+			for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it)
+			{
+				std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
+				if (it != layer_buffer_action_to_set_map.end())
+					input_buffers.push_back(layer_buffers[it->second]);
+				else
+					input_buffers.push_back(dedicated_buffers.find(*input_layer_name_it)->second);
+			}
+
+			plain_buffer::ptr temporary_working_per_entry_buffer;
+			{
+				std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_working_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
+				if (it != temporary_working_per_entry_data_action_to_set_map.end())
+					temporary_working_per_entry_buffer = layer_buffers[it->second];
+			}
+
+			// Lookups only, the method runs concurrently for independent actions
+			std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+			for(std::vector<std::string>::const_iterator it2 = current_layer->input_layer_instance_names.begin(); it2 != current_layer->input_layer_instance_names.end(); ++it2)
+				input_layer_configuration_specific_list.push_back(layer_config_map.find(*it2)->second);
+
+			layer_data::const_ptr current_data;
+			{
+				std::map<std::string, layer_data::const_ptr>::const_iterator it = transformed_data_map.find(layer_name);
+				if (it != transformed_data_map.end())
+					current_data = it->second;
+				else
+					current_data = net_data->data_list.find(layer_name);
+			}
+
+			std::chrono::high_resolution_clock::time_point action_start = std::chrono::high_resolution_clock::now();
+			testers.find(layer_name)->second->run_forward_propagation(
+				output_buffer,
+				input_buffers,
+				temporary_working_fixed_buffer,
+				temporary_working_per_entry_buffer,
+				action_plain_config,
+				current_layer,
+				current_data,
+				net_data->data_custom_list.find(layer_name),
+				input_layer_configuration_specific_list,
+				layer_config_map.find(layer_name)->second,
+				entry_count * cumulative_tiling_factor_map.find(layer_name)->second);
+			std::chrono::duration<double> action_sec = std::chrono::high_resolution_clock::now() - action_start;
+
+			return action_sec.count();
+		}
+
+		unsigned int forward_propagation_plain::get_worker_count() const
+		{
+			return scheduler ? scheduler->get_worker_count() : 1;
+		}
+
 		void forward_propagation_plain::layer_config_map_modified()
 		{
 			setup_dedicated_buffer_sizes();
@@ -213,6 +337,22 @@ namespace nnforge
 			setup_temporary_working_fixed_buffer_sizes();
 
 			update_max_entry_count();
+
+			if (debug->is_debug())
+			{
+				for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
+				{
+					std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(fused_schema->get_layer(it->first));
+					if (layer_derived && convolution_winograd_plain::is_applicable(layer_derived))
+						convolution_winograd_plain::check_against_gemm(
+							debug,
+							plain_config,
+							layer_derived,
+							layer_config_map[layer_derived->input_layer_instance_names.front()],
+							layer_config_map[it->first],
+							false);
+				}
+			}
 		}
 
 		void forward_propagation_plain::setup_dedicated_buffer_sizes()
@@ -231,13 +371,13 @@ namespace nnforge
 			for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
 			{
 				layer_configuration_specific output_layer_configuration_specific = layer_config_map[it->first];
-				layer::const_ptr l = schema->get_layer(it->first);
+				layer::const_ptr l = fused_schema->get_layer(it->first);
 				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 				size_t new_temporary_working_fixed_size = it->second->get_temporary_working_fixed_buffer_size(
 					plain_config,
-					schema->get_layer(it->first),
+					fused_schema->get_layer(it->first),
 					input_layer_configuration_specific_list,
 					output_layer_configuration_specific);
 				temporary_working_fixed_size = std::max(temporary_working_fixed_size, new_temporary_working_fixed_size);
@@ -259,13 +399,13 @@ namespace nnforge
 				for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
 				{
 					layer_configuration_specific output_layer_configuration_specific = layer_config_map[it->first];
-					layer::const_ptr l = schema->get_layer(it->first);
+					layer::const_ptr l = fused_schema->get_layer(it->first);
 					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 					int input_index_layer_can_write = it->second->get_input_index_layer_can_write(
 						plain_config,
-						schema->get_layer(it->first),
+						fused_schema->get_layer(it->first),
 						input_layer_configuration_specific_list,
 						output_layer_configuration_specific);
 					if (input_index_layer_can_write >= 0)
@@ -281,18 +421,18 @@ namespace nnforge
 					size_t buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
 					if (dedicated_output_buffers.find(layer_name) == dedicated_output_buffers.end())
 						buffers.insert(std::make_pair(*it, std::vector<std::pair<buffer_lifetime, float> >(1, std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)))));
-					layer::const_ptr l = schema->get_layer(layer_name);
+					layer::const_ptr l = fused_schema->get_layer(layer_name);
 
 					int input_index_layer_can_write;
 					{
 						layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-						layer::const_ptr l = schema->get_layer(layer_name);
+						layer::const_ptr l = fused_schema->get_layer(layer_name);
 						std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 						for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 							input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 						input_index_layer_can_write = testers[layer_name]->get_input_index_layer_can_write(
 							plain_config,
-							schema->get_layer(layer_name),
+							fused_schema->get_layer(layer_name),
 							input_layer_configuration_specific_list,
 							output_layer_configuration_specific);
 					}
@@ -313,13 +453,13 @@ namespace nnforge
 				for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
 				{
 					layer_configuration_specific output_layer_configuration_specific = layer_config_map[it->first];
-					layer::const_ptr l = schema->get_layer(it->first);
+					layer::const_ptr l = fused_schema->get_layer(it->first);
 					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 					size_t temporary_working_per_entry_buffer_size = it->second->get_temporary_working_per_entry_buffer_size(
 						plain_config,
-						schema->get_layer(it->first),
+						fused_schema->get_layer(it->first),
 						input_layer_configuration_specific_list,
 						output_layer_configuration_specific);
 					if (temporary_working_per_entry_buffer_size > 0)
@@ -353,13 +493,13 @@ namespace nnforge
 						temporary_working_per_entry_data_action_to_set_map.insert(std::make_pair(it->first, set_id));
 
 						layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-						layer::const_ptr l = schema->get_layer(layer_name);
+						layer::const_ptr l = fused_schema->get_layer(layer_name);
 						std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
 						for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
 							input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
 						size_t temporary_working_per_entry_buffer_size = testers.find(layer_name)->second->get_temporary_working_per_entry_buffer_size(
 							plain_config,
-							schema->get_layer(layer_name),
+							fused_schema->get_layer(layer_name),
 							input_layer_configuration_specific_list,
 							output_layer_configuration_specific);
 
@@ -402,7 +542,17 @@ namespace nnforge
 
 		void forward_propagation_plain::update_max_entry_count()
 		{
-			buffer_plain_size_configuration buffer_configuration;
+			buffer_config_without_data = buffer_plain_size_configuration();
+
+			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
+				buffer_config_without_data.add_per_entry_buffer(*it);
+
+			buffer_config_without_data.add_per_entry_buffer(data_pipeline_plain::get_per_entry_buffer_size(plain_config, dedicated_per_entry_data_name_to_size_map, data_layer_names, output_layer_names));
+
+			for(unsigned int worker_id = 0; worker_id < get_worker_count(); ++worker_id)
+				buffer_config_without_data.add_constant_buffer(temporary_working_fixed_size);
+
+			buffer_plain_size_configuration buffer_configuration = buffer_config_without_data;
 
 			std::vector<std::string> data_name_list = net_data->data_list.get_data_layer_name_list();
 			for(std::vector<std::string>::const_iterator it = data_name_list.begin(); it != data_name_list.end(); ++it)
@@ -412,6 +562,10 @@ namespace nnforge
 					buffer_configuration.add_constant_buffer(it2->size() * sizeof(float));
 			}
 
+			for(std::map<std::string, layer_data::const_ptr>::const_iterator it = transformed_data_map.begin(); it != transformed_data_map.end(); ++it)
+				for(layer_data::const_iterator it2 = it->second->begin(); it2 != it->second->end(); ++it2)
+					buffer_configuration.add_constant_buffer(it2->size() * sizeof(float));
+
 			std::vector<std::string> data_custom_name_list = net_data->data_custom_list.get_data_custom_layer_name_list();
 			for(std::vector<std::string>::const_iterator it = data_custom_name_list.begin(); it != data_custom_name_list.end(); ++it)
 			{
@@ -420,14 +574,6 @@ namespace nnforge
 					buffer_configuration.add_constant_buffer(it2->size() * sizeof(int));
 			}
 
-			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
-				buffer_configuration.add_per_entry_buffer(*it);
-
-			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
-				buffer_configuration.add_per_entry_buffer(it->second);
-
-			buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
-
 			max_entry_count = plain_config->get_max_entry_count(buffer_configuration);
 
 			if (max_entry_count == 0)
@@ -442,5 +588,35 @@ namespace nnforge
 				debug->output_message(debug_str.str().c_str());
 			}
 		}
+
+		network_schema::const_ptr forward_propagation_plain::get_executed_schema() const
+		{
+			return fused_schema;
+		}
+
+		float forward_propagation_plain::get_max_flops() const
+		{
+			return plain_config->get_flops();
+		}
+
+		std::map<layer_name_with_action, float> forward_propagation_plain::get_flops_per_action() const
+		{
+			std::map<layer_name_with_action, float> res;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				const std::string& layer_name = it->get_name();
+				layer::const_ptr l = fused_schema->get_layer(layer_name);
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map.find(*it2)->second);
+				float flops_per_entry = testers.find(layer_name)->second->get_flops_per_entry(
+					plain_config,
+					l,
+					input_layer_configuration_specific_list,
+					layer_config_map.find(layer_name)->second);
+				res.insert(std::make_pair(*it, flops_per_entry * static_cast<float>(cumulative_tiling_factor_map.find(layer_name)->second)));
+			}
+			return res;
+		}
 	}
 }
@@ -19,6 +19,8 @@
 #include "../forward_propagation.h"
 #include "plain_running_configuration.h"
 #include "layer_tester_plain.h"
+#include "plain_buffer_arena.h"
+#include "task_scheduler_plain.h"
 
 #include <map>
 
@@ -56,6 +58,12 @@ namespace nnforge
 			// The layer_config_map is guaranteed to be compatible with schema
 			virtual void layer_config_map_modified();
 
+			virtual float get_max_flops() const;
+
+			virtual std::map<layer_name_with_action, float> get_flops_per_action() const;
+
+			virtual network_schema::const_ptr get_executed_schema() const;
+
 		private:
 			void setup_dedicated_buffer_sizes();
 
@@ -65,14 +73,37 @@ namespace nnforge
 
 			void update_max_entry_count();
 
+			// Runs the action for entry_count entries with the OpenMP thread count from action_plain_config, returns the time spent
+			double run_action(
+				const layer_name_with_action& current_layer_name_with_action,
+				const std::map<std::string, plain_buffer::ptr>& dedicated_buffers,
+				const std::vector<plain_buffer::ptr>& layer_buffers,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				plain_running_configuration::const_ptr action_plain_config,
+				unsigned int entry_count) const;
+
+			unsigned int get_worker_count() const;
+
 		private:
 			plain_running_configuration::const_ptr plain_config;
 
+			// Actions are built from it, it is the same as schema unless layers are fused for inference.
+			// Names of the fused layers are those of the original ones, so layer_config_map is shared
+			network_schema::const_ptr fused_schema;
+
 			std::vector<layer_name_with_action> actions_in_execution_order;
 
+			// Runs independent actions concurrently, null when actions run in a single chain
+			task_scheduler_plain::ptr scheduler;
+			// Element i limits OpenMP threads for an action started while i + 1 actions run or are ready to run
+			std::vector<plain_running_configuration::const_ptr> concurrent_plain_configs;
+
 			std::map<std::string, layer_tester_plain::const_ptr> testers;
 			network_data::const_ptr net_data;
+			// Layer data testers transformed ahead of running and data of fused layers, used in place of net_data entries
+			std::map<std::string, layer_data::const_ptr> transformed_data_map;
 
+			// Each worker of the scheduler gets its own fixed working buffer of this size
 			size_t temporary_working_fixed_size;
 
 			std::vector<size_t> layer_buffer_set_per_entry_size_list;
@@ -83,6 +114,11 @@ namespace nnforge
 
 			unsigned int max_entry_count;
 
+			buffer_plain_size_configuration buffer_config_without_data;
+
+			// Layer, temporary and pipeline buffers, kept between runs
+			plain_buffer_arena arena;
+
 		private:
 			static const unsigned int max_max_entry_count;
 
@@ -35,5 +35,44 @@ namespace nnforge
 		{
 			return forward_propagation::ptr(new forward_propagation_plain(schema, output_layer_names, debug, profile, plain_config));
 		}
+
+		forward_propagation::ptr forward_propagation_plain_factory::create_concurrent(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			debug_state::ptr debug,
+			profile_state::ptr profile,
+			unsigned int concurrent_count) const
+		{
+			if (concurrent_count <= 1)
+				return create(schema, output_layer_names, debug, profile);
+
+			std::shared_ptr<plain_running_configuration> concurrent_plain_config(new plain_running_configuration(
+				*plain_config,
+				plain_config->openmp_thread_count / static_cast<int>(concurrent_count),
+				1.0F / static_cast<float>(concurrent_count)));
+			concurrent_plain_config->concurrent_action_count = plain_config->concurrent_action_count;
+
+			return forward_propagation::ptr(new forward_propagation_plain(schema, output_layer_names, debug, profile, concurrent_plain_config));
+		}
+
+		forward_propagation::ptr forward_propagation_plain_factory::create_coexisting(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			debug_state::ptr debug,
+			profile_state::ptr profile,
+			unsigned int coexisting_count) const
+		{
+			if (coexisting_count <= 1)
+				return create(schema, output_layer_names, debug, profile);
+
+			// The objects run one after another, so each of them keeps all the threads
+			std::shared_ptr<plain_running_configuration> coexisting_plain_config(new plain_running_configuration(
+				*plain_config,
+				plain_config->openmp_thread_count,
+				1.0F / static_cast<float>(coexisting_count)));
+			coexisting_plain_config->concurrent_action_count = plain_config->concurrent_action_count;
+
+			return forward_propagation::ptr(new forward_propagation_plain(schema, output_layer_names, debug, profile, coexisting_plain_config));
+		}
 	}
 }
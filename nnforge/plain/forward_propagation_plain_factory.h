@@ -36,6 +36,22 @@ namespace nnforge
 				debug_state::ptr debug,
 				profile_state::ptr profile) const;
 
+			// Each object gets concurrent_count-th part of the OpenMP threads and of the memory limit
+			virtual forward_propagation::ptr create_concurrent(
+				const network_schema& schema,
+				const std::vector<std::string>& output_layer_names,
+				debug_state::ptr debug,
+				profile_state::ptr profile,
+				unsigned int concurrent_count) const;
+
+			// Each object gets coexisting_count-th part of the memory limit and all the OpenMP threads
+			virtual forward_propagation::ptr create_coexisting(
+				const network_schema& schema,
+				const std::vector<std::string>& output_layer_names,
+				debug_state::ptr debug,
+				profile_state::ptr profile,
+				unsigned int coexisting_count) const;
+
 		protected:
 			plain_running_configuration::const_ptr plain_config;
 		};
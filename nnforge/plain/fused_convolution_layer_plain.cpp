@@ -0,0 +1,68 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "fused_convolution_layer_plain.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		fused_convolution_layer_plain::fused_convolution_layer_plain(const convolution_layer& convolution)
+			: convolution_layer(convolution)
+			, convolution_instance_name(convolution.instance_name)
+			, residual(false)
+			, relu(false)
+		{
+		}
+
+		layer::ptr fused_convolution_layer_plain::clone() const
+		{
+			return layer::ptr(new fused_convolution_layer_plain(*this));
+		}
+
+		float fused_convolution_layer_plain::get_flops_per_entry(
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_action& action) const
+		{
+			float res = convolution_layer::get_flops_per_entry(input_configuration_specific_list, action);
+			if (action.get_action_type() == layer_action::forward)
+			{
+				float neuron_count = static_cast<float>(get_output_layer_configuration_specific(input_configuration_specific_list).get_neuron_count());
+				if (residual)
+					res += neuron_count;
+				if (relu)
+					res += neuron_count;
+			}
+			return res;
+		}
+
+		std::vector<std::string> fused_convolution_layer_plain::get_parameter_strings() const
+		{
+			std::vector<std::string> res = convolution_layer::get_parameter_strings();
+
+			std::string fused = "fused " + convolution_instance_name;
+			if (!batch_norm_instance_name.empty())
+				fused += ", " + batch_norm_instance_name;
+			if (residual)
+				fused += ", residual";
+			if (relu)
+				fused += ", relu";
+			res.push_back(fused);
+
+			return res;
+		}
+	}
+}
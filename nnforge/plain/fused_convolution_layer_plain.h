@@ -0,0 +1,56 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../convolution_layer.h"
+
+#include <string>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Convolution standing for a chain of layers fused by layer_fusion_plain for inference:
+		// convolution, then optionally batch_norm folded into the weights and biases,
+		// then optionally add_layer with the residual taken from the second input, then optionally rectified_linear.
+		// The instance name is that of the last layer of the chain, so consumers of the chain stay intact.
+		// The type name is inherited, so the layer is run by convolution_layer_tester_plain
+		class fused_convolution_layer_plain : public convolution_layer
+		{
+		public:
+			typedef std::shared_ptr<fused_convolution_layer_plain> ptr;
+			typedef std::shared_ptr<const fused_convolution_layer_plain> const_ptr;
+
+			fused_convolution_layer_plain(const convolution_layer& convolution);
+
+			virtual layer::ptr clone() const;
+
+			virtual float get_flops_per_entry(
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_action& action) const;
+
+			virtual std::vector<std::string> get_parameter_strings() const;
+
+		public:
+			// Layers whose data the fused weights and biases are computed from, batch_norm_instance_name is empty when there is none
+			std::string convolution_instance_name;
+			std::string batch_norm_instance_name;
+			bool residual;
+			bool relu;
+		};
+	}
+}
@@ -0,0 +1,283 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "gemm_plain.h"
+
+#include "simd_kernels_plain.h"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const int gemm_plain::mr = simd_kernels_plain::gemm_mr;
+		const int gemm_plain::nr = simd_kernels_plain::gemm_nr;
+		const int gemm_plain::mc = 96;
+		const int gemm_plain::kc = 256;
+		const int gemm_plain::nc = 512;
+
+		size_t gemm_plain::get_workspace_elem_count()
+		{
+			return static_cast<size_t>(mc * kc) + static_cast<size_t>(kc * nc);
+		}
+
+		void gemm_plain::run(
+			bool transpose_a,
+			bool transpose_b,
+			int m,
+			int n,
+			int k,
+			float alpha,
+			const float * a,
+			int lda,
+			const float * b,
+			int ldb,
+			float beta,
+			float * c,
+			int ldc,
+			float * workspace)
+		{
+			if ((m <= 0) || (n <= 0))
+				return;
+
+			if (beta == 0.0F)
+			{
+				for(int i = 0; i < m; ++i)
+					std::fill_n(c + i * ldc, n, 0.0F);
+			}
+			else if (beta != 1.0F)
+			{
+				for(int i = 0; i < m; ++i)
+				{
+					float * c_row = c + i * ldc;
+					for(int j = 0; j < n; ++j)
+						c_row[j] *= beta;
+				}
+			}
+
+			if ((k <= 0) || (alpha == 0.0F))
+				return;
+
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+			float * packed_a = workspace;
+			float * packed_b = workspace + mc * kc;
+
+			for(int jc = 0; jc < n; jc += nc)
+			{
+				int nc_actual = std::min(nc, n - jc);
+				for(int pc = 0; pc < k; pc += kc)
+				{
+					int kc_actual = std::min(kc, k - pc);
+					pack_b(
+						transpose_b,
+						kc_actual,
+						nc_actual,
+						transpose_b ? b + jc * ldb + pc : b + pc * ldb + jc,
+						ldb,
+						packed_b);
+
+					for(int ic = 0; ic < m; ic += mc)
+					{
+						int mc_actual = std::min(mc, m - ic);
+						pack_a(
+							transpose_a,
+							mc_actual,
+							kc_actual,
+							alpha,
+							transpose_a ? a + pc * lda + ic : a + ic * lda + pc,
+							lda,
+							packed_a);
+
+						for(int jr = 0; jr < nc_actual; jr += nr)
+						{
+							int nr_actual = std::min(nr, nc_actual - jr);
+							const float * packed_b_panel = packed_b + jr * kc_actual;
+							for(int ir = 0; ir < mc_actual; ir += mr)
+							{
+								int mr_actual = std::min(mr, mc_actual - ir);
+								kernels.gemm_micro_kernel(
+									kc_actual,
+									packed_a + ir * kc_actual,
+									packed_b_panel,
+									c + (ic + ir) * ldc + (jc + jr),
+									ldc,
+									mr_actual,
+									nr_actual);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		void gemm_plain::run_parallel(
+			int thread_count,
+			bool transpose_a,
+			bool transpose_b,
+			int m,
+			int n,
+			int k,
+			float alpha,
+			const float * a,
+			int lda,
+			const float * b,
+			int ldb,
+			float beta,
+			float * c,
+			int ldc,
+			float * workspace)
+		{
+			// Shrink blocks until there is enough work for all the threads
+			int block_m = mc;
+			int block_n = nc;
+			while (true)
+			{
+				int block_count = ((m + block_m - 1) / block_m) * ((n + block_n - 1) / block_n);
+				if (block_count >= thread_count)
+					break;
+				if ((block_n >= block_m) && (block_n > nr))
+					block_n = std::max(block_n / 2, nr);
+				else if (block_m > mr)
+					block_m = std::max(block_m / 2, mr);
+				else
+					break;
+			}
+
+			const int block_m_count = (m + block_m - 1) / block_m;
+			const int total_workload = block_m_count * ((n + block_n - 1) / block_n);
+			const size_t workspace_elem_count = get_workspace_elem_count();
+
+			#pragma omp parallel default(shared) num_threads(std::max(std::min(thread_count, total_workload), 1))
+			{
+				int thread_id = 0;
+				#ifdef _OPENMP
+				thread_id = omp_get_thread_num();
+				#endif
+
+				float * thread_workspace = workspace + thread_id * workspace_elem_count;
+
+				#pragma omp for schedule(dynamic)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					int block_n_id = workload_id / block_m_count;
+					int block_m_id = workload_id - (block_n_id * block_m_count);
+					int i0 = block_m_id * block_m;
+					int j0 = block_n_id * block_n;
+
+					run(
+						transpose_a,
+						transpose_b,
+						std::min(block_m, m - i0),
+						std::min(block_n, n - j0),
+						k,
+						alpha,
+						transpose_a ? a + i0 : a + i0 * lda,
+						lda,
+						transpose_b ? b + j0 * ldb : b + j0,
+						ldb,
+						beta,
+						c + i0 * ldc + j0,
+						ldc,
+						thread_workspace);
+				}
+			}
+		}
+
+		void gemm_plain::pack_a(
+			bool transpose_a,
+			int mc_actual,
+			int kc_actual,
+			float alpha,
+			const float * a,
+			int lda,
+			float * packed_a)
+		{
+			// Row panels of mr rows each, within a panel elements are stored column by column
+			for(int ir = 0; ir < mc_actual; ir += mr)
+			{
+				int mr_actual = std::min(mr, mc_actual - ir);
+				float * dst = packed_a + ir * kc_actual;
+				if (transpose_a)
+				{
+					for(int p = 0; p < kc_actual; ++p)
+					{
+						const float * src = a + p * lda + ir;
+						for(int i = 0; i < mr_actual; ++i)
+							dst[p * mr + i] = src[i] * alpha;
+						for(int i = mr_actual; i < mr; ++i)
+							dst[p * mr + i] = 0.0F;
+					}
+				}
+				else
+				{
+					for(int i = 0; i < mr_actual; ++i)
+					{
+						const float * src = a + (ir + i) * lda;
+						for(int p = 0; p < kc_actual; ++p)
+							dst[p * mr + i] = src[p] * alpha;
+					}
+					for(int i = mr_actual; i < mr; ++i)
+						for(int p = 0; p < kc_actual; ++p)
+							dst[p * mr + i] = 0.0F;
+				}
+			}
+		}
+
+		void gemm_plain::pack_b(
+			bool transpose_b,
+			int kc_actual,
+			int nc_actual,
+			const float * b,
+			int ldb,
+			float * packed_b)
+		{
+			// Column panels of nr columns each, within a panel elements are stored row by row
+			for(int jr = 0; jr < nc_actual; jr += nr)
+			{
+				int nr_actual = std::min(nr, nc_actual - jr);
+				float * dst = packed_b + jr * kc_actual;
+				if (transpose_b)
+				{
+					for(int j = 0; j < nr_actual; ++j)
+					{
+						const float * src = b + (jr + j) * ldb;
+						for(int p = 0; p < kc_actual; ++p)
+							dst[p * nr + j] = src[p];
+					}
+					for(int j = nr_actual; j < nr; ++j)
+						for(int p = 0; p < kc_actual; ++p)
+							dst[p * nr + j] = 0.0F;
+				}
+				else
+				{
+					for(int p = 0; p < kc_actual; ++p)
+					{
+						const float * src = b + p * ldb + jr;
+						for(int j = 0; j < nr_actual; ++j)
+							dst[p * nr + j] = src[j];
+						for(int j = nr_actual; j < nr; ++j)
+							dst[p * nr + j] = 0.0F;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Blocked, cache-tiled single precision matrix multiplication, all matrices are row-major:
+		// C = alpha * op(A) * op(B) + beta * C, op(A) is m x k, op(B) is k x n, C is m x n
+		class gemm_plain
+		{
+		public:
+			// Single-threaded, workspace should hold at least get_workspace_elem_count() floats
+			static void run(
+				bool transpose_a,
+				bool transpose_b,
+				int m,
+				int n,
+				int k,
+				float alpha,
+				const float * a,
+				int lda,
+				const float * b,
+				int ldb,
+				float beta,
+				float * c,
+				int ldc,
+				float * workspace);
+
+			// Splits C into blocks and computes them with up to thread_count OpenMP threads
+			// workspace should hold at least thread_count * get_workspace_elem_count() floats
+			static void run_parallel(
+				int thread_count,
+				bool transpose_a,
+				bool transpose_b,
+				int m,
+				int n,
+				int k,
+				float alpha,
+				const float * a,
+				int lda,
+				const float * b,
+				int ldb,
+				float beta,
+				float * c,
+				int ldc,
+				float * workspace);
+
+			static size_t get_workspace_elem_count();
+
+		public:
+			static const int mr;
+			static const int nr;
+			static const int mc;
+			static const int kc;
+			static const int nc;
+
+		private:
+			static void pack_a(
+				bool transpose_a,
+				int mc_actual,
+				int kc_actual,
+				float alpha,
+				const float * a,
+				int lda,
+				float * packed_a);
+
+			static void pack_b(
+				bool transpose_b,
+				int kc_actual,
+				int nc_actual,
+				const float * b,
+				int ldb,
+				float * packed_b);
+
+		private:
+			gemm_plain() = delete;
+			gemm_plain(const gemm_plain&) = delete;
+			gemm_plain& operator =(const gemm_plain&) = delete;
+		};
+	}
+}
@@ -0,0 +1,172 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "layer_fusion_plain.h"
+
+#include "../batch_norm_layer.h"
+#include "../add_layer.h"
+#include "../rectified_linear_layer.h"
+#include "../neural_network_exception.h"
+
+#include <map>
+#include <set>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		std::vector<layer::const_ptr> layer_fusion_plain::get_fused_layers(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names)
+		{
+			std::vector<layer::const_ptr> layers = schema.get_layers_in_forward_propagation_order();
+			std::set<std::string> output_layer_name_set(output_layer_names.begin(), output_layer_names.end());
+
+			std::map<std::string, layer::const_ptr> name_to_layer_map;
+			// A layer is listed once for each of its inputs it consumes the output with
+			std::map<std::string, std::vector<std::string> > consumer_map;
+			for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+			{
+				name_to_layer_map.insert(std::make_pair((*it)->instance_name, *it));
+				for(std::vector<std::string>::const_iterator it2 = (*it)->input_layer_instance_names.begin(); it2 != (*it)->input_layer_instance_names.end(); ++it2)
+					consumer_map.insert(std::make_pair(*it2, std::vector<std::string>())).first->second.push_back((*it)->instance_name);
+			}
+
+			std::set<std::string> claimed_layer_names;
+			std::map<std::string, layer::const_ptr> chain_last_layer_name_to_fused_layer_map;
+			for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+			{
+				std::shared_ptr<const convolution_layer> convolution = std::dynamic_pointer_cast<const convolution_layer>(*it);
+				if ((!convolution) || (claimed_layer_names.find(convolution->instance_name) != claimed_layer_names.end()))
+					continue;
+
+				fused_convolution_layer_plain::ptr fused(new fused_convolution_layer_plain(*convolution));
+				std::vector<std::string> chain_layer_names(1, convolution->instance_name);
+				while (true)
+				{
+					const std::string& current_layer_name = chain_layer_names.back();
+					if (output_layer_name_set.find(current_layer_name) != output_layer_name_set.end())
+						break;
+					std::map<std::string, std::vector<std::string> >::const_iterator consumer_it = consumer_map.find(current_layer_name);
+					if ((consumer_it == consumer_map.end()) || (consumer_it->second.size() != 1))
+						break;
+					const std::string& next_layer_name = consumer_it->second.front();
+					if (claimed_layer_names.find(next_layer_name) != claimed_layer_names.end())
+						break;
+					layer::const_ptr next_layer = name_to_layer_map.find(next_layer_name)->second;
+
+					std::shared_ptr<const batch_norm_layer> batch_norm = std::dynamic_pointer_cast<const batch_norm_layer>(next_layer);
+					if (batch_norm)
+					{
+						if ((chain_layer_names.size() > 1) || (batch_norm->feature_map_count != fused->output_feature_map_count))
+							break;
+						fused->batch_norm_instance_name = next_layer_name;
+						fused->bias = true;
+						chain_layer_names.push_back(next_layer_name);
+						continue;
+					}
+
+					std::shared_ptr<const add_layer> add = std::dynamic_pointer_cast<const add_layer>(next_layer);
+					if (add)
+					{
+						if (fused->residual || fused->relu || (add->alpha != 1.0F) || (add->input_layer_instance_names.size() != 2))
+							break;
+						const std::string& residual_layer_name = (add->input_layer_instance_names[0] == current_layer_name) ? add->input_layer_instance_names[1] : add->input_layer_instance_names[0];
+						fused->residual = true;
+						fused->input_layer_instance_names.push_back(residual_layer_name);
+						chain_layer_names.push_back(next_layer_name);
+						continue;
+					}
+
+					std::shared_ptr<const rectified_linear_layer> relu = std::dynamic_pointer_cast<const rectified_linear_layer>(next_layer);
+					if (relu)
+					{
+						if (fused->relu)
+							break;
+						fused->relu = true;
+						chain_layer_names.push_back(next_layer_name);
+						continue;
+					}
+
+					break;
+				}
+
+				if (chain_layer_names.size() == 1)
+					continue;
+
+				fused->instance_name = chain_layer_names.back();
+				claimed_layer_names.insert(chain_layer_names.begin(), chain_layer_names.end());
+				chain_last_layer_name_to_fused_layer_map.insert(std::make_pair(fused->instance_name, fused));
+			}
+
+			std::vector<layer::const_ptr> res;
+			for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+			{
+				std::map<std::string, layer::const_ptr>::const_iterator fused_it = chain_last_layer_name_to_fused_layer_map.find((*it)->instance_name);
+				if (fused_it != chain_last_layer_name_to_fused_layer_map.end())
+					res.push_back(fused_it->second);
+				else if (claimed_layer_names.find((*it)->instance_name) == claimed_layer_names.end())
+					res.push_back(*it);
+			}
+
+			return res;
+		}
+
+		layer_data::const_ptr layer_fusion_plain::get_fused_data(
+			const fused_convolution_layer_plain& fused_layer,
+			const network_data& data)
+		{
+			layer_data::const_ptr convolution_data = data.data_list.find(fused_layer.convolution_instance_name);
+			if (!convolution_data)
+				throw neural_network_exception((boost::format("No data found for layer %1% fused into %2%") % fused_layer.convolution_instance_name % fused_layer.instance_name).str());
+
+			if (fused_layer.batch_norm_instance_name.empty())
+				return convolution_data;
+
+			layer_data::const_ptr batch_norm_data = data.data_list.find(fused_layer.batch_norm_instance_name);
+			if (!batch_norm_data)
+				throw neural_network_exception((boost::format("No data found for layer %1% fused into %2%") % fused_layer.batch_norm_instance_name % fused_layer.instance_name).str());
+
+			// The same per feature map affine transform batch_norm_layer_tester_plain applies
+			const int output_feature_map_count = static_cast<int>(fused_layer.output_feature_map_count);
+			const std::vector<float>& gamma = (*batch_norm_data)[0];
+			const std::vector<float>& beta = (*batch_norm_data)[1];
+			const std::vector<float>& mean = (*batch_norm_data)[2];
+			const std::vector<float>& inverse_sigma = (*batch_norm_data)[3];
+			const size_t weight_count_per_output_feature_map = (*convolution_data)[0].size() / output_feature_map_count;
+
+			layer_data::ptr res(new layer_data());
+			res->resize(2);
+			(*res)[0] = (*convolution_data)[0];
+			(*res)[1].resize(output_feature_map_count, 0.0F);
+			for(int output_feature_map_id = 0; output_feature_map_id < output_feature_map_count; ++output_feature_map_id)
+			{
+				float mult = gamma[output_feature_map_id] * inverse_sigma[output_feature_map_id];
+				float add = beta[output_feature_map_id] - mult * mean[output_feature_map_id];
+
+				std::vector<float>::iterator weights_it = (*res)[0].begin() + output_feature_map_id * weight_count_per_output_feature_map;
+				for(size_t i = 0; i < weight_count_per_output_feature_map; ++i)
+					weights_it[i] *= mult;
+
+				float bias = (convolution_data->size() > 1) ? (*convolution_data)[1][output_feature_map_id] : 0.0F;
+				(*res)[1][output_feature_map_id] = bias * mult + add;
+			}
+
+			return res;
+		}
+	}
+}
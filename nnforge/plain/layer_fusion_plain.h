@@ -0,0 +1,54 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../network_schema.h"
+#include "../network_data.h"
+
+#include "fused_convolution_layer_plain.h"
+
+#include <vector>
+#include <string>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Inference-only rewrite of the schema: each convolution absorbs the chain of layers consuming its output exclusively,
+		// batch_norm (right after the convolution) is folded into the weights and biases,
+		// add_layer with two inputs and unit alpha and rectified_linear are applied in the convolution epilogue.
+		// Outputs of output layers are never absorbed
+		class layer_fusion_plain
+		{
+		public:
+			// Returns the layers of the schema with the chains replaced by fused_convolution_layer_plain
+			static std::vector<layer::const_ptr> get_fused_layers(
+				const network_schema& schema,
+				const std::vector<std::string>& output_layer_names);
+
+			// Returns weights and biases of the fused convolution computed from the data of the layers it replaces
+			static layer_data::const_ptr get_fused_data(
+				const fused_convolution_layer_plain& fused_layer,
+				const network_data& data);
+
+		private:
+			layer_fusion_plain() = delete;
+			layer_fusion_plain(const layer_fusion_plain&) = delete;
+			layer_fusion_plain& operator =(const layer_fusion_plain&) = delete;
+		};
+	}
+}
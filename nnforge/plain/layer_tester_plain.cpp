@@ -46,5 +46,22 @@ namespace nnforge
 		{
 			return 0;
 		}
+
+		layer_data::const_ptr layer_tester_plain::get_transformed_data(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data) const
+		{
+			return layer_data::const_ptr();
+		}
+
+		float layer_tester_plain::get_flops_per_entry(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return layer_schema->get_flops_per_entry(input_configuration_specific_list, layer_action(layer_action::forward));
+		}
 	}
 }
@@ -70,6 +70,20 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+			// Default impl returns empty pointer, the original data is used then.
+			// Called once per network data, the result is passed to run_forward_propagation in place of the original data
+			virtual layer_data::const_ptr get_transformed_data(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				layer_data::const_ptr data) const;
+
+			// Default impl returns flops reported by the layer, override it for implementations doing less work
+			virtual float get_flops_per_entry(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 		protected:
 			layer_tester_plain() = default;
 
@@ -88,6 +88,26 @@ namespace nnforge
 				const std::set<layer_action>& actions,
 				unsigned int entry_count) const;
 
+			// Used by layers with fused backward_data_and_weights action, input errors are for the single input of the layer
+			virtual void run_backward_data_and_weights_propagation(
+				plain_buffer::ptr input_errors_buffer,
+				plain_buffer::const_ptr output_errors_buffer,
+				const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+				plain_buffer::const_ptr output_neurons_buffer,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				plain_buffer::ptr temporary_working_per_entry_buffer,
+				plain_buffer::ptr temporary_per_entry_buffer,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				layer_data::const_ptr data,
+				layer_data::ptr gradient,
+				layer_data_custom::const_ptr data_custom,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				const bool add_update_to_destination,
+				const std::set<layer_action>& actions,
+				unsigned int entry_count) const;
+
 			// Default impl returns -1
 			virtual int get_input_index_layer_can_write(
 				const layer_action& action,
@@ -166,6 +186,40 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+			// Default impl returns true
+			virtual bool is_backward_data_and_weights_dependent_on_input_buffer(
+				unsigned int data_input_index,
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Default impl returns true
+			virtual bool is_backward_data_and_weights_dependent_on_output_buffer(
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Default impl returns get_temporary_per_entry_buffer_size() != 0
+			virtual bool is_backward_data_and_weights_dependent_on_temporary_per_entry_buffer(
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Default impl returns flops reported by the layer, override it for implementations doing less work
+			virtual float get_flops_per_entry(
+				const layer_action& action,
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 		protected:
 			layer_updater_plain() = default;
 
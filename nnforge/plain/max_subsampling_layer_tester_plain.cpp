@@ -18,8 +18,14 @@
 
 #include "../max_subsampling_layer.h"
 #include "../neural_network_exception.h"
+#include "simd_kernels_plain.h"
 
 #include <array>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace nnforge
 {
@@ -60,6 +66,7 @@ namespace nnforge
 				test_non_tiling(
 					output_buffer,
 					input_buffers[0],
+					temporary_working_fixed_buffer,
 					plain_config,
 					layer_schema,
 					input_configuration_specific_list[0],
@@ -167,9 +174,25 @@ namespace nnforge
 			}
 		}
 
+		size_t max_subsampling_layer_tester_plain::get_temporary_working_fixed_buffer_size(
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			std::shared_ptr<const max_subsampling_layer> layer_derived = std::dynamic_pointer_cast<const max_subsampling_layer>(layer_schema);
+			if (layer_derived->tiling)
+				return 0;
+
+			// A row of partially reduced windows per thread
+			unsigned int row_elem_count = input_configuration_specific_list[0].dimension_sizes.empty() ? 1 : input_configuration_specific_list[0].dimension_sizes[0];
+			return row_elem_count * plain_config->openmp_thread_count * sizeof(float);
+		}
+
 		void max_subsampling_layer_tester_plain::test_non_tiling(
 			plain_buffer::ptr output_buffer,
 			plain_buffer::const_ptr input_buffer,
+			plain_buffer::ptr temporary_working_fixed_buffer,
 			plain_running_configuration::const_ptr plain_config,
 			layer::const_ptr layer_schema,
 			const layer_configuration_specific& input_configuration_specific,
@@ -218,7 +241,6 @@ namespace nnforge
 			for(unsigned int i = 0; i < subsampling_dimension_count; ++i)
 				subsampling_elem_count *= subsampling_sizes[i];
 			const unsigned int const_subsampling_elem_count = subsampling_elem_count;
-			const float mult = 1.0F / static_cast<float>(subsampling_elem_count);
 			const unsigned int output_feature_map_count = output_configuration_specific.feature_map_count;
 			const bool is_min = layer_derived->is_min;
 
@@ -240,14 +262,31 @@ namespace nnforge
 				}
 			}
 
+			// The window is reduced in two steps: whole rows along the 1st dimension are combined with vector kernels
+			// into a per-thread buffer first, then each output neuron reduces its few neighbouring elements of that buffer
+			const unsigned int row_window_size = subsampling_sizes[0];
+			const unsigned int row_stride = strides[0];
+			const unsigned int window_row_count = const_subsampling_elem_count / row_window_size;
+			const unsigned int output_row_elem_count = output_dimension_sizes[0];
+			const int row_elem_count = static_cast<int>((output_row_elem_count - 1) * row_stride + row_window_size);
+			const unsigned int row_buffer_elem_count = input_dimension_sizes[0];
+			float * const row_buffers = *temporary_working_fixed_buffer;
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+
 			const int total_workload = entry_count * output_configuration_specific.feature_map_count;
 			const std::vector<unsigned int>::const_iterator dimension_sizes_it = output_dimension_sizes.begin();
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count)
 			{
+				int thread_id = 0;
+				#ifdef _OPENMP
+				thread_id = omp_get_thread_num();
+				#endif
+
+				float * const row_buffer = row_buffers + thread_id * row_buffer_elem_count;
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
 				#pragma omp for schedule(guided)
@@ -260,23 +299,28 @@ namespace nnforge
 					float * out_it_base = out_it_global + (output_entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
 
 					std::fill_n(current_output_position.begin(), spatial_dimension_count, 0);
-					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it)
+					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; out_it += output_row_elem_count)
 					{
-						// Define the starting position of the first input elem
+						// Define the starting position of the first input elem of the row
 						const float * in_it = in_it_base;
-						for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+						for(unsigned int i = 1; i < spatial_dimension_count; ++i)
 							in_it += current_output_position[i] * (*(strides_it + i)) * (*(input_slices_it + i));
 
-						float current_max = is_min ? 1.0e37F : -1.0e37F;
-						for(unsigned int i = 0; i < const_subsampling_elem_count; ++i)
+						std::copy(in_it, in_it + row_elem_count, row_buffer);
+						for(unsigned int window_row_id = 1; window_row_id < window_row_count; ++window_row_id)
+							kernels.max_accumulate(row_buffer, in_it + (*(offset_list_it + window_row_id * row_window_size)), row_elem_count, is_min);
+
+						for(unsigned int x = 0; x < output_row_elem_count; ++x)
 						{
-							float new_val = *(in_it + (*(offset_list_it + i)));
-							current_max = is_min ? std::min<float>(current_max, new_val) : std::max<float>(current_max, new_val);
+							const float * window_it = row_buffer + x * row_stride;
+							float current_max = *window_it;
+							for(unsigned int i = 1; i < row_window_size; ++i)
+								current_max = is_min ? std::min<float>(current_max, window_it[i]) : std::max<float>(current_max, window_it[i]);
+							out_it[x] = current_max;
 						}
-						*out_it = current_max;
 
-						// Go to the next output element
-						for(unsigned int i = 0; i < spatial_dimension_count; ++i)
+						// Go to the next output row
+						for(unsigned int i = 1; i < spatial_dimension_count; ++i)
 						{
 							if ((++current_output_position[i]) < *( dimension_sizes_it + i))
 								break;
@@ -44,10 +44,17 @@ namespace nnforge
 				const layer_configuration_specific& output_configuration_specific,
 				unsigned int entry_count) const;
 
+			virtual size_t get_temporary_working_fixed_buffer_size(
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 		private:
 			void test_non_tiling(
 				plain_buffer::ptr output_buffer,
 				plain_buffer::const_ptr input_buffer,
+				plain_buffer::ptr temporary_working_fixed_buffer,
 				plain_running_configuration::const_ptr plain_config,
 				layer::const_ptr layer_schema,
 				const layer_configuration_specific& input_configuration_specific,
@@ -18,6 +18,8 @@
 
 #include "../nnforge.h"
 
+#include "simd_kernels_plain.h"
+
 #include "layer_tester_plain_factory.h"
 
 #include "absolute_layer_tester_plain.h"
@@ -82,6 +84,7 @@
 #include "entry_convolution_layer_updater_plain.h"
 #include "affine_grid_generator_layer_updater_plain.h"
 #include "linear_sampler_layer_updater_plain.h"
+#include "batch_norm_layer_updater_plain.h"
 
 namespace nnforge
 {
@@ -91,6 +94,9 @@ namespace nnforge
 		{
 			nnforge::init();
 
+			// Pick vector kernels once, before any worker threads start
+			simd_kernels_plain::get_singleton();
+
 			layer_tester_plain_factory::get_singleton().register_layer_tester_plain(layer_tester_plain::ptr(new absolute_layer_tester_plain()));
 			layer_tester_plain_factory::get_singleton().register_layer_tester_plain(layer_tester_plain::ptr(new dropout_layer_tester_plain()));
 			layer_tester_plain_factory::get_singleton().register_layer_tester_plain(layer_tester_plain::ptr(new hyperbolic_tangent_layer_tester_plain()));
@@ -150,6 +156,7 @@ namespace nnforge
 			layer_updater_plain_factory::get_singleton().register_layer_updater_plain(layer_updater_plain::ptr(new entry_convolution_layer_updater_plain()));
 			layer_updater_plain_factory::get_singleton().register_layer_updater_plain(layer_updater_plain::ptr(new affine_grid_generator_layer_updater_plain()));
 			layer_updater_plain_factory::get_singleton().register_layer_updater_plain(layer_updater_plain::ptr(new linear_sampler_layer_updater_plain()));
+			layer_updater_plain_factory::get_singleton().register_layer_updater_plain(layer_updater_plain::ptr(new batch_norm_layer_updater_plain()));
 		}
 	}
 }
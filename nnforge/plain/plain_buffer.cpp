@@ -16,23 +16,79 @@
 
 #include "plain_buffer.h"
 
+#include "../neural_network_exception.h"
+
 #include <cstdlib>
+#include <boost/format.hpp>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
 
 namespace nnforge
 {
 	namespace plain
 	{
-		plain_buffer::plain_buffer(size_t size)
+		const size_t plain_buffer::alignment = 64;
+		const size_t plain_buffer::huge_page_size = 2 * 1024 * 1024;
+
+		plain_buffer::plain_buffer(
+			size_t size,
+			bool use_huge_pages)
 			: buf(0)
 			, size(0)
 		{
-			buf = malloc(size);
+			if (size > 0)
+			{
+				bool huge_pages = use_huge_pages && (size >= huge_page_size);
+				size_t actual_alignment = huge_pages ? huge_page_size : alignment;
+				// Whole pages only, so that madvise doesn't affect anything else
+				size_t actual_size = huge_pages ? ((size + huge_page_size - 1) / huge_page_size * huge_page_size) : size;
+				#ifdef _WIN32
+				buf = _aligned_malloc(actual_size, actual_alignment);
+				#else
+				if (posix_memalign(&buf, actual_alignment, actual_size) != 0)
+					buf = 0;
+				#endif
+				if (buf == 0)
+					throw neural_network_exception((boost::format("Failed to allocate plain buffer of %1% bytes") % size).str());
+				#ifdef MADV_HUGEPAGE
+				if (huge_pages)
+					madvise(buf, actual_size, MADV_HUGEPAGE);
+				#endif
+			}
 			this->size = size;
 		}
 
+		plain_buffer::plain_buffer(
+			ptr parent,
+			size_t offset,
+			size_t size)
+			: parent(parent)
+			, buf(static_cast<unsigned char *>(parent->get_buf()) + offset)
+			, size(size)
+		{
+			if (offset + size > parent->get_size())
+				throw neural_network_exception((boost::format("View of %1% bytes at offset %2% exceeds plain buffer of %3% bytes") % size % offset % parent->get_size()).str());
+		}
+
 		plain_buffer::~plain_buffer()
 		{
-			free(buf);
+			if (!parent)
+			{
+				#ifdef _WIN32
+				_aligned_free(buf);
+				#else
+				free(buf);
+				#endif
+			}
+		}
+
+		size_t plain_buffer::get_aligned_size(size_t size)
+		{
+			return (size + alignment - 1) / alignment * alignment;
 		}
 
 		void * plain_buffer::get_buf()
@@ -29,10 +29,22 @@ namespace nnforge
 			typedef std::shared_ptr<plain_buffer> ptr;
 			typedef std::shared_ptr<const plain_buffer> const_ptr;
 
-			plain_buffer(size_t size);
+			// The memory is aligned to plain_buffer::alignment, large buffers are backed with huge pages when requested and supported by OS
+			plain_buffer(
+				size_t size,
+				bool use_huge_pages = false);
+
+			// Non-owning view of size bytes of parent starting at offset, parent is kept alive while the view exists
+			plain_buffer(
+				ptr parent,
+				size_t offset,
+				size_t size);
 
 			virtual ~plain_buffer();
 
+			// Rounds size up to the alignment, so that consecutive buffers stay aligned
+			static size_t get_aligned_size(size_t size);
+
 			// Size in bytes
 			virtual size_t get_size() const;
 
@@ -60,13 +72,22 @@ namespace nnforge
 
 			operator const int *() const;
 
+		public:
+			static const size_t alignment;
+			static const size_t huge_page_size;
+
 		protected:
 			void * get_buf();
 			const void * get_buf() const;
 
 		private:
+			ptr parent;
 			void * buf;
 			size_t size;
+
+		private:
+			plain_buffer(const plain_buffer&) = delete;
+			plain_buffer& operator =(const plain_buffer&) = delete;
 		};
 	}
 }
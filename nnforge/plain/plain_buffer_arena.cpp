@@ -0,0 +1,60 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_buffer_arena.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		plain_buffer_arena::plain_buffer_arena(bool use_huge_pages)
+			: use_huge_pages(use_huge_pages)
+			, allocated_size(0)
+		{
+		}
+
+		void plain_buffer_arena::reset(
+			const buffer_plain_size_configuration& buffers_config,
+			unsigned int entry_count)
+		{
+			allocated_size = 0;
+
+			size_t required_size = buffers_config.constant_buffer_size + buffers_config.per_entry_buffer_size * entry_count;
+			if (required_size > get_size())
+			{
+				// Release the old storage first to keep peak memory usage down
+				storage.reset();
+				storage = plain_buffer::ptr(new plain_buffer(required_size, use_huge_pages));
+			}
+		}
+
+		plain_buffer::ptr plain_buffer_arena::allocate(size_t size)
+		{
+			size_t aligned_size = plain_buffer::get_aligned_size(size);
+			if (allocated_size + aligned_size > get_size())
+				return plain_buffer::ptr(new plain_buffer(size, use_huge_pages));
+
+			plain_buffer::ptr res(new plain_buffer(storage, allocated_size, size));
+			allocated_size += aligned_size;
+			return res;
+		}
+
+		size_t plain_buffer_arena::get_size() const
+		{
+			return storage ? storage->get_size() : 0;
+		}
+	}
+}
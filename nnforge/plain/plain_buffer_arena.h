@@ -0,0 +1,56 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_buffer.h"
+#include "buffer_plain_size_configuration.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Hands out aligned views of a single allocation which lives across runs.
+		// The allocation is replaced with a larger one only when the buffers requested don't fit,
+		// so repeated runs with the same configuration don't allocate memory and don't take page faults.
+		class plain_buffer_arena
+		{
+		public:
+			plain_buffer_arena(bool use_huge_pages);
+
+			// Makes the whole storage available again, growing it to fit buffers_config for entry_count entries if needed.
+			// Buffers handed out before should not be used after this call
+			void reset(
+				const buffer_plain_size_configuration& buffers_config,
+				unsigned int entry_count);
+
+			// Falls back to a separate allocation when the storage is exhausted
+			plain_buffer::ptr allocate(size_t size);
+
+			// Size in bytes of the storage
+			size_t get_size() const;
+
+		private:
+			bool use_huge_pages;
+			plain_buffer::ptr storage;
+			size_t allocated_size;
+
+		private:
+			plain_buffer_arena(const plain_buffer_arena&) = delete;
+			plain_buffer_arena& operator =(const plain_buffer_arena&) = delete;
+		};
+	}
+}
@@ -0,0 +1,146 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include "plain_communicator.h"
+
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		plain_communicator::plain_communicator(
+			unsigned int worker_count,
+			int openmp_thread_count)
+			: worker_count(std::max(worker_count, 1U))
+			, openmp_thread_count(std::max(openmp_thread_count, 1))
+			, worker_data_list(std::max(worker_count, 1U), 0)
+			, worker_elem_count_list(std::max(worker_count, 1U), 0)
+			, worker_name_list(std::max(worker_count, 1U))
+			, arrived_worker_count(0)
+			, generation(0)
+			, aborted(false)
+		{
+		}
+
+		void plain_communicator::reduce_all(
+			const char * name,
+			unsigned int worker_id,
+			float * data,
+			size_t elem_count)
+		{
+			ring_reduce_all(name, worker_id, data, elem_count);
+		}
+
+		void plain_communicator::reduce_all(
+			const char * name,
+			unsigned int worker_id,
+			double * data,
+			size_t elem_count)
+		{
+			ring_reduce_all(name, worker_id, data, elem_count);
+		}
+
+		template<typename data_type> void plain_communicator::ring_reduce_all(
+			const char * name,
+			unsigned int worker_id,
+			data_type * data,
+			size_t elem_count)
+		{
+			if (worker_count == 1)
+				return;
+
+			worker_data_list[worker_id] = data;
+			worker_elem_count_list[worker_id] = elem_count;
+			worker_name_list[worker_id] = name;
+			barrier();
+
+			unsigned int previous_worker_id = (worker_id + worker_count - 1) % worker_count;
+			if ((worker_name_list[previous_worker_id] != name) || (worker_elem_count_list[previous_worker_id] != elem_count))
+			{
+				abort();
+				throw neural_network_exception((boost::format("reduce_all is requested for %1% with %2% elements while the previous worker requested it for %3% with %4% elements")
+					% name % elem_count % worker_name_list[previous_worker_id] % worker_elem_count_list[previous_worker_id]).str());
+			}
+			const data_type * previous_data = static_cast<const data_type *>(worker_data_list[previous_worker_id]);
+
+			// Reduce-scatter: at step i the segment (worker_id - i - 1) of the predecessor, holding the sum over i + 1 workers, is added to the own one.
+			// The predecessor updates a different segment at the same step
+			for(unsigned int step = 0; step < worker_count - 1; ++step)
+			{
+				unsigned int segment_id = (worker_id + 2 * worker_count - step - 1) % worker_count;
+				size_t segment_start = elem_count * segment_id / worker_count;
+				int segment_elem_count = static_cast<int>(elem_count * (segment_id + 1) / worker_count - segment_start);
+				data_type * dst = data + segment_start;
+				const data_type * src = previous_data + segment_start;
+				#pragma omp parallel for default(shared) schedule(static) num_threads(openmp_thread_count) if(segment_elem_count > (1 << 16))
+				for(int i = 0; i < segment_elem_count; ++i)
+					dst[i] = src[i] + dst[i];
+				barrier();
+			}
+
+			// All-gather: the worker holds the final segment (worker_id + 1) now, the final segments travel along the ring
+			for(unsigned int step = 0; step < worker_count - 1; ++step)
+			{
+				unsigned int segment_id = (worker_id + worker_count - step) % worker_count;
+				size_t segment_start = elem_count * segment_id / worker_count;
+				size_t segment_elem_count = elem_count * (segment_id + 1) / worker_count - segment_start;
+				if (segment_elem_count > 0)
+					memcpy(data + segment_start, previous_data + segment_start, segment_elem_count * sizeof(data_type));
+				barrier();
+			}
+		}
+
+		void plain_communicator::barrier()
+		{
+			std::unique_lock<std::mutex> lock(barrier_mutex);
+			if (aborted)
+				throw neural_network_exception("plain_communicator is aborted as another worker failed");
+
+			unsigned int current_generation = generation;
+			++arrived_worker_count;
+			if (arrived_worker_count == worker_count)
+			{
+				arrived_worker_count = 0;
+				++generation;
+				barrier_condition.notify_all();
+				return;
+			}
+
+			while ((current_generation == generation) && !aborted)
+				barrier_condition.wait(lock);
+			if (current_generation == generation)
+				throw neural_network_exception("plain_communicator is aborted as another worker failed");
+		}
+
+		void plain_communicator::abort()
+		{
+			std::lock_guard<std::mutex> lock(barrier_mutex);
+			aborted = true;
+			barrier_condition.notify_all();
+		}
+
+		unsigned int plain_communicator::get_worker_count() const
+		{
+			return worker_count;
+		}
+	}
+}
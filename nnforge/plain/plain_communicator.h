@@ -0,0 +1,92 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <string>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Sums buffers across the workers running in the same process with a ring all-reduce done in shared memory:
+		// the buffer is split into worker_count segments, each of them is reduced while travelling along the ring
+		// and then passed around in its final state. Each worker reads its predecessor's buffer only,
+		// and every element is summed in the same order on all the workers, so all of them get bit-identical results
+		class plain_communicator
+		{
+		public:
+			typedef std::shared_ptr<plain_communicator> ptr;
+
+			plain_communicator(
+				unsigned int worker_count,
+				int openmp_thread_count);
+
+			~plain_communicator() = default;
+
+			// All the workers should call it in the same order with the same name and elem_count, the call blocks until all of them do.
+			// The data buffer is read by the other worker until the call returns
+			void reduce_all(
+				const char * name,
+				unsigned int worker_id,
+				float * data,
+				size_t elem_count);
+
+			void reduce_all(
+				const char * name,
+				unsigned int worker_id,
+				double * data,
+				size_t elem_count);
+
+			// Workers blocked in reduce_all, and those calling it later, throw, used when one of the workers fails
+			void abort();
+
+			unsigned int get_worker_count() const;
+
+		private:
+			template<typename data_type> void ring_reduce_all(
+				const char * name,
+				unsigned int worker_id,
+				data_type * data,
+				size_t elem_count);
+
+			void barrier();
+
+		private:
+			unsigned int worker_count;
+			int openmp_thread_count;
+
+			std::vector<void *> worker_data_list;
+			std::vector<size_t> worker_elem_count_list;
+			std::vector<std::string> worker_name_list;
+
+			std::mutex barrier_mutex;
+			std::condition_variable barrier_condition;
+			unsigned int arrived_worker_count;
+			unsigned int generation;
+			bool aborted;
+
+		private:
+			plain_communicator(const plain_communicator&) = delete;
+			plain_communicator& operator =(const plain_communicator&) = delete;
+		};
+	}
+}
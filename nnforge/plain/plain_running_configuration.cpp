@@ -16,6 +16,12 @@
 
 #include "plain_running_configuration.h"
 
+#include "simd_kernels_plain.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -24,15 +30,49 @@ namespace nnforge
 {
 	namespace plain
 	{
+		const int plain_running_configuration::flops_benchmark_kc = 128;
+		const double plain_running_configuration::min_flops_benchmark_seconds = 0.05;
+		const int plain_running_configuration::flops_benchmark_run_count = 3;
+
 		plain_running_configuration::plain_running_configuration(
 			int openmp_thread_count,
-			float max_memory_usage_gigabytes)
+			float max_memory_usage_gigabytes,
+			int reader_thread_count,
+			int pipeline_depth,
+			bool use_huge_pages,
+			int concurrent_action_count,
+			bool fuse_layers,
+			int worker_count)
 			: openmp_thread_count(openmp_thread_count)
 			, max_memory_usage_gigabytes(max_memory_usage_gigabytes)
+			, pipeline_depth(static_cast<unsigned int>(std::max(pipeline_depth, 1)))
+			, use_huge_pages(use_huge_pages)
+			, concurrent_action_count(static_cast<unsigned int>(std::max(concurrent_action_count, 1)))
+			, fuse_layers(fuse_layers)
+			, worker_count(static_cast<unsigned int>(std::max(worker_count, 1)))
+			, flops(0.0F)
 		{
 			#ifndef _OPENMP
 			this->openmp_thread_count = 1;
 			#endif
+
+			job_runner = threadpool_job_runner::ptr(new threadpool_job_runner(static_cast<unsigned int>(std::max(reader_thread_count, 1))));
+		}
+
+		plain_running_configuration::plain_running_configuration(
+			const plain_running_configuration& parent,
+			int openmp_thread_count,
+			float memory_share)
+			: openmp_thread_count(std::max(std::min(openmp_thread_count, parent.openmp_thread_count), 1))
+			, max_memory_usage_gigabytes(parent.max_memory_usage_gigabytes * memory_share)
+			, pipeline_depth(parent.pipeline_depth)
+			, use_huge_pages(parent.use_huge_pages)
+			, concurrent_action_count(1)
+			, fuse_layers(parent.fuse_layers)
+			, worker_count(1)
+			, job_runner(parent.job_runner)
+			, flops(0.0F)
+		{
 		}
 
 		unsigned int plain_running_configuration::get_max_entry_count(
@@ -48,6 +88,71 @@ namespace nnforge
 			return static_cast<unsigned int>(entry_count_limited_by_global);
 		}
 
+		threadpool_job_runner::ptr plain_running_configuration::get_job_runner() const
+		{
+			return job_runner;
+		}
+
+		float plain_running_configuration::get_flops() const
+		{
+			std::call_once(flops_measured_flag, &plain_running_configuration::measure_flops, this);
+			return flops;
+		}
+
+		void plain_running_configuration::measure_flops() const
+		{
+			// Double the call count until a single run is long enough to be timed reliably
+			int call_count = 16;
+			double seconds = run_flops_benchmark(call_count);
+			while (seconds < min_flops_benchmark_seconds)
+			{
+				call_count *= 2;
+				seconds = run_flops_benchmark(call_count);
+			}
+
+			// The best run is the one least disturbed by other processes
+			for(int i = 1; i < flops_benchmark_run_count; ++i)
+				seconds = std::min(seconds, run_flops_benchmark(call_count));
+
+			double flops_per_call = 2.0 * static_cast<double>(simd_kernels_plain::gemm_mr * simd_kernels_plain::gemm_nr * flops_benchmark_kc);
+			flops = static_cast<float>(flops_per_call * static_cast<double>(call_count) * static_cast<double>(openmp_thread_count) / seconds);
+		}
+
+		double plain_running_configuration::run_flops_benchmark(int call_count) const
+		{
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+			const int packed_a_elem_count = simd_kernels_plain::gemm_mr * flops_benchmark_kc;
+			const int packed_b_elem_count = simd_kernels_plain::gemm_nr * flops_benchmark_kc;
+			const int c_elem_count = simd_kernels_plain::gemm_mr * simd_kernels_plain::gemm_nr;
+			// Rounded up to a cache line so that threads don't share any
+			const int elem_count_per_thread = (packed_a_elem_count + packed_b_elem_count + c_elem_count + 15) & ~15;
+			const int thread_count = openmp_thread_count;
+
+			// Small values keep accumulators far from overflow and denormals
+			std::vector<float> operands(static_cast<size_t>(elem_count_per_thread) * thread_count, 1.0e-3F);
+
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			#pragma omp parallel for default(shared) num_threads(thread_count) schedule(static, 1)
+			for(int thread_id = 0; thread_id < thread_count; ++thread_id)
+			{
+				float * packed_a = &operands[0] + static_cast<size_t>(elem_count_per_thread) * thread_id;
+				float * packed_b = packed_a + packed_a_elem_count;
+				float * c = packed_b + packed_b_elem_count;
+				for(int i = 0; i < call_count; ++i)
+					kernels.gemm_micro_kernel(
+						flops_benchmark_kc,
+						packed_a,
+						packed_b,
+						c,
+						simd_kernels_plain::gemm_nr,
+						simd_kernels_plain::gemm_mr,
+						simd_kernels_plain::gemm_nr);
+			}
+			std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+
+			return sec.count();
+		}
+
 		std::ostream& operator<< (std::ostream& out, const plain_running_configuration& running_configuration)
 		{
 			out << "--- Configuration ---" << std::endl;
@@ -56,11 +161,18 @@ namespace nnforge
 			#else
 			out << "Built without OpenMP support" << std::endl;
 			#endif
+			out << "Vector instruction set = " << simd_kernels_plain::get_singleton().get_instruction_set_name() << std::endl;
 
 			out << "--- Settings ---" << std::endl;
 
 			out << "Max memory usage = " << running_configuration.max_memory_usage_gigabytes << " GB" << std::endl;
 			out << "OpenMP thread count = " << running_configuration.openmp_thread_count << std::endl;
+			out << "Reader thread count = " << running_configuration.get_job_runner()->thread_count << std::endl;
+			out << "Pipeline depth = " << running_configuration.pipeline_depth << std::endl;
+			out << "Use huge pages = " << (running_configuration.use_huge_pages ? "true" : "false") << std::endl;
+			out << "Concurrent action count = " << running_configuration.concurrent_action_count << std::endl;
+			out << "Fuse layers = " << (running_configuration.fuse_layers ? "true" : "false") << std::endl;
+			out << "Worker count = " << running_configuration.worker_count << std::endl;
 
 			return out;
 		}
@@ -19,8 +19,10 @@
 #include <ostream>
 
 #include "buffer_plain_size_configuration.h"
+#include "../threadpool_job_runner.h"
 
 #include <memory>
+#include <mutex>
 
 namespace nnforge
 {
@@ -33,14 +35,60 @@ namespace nnforge
 
 			plain_running_configuration(
 				int openmp_thread_count,
-				float max_memory_usage_gigabytes);
+				float max_memory_usage_gigabytes,
+				int reader_thread_count,
+				int pipeline_depth,
+				bool use_huge_pages,
+				int concurrent_action_count,
+				bool fuse_layers,
+				int worker_count);
+
+			// Shares the settings and the job runner with parent, limits OpenMP regions to openmp_thread_count threads
+			// and memory to memory_share of the parent's limit.
+			// Used for the actions and the workers running concurrently so that together they don't oversubscribe the cores
+			plain_running_configuration(
+				const plain_running_configuration& parent,
+				int openmp_thread_count,
+				float memory_share = 1.0F);
 
 			unsigned int get_max_entry_count(
 				const buffer_plain_size_configuration& buffers_config,
 				float ratio = 1.0F) const;
 
+			// Threads reading input data and writing output data while layers are being computed
+			threadpool_job_runner::ptr get_job_runner() const;
+
+			// Peak single precision performance of all OpenMP threads, measured with a microbenchmark on the first call
+			float get_flops() const;
+
 			float max_memory_usage_gigabytes;
 			int openmp_thread_count;
+			// The number of batches being read ahead, 1 means reading starts once the previous batch is processed
+			unsigned int pipeline_depth;
+			// Back large buffers with huge pages to cut TLB misses
+			bool use_huge_pages;
+			// The number of independent layer actions run at the same time, 1 runs them one by one in a single chain
+			unsigned int concurrent_action_count;
+			// Fuse convolutions with the batch_norm, add and rectified_linear layers following them in forward prop
+			bool fuse_layers;
+			// The number of thread groups training on disjoint slices of each batch, each group pinned to its own subset of the CPUs
+			unsigned int worker_count;
+
+		private:
+			void measure_flops() const;
+
+			// Returns the time it takes for each thread to run the GEMM micro-kernel call_count times on cached data
+			double run_flops_benchmark(int call_count) const;
+
+		private:
+			threadpool_job_runner::ptr job_runner;
+
+			mutable std::once_flag flops_measured_flag;
+			mutable float flops;
+
+			static const int flops_benchmark_kc;
+			static const double min_flops_benchmark_seconds;
+			static const int flops_benchmark_run_count;
 
 		private:
 			plain_running_configuration() = delete;
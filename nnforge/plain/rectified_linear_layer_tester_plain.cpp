@@ -17,6 +17,9 @@
 #include "rectified_linear_layer_tester_plain.h"
 
 #include "../rectified_linear_layer.h"
+#include "simd_kernels_plain.h"
+
+#include <algorithm>
 
 namespace nnforge
 {
@@ -44,9 +47,16 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
-				*(out_it + i) = std::max<float>(*(in_it + i), 0.0F);
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
+			const int chunk_size = simd_kernels_plain::elementwise_chunk_elem_count;
+			const int chunk_count = (elem_count + chunk_size - 1) / chunk_size;
+
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			for(int chunk_id = 0; chunk_id < chunk_count; ++chunk_id)
+			{
+				int start = chunk_id * chunk_size;
+				kernels.relu(out_it + start, in_it + start, std::min(chunk_size, elem_count - start));
+			}
 		}
 
 		int rectified_linear_layer_tester_plain::get_input_index_layer_can_write(
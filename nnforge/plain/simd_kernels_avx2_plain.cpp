@@ -0,0 +1,477 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "simd_kernels_avx2_plain.h"
+
+#ifdef NNFORGE_SIMD_X86
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+
+#define NNFORGE_SIMD_TARGET_AVX2 NNFORGE_SIMD_TARGET("avx2,fma")
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// Cephes-style expf, see exp_sse2
+			NNFORGE_SIMD_TARGET_AVX2 inline __m256 exp_avx2(__m256 x)
+			{
+				x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.0F)), _mm256_set1_ps(88.0F));
+
+				__m256 n = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341F), _mm256_set1_ps(0.5F)));
+
+				x = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375F), x);
+				x = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4F), x);
+
+				__m256 y = _mm256_set1_ps(1.9875691500e-4F);
+				y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3F));
+				y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3F));
+				y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2F));
+				y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1F));
+				y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1F));
+				y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0F)));
+
+				__m256i pow2n = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127)), 23);
+				return _mm256_mul_ps(y, _mm256_castsi256_ps(pow2n));
+			}
+
+			NNFORGE_SIMD_TARGET_AVX2 inline float horizontal_max_avx2(__m256 v)
+			{
+				__m128 r = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+				r = _mm_max_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 0, 3, 2)));
+				r = _mm_max_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 3, 0, 1)));
+				return _mm_cvtss_f32(r);
+			}
+
+			NNFORGE_SIMD_TARGET_AVX2 inline float horizontal_sum_avx2(__m256 v)
+			{
+				__m128 r = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+				r = _mm_add_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 0, 3, 2)));
+				r = _mm_add_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 3, 0, 1)));
+				return _mm_cvtss_f32(r);
+			}
+		}
+
+		std::string simd_kernels_avx2_plain::get_instruction_set_name() const
+		{
+			return "AVX2";
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 void simd_kernels_avx2_plain::relu(
+			float * output,
+			const float * input,
+			int elem_count) const
+		{
+			const __m256 zero = _mm256_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 8; i += 8)
+				_mm256_storeu_ps(output + i, _mm256_max_ps(_mm256_loadu_ps(input + i), zero));
+			for(; i < elem_count; ++i)
+				output[i] = std::max(input[i], 0.0F);
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 void simd_kernels_avx2_plain::relu_backward(
+			float * input_errors,
+			const float * output_errors,
+			const float * output_neurons,
+			int elem_count,
+			bool add_update_to_destination) const
+		{
+			const __m256 zero = _mm256_setzero_ps();
+			int i = 0;
+			if (add_update_to_destination)
+			{
+				for(; i <= elem_count - 8; i += 8)
+				{
+					__m256 err = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(output_neurons + i), zero, _CMP_NEQ_UQ), _mm256_loadu_ps(output_errors + i));
+					_mm256_storeu_ps(input_errors + i, _mm256_add_ps(_mm256_loadu_ps(input_errors + i), err));
+				}
+			}
+			else
+			{
+				for(; i <= elem_count - 8; i += 8)
+				{
+					__m256 err = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(output_neurons + i), zero, _CMP_NEQ_UQ), _mm256_loadu_ps(output_errors + i));
+					_mm256_storeu_ps(input_errors + i, err);
+				}
+			}
+			simd_kernels_plain::relu_backward(input_errors + i, output_errors + i, output_neurons + i, elem_count - i, add_update_to_destination);
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 void simd_kernels_avx2_plain::scale_shift(
+			float * output,
+			const float * input,
+			int elem_count,
+			float mult,
+			float add) const
+		{
+			const __m256 mult_v = _mm256_set1_ps(mult);
+			const __m256 add_v = _mm256_set1_ps(add);
+			int i = 0;
+			for(; i <= elem_count - 8; i += 8)
+				_mm256_storeu_ps(output + i, _mm256_fmadd_ps(_mm256_loadu_ps(input + i), mult_v, add_v));
+			for(; i < elem_count; ++i)
+				output[i] = input[i] * mult + add;
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 void simd_kernels_avx2_plain::scale(
+			float * output,
+			const float * input,
+			int elem_count,
+			float alpha,
+			bool add_to_destination) const
+		{
+			const __m256 alpha_v = _mm256_set1_ps(alpha);
+			int i = 0;
+			if (add_to_destination)
+			{
+				for(; i <= elem_count - 8; i += 8)
+					_mm256_storeu_ps(output + i, _mm256_fmadd_ps(_mm256_loadu_ps(input + i), alpha_v, _mm256_loadu_ps(output + i)));
+			}
+			else
+			{
+				for(; i <= elem_count - 8; i += 8)
+					_mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_loadu_ps(input + i), alpha_v));
+			}
+			simd_kernels_plain::scale(output + i, input + i, elem_count - i, alpha, add_to_destination);
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 void simd_kernels_avx2_plain::sum_scaled(
+			float * output,
+			const float * const * input_list,
+			int input_count,
+			int elem_count,
+			float alpha) const
+		{
+			const __m256 alpha_v = _mm256_set1_ps(alpha);
+			int i = 0;
+			for(; i <= elem_count - 8; i += 8)
+			{
+				__m256 sum = _mm256_setzero_ps();
+				for(int j = 0; j < input_count; ++j)
+					sum = _mm256_add_ps(sum, _mm256_loadu_ps(input_list[j] + i));
+				_mm256_storeu_ps(output + i, _mm256_mul_ps(sum, alpha_v));
+			}
+			for(; i < elem_count; ++i)
+			{
+				float sum = 0.0F;
+				for(int j = 0; j < input_count; ++j)
+					sum += input_list[j][i];
+				output[i] = sum * alpha;
+			}
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 void simd_kernels_avx2_plain::max_accumulate(
+			float * output,
+			const float * input,
+			int elem_count,
+			bool is_min) const
+		{
+			int i = 0;
+			if (is_min)
+			{
+				for(; i <= elem_count - 8; i += 8)
+					_mm256_storeu_ps(output + i, _mm256_min_ps(_mm256_loadu_ps(output + i), _mm256_loadu_ps(input + i)));
+			}
+			else
+			{
+				for(; i <= elem_count - 8; i += 8)
+					_mm256_storeu_ps(output + i, _mm256_max_ps(_mm256_loadu_ps(output + i), _mm256_loadu_ps(input + i)));
+			}
+			simd_kernels_plain::max_accumulate(output + i, input + i, elem_count - i, is_min);
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 void simd_kernels_avx2_plain::add_accumulate(
+			float * output,
+			const float * input,
+			int elem_count) const
+		{
+			int i = 0;
+			for(; i <= elem_count - 8; i += 8)
+				_mm256_storeu_ps(output + i, _mm256_add_ps(_mm256_loadu_ps(output + i), _mm256_loadu_ps(input + i)));
+			for(; i < elem_count; ++i)
+				output[i] += input[i];
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 void simd_kernels_avx2_plain::softmax(
+			float * output,
+			const float * input,
+			int feature_map_count,
+			int feature_map_stride,
+			int elem_count) const
+		{
+			if (feature_map_stride == 1)
+			{
+				// Feature maps are contiguous, vectorize across them
+				for(int i = 0; i < elem_count; ++i)
+				{
+					const float * in_it = input + i;
+					float * out_it = output + i;
+					const int vector_feature_map_count = feature_map_count & ~7;
+
+					__m256 max_v = _mm256_set1_ps(-1.0e+37F);
+					for(int feature_map_id = 0; feature_map_id < vector_feature_map_count; feature_map_id += 8)
+						max_v = _mm256_max_ps(max_v, _mm256_loadu_ps(in_it + feature_map_id));
+					float max_val = horizontal_max_avx2(max_v);
+					for(int feature_map_id = vector_feature_map_count; feature_map_id < feature_map_count; ++feature_map_id)
+						max_val = std::max(max_val, in_it[feature_map_id]);
+
+					max_v = _mm256_set1_ps(max_val);
+					__m256 sum_v = _mm256_setzero_ps();
+					for(int feature_map_id = 0; feature_map_id < vector_feature_map_count; feature_map_id += 8)
+					{
+						__m256 val = exp_avx2(_mm256_sub_ps(_mm256_loadu_ps(in_it + feature_map_id), max_v));
+						sum_v = _mm256_add_ps(sum_v, val);
+						_mm256_storeu_ps(out_it + feature_map_id, val);
+					}
+					float sum = horizontal_sum_avx2(sum_v);
+					for(int feature_map_id = vector_feature_map_count; feature_map_id < feature_map_count; ++feature_map_id)
+					{
+						float val = expf(in_it[feature_map_id] - max_val);
+						sum += val;
+						out_it[feature_map_id] = val;
+					}
+
+					scale(out_it, out_it, feature_map_count, 1.0F / sum, false);
+				}
+				return;
+			}
+
+			// Vectorize across neurons
+			int i = 0;
+			for(; i <= elem_count - 8; i += 8)
+			{
+				const float * in_it = input + i;
+				float * out_it = output + i;
+
+				__m256 max_v = _mm256_set1_ps(-1.0e+37F);
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+					max_v = _mm256_max_ps(max_v, _mm256_loadu_ps(in_it + feature_map_id * feature_map_stride));
+
+				__m256 sum_v = _mm256_setzero_ps();
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+				{
+					__m256 val = exp_avx2(_mm256_sub_ps(_mm256_loadu_ps(in_it + feature_map_id * feature_map_stride), max_v));
+					sum_v = _mm256_add_ps(sum_v, val);
+					_mm256_storeu_ps(out_it + feature_map_id * feature_map_stride, val);
+				}
+
+				__m256 mult_v = _mm256_div_ps(_mm256_set1_ps(1.0F), sum_v);
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+				{
+					float * dst = out_it + feature_map_id * feature_map_stride;
+					_mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_loadu_ps(dst), mult_v));
+				}
+			}
+			simd_kernels_plain::softmax(output + i, input + i, feature_map_count, feature_map_stride, elem_count - i);
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 double simd_kernels_avx2_plain::apply_gradient(
+			float * weights,
+			float * gradient,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay) const
+		{
+			const __m256 learning_rate_v = _mm256_set1_ps(learning_rate);
+			const __m256 normalizer_v = _mm256_set1_ps(normalizer);
+			const __m256 weight_decay_v = _mm256_set1_ps(weight_decay);
+			const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+			__m256 accum_v = _mm256_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 8; i += 8)
+			{
+				__m256 current_weight = _mm256_loadu_ps(weights + i);
+				__m256 upd = _mm256_mul_ps(learning_rate_v, _mm256_fmsub_ps(_mm256_loadu_ps(gradient + i), normalizer_v, _mm256_mul_ps(current_weight, weight_decay_v)));
+				accum_v = _mm256_add_ps(accum_v, _mm256_and_ps(upd, abs_mask));
+				_mm256_storeu_ps(weights + i, _mm256_add_ps(current_weight, upd));
+				_mm256_storeu_ps(gradient + i, _mm256_setzero_ps());
+			}
+			return static_cast<double>(horizontal_sum_avx2(accum_v)) + simd_kernels_plain::apply_gradient(weights + i, gradient + i, elem_count - i, learning_rate, normalizer, weight_decay);
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 double simd_kernels_avx2_plain::apply_gradient_with_vanilla_momentum(
+			float * weights,
+			float * gradient,
+			float * previous_upd,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum) const
+		{
+			const __m256 learning_rate_v = _mm256_set1_ps(learning_rate);
+			const __m256 normalizer_v = _mm256_set1_ps(normalizer);
+			const __m256 weight_decay_v = _mm256_set1_ps(weight_decay);
+			const __m256 momentum_v = _mm256_set1_ps(momentum);
+			const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+			__m256 accum_v = _mm256_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 8; i += 8)
+			{
+				__m256 current_weight = _mm256_loadu_ps(weights + i);
+				__m256 upd = _mm256_fmadd_ps(_mm256_loadu_ps(previous_upd + i), momentum_v, _mm256_mul_ps(learning_rate_v, _mm256_fmsub_ps(_mm256_loadu_ps(gradient + i), normalizer_v, _mm256_mul_ps(current_weight, weight_decay_v))));
+				accum_v = _mm256_add_ps(accum_v, _mm256_and_ps(upd, abs_mask));
+				_mm256_storeu_ps(weights + i, _mm256_add_ps(current_weight, upd));
+				_mm256_storeu_ps(gradient + i, _mm256_setzero_ps());
+				_mm256_storeu_ps(previous_upd + i, upd);
+			}
+			return static_cast<double>(horizontal_sum_avx2(accum_v)) + simd_kernels_plain::apply_gradient_with_vanilla_momentum(weights + i, gradient + i, previous_upd + i, elem_count - i, learning_rate, normalizer, weight_decay, momentum);
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 double simd_kernels_avx2_plain::apply_gradient_with_nesterov_momentum(
+			float * weights,
+			float * gradient,
+			float * previous_upd,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum) const
+		{
+			const __m256 learning_rate_v = _mm256_set1_ps(learning_rate);
+			const __m256 normalizer_v = _mm256_set1_ps(normalizer);
+			const __m256 weight_decay_v = _mm256_set1_ps(weight_decay);
+			const __m256 momentum_v = _mm256_set1_ps(momentum);
+			const __m256 mp1_v = _mm256_set1_ps(momentum + 1.0F);
+			const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+			__m256 accum_v = _mm256_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 8; i += 8)
+			{
+				__m256 current_weight = _mm256_loadu_ps(weights + i);
+				__m256 prev_upd = _mm256_loadu_ps(previous_upd + i);
+				__m256 new_upd = _mm256_fmadd_ps(prev_upd, momentum_v, _mm256_mul_ps(learning_rate_v, _mm256_fmsub_ps(_mm256_loadu_ps(gradient + i), normalizer_v, _mm256_mul_ps(current_weight, weight_decay_v))));
+				__m256 upd = _mm256_fmsub_ps(mp1_v, new_upd, _mm256_mul_ps(momentum_v, prev_upd));
+				accum_v = _mm256_add_ps(accum_v, _mm256_and_ps(upd, abs_mask));
+				_mm256_storeu_ps(weights + i, _mm256_add_ps(current_weight, upd));
+				_mm256_storeu_ps(gradient + i, _mm256_setzero_ps());
+				_mm256_storeu_ps(previous_upd + i, new_upd);
+			}
+			return static_cast<double>(horizontal_sum_avx2(accum_v)) + simd_kernels_plain::apply_gradient_with_nesterov_momentum(weights + i, gradient + i, previous_upd + i, elem_count - i, learning_rate, normalizer, weight_decay, momentum);
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 double simd_kernels_avx2_plain::apply_gradient_with_adam_momentum(
+			float * weights,
+			float * gradient,
+			float * biased_first_momentum,
+			float * biased_second_momentum,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float beta1,
+			float beta2,
+			float one_minus_beta1t_inverted,
+			float one_minus_beta2t_inverted,
+			float epsilon) const
+		{
+			const __m256 learning_rate_v = _mm256_set1_ps(learning_rate);
+			const __m256 normalizer_v = _mm256_set1_ps(normalizer);
+			const __m256 weight_decay_v = _mm256_set1_ps(weight_decay);
+			const __m256 beta1_v = _mm256_set1_ps(beta1);
+			const __m256 one_minus_beta1_v = _mm256_set1_ps(1.0F - beta1);
+			const __m256 beta2_v = _mm256_set1_ps(beta2);
+			const __m256 one_minus_beta2_v = _mm256_set1_ps(1.0F - beta2);
+			const __m256 one_minus_beta1t_inverted_v = _mm256_set1_ps(one_minus_beta1t_inverted);
+			const __m256 one_minus_beta2t_inverted_v = _mm256_set1_ps(one_minus_beta2t_inverted);
+			const __m256 epsilon_v = _mm256_set1_ps(epsilon);
+			const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+			__m256 accum_v = _mm256_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 8; i += 8)
+			{
+				__m256 current_weight = _mm256_loadu_ps(weights + i);
+				__m256 total_gradient = _mm256_fmsub_ps(_mm256_loadu_ps(gradient + i), normalizer_v, _mm256_mul_ps(current_weight, weight_decay_v));
+				__m256 new_biased_first_momentum = _mm256_fmadd_ps(beta1_v, _mm256_loadu_ps(biased_first_momentum + i), _mm256_mul_ps(one_minus_beta1_v, total_gradient));
+				__m256 new_biased_second_momentum = _mm256_fmadd_ps(beta2_v, _mm256_loadu_ps(biased_second_momentum + i), _mm256_mul_ps(_mm256_mul_ps(one_minus_beta2_v, total_gradient), total_gradient));
+				__m256 unbiased_first_momentum = _mm256_mul_ps(new_biased_first_momentum, one_minus_beta1t_inverted_v);
+				__m256 unbiased_second_momentum = _mm256_mul_ps(new_biased_second_momentum, one_minus_beta2t_inverted_v);
+				__m256 upd = _mm256_div_ps(_mm256_mul_ps(learning_rate_v, unbiased_first_momentum), _mm256_add_ps(_mm256_sqrt_ps(unbiased_second_momentum), epsilon_v));
+				accum_v = _mm256_add_ps(accum_v, _mm256_and_ps(upd, abs_mask));
+				_mm256_storeu_ps(weights + i, _mm256_add_ps(current_weight, upd));
+				_mm256_storeu_ps(gradient + i, _mm256_setzero_ps());
+				_mm256_storeu_ps(biased_first_momentum + i, new_biased_first_momentum);
+				_mm256_storeu_ps(biased_second_momentum + i, new_biased_second_momentum);
+			}
+			return static_cast<double>(horizontal_sum_avx2(accum_v)) + simd_kernels_plain::apply_gradient_with_adam_momentum(weights + i, gradient + i, biased_first_momentum + i, biased_second_momentum + i, elem_count - i, learning_rate, normalizer, weight_decay, beta1, beta2, one_minus_beta1t_inverted, one_minus_beta2t_inverted, epsilon);
+		}
+
+		NNFORGE_SIMD_TARGET_AVX2 void simd_kernels_avx2_plain::gemm_micro_kernel(
+			int kc_actual,
+			const float * packed_a,
+			const float * packed_b,
+			float * c,
+			int ldc,
+			int mr_actual,
+			int nr_actual) const
+		{
+			// 12 accumulators + 2 rows of B + broadcast A element fit 16 YMM registers
+			__m256 acc00 = _mm256_setzero_ps(), acc01 = _mm256_setzero_ps();
+			__m256 acc10 = _mm256_setzero_ps(), acc11 = _mm256_setzero_ps();
+			__m256 acc20 = _mm256_setzero_ps(), acc21 = _mm256_setzero_ps();
+			__m256 acc30 = _mm256_setzero_ps(), acc31 = _mm256_setzero_ps();
+			__m256 acc40 = _mm256_setzero_ps(), acc41 = _mm256_setzero_ps();
+			__m256 acc50 = _mm256_setzero_ps(), acc51 = _mm256_setzero_ps();
+
+			const float * a_it = packed_a;
+			const float * b_it = packed_b;
+			for(int p = 0; p < kc_actual; ++p, a_it += gemm_mr, b_it += gemm_nr)
+			{
+				__m256 b0 = _mm256_loadu_ps(b_it);
+				__m256 b1 = _mm256_loadu_ps(b_it + 8);
+				__m256 a;
+				a = _mm256_broadcast_ss(a_it + 0); acc00 = _mm256_fmadd_ps(a, b0, acc00); acc01 = _mm256_fmadd_ps(a, b1, acc01);
+				a = _mm256_broadcast_ss(a_it + 1); acc10 = _mm256_fmadd_ps(a, b0, acc10); acc11 = _mm256_fmadd_ps(a, b1, acc11);
+				a = _mm256_broadcast_ss(a_it + 2); acc20 = _mm256_fmadd_ps(a, b0, acc20); acc21 = _mm256_fmadd_ps(a, b1, acc21);
+				a = _mm256_broadcast_ss(a_it + 3); acc30 = _mm256_fmadd_ps(a, b0, acc30); acc31 = _mm256_fmadd_ps(a, b1, acc31);
+				a = _mm256_broadcast_ss(a_it + 4); acc40 = _mm256_fmadd_ps(a, b0, acc40); acc41 = _mm256_fmadd_ps(a, b1, acc41);
+				a = _mm256_broadcast_ss(a_it + 5); acc50 = _mm256_fmadd_ps(a, b0, acc50); acc51 = _mm256_fmadd_ps(a, b1, acc51);
+			}
+
+			float acc[gemm_mr * gemm_nr];
+			_mm256_storeu_ps(acc + 0 * gemm_nr, acc00); _mm256_storeu_ps(acc + 0 * gemm_nr + 8, acc01);
+			_mm256_storeu_ps(acc + 1 * gemm_nr, acc10); _mm256_storeu_ps(acc + 1 * gemm_nr + 8, acc11);
+			_mm256_storeu_ps(acc + 2 * gemm_nr, acc20); _mm256_storeu_ps(acc + 2 * gemm_nr + 8, acc21);
+			_mm256_storeu_ps(acc + 3 * gemm_nr, acc30); _mm256_storeu_ps(acc + 3 * gemm_nr + 8, acc31);
+			_mm256_storeu_ps(acc + 4 * gemm_nr, acc40); _mm256_storeu_ps(acc + 4 * gemm_nr + 8, acc41);
+			_mm256_storeu_ps(acc + 5 * gemm_nr, acc50); _mm256_storeu_ps(acc + 5 * gemm_nr + 8, acc51);
+
+			for(int i = 0; i < mr_actual; ++i)
+			{
+				float * c_row = c + i * ldc;
+				const float * acc_row = acc + i * gemm_nr;
+				if (nr_actual == gemm_nr)
+				{
+					_mm256_storeu_ps(c_row, _mm256_add_ps(_mm256_loadu_ps(c_row), _mm256_loadu_ps(acc_row)));
+					_mm256_storeu_ps(c_row + 8, _mm256_add_ps(_mm256_loadu_ps(c_row + 8), _mm256_loadu_ps(acc_row + 8)));
+				}
+				else
+				{
+					for(int j = 0; j < nr_actual; ++j)
+						c_row[j] += acc_row[j];
+				}
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "simd_kernels_plain.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// AVX2 and FMA
+		class simd_kernels_avx2_plain : public simd_kernels_plain
+		{
+		public:
+			simd_kernels_avx2_plain() = default;
+
+			virtual ~simd_kernels_avx2_plain() = default;
+
+			virtual std::string get_instruction_set_name() const;
+
+			virtual void relu(
+				float * output,
+				const float * input,
+				int elem_count) const;
+
+			virtual void relu_backward(
+				float * input_errors,
+				const float * output_errors,
+				const float * output_neurons,
+				int elem_count,
+				bool add_update_to_destination) const;
+
+			virtual void scale_shift(
+				float * output,
+				const float * input,
+				int elem_count,
+				float mult,
+				float add) const;
+
+			virtual void scale(
+				float * output,
+				const float * input,
+				int elem_count,
+				float alpha,
+				bool add_to_destination) const;
+
+			virtual void sum_scaled(
+				float * output,
+				const float * const * input_list,
+				int input_count,
+				int elem_count,
+				float alpha) const;
+
+			virtual void max_accumulate(
+				float * output,
+				const float * input,
+				int elem_count,
+				bool is_min) const;
+
+			virtual void add_accumulate(
+				float * output,
+				const float * input,
+				int elem_count) const;
+
+			virtual void softmax(
+				float * output,
+				const float * input,
+				int feature_map_count,
+				int feature_map_stride,
+				int elem_count) const;
+
+			virtual double apply_gradient(
+				float * weights,
+				float * gradient,
+				int elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay) const;
+
+			virtual double apply_gradient_with_vanilla_momentum(
+				float * weights,
+				float * gradient,
+				float * previous_upd,
+				int elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float momentum) const;
+
+			virtual double apply_gradient_with_nesterov_momentum(
+				float * weights,
+				float * gradient,
+				float * previous_upd,
+				int elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float momentum) const;
+
+			virtual double apply_gradient_with_adam_momentum(
+				float * weights,
+				float * gradient,
+				float * biased_first_momentum,
+				float * biased_second_momentum,
+				int elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float beta1,
+				float beta2,
+				float one_minus_beta1t_inverted,
+				float one_minus_beta2t_inverted,
+				float epsilon) const;
+
+			virtual void gemm_micro_kernel(
+				int kc_actual,
+				const float * packed_a,
+				const float * packed_b,
+				float * c,
+				int ldc,
+				int mr_actual,
+				int nr_actual) const;
+		};
+	}
+}
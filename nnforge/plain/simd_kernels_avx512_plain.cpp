@@ -0,0 +1,441 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "simd_kernels_avx512_plain.h"
+
+#ifdef NNFORGE_SIMD_AVX512
+
+#include <immintrin.h>
+#include <algorithm>
+
+#define NNFORGE_SIMD_TARGET_AVX512 NNFORGE_SIMD_TARGET("avx512f,avx2,fma")
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// Mask covering first elem_count lanes, elem_count is in [0, 16]
+			inline __mmask16 tail_mask(int elem_count)
+			{
+				return static_cast<__mmask16>((1U << elem_count) - 1U);
+			}
+
+			// Cephes-style expf, see exp_sse2
+			NNFORGE_SIMD_TARGET_AVX512 inline __m512 exp_avx512(__m512 x)
+			{
+				x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(-87.0F)), _mm512_set1_ps(88.0F));
+
+				__m512 n = _mm512_roundscale_ps(_mm512_fmadd_ps(x, _mm512_set1_ps(1.44269504088896341F), _mm512_set1_ps(0.5F)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+
+				x = _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375F), x);
+				x = _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4F), x);
+
+				__m512 y = _mm512_set1_ps(1.9875691500e-4F);
+				y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.3981999507e-3F));
+				y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(8.3334519073e-3F));
+				y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(4.1665795894e-2F));
+				y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.6666665459e-1F));
+				y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(5.0000001201e-1F));
+				y = _mm512_fmadd_ps(y, _mm512_mul_ps(x, x), _mm512_add_ps(x, _mm512_set1_ps(1.0F)));
+
+				return _mm512_scalef_ps(y, n);
+			}
+
+			NNFORGE_SIMD_TARGET_AVX512 inline __m256 upper_half_avx512(__m512 v)
+			{
+				return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+			}
+
+			NNFORGE_SIMD_TARGET_AVX512 inline float horizontal_max_avx512(__m512 v)
+			{
+				__m256 r8 = _mm256_max_ps(_mm512_castps512_ps256(v), upper_half_avx512(v));
+				__m128 r = _mm_max_ps(_mm256_castps256_ps128(r8), _mm256_extractf128_ps(r8, 1));
+				r = _mm_max_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 0, 3, 2)));
+				r = _mm_max_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 3, 0, 1)));
+				return _mm_cvtss_f32(r);
+			}
+
+			NNFORGE_SIMD_TARGET_AVX512 inline float horizontal_sum_avx512(__m512 v)
+			{
+				__m256 r8 = _mm256_add_ps(_mm512_castps512_ps256(v), upper_half_avx512(v));
+				__m128 r = _mm_add_ps(_mm256_castps256_ps128(r8), _mm256_extractf128_ps(r8, 1));
+				r = _mm_add_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 0, 3, 2)));
+				r = _mm_add_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 3, 0, 1)));
+				return _mm_cvtss_f32(r);
+			}
+		}
+
+		std::string simd_kernels_avx512_plain::get_instruction_set_name() const
+		{
+			return "AVX-512";
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 void simd_kernels_avx512_plain::relu(
+			float * output,
+			const float * input,
+			int elem_count) const
+		{
+			const __m512 zero = _mm512_setzero_ps();
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				__mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				_mm512_mask_storeu_ps(output + i, mask, _mm512_max_ps(_mm512_maskz_loadu_ps(mask, input + i), zero));
+			}
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 void simd_kernels_avx512_plain::relu_backward(
+			float * input_errors,
+			const float * output_errors,
+			const float * output_neurons,
+			int elem_count,
+			bool add_update_to_destination) const
+		{
+			const __m512 zero = _mm512_setzero_ps();
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				__mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				__mmask16 nonzero = _mm512_mask_cmp_ps_mask(mask, _mm512_maskz_loadu_ps(mask, output_neurons + i), zero, _CMP_NEQ_UQ);
+				__m512 err = _mm512_maskz_loadu_ps(nonzero, output_errors + i);
+				if (add_update_to_destination)
+					err = _mm512_add_ps(err, _mm512_maskz_loadu_ps(mask, input_errors + i));
+				_mm512_mask_storeu_ps(input_errors + i, mask, err);
+			}
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 void simd_kernels_avx512_plain::scale_shift(
+			float * output,
+			const float * input,
+			int elem_count,
+			float mult,
+			float add) const
+		{
+			const __m512 mult_v = _mm512_set1_ps(mult);
+			const __m512 add_v = _mm512_set1_ps(add);
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				__mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				_mm512_mask_storeu_ps(output + i, mask, _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, input + i), mult_v, add_v));
+			}
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 void simd_kernels_avx512_plain::scale(
+			float * output,
+			const float * input,
+			int elem_count,
+			float alpha,
+			bool add_to_destination) const
+		{
+			const __m512 alpha_v = _mm512_set1_ps(alpha);
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				__mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				__m512 val = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, input + i), alpha_v);
+				if (add_to_destination)
+					val = _mm512_add_ps(val, _mm512_maskz_loadu_ps(mask, output + i));
+				_mm512_mask_storeu_ps(output + i, mask, val);
+			}
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 void simd_kernels_avx512_plain::sum_scaled(
+			float * output,
+			const float * const * input_list,
+			int input_count,
+			int elem_count,
+			float alpha) const
+		{
+			const __m512 alpha_v = _mm512_set1_ps(alpha);
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				__mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				__m512 sum = _mm512_setzero_ps();
+				for(int j = 0; j < input_count; ++j)
+					sum = _mm512_add_ps(sum, _mm512_maskz_loadu_ps(mask, input_list[j] + i));
+				_mm512_mask_storeu_ps(output + i, mask, _mm512_mul_ps(sum, alpha_v));
+			}
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 void simd_kernels_avx512_plain::max_accumulate(
+			float * output,
+			const float * input,
+			int elem_count,
+			bool is_min) const
+		{
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				__mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				__m512 current = _mm512_maskz_loadu_ps(mask, output + i);
+				__m512 val = _mm512_maskz_loadu_ps(mask, input + i);
+				_mm512_mask_storeu_ps(output + i, mask, is_min ? _mm512_min_ps(current, val) : _mm512_max_ps(current, val));
+			}
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 void simd_kernels_avx512_plain::add_accumulate(
+			float * output,
+			const float * input,
+			int elem_count) const
+		{
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				__mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				_mm512_mask_storeu_ps(output + i, mask, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, output + i), _mm512_maskz_loadu_ps(mask, input + i)));
+			}
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 void simd_kernels_avx512_plain::softmax(
+			float * output,
+			const float * input,
+			int feature_map_count,
+			int feature_map_stride,
+			int elem_count) const
+		{
+			if (feature_map_stride == 1)
+			{
+				// Feature maps are contiguous, vectorize across them
+				for(int i = 0; i < elem_count; ++i)
+				{
+					const float * in_it = input + i;
+					float * out_it = output + i;
+
+					__m512 max_v = _mm512_set1_ps(-1.0e+37F);
+					for(int feature_map_id = 0; feature_map_id < feature_map_count; feature_map_id += 16)
+					{
+						__mmask16 mask = tail_mask(std::min(feature_map_count - feature_map_id, 16));
+						max_v = _mm512_mask_max_ps(max_v, mask, max_v, _mm512_maskz_loadu_ps(mask, in_it + feature_map_id));
+					}
+					max_v = _mm512_set1_ps(horizontal_max_avx512(max_v));
+
+					__m512 sum_v = _mm512_setzero_ps();
+					for(int feature_map_id = 0; feature_map_id < feature_map_count; feature_map_id += 16)
+					{
+						__mmask16 mask = tail_mask(std::min(feature_map_count - feature_map_id, 16));
+						__m512 val = exp_avx512(_mm512_sub_ps(_mm512_maskz_loadu_ps(mask, in_it + feature_map_id), max_v));
+						sum_v = _mm512_mask_add_ps(sum_v, mask, sum_v, val);
+						_mm512_mask_storeu_ps(out_it + feature_map_id, mask, val);
+					}
+
+					scale(out_it, out_it, feature_map_count, 1.0F / horizontal_sum_avx512(sum_v), false);
+				}
+				return;
+			}
+
+			// Vectorize across neurons
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				const float * in_it = input + i;
+				float * out_it = output + i;
+				__mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+
+				__m512 max_v = _mm512_set1_ps(-1.0e+37F);
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+					max_v = _mm512_max_ps(max_v, _mm512_maskz_loadu_ps(mask, in_it + feature_map_id * feature_map_stride));
+
+				__m512 sum_v = _mm512_setzero_ps();
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+				{
+					__m512 val = exp_avx512(_mm512_sub_ps(_mm512_maskz_loadu_ps(mask, in_it + feature_map_id * feature_map_stride), max_v));
+					sum_v = _mm512_add_ps(sum_v, val);
+					_mm512_mask_storeu_ps(out_it + feature_map_id * feature_map_stride, mask, val);
+				}
+
+				__m512 mult_v = _mm512_div_ps(_mm512_set1_ps(1.0F), sum_v);
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+				{
+					float * dst = out_it + feature_map_id * feature_map_stride;
+					_mm512_mask_storeu_ps(dst, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, dst), mult_v));
+				}
+			}
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 double simd_kernels_avx512_plain::apply_gradient(
+			float * weights,
+			float * gradient,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay) const
+		{
+			const __m512 learning_rate_v = _mm512_set1_ps(learning_rate);
+			const __m512 normalizer_v = _mm512_set1_ps(normalizer);
+			const __m512 weight_decay_v = _mm512_set1_ps(weight_decay);
+			const __m512i abs_mask = _mm512_set1_epi32(0x7FFFFFFF);
+			__m512 accum_v = _mm512_setzero_ps();
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				// Inactive lanes load zeros, which result in zero updates
+				const __mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				__m512 current_weight = _mm512_maskz_loadu_ps(mask, weights + i);
+				__m512 upd = _mm512_mul_ps(learning_rate_v, _mm512_fmsub_ps(_mm512_maskz_loadu_ps(mask, gradient + i), normalizer_v, _mm512_mul_ps(current_weight, weight_decay_v)));
+				accum_v = _mm512_add_ps(accum_v, _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(upd), abs_mask)));
+				_mm512_mask_storeu_ps(weights + i, mask, _mm512_add_ps(current_weight, upd));
+				_mm512_mask_storeu_ps(gradient + i, mask, _mm512_setzero_ps());
+			}
+			return static_cast<double>(horizontal_sum_avx512(accum_v));
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 double simd_kernels_avx512_plain::apply_gradient_with_vanilla_momentum(
+			float * weights,
+			float * gradient,
+			float * previous_upd,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum) const
+		{
+			const __m512 learning_rate_v = _mm512_set1_ps(learning_rate);
+			const __m512 normalizer_v = _mm512_set1_ps(normalizer);
+			const __m512 weight_decay_v = _mm512_set1_ps(weight_decay);
+			const __m512 momentum_v = _mm512_set1_ps(momentum);
+			const __m512i abs_mask = _mm512_set1_epi32(0x7FFFFFFF);
+			__m512 accum_v = _mm512_setzero_ps();
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				// Inactive lanes load zeros, which result in zero updates
+				const __mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				__m512 current_weight = _mm512_maskz_loadu_ps(mask, weights + i);
+				__m512 upd = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, previous_upd + i), momentum_v, _mm512_mul_ps(learning_rate_v, _mm512_fmsub_ps(_mm512_maskz_loadu_ps(mask, gradient + i), normalizer_v, _mm512_mul_ps(current_weight, weight_decay_v))));
+				accum_v = _mm512_add_ps(accum_v, _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(upd), abs_mask)));
+				_mm512_mask_storeu_ps(weights + i, mask, _mm512_add_ps(current_weight, upd));
+				_mm512_mask_storeu_ps(gradient + i, mask, _mm512_setzero_ps());
+				_mm512_mask_storeu_ps(previous_upd + i, mask, upd);
+			}
+			return static_cast<double>(horizontal_sum_avx512(accum_v));
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 double simd_kernels_avx512_plain::apply_gradient_with_nesterov_momentum(
+			float * weights,
+			float * gradient,
+			float * previous_upd,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum) const
+		{
+			const __m512 learning_rate_v = _mm512_set1_ps(learning_rate);
+			const __m512 normalizer_v = _mm512_set1_ps(normalizer);
+			const __m512 weight_decay_v = _mm512_set1_ps(weight_decay);
+			const __m512 momentum_v = _mm512_set1_ps(momentum);
+			const __m512 mp1_v = _mm512_set1_ps(momentum + 1.0F);
+			const __m512i abs_mask = _mm512_set1_epi32(0x7FFFFFFF);
+			__m512 accum_v = _mm512_setzero_ps();
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				// Inactive lanes load zeros, which result in zero updates
+				const __mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				__m512 current_weight = _mm512_maskz_loadu_ps(mask, weights + i);
+				__m512 prev_upd = _mm512_maskz_loadu_ps(mask, previous_upd + i);
+				__m512 new_upd = _mm512_fmadd_ps(prev_upd, momentum_v, _mm512_mul_ps(learning_rate_v, _mm512_fmsub_ps(_mm512_maskz_loadu_ps(mask, gradient + i), normalizer_v, _mm512_mul_ps(current_weight, weight_decay_v))));
+				__m512 upd = _mm512_fmsub_ps(mp1_v, new_upd, _mm512_mul_ps(momentum_v, prev_upd));
+				accum_v = _mm512_add_ps(accum_v, _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(upd), abs_mask)));
+				_mm512_mask_storeu_ps(weights + i, mask, _mm512_add_ps(current_weight, upd));
+				_mm512_mask_storeu_ps(gradient + i, mask, _mm512_setzero_ps());
+				_mm512_mask_storeu_ps(previous_upd + i, mask, new_upd);
+			}
+			return static_cast<double>(horizontal_sum_avx512(accum_v));
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 double simd_kernels_avx512_plain::apply_gradient_with_adam_momentum(
+			float * weights,
+			float * gradient,
+			float * biased_first_momentum,
+			float * biased_second_momentum,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float beta1,
+			float beta2,
+			float one_minus_beta1t_inverted,
+			float one_minus_beta2t_inverted,
+			float epsilon) const
+		{
+			const __m512 learning_rate_v = _mm512_set1_ps(learning_rate);
+			const __m512 normalizer_v = _mm512_set1_ps(normalizer);
+			const __m512 weight_decay_v = _mm512_set1_ps(weight_decay);
+			const __m512 beta1_v = _mm512_set1_ps(beta1);
+			const __m512 one_minus_beta1_v = _mm512_set1_ps(1.0F - beta1);
+			const __m512 beta2_v = _mm512_set1_ps(beta2);
+			const __m512 one_minus_beta2_v = _mm512_set1_ps(1.0F - beta2);
+			const __m512 one_minus_beta1t_inverted_v = _mm512_set1_ps(one_minus_beta1t_inverted);
+			const __m512 one_minus_beta2t_inverted_v = _mm512_set1_ps(one_minus_beta2t_inverted);
+			const __m512 epsilon_v = _mm512_set1_ps(epsilon);
+			const __m512i abs_mask = _mm512_set1_epi32(0x7FFFFFFF);
+			__m512 accum_v = _mm512_setzero_ps();
+			for(int i = 0; i < elem_count; i += 16)
+			{
+				// Inactive lanes load zeros, which result in zero updates
+				const __mmask16 mask = tail_mask(std::min(elem_count - i, 16));
+				__m512 current_weight = _mm512_maskz_loadu_ps(mask, weights + i);
+				__m512 total_gradient = _mm512_fmsub_ps(_mm512_maskz_loadu_ps(mask, gradient + i), normalizer_v, _mm512_mul_ps(current_weight, weight_decay_v));
+				__m512 new_biased_first_momentum = _mm512_fmadd_ps(beta1_v, _mm512_maskz_loadu_ps(mask, biased_first_momentum + i), _mm512_mul_ps(one_minus_beta1_v, total_gradient));
+				__m512 new_biased_second_momentum = _mm512_fmadd_ps(beta2_v, _mm512_maskz_loadu_ps(mask, biased_second_momentum + i), _mm512_mul_ps(_mm512_mul_ps(one_minus_beta2_v, total_gradient), total_gradient));
+				__m512 unbiased_first_momentum = _mm512_mul_ps(new_biased_first_momentum, one_minus_beta1t_inverted_v);
+				__m512 unbiased_second_momentum = _mm512_mul_ps(new_biased_second_momentum, one_minus_beta2t_inverted_v);
+				__m512 upd = _mm512_div_ps(_mm512_mul_ps(learning_rate_v, unbiased_first_momentum), _mm512_add_ps(_mm512_sqrt_ps(unbiased_second_momentum), epsilon_v));
+				accum_v = _mm512_add_ps(accum_v, _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(upd), abs_mask)));
+				_mm512_mask_storeu_ps(weights + i, mask, _mm512_add_ps(current_weight, upd));
+				_mm512_mask_storeu_ps(gradient + i, mask, _mm512_setzero_ps());
+				_mm512_mask_storeu_ps(biased_first_momentum + i, mask, new_biased_first_momentum);
+				_mm512_mask_storeu_ps(biased_second_momentum + i, mask, new_biased_second_momentum);
+			}
+			return static_cast<double>(horizontal_sum_avx512(accum_v));
+		}
+
+		NNFORGE_SIMD_TARGET_AVX512 void simd_kernels_avx512_plain::gemm_micro_kernel(
+			int kc_actual,
+			const float * packed_a,
+			const float * packed_b,
+			float * c,
+			int ldc,
+			int mr_actual,
+			int nr_actual) const
+		{
+			// A row of the tile is exactly one ZMM register
+			__m512 acc0 = _mm512_setzero_ps();
+			__m512 acc1 = _mm512_setzero_ps();
+			__m512 acc2 = _mm512_setzero_ps();
+			__m512 acc3 = _mm512_setzero_ps();
+			__m512 acc4 = _mm512_setzero_ps();
+			__m512 acc5 = _mm512_setzero_ps();
+
+			const float * a_it = packed_a;
+			const float * b_it = packed_b;
+			for(int p = 0; p < kc_actual; ++p, a_it += gemm_mr, b_it += gemm_nr)
+			{
+				__m512 b = _mm512_loadu_ps(b_it);
+				acc0 = _mm512_fmadd_ps(_mm512_set1_ps(a_it[0]), b, acc0);
+				acc1 = _mm512_fmadd_ps(_mm512_set1_ps(a_it[1]), b, acc1);
+				acc2 = _mm512_fmadd_ps(_mm512_set1_ps(a_it[2]), b, acc2);
+				acc3 = _mm512_fmadd_ps(_mm512_set1_ps(a_it[3]), b, acc3);
+				acc4 = _mm512_fmadd_ps(_mm512_set1_ps(a_it[4]), b, acc4);
+				acc5 = _mm512_fmadd_ps(_mm512_set1_ps(a_it[5]), b, acc5);
+			}
+
+			const __m512 acc[gemm_mr] = {acc0, acc1, acc2, acc3, acc4, acc5};
+			const __mmask16 mask = tail_mask(nr_actual);
+			for(int i = 0; i < mr_actual; ++i)
+			{
+				float * c_row = c + i * ldc;
+				_mm512_mask_storeu_ps(c_row, mask, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, c_row), acc[i]));
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,393 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "simd_kernels_plain.h"
+
+#include "simd_kernels_sse2_plain.h"
+#include "simd_kernels_avx2_plain.h"
+#include "simd_kernels_avx512_plain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#ifdef NNFORGE_SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const int simd_kernels_plain::elementwise_chunk_elem_count = 16384;
+
+#ifdef NNFORGE_SIMD_X86
+		namespace
+		{
+			void cpuid(int leaf, unsigned int regs[4])
+			{
+				#ifdef _MSC_VER
+				int r[4];
+				__cpuidex(r, leaf, 0);
+				for(int i = 0; i < 4; ++i)
+					regs[i] = static_cast<unsigned int>(r[i]);
+				#else
+				__cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+				#endif
+			}
+
+			// Register state the OS saves on context switch
+			unsigned long long xgetbv()
+			{
+				#ifdef _MSC_VER
+				return _xgetbv(0);
+				#else
+				unsigned int eax;
+				unsigned int edx;
+				__asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+				return (static_cast<unsigned long long>(edx) << 32) | eax;
+				#endif
+			}
+		}
+#endif
+
+		const simd_kernels_plain& simd_kernels_plain::get_singleton()
+		{
+			static const std::unique_ptr<const simd_kernels_plain> instance(create_for_current_cpu());
+			return *instance;
+		}
+
+		simd_kernels_plain * simd_kernels_plain::create_for_current_cpu()
+		{
+			#ifdef NNFORGE_SIMD_X86
+			unsigned int regs[4];
+			cpuid(0, regs);
+			const unsigned int max_leaf = regs[0];
+			if (max_leaf < 1)
+				return new simd_kernels_plain();
+
+			cpuid(1, regs);
+			const bool sse2 = (regs[3] & (1U << 26)) != 0;
+			const bool fma = (regs[2] & (1U << 12)) != 0;
+			const bool osxsave = (regs[2] & (1U << 27)) != 0;
+			const bool avx = (regs[2] & (1U << 28)) != 0;
+
+			bool avx2 = false;
+			bool avx512f = false;
+			if (max_leaf >= 7)
+			{
+				cpuid(7, regs);
+				avx2 = (regs[1] & (1U << 5)) != 0;
+				avx512f = (regs[1] & (1U << 16)) != 0;
+			}
+
+			const unsigned long long xcr0 = osxsave ? xgetbv() : 0;
+			const bool os_ymm = (xcr0 & 0x6) == 0x6;
+			const bool os_zmm = (xcr0 & 0xE6) == 0xE6;
+
+			#ifdef NNFORGE_SIMD_AVX512
+			// The AVX-512 kernels are compiled with AVX2 and FMA enabled as well
+			if (avx512f && avx2 && fma && os_zmm)
+				return new simd_kernels_avx512_plain();
+			#endif
+			if (avx && avx2 && fma && os_ymm)
+				return new simd_kernels_avx2_plain();
+			if (sse2)
+				return new simd_kernels_sse2_plain();
+			#endif
+
+			return new simd_kernels_plain();
+		}
+
+		std::string simd_kernels_plain::get_instruction_set_name() const
+		{
+			return "scalar";
+		}
+
+		void simd_kernels_plain::relu(
+			float * output,
+			const float * input,
+			int elem_count) const
+		{
+			for(int i = 0; i < elem_count; ++i)
+				output[i] = std::max(input[i], 0.0F);
+		}
+
+		void simd_kernels_plain::relu_backward(
+			float * input_errors,
+			const float * output_errors,
+			const float * output_neurons,
+			int elem_count,
+			bool add_update_to_destination) const
+		{
+			if (add_update_to_destination)
+			{
+				for(int i = 0; i < elem_count; ++i)
+					input_errors[i] += (output_neurons[i] == 0.0F) ? 0.0F : output_errors[i];
+			}
+			else
+			{
+				for(int i = 0; i < elem_count; ++i)
+					input_errors[i] = (output_neurons[i] == 0.0F) ? 0.0F : output_errors[i];
+			}
+		}
+
+		void simd_kernels_plain::scale_shift(
+			float * output,
+			const float * input,
+			int elem_count,
+			float mult,
+			float add) const
+		{
+			for(int i = 0; i < elem_count; ++i)
+				output[i] = input[i] * mult + add;
+		}
+
+		void simd_kernels_plain::scale(
+			float * output,
+			const float * input,
+			int elem_count,
+			float alpha,
+			bool add_to_destination) const
+		{
+			if (add_to_destination)
+			{
+				for(int i = 0; i < elem_count; ++i)
+					output[i] += input[i] * alpha;
+			}
+			else
+			{
+				for(int i = 0; i < elem_count; ++i)
+					output[i] = input[i] * alpha;
+			}
+		}
+
+		void simd_kernels_plain::sum_scaled(
+			float * output,
+			const float * const * input_list,
+			int input_count,
+			int elem_count,
+			float alpha) const
+		{
+			for(int i = 0; i < elem_count; ++i)
+			{
+				float sum = 0.0F;
+				for(int j = 0; j < input_count; ++j)
+					sum += input_list[j][i];
+				output[i] = sum * alpha;
+			}
+		}
+
+		void simd_kernels_plain::max_accumulate(
+			float * output,
+			const float * input,
+			int elem_count,
+			bool is_min) const
+		{
+			if (is_min)
+			{
+				for(int i = 0; i < elem_count; ++i)
+					output[i] = std::min(output[i], input[i]);
+			}
+			else
+			{
+				for(int i = 0; i < elem_count; ++i)
+					output[i] = std::max(output[i], input[i]);
+			}
+		}
+
+		void simd_kernels_plain::add_accumulate(
+			float * output,
+			const float * input,
+			int elem_count) const
+		{
+			for(int i = 0; i < elem_count; ++i)
+				output[i] += input[i];
+		}
+
+		void simd_kernels_plain::softmax(
+			float * output,
+			const float * input,
+			int feature_map_count,
+			int feature_map_stride,
+			int elem_count) const
+		{
+			for(int i = 0; i < elem_count; ++i)
+			{
+				const float * in_it = input + i;
+				float * out_it = output + i;
+
+				float max_val = -1.0e+37F;
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+					max_val = std::max(max_val, in_it[feature_map_id * feature_map_stride]);
+
+				float sum = 0.0F;
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+				{
+					float val = expf(in_it[feature_map_id * feature_map_stride] - max_val);
+					sum += val;
+					out_it[feature_map_id * feature_map_stride] = val;
+				}
+
+				float mult = 1.0F / sum;
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+					out_it[feature_map_id * feature_map_stride] *= mult;
+			}
+		}
+
+		double simd_kernels_plain::apply_gradient(
+			float * weights,
+			float * gradient,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay) const
+		{
+			double accum = 0.0;
+			for(int i = 0; i < elem_count; ++i)
+			{
+				float current_weight = weights[i];
+				float upd = learning_rate * (gradient[i] * normalizer - current_weight * weight_decay);
+				accum += static_cast<double>(fabsf(upd));
+				weights[i] = current_weight + upd;
+				gradient[i] = 0.0F;
+			}
+			return accum;
+		}
+
+		double simd_kernels_plain::apply_gradient_with_vanilla_momentum(
+			float * weights,
+			float * gradient,
+			float * previous_upd,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum) const
+		{
+			double accum = 0.0;
+			for(int i = 0; i < elem_count; ++i)
+			{
+				float current_weight = weights[i];
+				float upd = previous_upd[i] * momentum + learning_rate * (gradient[i] * normalizer - current_weight * weight_decay);
+				accum += static_cast<double>(fabsf(upd));
+				weights[i] = current_weight + upd;
+				gradient[i] = 0.0F;
+				previous_upd[i] = upd;
+			}
+			return accum;
+		}
+
+		double simd_kernels_plain::apply_gradient_with_nesterov_momentum(
+			float * weights,
+			float * gradient,
+			float * previous_upd,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum) const
+		{
+			double accum = 0.0;
+			float mp1 = momentum + 1.0F;
+			for(int i = 0; i < elem_count; ++i)
+			{
+				float current_weight = weights[i];
+				float prev_upd = previous_upd[i];
+				float new_upd = prev_upd * momentum + learning_rate * (gradient[i] * normalizer - current_weight * weight_decay);
+				float upd = mp1 * new_upd - momentum * prev_upd;
+				accum += static_cast<double>(fabsf(upd));
+				weights[i] = current_weight + upd;
+				gradient[i] = 0.0F;
+				previous_upd[i] = new_upd;
+			}
+			return accum;
+		}
+
+		double simd_kernels_plain::apply_gradient_with_adam_momentum(
+			float * weights,
+			float * gradient,
+			float * biased_first_momentum,
+			float * biased_second_momentum,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float beta1,
+			float beta2,
+			float one_minus_beta1t_inverted,
+			float one_minus_beta2t_inverted,
+			float epsilon) const
+		{
+			double accum = 0.0;
+			for(int i = 0; i < elem_count; ++i)
+			{
+				float current_weight = weights[i];
+				float total_gradient = gradient[i] * normalizer - current_weight * weight_decay;
+				float new_biased_first_momentum = beta1 * biased_first_momentum[i] + (1.0F - beta1) * total_gradient;
+				float new_biased_second_momentum = beta2 * biased_second_momentum[i] + (1.0F - beta2) * total_gradient * total_gradient;
+				float unbiased_first_momentum = new_biased_first_momentum * one_minus_beta1t_inverted;
+				float unbiased_second_momentum = new_biased_second_momentum * one_minus_beta2t_inverted;
+				float upd = (learning_rate * unbiased_first_momentum) / (sqrtf(unbiased_second_momentum) + epsilon);
+				accum += static_cast<double>(fabsf(upd));
+				weights[i] = current_weight + upd;
+				gradient[i] = 0.0F;
+				biased_first_momentum[i] = new_biased_first_momentum;
+				biased_second_momentum[i] = new_biased_second_momentum;
+			}
+			return accum;
+		}
+
+		void simd_kernels_plain::gemm_micro_kernel(
+			int kc_actual,
+			const float * packed_a,
+			const float * packed_b,
+			float * c,
+			int ldc,
+			int mr_actual,
+			int nr_actual) const
+		{
+			// Fixed-size accumulator block, the compiler keeps it in vector registers
+			float acc[gemm_mr * gemm_nr];
+			for(int i = 0; i < gemm_mr * gemm_nr; ++i)
+				acc[i] = 0.0F;
+
+			for(int p = 0; p < kc_actual; ++p)
+			{
+				const float * a_col = packed_a + p * gemm_mr;
+				const float * b_row = packed_b + p * gemm_nr;
+				for(int i = 0; i < gemm_mr; ++i)
+				{
+					float a_val = a_col[i];
+					for(int j = 0; j < gemm_nr; ++j)
+						acc[i * gemm_nr + j] += a_val * b_row[j];
+				}
+			}
+
+			for(int i = 0; i < mr_actual; ++i)
+			{
+				float * c_row = c + i * ldc;
+				const float * acc_row = acc + i * gemm_nr;
+				for(int j = 0; j < nr_actual; ++j)
+					c_row[j] += acc_row[j];
+			}
+		}
+	}
+}
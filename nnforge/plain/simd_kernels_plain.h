@@ -0,0 +1,193 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NNFORGE_SIMD_X86
+#if defined(__GNUC__) || defined(__clang__)
+// Vector code is compiled per function, so the rest of the library doesn't need -mavx2 and friends
+#define NNFORGE_SIMD_TARGET(isa) __attribute__((target(isa)))
+#if defined(__clang__) || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9))
+#define NNFORGE_SIMD_AVX512
+#endif
+#elif defined(_MSC_VER)
+#define NNFORGE_SIMD_TARGET(isa)
+#if _MSC_VER >= 1910
+#define NNFORGE_SIMD_AVX512
+#endif
+#endif
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Building blocks shared by plain layer testers and updaters.
+		// The base class holds portable scalar versions, derived classes provide explicit SSE2, AVX2 and AVX-512 implementations.
+		// The widest instruction set supported by both the CPU and the OS is picked once, so a single build runs everywhere.
+		// All the functions are single-threaded, callers split the work across OpenMP threads.
+		class simd_kernels_plain
+		{
+		public:
+			virtual ~simd_kernels_plain() = default;
+
+			static const simd_kernels_plain& get_singleton();
+
+			virtual std::string get_instruction_set_name() const;
+
+			// output[i] = max(input[i], 0), output might be the same as input
+			virtual void relu(
+				float * output,
+				const float * input,
+				int elem_count) const;
+
+			// input_errors[i] (+)= (output_neurons[i] == 0) ? 0 : output_errors[i]
+			virtual void relu_backward(
+				float * input_errors,
+				const float * output_errors,
+				const float * output_neurons,
+				int elem_count,
+				bool add_update_to_destination) const;
+
+			// output[i] = input[i] * mult + add, output might be the same as input
+			virtual void scale_shift(
+				float * output,
+				const float * input,
+				int elem_count,
+				float mult,
+				float add) const;
+
+			// output[i] (+)= input[i] * alpha, output might be the same as input
+			virtual void scale(
+				float * output,
+				const float * input,
+				int elem_count,
+				float alpha,
+				bool add_to_destination) const;
+
+			// output[i] = (input_list[0][i] + ... + input_list[input_count - 1][i]) * alpha, output might be the same as any of inputs
+			virtual void sum_scaled(
+				float * output,
+				const float * const * input_list,
+				int input_count,
+				int elem_count,
+				float alpha) const;
+
+			// output[i] = max(output[i], input[i]) or min if is_min is set
+			virtual void max_accumulate(
+				float * output,
+				const float * input,
+				int elem_count,
+				bool is_min) const;
+
+			// output[i] += input[i]
+			virtual void add_accumulate(
+				float * output,
+				const float * input,
+				int elem_count) const;
+
+			// Softmax across feature maps for elem_count consecutive neurons,
+			// values of subsequent feature maps are feature_map_stride elements apart, output might be the same as input
+			virtual void softmax(
+				float * output,
+				const float * input,
+				int feature_map_count,
+				int feature_map_stride,
+				int elem_count) const;
+
+			// Optimizer steps matching cuda_util::apply_gradient*.
+			// The update is computed from gradient * normalizer - weights * weight_decay and added to weights, gradient is zeroed.
+			// The sum of absolute values of the updates is returned, vector versions accumulate it in single precision,
+			// so callers should keep elem_count within elementwise_chunk_elem_count
+			virtual double apply_gradient(
+				float * weights,
+				float * gradient,
+				int elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay) const;
+
+			// previous_upd holds the previous update and receives the new one
+			virtual double apply_gradient_with_vanilla_momentum(
+				float * weights,
+				float * gradient,
+				float * previous_upd,
+				int elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float momentum) const;
+
+			// previous_upd holds the previous velocity and receives the new one
+			virtual double apply_gradient_with_nesterov_momentum(
+				float * weights,
+				float * gradient,
+				float * previous_upd,
+				int elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float momentum) const;
+
+			// Both momentums are biased and updated in place
+			virtual double apply_gradient_with_adam_momentum(
+				float * weights,
+				float * gradient,
+				float * biased_first_momentum,
+				float * biased_second_momentum,
+				int elem_count,
+				float learning_rate,
+				float normalizer,
+				float weight_decay,
+				float beta1,
+				float beta2,
+				float one_minus_beta1t_inverted,
+				float one_minus_beta2t_inverted,
+				float epsilon) const;
+
+			// c += packed_a * packed_b for a single gemm_mr x gemm_nr tile, only mr_actual x nr_actual part of c is written.
+			// packed_a holds kc_actual columns of gemm_mr elements, packed_b holds kc_actual rows of gemm_nr elements
+			virtual void gemm_micro_kernel(
+				int kc_actual,
+				const float * packed_a,
+				const float * packed_b,
+				float * c,
+				int ldc,
+				int mr_actual,
+				int nr_actual) const;
+
+			static const int gemm_mr = 6;
+			static const int gemm_nr = 16;
+
+			// Elementwise work is split into chunks of this size across threads
+			static const int elementwise_chunk_elem_count;
+
+		protected:
+			simd_kernels_plain() = default;
+
+		private:
+			// Picks the widest instruction set supported by both the CPU and the OS
+			static simd_kernels_plain * create_for_current_cpu();
+
+		private:
+			simd_kernels_plain(const simd_kernels_plain&) = delete;
+			simd_kernels_plain& operator =(const simd_kernels_plain&) = delete;
+		};
+	}
+}
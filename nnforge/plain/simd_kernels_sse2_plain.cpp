@@ -0,0 +1,484 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "simd_kernels_sse2_plain.h"
+
+#ifdef NNFORGE_SIMD_X86
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		namespace
+		{
+			// Cephes-style expf, relative error is within a few ulp over the range softmax uses
+			NNFORGE_SIMD_TARGET("sse2") inline __m128 exp_sse2(__m128 x)
+			{
+				x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-87.0F)), _mm_set1_ps(88.0F));
+
+				// n = floor(x * log2(e) + 0.5), SSE2 has no floor instruction so truncate and fix up negative values
+				__m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341F)), _mm_set1_ps(0.5F));
+				__m128 n = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+				n = _mm_sub_ps(n, _mm_and_ps(_mm_cmpgt_ps(n, fx), _mm_set1_ps(1.0F)));
+
+				x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(0.693359375F)));
+				x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(-2.12194440e-4F)));
+
+				__m128 y = _mm_set1_ps(1.9875691500e-4F);
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507e-3F));
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073e-3F));
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894e-2F));
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459e-1F));
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201e-1F));
+				y = _mm_add_ps(_mm_mul_ps(y, _mm_mul_ps(x, x)), _mm_add_ps(x, _mm_set1_ps(1.0F)));
+
+				__m128i pow2n = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23);
+				return _mm_mul_ps(y, _mm_castsi128_ps(pow2n));
+			}
+
+			NNFORGE_SIMD_TARGET("sse2") inline float horizontal_max_sse2(__m128 v)
+			{
+				v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+				v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+				return _mm_cvtss_f32(v);
+			}
+
+			NNFORGE_SIMD_TARGET("sse2") inline float horizontal_sum_sse2(__m128 v)
+			{
+				v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+				v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+				return _mm_cvtss_f32(v);
+			}
+		}
+
+		std::string simd_kernels_sse2_plain::get_instruction_set_name() const
+		{
+			return "SSE2";
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") void simd_kernels_sse2_plain::relu(
+			float * output,
+			const float * input,
+			int elem_count) const
+		{
+			const __m128 zero = _mm_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 4; i += 4)
+				_mm_storeu_ps(output + i, _mm_max_ps(_mm_loadu_ps(input + i), zero));
+			for(; i < elem_count; ++i)
+				output[i] = std::max(input[i], 0.0F);
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") void simd_kernels_sse2_plain::relu_backward(
+			float * input_errors,
+			const float * output_errors,
+			const float * output_neurons,
+			int elem_count,
+			bool add_update_to_destination) const
+		{
+			const __m128 zero = _mm_setzero_ps();
+			int i = 0;
+			if (add_update_to_destination)
+			{
+				for(; i <= elem_count - 4; i += 4)
+				{
+					__m128 err = _mm_and_ps(_mm_cmpneq_ps(_mm_loadu_ps(output_neurons + i), zero), _mm_loadu_ps(output_errors + i));
+					_mm_storeu_ps(input_errors + i, _mm_add_ps(_mm_loadu_ps(input_errors + i), err));
+				}
+			}
+			else
+			{
+				for(; i <= elem_count - 4; i += 4)
+				{
+					__m128 err = _mm_and_ps(_mm_cmpneq_ps(_mm_loadu_ps(output_neurons + i), zero), _mm_loadu_ps(output_errors + i));
+					_mm_storeu_ps(input_errors + i, err);
+				}
+			}
+			simd_kernels_plain::relu_backward(input_errors + i, output_errors + i, output_neurons + i, elem_count - i, add_update_to_destination);
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") void simd_kernels_sse2_plain::scale_shift(
+			float * output,
+			const float * input,
+			int elem_count,
+			float mult,
+			float add) const
+		{
+			const __m128 mult_v = _mm_set1_ps(mult);
+			const __m128 add_v = _mm_set1_ps(add);
+			int i = 0;
+			for(; i <= elem_count - 4; i += 4)
+				_mm_storeu_ps(output + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(input + i), mult_v), add_v));
+			for(; i < elem_count; ++i)
+				output[i] = input[i] * mult + add;
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") void simd_kernels_sse2_plain::scale(
+			float * output,
+			const float * input,
+			int elem_count,
+			float alpha,
+			bool add_to_destination) const
+		{
+			const __m128 alpha_v = _mm_set1_ps(alpha);
+			int i = 0;
+			if (add_to_destination)
+			{
+				for(; i <= elem_count - 4; i += 4)
+					_mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_mul_ps(_mm_loadu_ps(input + i), alpha_v)));
+			}
+			else
+			{
+				for(; i <= elem_count - 4; i += 4)
+					_mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i), alpha_v));
+			}
+			simd_kernels_plain::scale(output + i, input + i, elem_count - i, alpha, add_to_destination);
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") void simd_kernels_sse2_plain::sum_scaled(
+			float * output,
+			const float * const * input_list,
+			int input_count,
+			int elem_count,
+			float alpha) const
+		{
+			const __m128 alpha_v = _mm_set1_ps(alpha);
+			int i = 0;
+			for(; i <= elem_count - 4; i += 4)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for(int j = 0; j < input_count; ++j)
+					sum = _mm_add_ps(sum, _mm_loadu_ps(input_list[j] + i));
+				_mm_storeu_ps(output + i, _mm_mul_ps(sum, alpha_v));
+			}
+			for(; i < elem_count; ++i)
+			{
+				float sum = 0.0F;
+				for(int j = 0; j < input_count; ++j)
+					sum += input_list[j][i];
+				output[i] = sum * alpha;
+			}
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") void simd_kernels_sse2_plain::max_accumulate(
+			float * output,
+			const float * input,
+			int elem_count,
+			bool is_min) const
+		{
+			int i = 0;
+			if (is_min)
+			{
+				for(; i <= elem_count - 4; i += 4)
+					_mm_storeu_ps(output + i, _mm_min_ps(_mm_loadu_ps(output + i), _mm_loadu_ps(input + i)));
+			}
+			else
+			{
+				for(; i <= elem_count - 4; i += 4)
+					_mm_storeu_ps(output + i, _mm_max_ps(_mm_loadu_ps(output + i), _mm_loadu_ps(input + i)));
+			}
+			simd_kernels_plain::max_accumulate(output + i, input + i, elem_count - i, is_min);
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") void simd_kernels_sse2_plain::add_accumulate(
+			float * output,
+			const float * input,
+			int elem_count) const
+		{
+			int i = 0;
+			for(; i <= elem_count - 4; i += 4)
+				_mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_loadu_ps(input + i)));
+			for(; i < elem_count; ++i)
+				output[i] += input[i];
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") void simd_kernels_sse2_plain::softmax(
+			float * output,
+			const float * input,
+			int feature_map_count,
+			int feature_map_stride,
+			int elem_count) const
+		{
+			if (feature_map_stride == 1)
+			{
+				// Feature maps are contiguous, vectorize across them
+				for(int i = 0; i < elem_count; ++i)
+				{
+					const float * in_it = input + i;
+					float * out_it = output + i;
+					const int vector_feature_map_count = feature_map_count & ~3;
+
+					__m128 max_v = _mm_set1_ps(-1.0e+37F);
+					for(int feature_map_id = 0; feature_map_id < vector_feature_map_count; feature_map_id += 4)
+						max_v = _mm_max_ps(max_v, _mm_loadu_ps(in_it + feature_map_id));
+					float max_val = horizontal_max_sse2(max_v);
+					for(int feature_map_id = vector_feature_map_count; feature_map_id < feature_map_count; ++feature_map_id)
+						max_val = std::max(max_val, in_it[feature_map_id]);
+
+					max_v = _mm_set1_ps(max_val);
+					__m128 sum_v = _mm_setzero_ps();
+					for(int feature_map_id = 0; feature_map_id < vector_feature_map_count; feature_map_id += 4)
+					{
+						__m128 val = exp_sse2(_mm_sub_ps(_mm_loadu_ps(in_it + feature_map_id), max_v));
+						sum_v = _mm_add_ps(sum_v, val);
+						_mm_storeu_ps(out_it + feature_map_id, val);
+					}
+					float sum = horizontal_sum_sse2(sum_v);
+					for(int feature_map_id = vector_feature_map_count; feature_map_id < feature_map_count; ++feature_map_id)
+					{
+						float val = expf(in_it[feature_map_id] - max_val);
+						sum += val;
+						out_it[feature_map_id] = val;
+					}
+
+					scale(out_it, out_it, feature_map_count, 1.0F / sum, false);
+				}
+				return;
+			}
+
+			// Vectorize across neurons
+			int i = 0;
+			for(; i <= elem_count - 4; i += 4)
+			{
+				const float * in_it = input + i;
+				float * out_it = output + i;
+
+				__m128 max_v = _mm_set1_ps(-1.0e+37F);
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+					max_v = _mm_max_ps(max_v, _mm_loadu_ps(in_it + feature_map_id * feature_map_stride));
+
+				__m128 sum_v = _mm_setzero_ps();
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+				{
+					__m128 val = exp_sse2(_mm_sub_ps(_mm_loadu_ps(in_it + feature_map_id * feature_map_stride), max_v));
+					sum_v = _mm_add_ps(sum_v, val);
+					_mm_storeu_ps(out_it + feature_map_id * feature_map_stride, val);
+				}
+
+				__m128 mult_v = _mm_div_ps(_mm_set1_ps(1.0F), sum_v);
+				for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+				{
+					float * dst = out_it + feature_map_id * feature_map_stride;
+					_mm_storeu_ps(dst, _mm_mul_ps(_mm_loadu_ps(dst), mult_v));
+				}
+			}
+			simd_kernels_plain::softmax(output + i, input + i, feature_map_count, feature_map_stride, elem_count - i);
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") double simd_kernels_sse2_plain::apply_gradient(
+			float * weights,
+			float * gradient,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay) const
+		{
+			const __m128 learning_rate_v = _mm_set1_ps(learning_rate);
+			const __m128 normalizer_v = _mm_set1_ps(normalizer);
+			const __m128 weight_decay_v = _mm_set1_ps(weight_decay);
+			const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+			__m128 accum_v = _mm_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 4; i += 4)
+			{
+				__m128 current_weight = _mm_loadu_ps(weights + i);
+				__m128 upd = _mm_mul_ps(learning_rate_v, _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(gradient + i), normalizer_v), _mm_mul_ps(current_weight, weight_decay_v)));
+				accum_v = _mm_add_ps(accum_v, _mm_and_ps(upd, abs_mask));
+				_mm_storeu_ps(weights + i, _mm_add_ps(current_weight, upd));
+				_mm_storeu_ps(gradient + i, _mm_setzero_ps());
+			}
+			return static_cast<double>(horizontal_sum_sse2(accum_v)) + simd_kernels_plain::apply_gradient(weights + i, gradient + i, elem_count - i, learning_rate, normalizer, weight_decay);
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") double simd_kernels_sse2_plain::apply_gradient_with_vanilla_momentum(
+			float * weights,
+			float * gradient,
+			float * previous_upd,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum) const
+		{
+			const __m128 learning_rate_v = _mm_set1_ps(learning_rate);
+			const __m128 normalizer_v = _mm_set1_ps(normalizer);
+			const __m128 weight_decay_v = _mm_set1_ps(weight_decay);
+			const __m128 momentum_v = _mm_set1_ps(momentum);
+			const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+			__m128 accum_v = _mm_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 4; i += 4)
+			{
+				__m128 current_weight = _mm_loadu_ps(weights + i);
+				__m128 upd = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(previous_upd + i), momentum_v), _mm_mul_ps(learning_rate_v, _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(gradient + i), normalizer_v), _mm_mul_ps(current_weight, weight_decay_v))));
+				accum_v = _mm_add_ps(accum_v, _mm_and_ps(upd, abs_mask));
+				_mm_storeu_ps(weights + i, _mm_add_ps(current_weight, upd));
+				_mm_storeu_ps(gradient + i, _mm_setzero_ps());
+				_mm_storeu_ps(previous_upd + i, upd);
+			}
+			return static_cast<double>(horizontal_sum_sse2(accum_v)) + simd_kernels_plain::apply_gradient_with_vanilla_momentum(weights + i, gradient + i, previous_upd + i, elem_count - i, learning_rate, normalizer, weight_decay, momentum);
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") double simd_kernels_sse2_plain::apply_gradient_with_nesterov_momentum(
+			float * weights,
+			float * gradient,
+			float * previous_upd,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float momentum) const
+		{
+			const __m128 learning_rate_v = _mm_set1_ps(learning_rate);
+			const __m128 normalizer_v = _mm_set1_ps(normalizer);
+			const __m128 weight_decay_v = _mm_set1_ps(weight_decay);
+			const __m128 momentum_v = _mm_set1_ps(momentum);
+			const __m128 mp1_v = _mm_set1_ps(momentum + 1.0F);
+			const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+			__m128 accum_v = _mm_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 4; i += 4)
+			{
+				__m128 current_weight = _mm_loadu_ps(weights + i);
+				__m128 prev_upd = _mm_loadu_ps(previous_upd + i);
+				__m128 new_upd = _mm_add_ps(_mm_mul_ps(prev_upd, momentum_v), _mm_mul_ps(learning_rate_v, _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(gradient + i), normalizer_v), _mm_mul_ps(current_weight, weight_decay_v))));
+				__m128 upd = _mm_sub_ps(_mm_mul_ps(mp1_v, new_upd), _mm_mul_ps(momentum_v, prev_upd));
+				accum_v = _mm_add_ps(accum_v, _mm_and_ps(upd, abs_mask));
+				_mm_storeu_ps(weights + i, _mm_add_ps(current_weight, upd));
+				_mm_storeu_ps(gradient + i, _mm_setzero_ps());
+				_mm_storeu_ps(previous_upd + i, new_upd);
+			}
+			return static_cast<double>(horizontal_sum_sse2(accum_v)) + simd_kernels_plain::apply_gradient_with_nesterov_momentum(weights + i, gradient + i, previous_upd + i, elem_count - i, learning_rate, normalizer, weight_decay, momentum);
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") double simd_kernels_sse2_plain::apply_gradient_with_adam_momentum(
+			float * weights,
+			float * gradient,
+			float * biased_first_momentum,
+			float * biased_second_momentum,
+			int elem_count,
+			float learning_rate,
+			float normalizer,
+			float weight_decay,
+			float beta1,
+			float beta2,
+			float one_minus_beta1t_inverted,
+			float one_minus_beta2t_inverted,
+			float epsilon) const
+		{
+			const __m128 learning_rate_v = _mm_set1_ps(learning_rate);
+			const __m128 normalizer_v = _mm_set1_ps(normalizer);
+			const __m128 weight_decay_v = _mm_set1_ps(weight_decay);
+			const __m128 beta1_v = _mm_set1_ps(beta1);
+			const __m128 one_minus_beta1_v = _mm_set1_ps(1.0F - beta1);
+			const __m128 beta2_v = _mm_set1_ps(beta2);
+			const __m128 one_minus_beta2_v = _mm_set1_ps(1.0F - beta2);
+			const __m128 one_minus_beta1t_inverted_v = _mm_set1_ps(one_minus_beta1t_inverted);
+			const __m128 one_minus_beta2t_inverted_v = _mm_set1_ps(one_minus_beta2t_inverted);
+			const __m128 epsilon_v = _mm_set1_ps(epsilon);
+			const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+			__m128 accum_v = _mm_setzero_ps();
+			int i = 0;
+			for(; i <= elem_count - 4; i += 4)
+			{
+				__m128 current_weight = _mm_loadu_ps(weights + i);
+				__m128 total_gradient = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(gradient + i), normalizer_v), _mm_mul_ps(current_weight, weight_decay_v));
+				__m128 new_biased_first_momentum = _mm_add_ps(_mm_mul_ps(beta1_v, _mm_loadu_ps(biased_first_momentum + i)), _mm_mul_ps(one_minus_beta1_v, total_gradient));
+				__m128 new_biased_second_momentum = _mm_add_ps(_mm_mul_ps(beta2_v, _mm_loadu_ps(biased_second_momentum + i)), _mm_mul_ps(_mm_mul_ps(one_minus_beta2_v, total_gradient), total_gradient));
+				__m128 unbiased_first_momentum = _mm_mul_ps(new_biased_first_momentum, one_minus_beta1t_inverted_v);
+				__m128 unbiased_second_momentum = _mm_mul_ps(new_biased_second_momentum, one_minus_beta2t_inverted_v);
+				__m128 upd = _mm_div_ps(_mm_mul_ps(learning_rate_v, unbiased_first_momentum), _mm_add_ps(_mm_sqrt_ps(unbiased_second_momentum), epsilon_v));
+				accum_v = _mm_add_ps(accum_v, _mm_and_ps(upd, abs_mask));
+				_mm_storeu_ps(weights + i, _mm_add_ps(current_weight, upd));
+				_mm_storeu_ps(gradient + i, _mm_setzero_ps());
+				_mm_storeu_ps(biased_first_momentum + i, new_biased_first_momentum);
+				_mm_storeu_ps(biased_second_momentum + i, new_biased_second_momentum);
+			}
+			return static_cast<double>(horizontal_sum_sse2(accum_v)) + simd_kernels_plain::apply_gradient_with_adam_momentum(weights + i, gradient + i, biased_first_momentum + i, biased_second_momentum + i, elem_count - i, learning_rate, normalizer, weight_decay, beta1, beta2, one_minus_beta1t_inverted, one_minus_beta2t_inverted, epsilon);
+		}
+
+		NNFORGE_SIMD_TARGET("sse2") void simd_kernels_sse2_plain::gemm_micro_kernel(
+			int kc_actual,
+			const float * packed_a,
+			const float * packed_b,
+			float * c,
+			int ldc,
+			int mr_actual,
+			int nr_actual) const
+		{
+			// 16 XMM registers don't fit the whole 6x16 tile, compute it as two 6x8 halves
+			for(int half = 0; half < 2; ++half)
+			{
+				const int column_offset = half * 8;
+				const int half_nr_actual = std::min(std::max(nr_actual - column_offset, 0), 8);
+				if (half_nr_actual == 0)
+					break;
+
+				__m128 acc00 = _mm_setzero_ps(), acc01 = _mm_setzero_ps();
+				__m128 acc10 = _mm_setzero_ps(), acc11 = _mm_setzero_ps();
+				__m128 acc20 = _mm_setzero_ps(), acc21 = _mm_setzero_ps();
+				__m128 acc30 = _mm_setzero_ps(), acc31 = _mm_setzero_ps();
+				__m128 acc40 = _mm_setzero_ps(), acc41 = _mm_setzero_ps();
+				__m128 acc50 = _mm_setzero_ps(), acc51 = _mm_setzero_ps();
+
+				const float * a_it = packed_a;
+				const float * b_it = packed_b + column_offset;
+				for(int p = 0; p < kc_actual; ++p, a_it += gemm_mr, b_it += gemm_nr)
+				{
+					__m128 b0 = _mm_loadu_ps(b_it);
+					__m128 b1 = _mm_loadu_ps(b_it + 4);
+					__m128 a;
+					a = _mm_set1_ps(a_it[0]); acc00 = _mm_add_ps(acc00, _mm_mul_ps(a, b0)); acc01 = _mm_add_ps(acc01, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(a_it[1]); acc10 = _mm_add_ps(acc10, _mm_mul_ps(a, b0)); acc11 = _mm_add_ps(acc11, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(a_it[2]); acc20 = _mm_add_ps(acc20, _mm_mul_ps(a, b0)); acc21 = _mm_add_ps(acc21, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(a_it[3]); acc30 = _mm_add_ps(acc30, _mm_mul_ps(a, b0)); acc31 = _mm_add_ps(acc31, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(a_it[4]); acc40 = _mm_add_ps(acc40, _mm_mul_ps(a, b0)); acc41 = _mm_add_ps(acc41, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(a_it[5]); acc50 = _mm_add_ps(acc50, _mm_mul_ps(a, b0)); acc51 = _mm_add_ps(acc51, _mm_mul_ps(a, b1));
+				}
+
+				float acc[gemm_mr * 8];
+				_mm_storeu_ps(acc + 0 * 8, acc00); _mm_storeu_ps(acc + 0 * 8 + 4, acc01);
+				_mm_storeu_ps(acc + 1 * 8, acc10); _mm_storeu_ps(acc + 1 * 8 + 4, acc11);
+				_mm_storeu_ps(acc + 2 * 8, acc20); _mm_storeu_ps(acc + 2 * 8 + 4, acc21);
+				_mm_storeu_ps(acc + 3 * 8, acc30); _mm_storeu_ps(acc + 3 * 8 + 4, acc31);
+				_mm_storeu_ps(acc + 4 * 8, acc40); _mm_storeu_ps(acc + 4 * 8 + 4, acc41);
+				_mm_storeu_ps(acc + 5 * 8, acc50); _mm_storeu_ps(acc + 5 * 8 + 4, acc51);
+
+				for(int i = 0; i < mr_actual; ++i)
+				{
+					float * c_row = c + i * ldc + column_offset;
+					const float * acc_row = acc + i * 8;
+					if (half_nr_actual == 8)
+					{
+						_mm_storeu_ps(c_row, _mm_add_ps(_mm_loadu_ps(c_row), _mm_loadu_ps(acc_row)));
+						_mm_storeu_ps(c_row + 4, _mm_add_ps(_mm_loadu_ps(c_row + 4), _mm_loadu_ps(acc_row + 4)));
+					}
+					else
+					{
+						for(int j = 0; j < half_nr_actual; ++j)
+							c_row[j] += acc_row[j];
+					}
+				}
+			}
+		}
+	}
+}
+
+#endif
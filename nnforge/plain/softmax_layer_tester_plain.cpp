@@ -21,11 +21,16 @@
 #endif
 
 #include "../softmax_layer.h"
+#include "simd_kernels_plain.h"
+
+#include <algorithm>
 
 namespace nnforge
 {
 	namespace plain
 	{
+		const unsigned int softmax_layer_tester_plain::neuron_chunk_elem_count = 64;
+
 		std::string softmax_layer_tester_plain::get_type_name() const
 		{
 			return softmax_layer::layer_type_name;
@@ -51,43 +56,25 @@ namespace nnforge
 			float * const output_buffer_it = *output_buffer;
 			const float * const input_buffer_it = *input_buffers[0];
 
-			const int total_workload = entry_count * neuron_count_per_feature_map;
-			const int openmp_thread_count = plain_config->openmp_thread_count;
-			
-			#pragma omp parallel default(none) num_threads(openmp_thread_count)
-			{
-				int thread_id = 0;
-				#ifdef _OPENMP
-				thread_id = omp_get_thread_num();
-				#endif
+			// Each workload item covers a run of consecutive neurons, so that the kernel vectorizes across them
+			const int neuron_chunk_size = static_cast<int>(std::min(neuron_count_per_feature_map, neuron_chunk_elem_count));
+			const int neuron_chunk_count = (static_cast<int>(neuron_count_per_feature_map) + neuron_chunk_size - 1) / neuron_chunk_size;
+			const int total_workload = entry_count * neuron_chunk_count;
+			const simd_kernels_plain& kernels = simd_kernels_plain::get_singleton();
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int entry_id = workload_id / neuron_count_per_feature_map;
-					int neuron_id = workload_id - (entry_id * neuron_count_per_feature_map);
-					const float * in_it = input_buffer_it + (entry_id * neuron_count) + neuron_id;
-					float * out_it = output_buffer_it + (entry_id * neuron_count) + neuron_id;
-
-					float max_val = -1.0e+37F;
-					for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
-					{
-						float val = *(in_it + (feature_map_id * neuron_count_per_feature_map));
-						max_val = std::max(max_val, val);
-					}
+			#pragma omp parallel for default(shared) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / neuron_chunk_count;
+				int neuron_id = (workload_id - (entry_id * neuron_chunk_count)) * neuron_chunk_size;
 
-					float sum = 0.0F;
-					for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
-					{
-						float val = expf((*(in_it + (feature_map_id * neuron_count_per_feature_map))) - max_val);
-						sum += val;
-						*(out_it + (feature_map_id * neuron_count_per_feature_map)) = val;
-					}
-					float mult = 1.0F / sum;
-					for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
-						*(out_it + (feature_map_id * neuron_count_per_feature_map)) *= mult;
-				} // for(int workload_id
-			} // #pragma parallel
+				kernels.softmax(
+					output_buffer_it + (entry_id * neuron_count) + neuron_id,
+					input_buffer_it + (entry_id * neuron_count) + neuron_id,
+					feature_map_count,
+					neuron_count_per_feature_map,
+					std::min(neuron_chunk_size, static_cast<int>(neuron_count_per_feature_map) - neuron_id));
+			}
 		}
 
 		int softmax_layer_tester_plain::get_input_index_layer_can_write(
@@ -0,0 +1,231 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "task_scheduler_plain.h"
+
+#include "../neural_network_exception.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		task_scheduler_plain::task_scheduler_plain(
+			unsigned int worker_count,
+			const std::vector<std::vector<unsigned int> >& dependencies)
+			: worker_count(std::max(worker_count, 1U))
+			, dependents(dependencies.size())
+			, dependency_counts(dependencies.size())
+			, pending_dependency_counts(new std::atomic<unsigned int>[dependencies.size()])
+			, remaining_task_count(0)
+			, ready_task_count(0)
+			, running_task_count(0)
+			, failed(false)
+			, current_func(0)
+			, run_id(0)
+			, stop(false)
+			, active_worker_count(0)
+		{
+			for(unsigned int task_id = 0; task_id < static_cast<unsigned int>(dependencies.size()); ++task_id)
+			{
+				dependency_counts[task_id] = static_cast<unsigned int>(dependencies[task_id].size());
+				for(std::vector<unsigned int>::const_iterator it = dependencies[task_id].begin(); it != dependencies[task_id].end(); ++it)
+					dependents[*it].push_back(task_id);
+			}
+
+			for(unsigned int worker_id = 0; worker_id < this->worker_count; ++worker_id)
+				queues.push_back(std::shared_ptr<worker_queue>(new worker_queue()));
+
+			for(unsigned int worker_id = 1; worker_id < this->worker_count; ++worker_id)
+				threads.push_back(std::thread(&task_scheduler_plain::worker_thread_func, this, worker_id));
+		}
+
+		task_scheduler_plain::~task_scheduler_plain()
+		{
+			{
+				std::lock_guard<std::mutex> lock(state_mutex);
+				stop = true;
+				run_started_condition.notify_all();
+			}
+			for(std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+				it->join();
+		}
+
+		unsigned int task_scheduler_plain::get_worker_count() const
+		{
+			return worker_count;
+		}
+
+		void task_scheduler_plain::run(const task_function& func)
+		{
+			const unsigned int task_count = static_cast<unsigned int>(dependency_counts.size());
+			if (task_count == 0)
+				return;
+
+			remaining_task_count = task_count;
+			running_task_count = 0;
+			failed = false;
+			error_message.clear();
+			current_func = &func;
+
+			// Spread the tasks having no dependencies across the workers
+			unsigned int root_count = 0;
+			for(unsigned int task_id = 0; task_id < task_count; ++task_id)
+			{
+				pending_dependency_counts[task_id] = dependency_counts[task_id];
+				if (dependency_counts[task_id] == 0)
+				{
+					queues[root_count % worker_count]->tasks.push_back(task_id);
+					++root_count;
+				}
+			}
+			ready_task_count = root_count;
+
+			{
+				std::lock_guard<std::mutex> lock(state_mutex);
+				++run_id;
+				active_worker_count = worker_count - 1;
+				run_started_condition.notify_all();
+			}
+
+			process_tasks(0);
+
+			{
+				std::unique_lock<std::mutex> lock(state_mutex);
+				while (active_worker_count > 0)
+					run_finished_condition.wait(lock);
+			}
+			current_func = 0;
+
+			if (failed)
+				throw neural_network_exception(error_message);
+		}
+
+		void task_scheduler_plain::worker_thread_func(unsigned int worker_id)
+		{
+			unsigned int last_run_id = 0;
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(state_mutex);
+					while ((!stop) && (run_id == last_run_id))
+						run_started_condition.wait(lock);
+					if (stop)
+						return;
+					last_run_id = run_id;
+				}
+
+				process_tasks(worker_id);
+
+				{
+					// Notify under the lock, run may return and the scheduler may be destroyed as soon as the count drops
+					std::lock_guard<std::mutex> lock(state_mutex);
+					--active_worker_count;
+					run_finished_condition.notify_all();
+				}
+			}
+		}
+
+		void task_scheduler_plain::process_tasks(unsigned int worker_id)
+		{
+			while (remaining_task_count > 0)
+			{
+				unsigned int task_id;
+				if (!pop_task(worker_id, task_id))
+				{
+					std::unique_lock<std::mutex> lock(state_mutex);
+					while ((ready_task_count == 0) && (remaining_task_count > 0))
+						task_ready_condition.wait(lock);
+					continue;
+				}
+
+				--ready_task_count;
+				unsigned int concurrency = std::min(++running_task_count + ready_task_count, worker_count);
+				if (!failed)
+				{
+					try
+					{
+						(*current_func)(task_id, worker_id, concurrency);
+					}
+					catch (const std::exception& e)
+					{
+						std::lock_guard<std::mutex> lock(state_mutex);
+						if (!failed)
+							error_message = e.what();
+						failed = true;
+					}
+				}
+				--running_task_count;
+
+				unsigned int new_ready_task_count = 0;
+				for(std::vector<unsigned int>::const_iterator it = dependents[task_id].begin(); it != dependents[task_id].end(); ++it)
+				{
+					if (--pending_dependency_counts[*it] == 0)
+					{
+						push_task(worker_id, *it);
+						++new_ready_task_count;
+					}
+				}
+
+				bool last_task = (--remaining_task_count == 0);
+
+				// This worker takes one of the new tasks itself, wake up others for the rest
+				if (last_task || (new_ready_task_count > 1))
+				{
+					std::lock_guard<std::mutex> lock(state_mutex);
+					task_ready_condition.notify_all();
+				}
+			}
+		}
+
+		bool task_scheduler_plain::pop_task(unsigned int worker_id, unsigned int& task_id)
+		{
+			{
+				worker_queue& own_queue = *queues[worker_id];
+				std::lock_guard<std::mutex> lock(own_queue.tasks_mutex);
+				if (!own_queue.tasks.empty())
+				{
+					task_id = own_queue.tasks.back();
+					own_queue.tasks.pop_back();
+					return true;
+				}
+			}
+
+			for(unsigned int i = 1; i < worker_count; ++i)
+			{
+				worker_queue& victim_queue = *queues[(worker_id + i) % worker_count];
+				std::lock_guard<std::mutex> lock(victim_queue.tasks_mutex);
+				if (!victim_queue.tasks.empty())
+				{
+					task_id = victim_queue.tasks.front();
+					victim_queue.tasks.pop_front();
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		void task_scheduler_plain::push_task(unsigned int worker_id, unsigned int task_id)
+		{
+			worker_queue& own_queue = *queues[worker_id];
+			std::lock_guard<std::mutex> lock(own_queue.tasks_mutex);
+			own_queue.tasks.push_back(task_id);
+			++ready_task_count;
+		}
+	}
+}
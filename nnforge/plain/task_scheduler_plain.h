@@ -0,0 +1,112 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Runs a DAG of tasks on a fixed set of worker threads, the threads are kept between runs.
+		// Each worker owns a deque of ready tasks: it takes the most recently readied task from the back
+		// and, once its deque is empty, steals the oldest task from the front of the other workers' deques.
+		class task_scheduler_plain
+		{
+		public:
+			typedef std::shared_ptr<task_scheduler_plain> ptr;
+
+			// task_id, worker_id and the number of tasks running or ready to run when the task starts (1 to worker_count)
+			typedef std::function<void(unsigned int, unsigned int, unsigned int)> task_function;
+
+			// dependencies[task_id] lists the tasks which should finish before task_id starts
+			task_scheduler_plain(
+				unsigned int worker_count,
+				const std::vector<std::vector<unsigned int> >& dependencies);
+
+			// Stops the worker threads
+			~task_scheduler_plain();
+
+			// Runs all the tasks once, the calling thread serves as worker 0.
+			// Once a task fails the remaining ones are skipped and the error is rethrown
+			void run(const task_function& func);
+
+			unsigned int get_worker_count() const;
+
+		private:
+			class worker_queue
+			{
+			public:
+				worker_queue() = default;
+
+				std::deque<unsigned int> tasks;
+				std::mutex tasks_mutex;
+
+			private:
+				worker_queue(const worker_queue&) = delete;
+				worker_queue& operator =(const worker_queue&) = delete;
+			};
+
+			void worker_thread_func(unsigned int worker_id);
+
+			void process_tasks(unsigned int worker_id);
+
+			bool pop_task(unsigned int worker_id, unsigned int& task_id);
+
+			void push_task(unsigned int worker_id, unsigned int task_id);
+
+		private:
+			unsigned int worker_count;
+			std::vector<std::vector<unsigned int> > dependents;
+			std::vector<unsigned int> dependency_counts;
+
+			std::vector<std::shared_ptr<worker_queue> > queues;
+			std::vector<std::thread> threads;
+
+			std::unique_ptr<std::atomic<unsigned int>[]> pending_dependency_counts;
+			std::atomic<unsigned int> remaining_task_count;
+			std::atomic<unsigned int> ready_task_count;
+			std::atomic<unsigned int> running_task_count;
+			std::atomic<bool> failed;
+
+			const task_function * current_func;
+
+			// Guards run_id, stop, active_worker_count and error_message, and serves the conditions
+			std::mutex state_mutex;
+			std::condition_variable run_started_condition;
+			std::condition_variable task_ready_condition;
+			std::condition_variable run_finished_condition;
+			unsigned int run_id;
+			bool stop;
+			unsigned int active_worker_count;
+			std::string error_message;
+
+		private:
+			task_scheduler_plain() = delete;
+			task_scheduler_plain(const task_scheduler_plain&) = delete;
+			task_scheduler_plain& operator =(const task_scheduler_plain&) = delete;
+		};
+	}
+}
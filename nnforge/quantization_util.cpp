@@ -0,0 +1,372 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "quantization_util.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NNFORGE_QUANTIZATION_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define NNFORGE_QUANTIZATION_TARGET(isa)
+#else
+#include <cpuid.h>
+#define NNFORGE_QUANTIZATION_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace nnforge
+{
+	namespace
+	{
+		typedef void (*dequantize_func)(float *, const void *, int, float, float);
+
+		void dequantize_uint8_scalar(
+			float * output,
+			const void * input,
+			int elem_count,
+			float scale,
+			float offset)
+		{
+			const unsigned char * in = static_cast<const unsigned char *>(input);
+			for(int i = 0; i < elem_count; ++i)
+				output[i] = static_cast<float>(in[i]) * scale + offset;
+		}
+
+		void dequantize_fp16_scalar(
+			float * output,
+			const void * input,
+			int elem_count,
+			float scale,
+			float offset)
+		{
+			const unsigned short * in = static_cast<const unsigned short *>(input);
+			for(int i = 0; i < elem_count; ++i)
+				output[i] = quantization_util::half_to_float(in[i]) * scale + offset;
+		}
+
+#ifdef NNFORGE_QUANTIZATION_X86
+		NNFORGE_QUANTIZATION_TARGET("sse2")
+		void dequantize_uint8_sse2(
+			float * output,
+			const void * input,
+			int elem_count,
+			float scale,
+			float offset)
+		{
+			const unsigned char * in = static_cast<const unsigned char *>(input);
+			const __m128 s = _mm_set1_ps(scale);
+			const __m128 o = _mm_set1_ps(offset);
+			const __m128i zero = _mm_setzero_si128();
+			int i = 0;
+			for(; i + 16 <= elem_count; i += 16)
+			{
+				__m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+				__m128i v16lo = _mm_unpacklo_epi8(v8, zero);
+				__m128i v16hi = _mm_unpackhi_epi8(v8, zero);
+				_mm_storeu_ps(output + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v16lo, zero)), s), o));
+				_mm_storeu_ps(output + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v16lo, zero)), s), o));
+				_mm_storeu_ps(output + i + 8, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v16hi, zero)), s), o));
+				_mm_storeu_ps(output + i + 12, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v16hi, zero)), s), o));
+			}
+			dequantize_uint8_scalar(output + i, in + i, elem_count - i, scale, offset);
+		}
+
+		NNFORGE_QUANTIZATION_TARGET("avx2")
+		void dequantize_uint8_avx2(
+			float * output,
+			const void * input,
+			int elem_count,
+			float scale,
+			float offset)
+		{
+			const unsigned char * in = static_cast<const unsigned char *>(input);
+			const __m256 s = _mm256_set1_ps(scale);
+			const __m256 o = _mm256_set1_ps(offset);
+			int i = 0;
+			for(; i + 16 <= elem_count; i += 16)
+			{
+				__m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+				__m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v8));
+				__m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v8, 8)));
+				_mm256_storeu_ps(output + i, _mm256_add_ps(_mm256_mul_ps(lo, s), o));
+				_mm256_storeu_ps(output + i + 8, _mm256_add_ps(_mm256_mul_ps(hi, s), o));
+			}
+			dequantize_uint8_scalar(output + i, in + i, elem_count - i, scale, offset);
+		}
+
+		NNFORGE_QUANTIZATION_TARGET("avx,f16c")
+		void dequantize_fp16_f16c(
+			float * output,
+			const void * input,
+			int elem_count,
+			float scale,
+			float offset)
+		{
+			const unsigned short * in = static_cast<const unsigned short *>(input);
+			const __m256 s = _mm256_set1_ps(scale);
+			const __m256 o = _mm256_set1_ps(offset);
+			int i = 0;
+			for(; i + 8 <= elem_count; i += 8)
+			{
+				__m256 v = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)));
+				_mm256_storeu_ps(output + i, _mm256_add_ps(_mm256_mul_ps(v, s), o));
+			}
+			dequantize_fp16_scalar(output + i, in + i, elem_count - i, scale, offset);
+		}
+
+		void cpuid(int leaf, unsigned int regs[4])
+		{
+			#ifdef _MSC_VER
+			int r[4];
+			__cpuidex(r, leaf, 0);
+			for(int i = 0; i < 4; ++i)
+				regs[i] = static_cast<unsigned int>(r[i]);
+			#else
+			__cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+			#endif
+		}
+
+		unsigned long long xgetbv()
+		{
+			#ifdef _MSC_VER
+			return _xgetbv(0);
+			#else
+			unsigned int eax;
+			unsigned int edx;
+			__asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return (static_cast<unsigned long long>(edx) << 32) | eax;
+			#endif
+		}
+#endif
+
+		struct dequantize_kernels
+		{
+			dequantize_kernels()
+				: uint8(dequantize_uint8_scalar)
+				, fp16(dequantize_fp16_scalar)
+			{
+				#ifdef NNFORGE_QUANTIZATION_X86
+				unsigned int regs[4];
+				cpuid(0, regs);
+				const unsigned int max_leaf = regs[0];
+				if (max_leaf < 1)
+					return;
+
+				cpuid(1, regs);
+				const bool sse2 = (regs[3] & (1U << 26)) != 0;
+				const bool osxsave = (regs[2] & (1U << 27)) != 0;
+				const bool avx = (regs[2] & (1U << 28)) != 0;
+				const bool f16c = (regs[2] & (1U << 29)) != 0;
+
+				bool avx2 = false;
+				if (max_leaf >= 7)
+				{
+					cpuid(7, regs);
+					avx2 = (regs[1] & (1U << 5)) != 0;
+				}
+
+				const bool os_ymm = osxsave && ((xgetbv() & 0x6) == 0x6);
+
+				if (avx && avx2 && os_ymm)
+					uint8 = dequantize_uint8_avx2;
+				else if (sse2)
+					uint8 = dequantize_uint8_sse2;
+				if (avx && f16c && os_ymm)
+					fp16 = dequantize_fp16_f16c;
+				#endif
+			}
+
+			dequantize_func uint8;
+			dequantize_func fp16;
+		};
+
+		const dequantize_kernels& get_dequantize_kernels()
+		{
+			static const dequantize_kernels kernels;
+			return kernels;
+		}
+	}
+
+	unsigned int quantization_util::get_elem_size(quantized_type type)
+	{
+		switch (type)
+		{
+		case quantized_type_uint8:
+			return sizeof(unsigned char);
+		case quantized_type_fp16:
+			return sizeof(unsigned short);
+		default:
+			throw neural_network_exception((boost::format("Unknown quantized type %1%") % type).str());
+		}
+	}
+
+	quantization_util::quantized_type quantization_util::get_quantized_type(const std::string& name)
+	{
+		if (name == "uint8")
+			return quantized_type_uint8;
+		else if (name == "fp16")
+			return quantized_type_fp16;
+		else
+			throw neural_network_exception((boost::format("Unknown quantized type %1%") % name).str());
+	}
+
+	const char * quantization_util::get_quantized_type_name(quantized_type type)
+	{
+		switch (type)
+		{
+		case quantized_type_uint8:
+			return "uint8";
+		case quantized_type_fp16:
+			return "fp16";
+		default:
+			throw neural_network_exception((boost::format("Unknown quantized type %1%") % type).str());
+		}
+	}
+
+	void quantization_util::dequantize(
+		quantized_type type,
+		float * output,
+		const void * input,
+		int elem_count,
+		float scale,
+		float offset)
+	{
+		const dequantize_kernels& kernels = get_dequantize_kernels();
+		switch (type)
+		{
+		case quantized_type_uint8:
+			kernels.uint8(output, input, elem_count, scale, offset);
+			break;
+		case quantized_type_fp16:
+			kernels.fp16(output, input, elem_count, scale, offset);
+			break;
+		default:
+			throw neural_network_exception((boost::format("Unknown quantized type %1%") % type).str());
+		}
+	}
+
+	void quantization_util::quantize(
+		quantized_type type,
+		void * output,
+		const float * input,
+		int elem_count,
+		float scale,
+		float offset)
+	{
+		float mult = 1.0F / scale;
+		switch (type)
+		{
+		case quantized_type_uint8:
+			{
+				unsigned char * out = static_cast<unsigned char *>(output);
+				for(int i = 0; i < elem_count; ++i)
+					out[i] = static_cast<unsigned char>(std::min(std::max(floorf((input[i] - offset) * mult + 0.5F), 0.0F), 255.0F));
+			}
+			break;
+		case quantized_type_fp16:
+			{
+				unsigned short * out = static_cast<unsigned short *>(output);
+				for(int i = 0; i < elem_count; ++i)
+					out[i] = float_to_half((input[i] - offset) * mult);
+			}
+			break;
+		default:
+			throw neural_network_exception((boost::format("Unknown quantized type %1%") % type).str());
+		}
+	}
+
+	unsigned short quantization_util::float_to_half(float val)
+	{
+		unsigned int x;
+		memcpy(&x, &val, sizeof(x));
+
+		unsigned int sign = (x >> 16) & 0x8000;
+		unsigned int mantissa = x & 0x007FFFFF;
+		int exponent = static_cast<int>((x >> 23) & 0xFF);
+
+		// Inf and NaN
+		if (exponent == 0xFF)
+			return static_cast<unsigned short>(sign | 0x7C00 | (mantissa ? 0x0200 : 0));
+
+		exponent = exponent - 127 + 15;
+		if (exponent >= 0x1F)
+			return static_cast<unsigned short>(sign | 0x7C00);
+
+		// Subnormal half or zero
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+				return static_cast<unsigned short>(sign);
+			mantissa |= 0x00800000;
+			unsigned int shift = static_cast<unsigned int>(14 - exponent);
+			unsigned int res = mantissa >> shift;
+			unsigned int remainder = mantissa & ((1U << shift) - 1);
+			unsigned int halfway = 1U << (shift - 1);
+			if ((remainder > halfway) || ((remainder == halfway) && (res & 1)))
+				++res;
+			return static_cast<unsigned short>(sign | res);
+		}
+
+		// Rounding carry propagates into the exponent, up to infinity
+		unsigned int res = (static_cast<unsigned int>(exponent) << 10) | (mantissa >> 13);
+		unsigned int remainder = mantissa & 0x1FFF;
+		if ((remainder > 0x1000) || ((remainder == 0x1000) && (res & 1)))
+			++res;
+		return static_cast<unsigned short>(sign | res);
+	}
+
+	float quantization_util::half_to_float(unsigned short val)
+	{
+		unsigned int sign = (static_cast<unsigned int>(val) & 0x8000) << 16;
+		int exponent = (val >> 10) & 0x1F;
+		unsigned int mantissa = val & 0x03FF;
+
+		unsigned int x;
+		if (exponent == 0)
+		{
+			if (mantissa == 0)
+				x = sign;
+			else
+			{
+				// Subnormal half is a normal float
+				exponent = 1;
+				while (!(mantissa & 0x0400))
+				{
+					mantissa <<= 1;
+					--exponent;
+				}
+				mantissa &= 0x03FF;
+				x = sign | (static_cast<unsigned int>(exponent + 112) << 23) | (mantissa << 13);
+			}
+		}
+		else if (exponent == 0x1F)
+			x = sign | 0x7F800000 | (mantissa << 13);
+		else
+			x = sign | (static_cast<unsigned int>(exponent + 112) << 23) | (mantissa << 13);
+
+		float res;
+		memcpy(&res, &x, sizeof(res));
+		return res;
+	}
+}
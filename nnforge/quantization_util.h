@@ -0,0 +1,68 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+namespace nnforge
+{
+	// Compact storage of float data: value = stored * scale + offset.
+	// Dequantization picks the widest instruction set supported by both the CPU and the OS at run time
+	class quantization_util
+	{
+	public:
+		enum quantized_type
+		{
+			quantized_type_uint8 = 0,
+			quantized_type_fp16 = 1
+		};
+
+		static unsigned int get_elem_size(quantized_type type);
+
+		// Throws if name is neither uint8 nor fp16
+		static quantized_type get_quantized_type(const std::string& name);
+
+		static const char * get_quantized_type_name(quantized_type type);
+
+		// output[i] = input[i] * scale + offset, input holds elem_count elements of the type specified
+		static void dequantize(
+			quantized_type type,
+			float * output,
+			const void * input,
+			int elem_count,
+			float scale,
+			float offset);
+
+		// Inverse of dequantize, uint8 values are rounded to nearest and saturated
+		static void quantize(
+			quantized_type type,
+			void * output,
+			const float * input,
+			int elem_count,
+			float scale,
+			float offset);
+
+		// IEEE 754 binary16 conversions, rounding to nearest even
+		static unsigned short float_to_half(float val);
+
+		static float half_to_float(unsigned short val);
+
+	private:
+		quantization_util() = delete;
+		~quantization_util() = delete;
+	};
+}
@@ -36,6 +36,14 @@ namespace nnforge
 			unsigned int entry_id,
 			std::vector<unsigned char>& all_elems) = 0;
 
+		// Zero-copy variant: data is set to the entry kept by the reader, the memory stays valid while the reader exists.
+		// The method returns false in case the entry cannot be read or the reader doesn't keep entries in memory,
+		// the copying overload should be used then
+		virtual bool raw_read(
+			unsigned int entry_id,
+			const unsigned char *& data,
+			size_t& data_length);
+
 		// The method should return -1 if entry count is unknown
 		virtual int get_entry_count() const = 0;
 
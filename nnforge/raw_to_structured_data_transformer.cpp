@@ -22,4 +22,15 @@ namespace nnforge
 	{
 		return 1;
 	}
+
+	void raw_to_structured_data_transformer::transform(
+		unsigned int sample_id,
+		const unsigned char * raw_data,
+		size_t raw_data_length,
+		float * structured_data,
+		counter_random_generator& gen)
+	{
+		std::vector<unsigned char> raw_data_copy(raw_data, raw_data + raw_data_length);
+		transform(sample_id, raw_data_copy, structured_data);
+	}
 }
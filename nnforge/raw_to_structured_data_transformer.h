@@ -17,6 +17,7 @@
 #pragma once
 
 #include "layer_configuration_specific.h"
+#include "rnd.h"
 
 #include <vector>
 #include <memory>
@@ -35,6 +36,16 @@ namespace nnforge
 			const std::vector<unsigned char>& raw_data,
 			float * structured_data) = 0;
 
+		// Transforms raw data the transformer doesn't own, a memory mapped file for example.
+		// Randomized transformers draw all the random parameters from gen, which is private to the entry being transformed.
+		// The default implementation copies raw data into a vector and calls the overload above, ignoring gen
+		virtual void transform(
+			unsigned int sample_id,
+			const unsigned char * raw_data,
+			size_t raw_data_length,
+			float * structured_data,
+			counter_random_generator& gen);
+
 		virtual layer_configuration_specific get_configuration() const = 0;
 
 		virtual unsigned int get_sample_count() const;
@@ -1,9 +1,49 @@
 #include "rnd.h"
 
 #include <chrono>
+#include <atomic>
 
 namespace nnforge
 {
+	namespace
+	{
+		// SplitMix64 finalizer
+		unsigned long long mix64(unsigned long long z)
+		{
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+	}
+
+	counter_random_generator::counter_random_generator(
+		unsigned int seed,
+		unsigned int epoch_id,
+		unsigned int entry_id,
+		unsigned int stream_id)
+		: key(mix64(mix64((static_cast<unsigned long long>(seed) << 32) | epoch_id) ^ ((static_cast<unsigned long long>(entry_id) << 32) | stream_id)))
+		, counter(0)
+	{
+	}
+
+	counter_random_generator::result_type counter_random_generator::operator()()
+	{
+		++counter;
+		return static_cast<result_type>(mix64(key + counter * 0x9E3779B97F4A7C15ULL) >> 32);
+	}
+
+	void counter_random_generator::discard(unsigned long long z)
+	{
+		counter += z;
+	}
+
+	counter_random_generator rnd::get_counter_random_generator()
+	{
+		static const unsigned int seed = get_time_dependent_seed();
+		static std::atomic<unsigned int> call_count(0);
+		return counter_random_generator(seed, 0, call_count++);
+	}
+
 	random_generator rnd::get_random_generator()
 	{
 		return get_random_generator(get_time_dependent_seed());
@@ -22,6 +22,39 @@ namespace nnforge
 {
 	typedef std::mt19937 random_generator;
 
+	// Counter-based generator: the output is a hash of the key and the running counter.
+	// Streams are cheap to create, so each entry gets its own one, deterministic given (seed, epoch, entry, stream)
+	// and independent of which thread processes the entry and when
+	class counter_random_generator
+	{
+	public:
+		typedef unsigned int result_type;
+
+		counter_random_generator(
+			unsigned int seed,
+			unsigned int epoch_id = 0,
+			unsigned int entry_id = 0,
+			unsigned int stream_id = 0);
+
+		result_type operator()();
+
+		void discard(unsigned long long z);
+
+		static constexpr result_type min()
+		{
+			return 0;
+		}
+
+		static constexpr result_type max()
+		{
+			return 0xFFFFFFFFU;
+		}
+
+	private:
+		unsigned long long key;
+		unsigned long long counter;
+	};
+
 	class rnd
 	{
 	public:
@@ -29,6 +62,10 @@ namespace nnforge
 
 		static random_generator get_random_generator(unsigned int seed);
 
+		// For callers having no epoch and entry to key the stream with: streams are keyed with a process wide atomic counter.
+		// No lock is taken, though the result depends on the order of calls
+		static counter_random_generator get_counter_random_generator();
+
 		static unsigned int get_time_dependent_seed();
 
 	private:
@@ -22,13 +22,12 @@
 #include <boost/format.hpp>
 
 #include <memory>
+#include <cstring>
 
 namespace nnforge
 {
 	rotate_band_data_transformer::rotate_band_data_transformer(const std::vector<unsigned int>& max_absolute_band_rotations)
 	{
-		generator = rnd::get_random_generator();
-
 		for(std::vector<unsigned int>::const_iterator it = max_absolute_band_rotations.begin(); it != max_absolute_band_rotations.end(); ++it)
 			rotate_band_distributions.push_back(std::uniform_int_distribution<int>(-static_cast<int>(*it), static_cast<int>(*it)));
 	}
@@ -38,6 +37,17 @@ namespace nnforge
 		float * data_transformed,
 		const layer_configuration_specific& original_config,
 		unsigned int sample_id)
+	{
+		counter_random_generator gen = rnd::get_counter_random_generator();
+		transform(data, data_transformed, original_config, sample_id, gen);
+	}
+
+	void rotate_band_data_transformer::transform(
+		const float * data,
+		float * data_transformed,
+		const layer_configuration_specific& original_config,
+		unsigned int sample_id,
+		counter_random_generator& gen)
 	{
 		const std::vector<unsigned int>& dimension_sizes = original_config.dimension_sizes;
 
@@ -50,19 +60,15 @@ namespace nnforge
 		std::vector<unsigned int> src_pos_list;
 		std::vector<unsigned int>::const_iterator it2 = dimension_sizes.begin();
 
+		for(std::vector<std::uniform_int_distribution<int> >::iterator it = rotate_band_distributions.begin(); it != rotate_band_distributions.end(); ++it, ++it2)
 		{
-			std::lock_guard<std::mutex> lock(gen_stream_mutex);
-
-			for(std::vector<std::uniform_int_distribution<int> >::iterator it = rotate_band_distributions.begin(); it != rotate_band_distributions.end(); ++it, ++it2)
-			{
-				std::uniform_int_distribution<int>& rotate_band_distribution = *it;
-				int rotate_band = rotate_band_distribution.min();
-				if (rotate_band_distribution.max() > rotate_band_distribution.min())
-					rotate_band = rotate_band_distribution(generator);
-				if (rotate_band < 0)
-					rotate_band += *it2;
-				src_pos_list.push_back(rotate_band);
-			}
+			std::uniform_int_distribution<int>& rotate_band_distribution = *it;
+			int rotate_band = rotate_band_distribution.min();
+			if (rotate_band_distribution.max() > rotate_band_distribution.min())
+				rotate_band = rotate_band_distribution(gen);
+			if (rotate_band < 0)
+				rotate_band += *it2;
+			src_pos_list.push_back(rotate_band);
 		}
 
 		std::vector<unsigned int> dst_pos_list(dimension_sizes.size(), 0);
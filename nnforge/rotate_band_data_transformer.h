@@ -19,7 +19,6 @@
 #include "data_transformer.h"
 #include "rnd.h"
 
-#include <mutex>
 
 namespace nnforge
 {
@@ -35,11 +34,15 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual void transform(
+			const float * data,
+			float * data_transformed,
+			const layer_configuration_specific& original_config,
+			unsigned int sample_id,
+			counter_random_generator& gen);
 			
 	protected:
-		random_generator generator;
-		std::mutex gen_stream_mutex;
-
 		std::vector<std::uniform_int_distribution<int> > rotate_band_distributions;
 	};
 }
@@ -18,13 +18,17 @@
 
 #include "neural_network_exception.h"
 
-#include <boost/filesystem/fstream.hpp>
 #include <boost/format.hpp>
+#include <chrono>
+#include <iostream>
 
 namespace nnforge
 {
-	save_snapshot_network_data_pusher::save_snapshot_network_data_pusher(const boost::filesystem::path& folder_path)
+	save_snapshot_network_data_pusher::save_snapshot_network_data_pusher(
+		const boost::filesystem::path& folder_path,
+		network_data_async_writer::ptr writer)
 		: folder_path(folder_path)
+		, writer(writer)
 	{
 	}
 
@@ -32,41 +36,31 @@ namespace nnforge
 		const training_task_state& task_state,
 		const network_schema& schema)
 	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		float wait_seconds = 0.0F;
+
 		unsigned int index = task_state.index_peeked;
 
 		std::string data_folder_name = (boost::format("ann_trained_%|1$03d|_epoch_%|2$05d|") % index % task_state.get_current_epoch()).str();
-		save_data_to_file(task_state.data, data_folder_name);
+		wait_seconds += writer->write(*task_state.data, folder_path / data_folder_name);
 
 		{
 			std::string momentum_data_folder_name = (boost::format("momentum_%|1$03d|") % index).str();
 			if (task_state.momentum_data)
-				save_data_to_file(task_state.momentum_data, momentum_data_folder_name);
+				wait_seconds += writer->write(*task_state.momentum_data, folder_path / momentum_data_folder_name);
 			else
-				boost::filesystem::remove_all(folder_path / momentum_data_folder_name);
+				wait_seconds += writer->remove(folder_path / momentum_data_folder_name);
 		}
 
 		{
 			std::string momentum2_data_folder_name = (boost::format("momentum2_%|1$03d|") % index).str();
 			if (task_state.momentum_data2)
-				save_data_to_file(task_state.momentum_data2, momentum2_data_folder_name);
+				wait_seconds += writer->write(*task_state.momentum_data2, folder_path / momentum2_data_folder_name);
 			else
-				boost::filesystem::remove_all(folder_path / momentum2_data_folder_name);
+				wait_seconds += writer->remove(folder_path / momentum2_data_folder_name);
 		}
-	}
-
-	void save_snapshot_network_data_pusher::save_data_to_file(
-		network_data::const_ptr data,
-		std::string folder_name) const
-	{
-		std::string temp_folder_name = folder_name + ".temp";
-
-		boost::filesystem::path temp_full_folder_path = folder_path / temp_folder_name;
-		data->write(temp_full_folder_path);
-
-		boost::filesystem::path full_folder_path = folder_path / folder_name;
-		if (boost::filesystem::exists(full_folder_path))
-			boost::filesystem::remove_all(full_folder_path);
 
-		boost::filesystem::rename(temp_full_folder_path, full_folder_path);
+		std::chrono::duration<float> sec = std::chrono::high_resolution_clock::now() - start;
+		std::cout << (boost::format("Snapshot queued, training blocked for %|1$.2f| seconds (%|2$.2f| seconds waiting for the writer)") % sec.count() % wait_seconds).str() << std::endl;
 	}
 }
@@ -17,15 +17,19 @@
 #pragma once
 
 #include "network_data_pusher.h"
+#include "network_data_async_writer.h"
 
 #include <boost/filesystem.hpp>
 
 namespace nnforge
 {
+	// Snapshots are copied in push and written to disk by the writer in the background
 	class save_snapshot_network_data_pusher : public network_data_pusher
 	{
 	public:
-		save_snapshot_network_data_pusher(const boost::filesystem::path& folder_path);
+		save_snapshot_network_data_pusher(
+			const boost::filesystem::path& folder_path,
+			network_data_async_writer::ptr writer);
 
 		virtual ~save_snapshot_network_data_pusher() = default;
 
@@ -33,12 +37,8 @@ namespace nnforge
 			const training_task_state& task_state,
 			const network_schema& schema);
 
-	private:
-		void save_data_to_file(
-			network_data::const_ptr data,
-			std::string folder_name) const;
-
 	private:
 		boost::filesystem::path folder_path;
+		network_data_async_writer::ptr writer;
 	};
 }
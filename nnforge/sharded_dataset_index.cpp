@@ -0,0 +1,107 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "sharded_dataset_index.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+namespace nnforge
+{
+	// {90BDFFDB-7418-4F97-9B5B-C617CB24F93E}
+	const boost::uuids::uuid sharded_dataset_index::sharded_dataset_index_guid =
+	{ 0x90, 0xbd, 0xff, 0xdb
+	, 0x74, 0x18
+	, 0x4f, 0x97
+	, 0x9b, 0x5b
+	, 0xc6, 0x17, 0xcb, 0x24, 0xf9, 0x3e };
+
+	sharded_dataset_index::sharded_dataset_index(const std::vector<unsigned int>& shard_entry_count_list)
+		: shard_entry_count_list(shard_entry_count_list)
+	{
+		unsigned int first_entry_id = 0;
+		for(std::vector<unsigned int>::const_iterator it = shard_entry_count_list.begin(); it != shard_entry_count_list.end(); ++it)
+		{
+			first_entry_id_list.push_back(first_entry_id);
+			first_entry_id += *it;
+		}
+	}
+
+	void sharded_dataset_index::write(std::ostream& output_stream) const
+	{
+		output_stream.exceptions(std::ostream::failbit | std::ostream::badbit);
+
+		output_stream.write(reinterpret_cast<const char*>(sharded_dataset_index_guid.data), sizeof(sharded_dataset_index_guid.data));
+
+		unsigned int shard_count = static_cast<unsigned int>(shard_entry_count_list.size());
+		output_stream.write(reinterpret_cast<const char*>(&shard_count), sizeof(shard_count));
+		for(unsigned int shard_id = 0; shard_id < shard_count; ++shard_id)
+		{
+			output_stream.write(reinterpret_cast<const char*>(&first_entry_id_list[shard_id]), sizeof(unsigned int));
+			output_stream.write(reinterpret_cast<const char*>(&shard_entry_count_list[shard_id]), sizeof(unsigned int));
+		}
+
+		output_stream.flush();
+	}
+
+	void sharded_dataset_index::read(std::istream& input_stream)
+	{
+		input_stream.exceptions(std::istream::failbit | std::istream::badbit);
+
+		boost::uuids::uuid guid_read;
+		input_stream.read(reinterpret_cast<char*>(guid_read.data), sizeof(guid_read.data));
+		if (guid_read != sharded_dataset_index_guid)
+			throw neural_network_exception((boost::format("Unknown sharded dataset index GUID encountered in input stream: %1%") % guid_read).str());
+
+		unsigned int shard_count;
+		input_stream.read(reinterpret_cast<char*>(&shard_count), sizeof(shard_count));
+		shard_entry_count_list.resize(shard_count);
+		first_entry_id_list.resize(shard_count);
+		unsigned int expected_first_entry_id = 0;
+		for(unsigned int shard_id = 0; shard_id < shard_count; ++shard_id)
+		{
+			input_stream.read(reinterpret_cast<char*>(&first_entry_id_list[shard_id]), sizeof(unsigned int));
+			input_stream.read(reinterpret_cast<char*>(&shard_entry_count_list[shard_id]), sizeof(unsigned int));
+			if (first_entry_id_list[shard_id] != expected_first_entry_id)
+				throw neural_network_exception((boost::format("Shard %1% starts at entry %2% while %3% is expected") % shard_id % first_entry_id_list[shard_id] % expected_first_entry_id).str());
+			expected_first_entry_id += shard_entry_count_list[shard_id];
+		}
+	}
+
+	unsigned int sharded_dataset_index::get_shard_count() const
+	{
+		return static_cast<unsigned int>(shard_entry_count_list.size());
+	}
+
+	unsigned int sharded_dataset_index::get_entry_count(unsigned int shard_id) const
+	{
+		return shard_entry_count_list[shard_id];
+	}
+
+	unsigned int sharded_dataset_index::get_first_entry_id(unsigned int shard_id) const
+	{
+		return first_entry_id_list[shard_id];
+	}
+
+	unsigned int sharded_dataset_index::get_total_entry_count() const
+	{
+		if (shard_entry_count_list.empty())
+			return 0;
+		return first_entry_id_list.back() + shard_entry_count_list.back();
+	}
+}
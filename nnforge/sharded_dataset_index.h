@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/uuid/uuid.hpp>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <memory>
+
+namespace nnforge
+{
+	// Describes the dataset split into shards: shard i holds entries [get_first_entry_id(i), get_first_entry_id(i) + get_entry_count(i))
+	// of the whole dataset. Each shard is a regular dataset with its own per-layer data files,
+	// so shards might be written and read independently of each other
+	class sharded_dataset_index
+	{
+	public:
+		typedef std::shared_ptr<sharded_dataset_index> ptr;
+
+		sharded_dataset_index() = default;
+
+		sharded_dataset_index(const std::vector<unsigned int>& shard_entry_count_list);
+
+		void write(std::ostream& output_stream) const;
+
+		// The stream should be created with std::ios_base::binary flag
+		void read(std::istream& input_stream);
+
+		unsigned int get_shard_count() const;
+
+		unsigned int get_entry_count(unsigned int shard_id) const;
+
+		unsigned int get_first_entry_id(unsigned int shard_id) const;
+
+		unsigned int get_total_entry_count() const;
+
+	public:
+		static const boost::uuids::uuid sharded_dataset_index_guid;
+
+	private:
+		std::vector<unsigned int> shard_entry_count_list;
+		std::vector<unsigned int> first_entry_id_list;
+	};
+}
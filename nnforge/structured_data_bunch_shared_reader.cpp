@@ -0,0 +1,248 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_bunch_shared_reader.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <cstring>
+#include <exception>
+#include <algorithm>
+#include <limits>
+
+namespace nnforge
+{
+	structured_data_bunch_shared_reader::structured_data_bunch_shared_reader(
+		structured_data_bunch_reader& original_reader,
+		unsigned int consumer_count,
+		unsigned int max_cache_mb)
+		: original_reader(original_reader)
+		, consumer_state_list(consumer_count)
+		, original_read_count(0)
+		, consumer_read_count(0)
+	{
+		unsigned long long entry_size = 0;
+		std::map<std::string, layer_configuration_specific> config_map = original_reader.get_config_map();
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+		{
+			layer_name_to_neuron_count_map.insert(std::make_pair(it->first, it->second.get_neuron_count()));
+			entry_size += static_cast<unsigned long long>(it->second.get_neuron_count()) * sizeof(float);
+		}
+
+		unsigned long long max_cache_size = static_cast<unsigned long long>(max_cache_mb) * 1024ULL * 1024ULL;
+		max_cached_entry_count = static_cast<unsigned int>(std::min(
+			std::max(max_cache_size / std::max(entry_size, 1ULL), 1ULL),
+			static_cast<unsigned long long>(std::numeric_limits<unsigned int>::max())));
+
+		for(std::vector<consumer_state>::iterator it = consumer_state_list.begin(); it != consumer_state_list.end(); ++it)
+			it->frontier = 0;
+	}
+
+	structured_data_bunch_reader::ptr structured_data_bunch_shared_reader::get_consumer_reader(unsigned int consumer_id)
+	{
+		return structured_data_bunch_reader::ptr(new consumer_reader(*this, consumer_id));
+	}
+
+	void structured_data_bunch_shared_reader::set_epoch(unsigned int epoch_id)
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+
+		entry_id_to_cached_entry_map.clear();
+		for(std::vector<consumer_state>::iterator it = consumer_state_list.begin(); it != consumer_state_list.end(); ++it)
+		{
+			it->frontier = 0;
+			it->read_entry_id_set.clear();
+		}
+		original_read_count = 0;
+		consumer_read_count = 0;
+
+		original_reader.set_epoch(epoch_id);
+	}
+
+	std::pair<unsigned int, unsigned int> structured_data_bunch_shared_reader::get_read_count() const
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+
+		return std::make_pair(original_read_count, consumer_read_count);
+	}
+
+	bool structured_data_bunch_shared_reader::read(
+		unsigned int consumer_id,
+		unsigned int entry_id,
+		const std::map<std::string, float *>& data_map)
+	{
+		std::unique_lock<std::mutex> lock(cache_mutex);
+
+		std::map<unsigned int, cached_entry>::iterator it = entry_id_to_cached_entry_map.find(entry_id);
+		while ((it != entry_id_to_cached_entry_map.end()) && it->second.loading)
+		{
+			entry_loaded_condition.wait(lock);
+			it = entry_id_to_cached_entry_map.find(entry_id);
+		}
+
+		bool res;
+		if (it != entry_id_to_cached_entry_map.end())
+		{
+			// Cached entries are not modified until all the consumers read them, so it is safe to copy without the lock
+			const cached_entry& entry = it->second;
+			res = entry.valid;
+			std::exception_ptr error = entry.error;
+			lock.unlock();
+			if (res)
+			{
+				for(std::map<std::string, float *>::const_iterator it2 = data_map.begin(); it2 != data_map.end(); ++it2)
+				{
+					std::map<std::string, std::vector<float> >::const_iterator data_it = entry.data.find(it2->first);
+					if (data_it == entry.data.end())
+						throw neural_network_exception((boost::format("structured_data_bunch_shared_reader is requested to read %1% data, which other consumers didn't request") % it2->first).str());
+					memcpy(it2->second, &data_it->second[0], data_it->second.size() * sizeof(float));
+				}
+			}
+			lock.lock();
+
+			if (error)
+			{
+				++consumer_read_count;
+				mark_read(consumer_id, entry_id);
+				if (is_read_by_all(entry_id))
+					entry_id_to_cached_entry_map.erase(entry_id);
+				std::rethrow_exception(error);
+			}
+		}
+		else
+		{
+			// Validate the request before any state is changed, the entry created below would be left loading otherwise
+			for(std::map<std::string, float *>::const_iterator it2 = data_map.begin(); it2 != data_map.end(); ++it2)
+			{
+				if (layer_name_to_neuron_count_map.find(it2->first) == layer_name_to_neuron_count_map.end())
+					throw neural_network_exception((boost::format("structured_data_bunch_shared_reader is requested to read %1% data, while the original reader doesn't have it") % it2->first).str());
+			}
+
+			++original_read_count;
+			mark_read(consumer_id, entry_id);
+			if (is_read_by_all(entry_id) || (entry_id_to_cached_entry_map.size() >= max_cached_entry_count))
+			{
+				// Nobody else needs the entry, or the cache is full
+				lock.unlock();
+				res = original_reader.read(entry_id, data_map);
+				lock.lock();
+				++consumer_read_count;
+				return res;
+			}
+
+			cached_entry& entry = entry_id_to_cached_entry_map[entry_id];
+			entry.loading = true;
+			entry.valid = false;
+			std::map<std::string, float *> cached_data_map;
+			for(std::map<std::string, float *>::const_iterator it2 = data_map.begin(); it2 != data_map.end(); ++it2)
+			{
+				std::vector<float>& buf = entry.data[it2->first];
+				buf.resize(layer_name_to_neuron_count_map.find(it2->first)->second);
+				cached_data_map.insert(std::make_pair(it2->first, &buf[0]));
+			}
+			lock.unlock();
+
+			std::exception_ptr error;
+			try
+			{
+				res = original_reader.read(entry_id, cached_data_map);
+				if (res)
+				{
+					for(std::map<std::string, float *>::const_iterator it2 = data_map.begin(); it2 != data_map.end(); ++it2)
+						memcpy(it2->second, cached_data_map[it2->first], entry.data[it2->first].size() * sizeof(float));
+				}
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+				res = false;
+			}
+
+			lock.lock();
+			entry.loading = false;
+			entry.valid = res;
+			entry.error = error;
+			entry_loaded_condition.notify_all();
+			++consumer_read_count;
+			if (error)
+				std::rethrow_exception(error);
+			return res;
+		}
+
+		++consumer_read_count;
+		mark_read(consumer_id, entry_id);
+		if (is_read_by_all(entry_id))
+			entry_id_to_cached_entry_map.erase(entry_id);
+
+		return res;
+	}
+
+	void structured_data_bunch_shared_reader::mark_read(
+		unsigned int consumer_id,
+		unsigned int entry_id)
+	{
+		consumer_state& state = consumer_state_list[consumer_id];
+		if (entry_id < state.frontier)
+			return;
+
+		state.read_entry_id_set.insert(entry_id);
+		while (!state.read_entry_id_set.empty() && (*state.read_entry_id_set.begin() == state.frontier))
+		{
+			state.read_entry_id_set.erase(state.read_entry_id_set.begin());
+			++state.frontier;
+		}
+	}
+
+	bool structured_data_bunch_shared_reader::is_read_by_all(unsigned int entry_id) const
+	{
+		for(std::vector<consumer_state>::const_iterator it = consumer_state_list.begin(); it != consumer_state_list.end(); ++it)
+		{
+			if ((entry_id >= it->frontier) && (it->read_entry_id_set.find(entry_id) == it->read_entry_id_set.end()))
+				return false;
+		}
+		return true;
+	}
+
+	structured_data_bunch_shared_reader::consumer_reader::consumer_reader(
+		structured_data_bunch_shared_reader& parent,
+		unsigned int consumer_id)
+		: parent(parent)
+		, consumer_id(consumer_id)
+	{
+	}
+
+	std::map<std::string, layer_configuration_specific> structured_data_bunch_shared_reader::consumer_reader::get_config_map() const
+	{
+		return parent.original_reader.get_config_map();
+	}
+
+	bool structured_data_bunch_shared_reader::consumer_reader::read(
+		unsigned int entry_id,
+		const std::map<std::string, float *>& data_map)
+	{
+		return parent.read(consumer_id, entry_id, data_map);
+	}
+
+	void structured_data_bunch_shared_reader::consumer_reader::set_epoch(unsigned int epoch_id)
+	{
+	}
+
+	int structured_data_bunch_shared_reader::consumer_reader::get_entry_count() const
+	{
+		return parent.original_reader.get_entry_count();
+	}
+}
@@ -0,0 +1,129 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_bunch_reader.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace nnforge
+{
+	// Lets several consumers, running concurrently, read the same epoch of the original reader.
+	// Each entry is read from the original reader once and kept until all the consumers have read it.
+	// When the entries kept take max_cache_mb megabytes already, the consumer reads the entry from the original reader directly,
+	// so the consumers drifting apart cost extra reads instead of memory or waiting for each other
+	class structured_data_bunch_shared_reader
+	{
+	public:
+		typedef std::shared_ptr<structured_data_bunch_shared_reader> ptr;
+
+		// The original reader should outlive the object
+		structured_data_bunch_shared_reader(
+			structured_data_bunch_reader& original_reader,
+			unsigned int consumer_count,
+			unsigned int max_cache_mb);
+
+		~structured_data_bunch_shared_reader() = default;
+
+		// The consumer reader should be used by a single consumer only, it might be read from multiple threads though
+		structured_data_bunch_reader::ptr get_consumer_reader(unsigned int consumer_id);
+
+		// Sets the epoch of the original reader, all the consumers should be done with the previous epoch
+		void set_epoch(unsigned int epoch_id);
+
+		// The number of entries read from the original reader and the number of entries served to the consumers since the last set_epoch call
+		std::pair<unsigned int, unsigned int> get_read_count() const;
+
+	private:
+		struct cached_entry
+		{
+			bool loading;
+			bool valid;
+			// Set when reading the entry from the original reader failed, the error is rethrown to all the consumers reading the entry
+			std::exception_ptr error;
+			std::map<std::string, std::vector<float> > data;
+		};
+
+		struct consumer_state
+		{
+			// All the entries below the frontier are read
+			unsigned int frontier;
+			std::set<unsigned int> read_entry_id_set;
+		};
+
+		class consumer_reader : public structured_data_bunch_reader
+		{
+		public:
+			consumer_reader(
+				structured_data_bunch_shared_reader& parent,
+				unsigned int consumer_id);
+
+			virtual ~consumer_reader() = default;
+
+			virtual std::map<std::string, layer_configuration_specific> get_config_map() const;
+
+			virtual bool read(
+				unsigned int entry_id,
+				const std::map<std::string, float *>& data_map);
+
+			// The epoch is set on the parent
+			virtual void set_epoch(unsigned int epoch_id);
+
+			virtual int get_entry_count() const;
+
+		private:
+			structured_data_bunch_shared_reader& parent;
+			unsigned int consumer_id;
+		};
+
+		bool read(
+			unsigned int consumer_id,
+			unsigned int entry_id,
+			const std::map<std::string, float *>& data_map);
+
+		// Should be called with the mutex locked
+		void mark_read(
+			unsigned int consumer_id,
+			unsigned int entry_id);
+
+		// Should be called with the mutex locked
+		bool is_read_by_all(unsigned int entry_id) const;
+
+	private:
+		structured_data_bunch_reader& original_reader;
+		std::map<std::string, unsigned int> layer_name_to_neuron_count_map;
+		// Derived from max_cache_mb and the size of the entry, at least 1
+		unsigned int max_cached_entry_count;
+
+		std::map<unsigned int, cached_entry> entry_id_to_cached_entry_map;
+		std::vector<consumer_state> consumer_state_list;
+		unsigned int original_read_count;
+		unsigned int consumer_read_count;
+		mutable std::mutex cache_mutex;
+		std::condition_variable entry_loaded_condition;
+
+	private:
+		structured_data_bunch_shared_reader(const structured_data_bunch_shared_reader&) = delete;
+		structured_data_bunch_shared_reader& operator =(const structured_data_bunch_shared_reader&) = delete;
+	};
+}
@@ -122,6 +122,9 @@ namespace nnforge
 
 		current_chunk = epoch_id % entry_count_list.size();
 		current_epoch = epoch_id;
+
+		for(std::map<std::string, structured_data_reader::ptr>::const_iterator it = data_reader_map.begin(); it != data_reader_map.end(); ++it)
+			it->second->set_epoch(epoch_id);
 	}
 
 	bool structured_data_bunch_stream_reader::read(
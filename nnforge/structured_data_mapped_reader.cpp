@@ -0,0 +1,101 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_mapped_reader.h"
+
+#include "neural_network_exception.h"
+#include "structured_data_stream_schema.h"
+#include "structured_data_stream_writer.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <boost/format.hpp>
+#include <cstring>
+
+namespace nnforge
+{
+	structured_data_mapped_reader::structured_data_mapped_reader(
+		const boost::filesystem::path& file_path,
+		bool random_access)
+	{
+		size_t header_size;
+		{
+			boost::filesystem::ifstream in(file_path, std::ios_base::in | std::ios_base::binary);
+			in.exceptions(std::ostream::eofbit | std::ostream::failbit | std::ostream::badbit);
+
+			boost::uuids::uuid guid_read;
+			in.read(reinterpret_cast<char*>(guid_read.data), sizeof(guid_read.data));
+			if (guid_read != structured_data_stream_schema::structured_data_stream_guid)
+				throw neural_network_exception((boost::format("Unknown structured data GUID encountered in file %1%: %2%") % file_path.string() % guid_read).str());
+
+			input_configuration.read(in);
+
+			input_neuron_count = input_configuration.get_neuron_count();
+
+			in.read(reinterpret_cast<char*>(&entry_count), sizeof(entry_count));
+
+			header_size = static_cast<size_t>(in.tellg());
+		}
+
+		unsigned long long expected_file_size = static_cast<unsigned long long>(header_size) + static_cast<unsigned long long>(entry_count) * static_cast<unsigned long long>(input_neuron_count) * sizeof(float);
+		unsigned long long file_size = static_cast<unsigned long long>(boost::filesystem::file_size(file_path));
+		if (file_size < expected_file_size)
+			throw neural_network_exception((boost::format("File %1% is truncated: %2% bytes while %3% entries require %4% bytes") % file_path.string() % file_size % entry_count % expected_file_size).str());
+
+		mapping = boost::interprocess::file_mapping(file_path.string().c_str(), boost::interprocess::read_only);
+		region = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only, 0, static_cast<size_t>(expected_file_size));
+		region.advise(random_access ? boost::interprocess::mapped_region::advice_random : boost::interprocess::mapped_region::advice_sequential);
+
+		entries_begin = static_cast<const unsigned char *>(region.get_address()) + header_size;
+	}
+
+	bool structured_data_mapped_reader::read(
+		unsigned int entry_id,
+		float * data)
+	{
+		const float * src = get_entry(entry_id);
+		if (!src)
+			return false;
+
+		memcpy(data, src, sizeof(float) * input_neuron_count);
+
+		return true;
+	}
+
+	const float * structured_data_mapped_reader::get_entry(unsigned int entry_id) const
+	{
+		if (entry_id >= entry_count)
+			return 0;
+
+		return reinterpret_cast<const float *>(entries_begin + static_cast<size_t>(entry_id) * static_cast<size_t>(input_neuron_count) * sizeof(float));
+	}
+
+	layer_configuration_specific structured_data_mapped_reader::get_configuration() const
+	{
+		return input_configuration;
+	}
+
+	int structured_data_mapped_reader::get_entry_count() const
+	{
+		return entry_count;
+	}
+
+	raw_data_writer::ptr structured_data_mapped_reader::get_writer(std::shared_ptr<std::ostream> out) const
+	{
+		return raw_data_writer::ptr(new structured_data_stream_writer(out, get_configuration()));
+	}
+}
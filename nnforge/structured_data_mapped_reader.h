@@ -0,0 +1,68 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_reader.h"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <memory>
+
+namespace nnforge
+{
+	// Reads the same format as structured_data_stream_reader does, but through a read-only memory mapping of the file.
+	// read() is just a copy from the mapping, so it may be called from multiple threads concurrently
+	class structured_data_mapped_reader : public structured_data_reader
+	{
+	public:
+		typedef std::shared_ptr<structured_data_mapped_reader> ptr;
+
+		// Set random_access when entries are going to be read in shuffled order, OS read-ahead is disabled then
+		structured_data_mapped_reader(
+			const boost::filesystem::path& file_path,
+			bool random_access = false);
+
+		virtual ~structured_data_mapped_reader() = default;
+
+		virtual bool read(
+			unsigned int entry_id,
+			float * data);
+
+		virtual layer_configuration_specific get_configuration() const;
+
+		virtual int get_entry_count() const;
+
+		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
+
+		// Returns the entry inside the mapping without copying, the pointer is valid while the reader exists.
+		// Returns null if entry_id is out of range
+		const float * get_entry(unsigned int entry_id) const;
+
+	protected:
+		boost::interprocess::file_mapping mapping;
+		boost::interprocess::mapped_region region;
+		const unsigned char * entries_begin;
+		unsigned int input_neuron_count;
+		layer_configuration_specific input_configuration;
+		unsigned int entry_count;
+
+	private:
+		structured_data_mapped_reader(const structured_data_mapped_reader&) = delete;
+		structured_data_mapped_reader& operator =(const structured_data_mapped_reader&) = delete;
+	};
+}
@@ -0,0 +1,200 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_quantized_reader.h"
+
+#include "neural_network_exception.h"
+#include "structured_data_stream_schema.h"
+#include "structured_data_quantized_stream_writer.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <boost/format.hpp>
+#include <cstring>
+
+namespace nnforge
+{
+	structured_data_quantized_reader::structured_data_quantized_reader(std::shared_ptr<std::istream> input_stream)
+		: in_stream(input_stream)
+		, entries_begin(0)
+	{
+		in_stream->exceptions(std::ostream::eofbit | std::ostream::failbit | std::ostream::badbit);
+
+		read_header(*in_stream);
+
+		reset_pos = in_stream->tellg();
+	}
+
+	structured_data_quantized_reader::structured_data_quantized_reader(
+		const boost::filesystem::path& file_path,
+		bool random_access)
+	{
+		size_t header_size;
+		{
+			boost::filesystem::ifstream in(file_path, std::ios_base::in | std::ios_base::binary);
+			in.exceptions(std::ostream::eofbit | std::ostream::failbit | std::ostream::badbit);
+
+			read_header(in);
+
+			header_size = static_cast<size_t>(in.tellg());
+		}
+
+		unsigned long long expected_file_size = static_cast<unsigned long long>(header_size) + static_cast<unsigned long long>(entry_count) * static_cast<unsigned long long>(entry_size);
+		unsigned long long file_size = static_cast<unsigned long long>(boost::filesystem::file_size(file_path));
+		if (file_size < expected_file_size)
+			throw neural_network_exception((boost::format("File %1% is truncated: %2% bytes while %3% entries require %4% bytes") % file_path.string() % file_size % entry_count % expected_file_size).str());
+
+		mapping = boost::interprocess::file_mapping(file_path.string().c_str(), boost::interprocess::read_only);
+		region = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only, 0, static_cast<size_t>(expected_file_size));
+		region.advise(random_access ? boost::interprocess::mapped_region::advice_random : boost::interprocess::mapped_region::advice_sequential);
+
+		entries_begin = static_cast<const unsigned char *>(region.get_address()) + header_size;
+	}
+
+	void structured_data_quantized_reader::read_header(std::istream& input_stream)
+	{
+		boost::uuids::uuid guid_read;
+		input_stream.read(reinterpret_cast<char*>(guid_read.data), sizeof(guid_read.data));
+		if (guid_read != structured_data_stream_schema::structured_data_quantized_stream_guid)
+			throw neural_network_exception((boost::format("Unknown quantized structured data GUID encountered in input stream: %1%") % guid_read).str());
+
+		input_configuration.read(input_stream);
+
+		unsigned int type_id;
+		input_stream.read(reinterpret_cast<char*>(&type_id), sizeof(type_id));
+		type = static_cast<quantization_util::quantized_type>(type_id);
+
+		scale_list.resize(input_configuration.feature_map_count);
+		offset_list.resize(input_configuration.feature_map_count);
+		input_stream.read(reinterpret_cast<char*>(&scale_list[0]), sizeof(float) * scale_list.size());
+		input_stream.read(reinterpret_cast<char*>(&offset_list[0]), sizeof(float) * offset_list.size());
+
+		input_stream.read(reinterpret_cast<char*>(&entry_count), sizeof(entry_count));
+
+		neuron_count_per_feature_map = input_configuration.get_neuron_count_per_feature_map();
+		entry_size = static_cast<size_t>(input_configuration.get_neuron_count()) * quantization_util::get_elem_size(type);
+	}
+
+	bool structured_data_quantized_reader::read(
+		unsigned int entry_id,
+		float * data)
+	{
+		if (entry_id >= entry_count)
+			return false;
+
+		if (entries_begin)
+			dequantize(entries_begin + static_cast<size_t>(entry_id) * entry_size, data);
+		else
+		{
+			std::vector<unsigned char> quantized_entry(entry_size);
+			{
+				std::lock_guard<std::mutex> lock(read_data_from_stream_mutex);
+				in_stream->seekg(reset_pos + (std::istream::off_type)entry_id * (std::istream::off_type)entry_size, std::ios::beg);
+				in_stream->read(reinterpret_cast<char*>(&quantized_entry[0]), entry_size);
+			}
+			dequantize(&quantized_entry[0], data);
+		}
+
+		return true;
+	}
+
+	bool structured_data_quantized_reader::raw_read(
+		unsigned int entry_id,
+		std::vector<unsigned char>& all_elems)
+	{
+		if (entry_id >= entry_count)
+			return false;
+
+		all_elems.resize(entry_size);
+		if (entries_begin)
+			memcpy(&all_elems[0], entries_begin + static_cast<size_t>(entry_id) * entry_size, entry_size);
+		else
+		{
+			std::lock_guard<std::mutex> lock(read_data_from_stream_mutex);
+			in_stream->seekg(reset_pos + (std::istream::off_type)entry_id * (std::istream::off_type)entry_size, std::ios::beg);
+			in_stream->read(reinterpret_cast<char*>(&all_elems[0]), entry_size);
+		}
+
+		return true;
+	}
+
+	bool structured_data_quantized_reader::raw_read(
+		unsigned int entry_id,
+		const unsigned char *& data,
+		size_t& data_length)
+	{
+		if ((!entries_begin) || (entry_id >= entry_count))
+			return false;
+
+		data = entries_begin + static_cast<size_t>(entry_id) * entry_size;
+		data_length = entry_size;
+
+		return true;
+	}
+
+	void structured_data_quantized_reader::dequantize(
+		const unsigned char * src,
+		float * data) const
+	{
+		size_t feature_map_size = static_cast<size_t>(neuron_count_per_feature_map) * quantization_util::get_elem_size(type);
+		for(unsigned int feature_map_id = 0; feature_map_id < static_cast<unsigned int>(scale_list.size()); ++feature_map_id)
+			quantization_util::dequantize(
+				type,
+				data + feature_map_id * neuron_count_per_feature_map,
+				src + feature_map_id * feature_map_size,
+				neuron_count_per_feature_map,
+				scale_list[feature_map_id],
+				offset_list[feature_map_id]);
+	}
+
+	layer_configuration_specific structured_data_quantized_reader::get_configuration() const
+	{
+		return input_configuration;
+	}
+
+	int structured_data_quantized_reader::get_entry_count() const
+	{
+		return entry_count;
+	}
+
+	raw_data_writer::ptr structured_data_quantized_reader::get_writer(std::shared_ptr<std::ostream> out) const
+	{
+		return raw_data_writer::ptr(new structured_data_quantized_stream_writer(out, input_configuration, type, scale_list, offset_list));
+	}
+
+	quantization_util::quantized_type structured_data_quantized_reader::get_quantized_type() const
+	{
+		return type;
+	}
+
+	bool structured_data_quantized_reader::is_quantized(std::istream& input_stream)
+	{
+		std::istream::pos_type pos = input_stream.tellg();
+		std::ios_base::iostate exception_mask = input_stream.exceptions();
+		input_stream.exceptions(std::ios_base::goodbit);
+
+		boost::uuids::uuid guid_read;
+		input_stream.read(reinterpret_cast<char*>(guid_read.data), sizeof(guid_read.data));
+		bool res = input_stream.good() && (guid_read == structured_data_stream_schema::structured_data_quantized_stream_guid);
+
+		input_stream.clear();
+		input_stream.seekg(pos);
+		input_stream.exceptions(exception_mask);
+
+		return res;
+	}
+}
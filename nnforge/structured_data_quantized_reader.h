@@ -0,0 +1,102 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_reader.h"
+#include "quantization_util.h"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <vector>
+#include <istream>
+#include <memory>
+#include <mutex>
+
+namespace nnforge
+{
+	// Reads data written by structured_data_quantized_stream_writer, entries are dequantized straight into the destination buffer.
+	// raw_read returns quantized entries, so that the writer returned by get_writer copies them without loss
+	class structured_data_quantized_reader : public structured_data_reader
+	{
+	public:
+		typedef std::shared_ptr<structured_data_quantized_reader> ptr;
+
+		// The constructor modifies input_stream to throw exceptions in case of failure
+		structured_data_quantized_reader(std::shared_ptr<std::istream> input_stream);
+
+		// Reads through a read-only memory mapping of the file, without locking.
+		// Set random_access when entries are going to be read in shuffled order, OS read-ahead is disabled then
+		structured_data_quantized_reader(
+			const boost::filesystem::path& file_path,
+			bool random_access = false);
+
+		virtual ~structured_data_quantized_reader() = default;
+
+		virtual bool read(
+			unsigned int entry_id,
+			float * data);
+
+		virtual bool raw_read(
+			unsigned int entry_id,
+			std::vector<unsigned char>& all_elems);
+
+		// Available for memory mapped files only
+		virtual bool raw_read(
+			unsigned int entry_id,
+			const unsigned char *& data,
+			size_t& data_length);
+
+		virtual layer_configuration_specific get_configuration() const;
+
+		virtual int get_entry_count() const;
+
+		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
+
+		quantization_util::quantized_type get_quantized_type() const;
+
+		// Returns true if the stream holds quantized structured data, the stream position is kept
+		static bool is_quantized(std::istream& input_stream);
+
+	protected:
+		void read_header(std::istream& input_stream);
+
+		void dequantize(
+			const unsigned char * src,
+			float * data) const;
+
+	protected:
+		std::shared_ptr<std::istream> in_stream;
+		boost::interprocess::file_mapping mapping;
+		boost::interprocess::mapped_region region;
+		// Null when reading from the stream
+		const unsigned char * entries_begin;
+		layer_configuration_specific input_configuration;
+		quantization_util::quantized_type type;
+		std::vector<float> scale_list;
+		std::vector<float> offset_list;
+		unsigned int neuron_count_per_feature_map;
+		size_t entry_size;
+		unsigned int entry_count;
+		std::istream::pos_type reset_pos;
+		std::mutex read_data_from_stream_mutex;
+
+	private:
+		structured_data_quantized_reader(const structured_data_quantized_reader&) = delete;
+		structured_data_quantized_reader& operator =(const structured_data_quantized_reader&) = delete;
+	};
+}
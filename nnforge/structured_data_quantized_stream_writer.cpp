@@ -0,0 +1,121 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_quantized_stream_writer.h"
+
+#include "neural_network_exception.h"
+#include "structured_data_stream_schema.h"
+
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	structured_data_quantized_stream_writer::structured_data_quantized_stream_writer(
+		std::shared_ptr<std::ostream> output_stream,
+		const layer_configuration_specific& config,
+		quantization_util::quantized_type type,
+		const std::vector<float>& scale_list,
+		const std::vector<float>& offset_list)
+		: out_stream(output_stream)
+		, type(type)
+		, scale_list(scale_list)
+		, offset_list(offset_list)
+		, entry_count(0)
+	{
+		if ((scale_list.size() != config.feature_map_count) || (offset_list.size() != config.feature_map_count))
+			throw neural_network_exception((boost::format("structured_data_quantized_stream_writer got %1% scales and %2% offsets for %3% feature maps") % scale_list.size() % offset_list.size() % config.feature_map_count).str());
+
+		out_stream->exceptions(std::ostream::failbit | std::ostream::badbit);
+
+		neuron_count_per_feature_map = config.get_neuron_count_per_feature_map();
+		entry_size = static_cast<size_t>(config.get_neuron_count()) * quantization_util::get_elem_size(type);
+		quantized_entry.resize(entry_size);
+
+		out_stream->write(reinterpret_cast<const char*>(structured_data_stream_schema::structured_data_quantized_stream_guid.data), sizeof(structured_data_stream_schema::structured_data_quantized_stream_guid.data));
+
+		config.write(*out_stream);
+
+		unsigned int type_id = static_cast<unsigned int>(type);
+		out_stream->write(reinterpret_cast<const char*>(&type_id), sizeof(type_id));
+		out_stream->write(reinterpret_cast<const char*>(&scale_list[0]), sizeof(float) * scale_list.size());
+		out_stream->write(reinterpret_cast<const char*>(&offset_list[0]), sizeof(float) * offset_list.size());
+
+		entry_count_pos = out_stream->tellp();
+		out_stream->write(reinterpret_cast<const char*>(&entry_count), sizeof(entry_count));
+	}
+
+	structured_data_quantized_stream_writer::~structured_data_quantized_stream_writer()
+	{
+		// write entry count
+		out_stream->seekp(entry_count_pos);
+		out_stream->write(reinterpret_cast<const char*>(&entry_count), sizeof(entry_count));
+
+		out_stream->flush();
+	}
+
+	void structured_data_quantized_stream_writer::write(const float * neurons)
+	{
+		quantize_and_write(neurons);
+	}
+
+	void structured_data_quantized_stream_writer::write(
+		unsigned int entry_id,
+		const float * neurons)
+	{
+		if (entry_id != entry_count)
+			throw neural_network_exception((boost::format("structured_data_quantized_stream_writer cannot write entry %1% when %2% written already") % entry_id % entry_count).str());
+
+		quantize_and_write(neurons);
+	}
+
+	void structured_data_quantized_stream_writer::raw_write(
+		const void * all_entry_data,
+		size_t data_length)
+	{
+		if (data_length != entry_size)
+			throw neural_network_exception((boost::format("structured_data_quantized_stream_writer got raw entry of %1% bytes while %2% bytes expected") % data_length % entry_size).str());
+
+		out_stream->write(reinterpret_cast<const char*>(all_entry_data), data_length);
+		entry_count++;
+	}
+
+	void structured_data_quantized_stream_writer::raw_write(
+		unsigned int entry_id,
+		const void * all_entry_data,
+		size_t data_length)
+	{
+		if (entry_id != entry_count)
+			throw neural_network_exception((boost::format("structured_data_quantized_stream_writer cannot write entry %1% when %2% written already") % entry_id % entry_count).str());
+
+		raw_write(all_entry_data, data_length);
+	}
+
+	void structured_data_quantized_stream_writer::quantize_and_write(const float * neurons)
+	{
+		size_t feature_map_size = static_cast<size_t>(neuron_count_per_feature_map) * quantization_util::get_elem_size(type);
+		for(unsigned int feature_map_id = 0; feature_map_id < static_cast<unsigned int>(scale_list.size()); ++feature_map_id)
+			quantization_util::quantize(
+				type,
+				&quantized_entry[0] + feature_map_id * feature_map_size,
+				neurons + feature_map_id * neuron_count_per_feature_map,
+				neuron_count_per_feature_map,
+				scale_list[feature_map_id],
+				offset_list[feature_map_id]);
+
+		out_stream->write(reinterpret_cast<const char*>(&quantized_entry[0]), entry_size);
+		entry_count++;
+	}
+}
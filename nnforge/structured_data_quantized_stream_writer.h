@@ -0,0 +1,82 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "layer_configuration_specific.h"
+#include "structured_data_writer.h"
+#include "quantization_util.h"
+
+#include <vector>
+#include <ostream>
+#include <memory>
+
+namespace nnforge
+{
+	// Writes entries quantized to uint8 or fp16, neuron of feature map i is stored as (value - offset_list[i]) / scale_list[i]
+	class structured_data_quantized_stream_writer : public structured_data_writer
+	{
+	public:
+		typedef std::shared_ptr<structured_data_quantized_stream_writer> ptr;
+
+		// The constructor modifies output_stream to throw exceptions in case of failure
+		// The stream should be created with std::ios_base::binary flag
+		structured_data_quantized_stream_writer(
+			std::shared_ptr<std::ostream> output_stream,
+			const layer_configuration_specific& config,
+			quantization_util::quantized_type type,
+			const std::vector<float>& scale_list,
+			const std::vector<float>& offset_list);
+
+		virtual ~structured_data_quantized_stream_writer();
+
+		virtual void write(const float * neurons);
+
+		virtual void write(
+			unsigned int entry_id,
+			const float * neurons);
+
+		// Writes already quantized entry as is
+		virtual void raw_write(
+			const void * all_entry_data,
+			size_t data_length);
+
+		// Writes already quantized entry as is
+		virtual void raw_write(
+			unsigned int entry_id,
+			const void * all_entry_data,
+			size_t data_length);
+
+	private:
+		void quantize_and_write(const float * neurons);
+
+	private:
+		std::shared_ptr<std::ostream> out_stream;
+
+		quantization_util::quantized_type type;
+		std::vector<float> scale_list;
+		std::vector<float> offset_list;
+		unsigned int neuron_count_per_feature_map;
+		size_t entry_size;
+		std::vector<unsigned char> quantized_entry;
+		std::ostream::pos_type entry_count_pos;
+		unsigned int entry_count;
+
+	private:
+		structured_data_quantized_stream_writer(const structured_data_quantized_stream_writer&) = delete;
+		structured_data_quantized_stream_writer& operator =(const structured_data_quantized_stream_writer&) = delete;
+	};
+}
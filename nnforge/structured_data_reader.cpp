@@ -31,4 +31,12 @@ namespace nnforge
 		all_elems.resize(get_configuration().get_neuron_count() * sizeof(float));
 		return read(entry_id, (float *)(&all_elems[0]));
 	}
+
+	void structured_data_reader::set_epoch(unsigned int epoch_id)
+	{
+	}
+
+	void structured_data_reader::set_first_entry_id(unsigned int first_entry_id)
+	{
+	}
 }
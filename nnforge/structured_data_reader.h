@@ -40,6 +40,13 @@ namespace nnforge
 
 		virtual layer_configuration_specific get_configuration() const = 0;
 
+		// Readers producing randomized data key their random streams with the epoch, the default implementation does nothing
+		virtual void set_epoch(unsigned int epoch_id);
+
+		// Called when the reader provides entries of the larger dataset starting with first_entry_id, a shard for example.
+		// Readers producing randomized data key their random streams with entry IDs of that dataset, the default implementation does nothing
+		virtual void set_first_entry_id(unsigned int first_entry_id);
+
 	protected:
 		structured_data_reader() = default;
 
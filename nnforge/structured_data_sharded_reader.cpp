@@ -0,0 +1,127 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_sharded_reader.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <algorithm>
+
+namespace nnforge
+{
+	structured_data_sharded_reader::structured_data_sharded_reader(const std::vector<structured_data_reader::ptr>& shard_reader_list)
+		: shard_reader_list(shard_reader_list)
+		, total_entry_count(0)
+	{
+		if (shard_reader_list.empty())
+			throw neural_network_exception("No shards specified for structured_data_sharded_reader");
+
+		config = shard_reader_list.front()->get_configuration();
+		for(std::vector<structured_data_reader::ptr>::const_iterator it = shard_reader_list.begin(); it != shard_reader_list.end(); ++it)
+		{
+			layer_configuration_specific shard_config = (*it)->get_configuration();
+			if (shard_config != config)
+				throw neural_network_exception((boost::format("Shard %1% has configuration different from the one of the first shard") % (it - shard_reader_list.begin())).str());
+			int shard_entry_count = (*it)->get_entry_count();
+			if (shard_entry_count < 0)
+				throw neural_network_exception((boost::format("Unknown entry count in shard %1%") % (it - shard_reader_list.begin())).str());
+
+			first_entry_id_list.push_back(total_entry_count);
+			total_entry_count += static_cast<unsigned int>(shard_entry_count);
+		}
+
+		set_first_entry_id(0);
+	}
+
+	bool structured_data_sharded_reader::get_shard_entry(
+		unsigned int entry_id,
+		unsigned int& shard_id,
+		unsigned int& shard_entry_id) const
+	{
+		if (entry_id >= total_entry_count)
+			return false;
+
+		shard_id = static_cast<unsigned int>(std::upper_bound(first_entry_id_list.begin(), first_entry_id_list.end(), entry_id) - first_entry_id_list.begin()) - 1;
+		shard_entry_id = entry_id - first_entry_id_list[shard_id];
+		return true;
+	}
+
+	bool structured_data_sharded_reader::read(
+		unsigned int entry_id,
+		float * data)
+	{
+		unsigned int shard_id;
+		unsigned int shard_entry_id;
+		if (!get_shard_entry(entry_id, shard_id, shard_entry_id))
+			return false;
+
+		return shard_reader_list[shard_id]->read(shard_entry_id, data);
+	}
+
+	bool structured_data_sharded_reader::raw_read(
+		unsigned int entry_id,
+		std::vector<unsigned char>& all_elems)
+	{
+		unsigned int shard_id;
+		unsigned int shard_entry_id;
+		if (!get_shard_entry(entry_id, shard_id, shard_entry_id))
+			return false;
+
+		return shard_reader_list[shard_id]->raw_read(shard_entry_id, all_elems);
+	}
+
+	bool structured_data_sharded_reader::raw_read(
+		unsigned int entry_id,
+		const unsigned char *& data,
+		size_t& data_length)
+	{
+		unsigned int shard_id;
+		unsigned int shard_entry_id;
+		if (!get_shard_entry(entry_id, shard_id, shard_entry_id))
+			return false;
+
+		raw_data_reader& shard_reader = *shard_reader_list[shard_id];
+		return shard_reader.raw_read(shard_entry_id, data, data_length);
+	}
+
+	layer_configuration_specific structured_data_sharded_reader::get_configuration() const
+	{
+		return config;
+	}
+
+	int structured_data_sharded_reader::get_entry_count() const
+	{
+		return static_cast<int>(total_entry_count);
+	}
+
+	void structured_data_sharded_reader::set_epoch(unsigned int epoch_id)
+	{
+		for(std::vector<structured_data_reader::ptr>::const_iterator it = shard_reader_list.begin(); it != shard_reader_list.end(); ++it)
+			(*it)->set_epoch(epoch_id);
+	}
+
+	void structured_data_sharded_reader::set_first_entry_id(unsigned int first_entry_id)
+	{
+		for(unsigned int shard_id = 0; shard_id < static_cast<unsigned int>(shard_reader_list.size()); ++shard_id)
+			shard_reader_list[shard_id]->set_first_entry_id(first_entry_id + first_entry_id_list[shard_id]);
+	}
+
+	raw_data_writer::ptr structured_data_sharded_reader::get_writer(std::shared_ptr<std::ostream> out) const
+	{
+		return shard_reader_list.front()->get_writer(out);
+	}
+}
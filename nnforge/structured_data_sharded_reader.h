@@ -0,0 +1,77 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_reader.h"
+
+#include <vector>
+#include <memory>
+
+namespace nnforge
+{
+	// Concatenates shards of the layer data. Each shard reader owns its file handle (or mapping),
+	// so entries from different shards are read concurrently without contending on a single stream
+	class structured_data_sharded_reader : public structured_data_reader
+	{
+	public:
+		typedef std::shared_ptr<structured_data_sharded_reader> ptr;
+
+		structured_data_sharded_reader(const std::vector<structured_data_reader::ptr>& shard_reader_list);
+
+		virtual ~structured_data_sharded_reader() = default;
+
+		virtual bool read(
+			unsigned int entry_id,
+			float * data);
+
+		virtual bool raw_read(
+			unsigned int entry_id,
+			std::vector<unsigned char>& all_elems);
+
+		virtual bool raw_read(
+			unsigned int entry_id,
+			const unsigned char *& data,
+			size_t& data_length);
+
+		virtual layer_configuration_specific get_configuration() const;
+
+		virtual int get_entry_count() const;
+
+		virtual void set_epoch(unsigned int epoch_id);
+
+		virtual void set_first_entry_id(unsigned int first_entry_id);
+
+		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
+
+	private:
+		// Returns false if entry_id is out of range
+		bool get_shard_entry(
+			unsigned int entry_id,
+			unsigned int& shard_id,
+			unsigned int& shard_entry_id) const;
+
+	protected:
+		std::vector<structured_data_reader::ptr> shard_reader_list;
+		std::vector<unsigned int> first_entry_id_list;
+		unsigned int total_entry_count;
+		layer_configuration_specific config;
+
+	private:
+		structured_data_sharded_reader(const structured_data_sharded_reader&) = delete;
+		structured_data_sharded_reader& operator =(const structured_data_sharded_reader&) = delete;
+	};
+}
@@ -25,4 +25,12 @@ namespace nnforge
 	, 0x43, 0xb2
 	, 0xa8, 0x2c
 	, 0x85, 0xcd, 0x58, 0x58, 0x15, 0xd9 };
+
+	// {0238D3EA-7C4F-4967-9DCB-6EC190CB8B14}
+	const boost::uuids::uuid structured_data_stream_schema::structured_data_quantized_stream_guid =
+	{ 0x02, 0x38, 0xd3, 0xea
+	, 0x7c, 0x4f
+	, 0x49, 0x67
+	, 0x9d, 0xcb
+	, 0x6e, 0xc1, 0x90, 0xcb, 0x8b, 0x14 };
 }
@@ -25,6 +25,9 @@ namespace nnforge
 	public:
 		static const boost::uuids::uuid structured_data_stream_guid;
 
+		// Entries are stored as uint8 or fp16 with per feature map scale and offset
+		static const boost::uuids::uuid structured_data_quantized_stream_guid;
+
 	private:
 		structured_data_stream_schema();
 		structured_data_stream_schema(const structured_data_stream_schema&);
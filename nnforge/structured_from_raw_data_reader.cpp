@@ -20,10 +20,14 @@ namespace nnforge
 {
 	structured_from_raw_data_reader::structured_from_raw_data_reader(
 		raw_data_reader::ptr raw_reader,
-		raw_to_structured_data_transformer::ptr transformer)
+		raw_to_structured_data_transformer::ptr transformer,
+		unsigned int seed)
 		: raw_reader(raw_reader)
 		, transformer(transformer)
 		, transformer_sample_count(transformer->get_sample_count())
+		, seed(seed)
+		, epoch_id(0)
+		, first_entry_id(0)
 	{
 	}
 
@@ -32,13 +36,23 @@ namespace nnforge
 		float * data)
 	{
 		unsigned int original_entry_id = entry_id / transformer_sample_count;
+		unsigned int sample_id = entry_id - original_entry_id * transformer_sample_count;
+		// Transformers applied on top draw from streams starting with 1, see transformed_structured_data_reader
+		counter_random_generator gen(seed, epoch_id, first_entry_id + entry_id, 0);
+
+		const unsigned char * raw_data_ptr;
+		size_t raw_data_length;
+		if (raw_reader->raw_read(original_entry_id, raw_data_ptr, raw_data_length))
+		{
+			transformer->transform(sample_id, raw_data_ptr, raw_data_length, data, gen);
+			return true;
+		}
 
 		std::vector<unsigned char> raw_data;
 		if (!raw_reader->raw_read(original_entry_id, raw_data))
 			return false;
 
-		unsigned int sample_id = entry_id - original_entry_id * transformer_sample_count;
-		transformer->transform(sample_id, raw_data, data);
+		transformer->transform(sample_id, raw_data.empty() ? 0 : &raw_data[0], raw_data.size(), data, gen);
 		return true;
 	}
 
@@ -59,6 +73,16 @@ namespace nnforge
 		return raw_reader->get_entry_count() * transformer_sample_count;
 	}
 
+	void structured_from_raw_data_reader::set_epoch(unsigned int epoch_id)
+	{
+		this->epoch_id = epoch_id;
+	}
+
+	void structured_from_raw_data_reader::set_first_entry_id(unsigned int first_entry_id)
+	{
+		this->first_entry_id = first_entry_id;
+	}
+
 	raw_data_writer::ptr structured_from_raw_data_reader::get_writer(std::shared_ptr<std::ostream> out) const
 	{
 		return raw_reader->get_writer(out);
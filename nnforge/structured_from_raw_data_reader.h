@@ -27,9 +27,12 @@ namespace nnforge
 	public:
 		typedef std::shared_ptr<structured_from_raw_data_reader> ptr;
 
+		// Random parameters of each entry are drawn from the stream keyed with (seed, epoch, entry_id),
+		// so the data doesn't depend on the order entries are read in
 		structured_from_raw_data_reader(
 			raw_data_reader::ptr raw_reader,
-			raw_to_structured_data_transformer::ptr transformer);
+			raw_to_structured_data_transformer::ptr transformer,
+			unsigned int seed = 0);
 
 		virtual ~structured_from_raw_data_reader() = default;
 
@@ -45,12 +48,19 @@ namespace nnforge
 
 		virtual int get_entry_count() const;
 
+		virtual void set_epoch(unsigned int epoch_id);
+
+		virtual void set_first_entry_id(unsigned int first_entry_id);
+
 		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
 
 	protected:
 		raw_data_reader::ptr raw_reader;
 		raw_to_structured_data_transformer::ptr transformer;
 		unsigned int transformer_sample_count;
+		unsigned int seed;
+		unsigned int epoch_id;
+		unsigned int first_entry_id;
 
 	protected:
 		structured_from_raw_data_reader() = default;
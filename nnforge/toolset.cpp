@@ -24,10 +24,21 @@
 #include <boost/algorithm/string.hpp>
 #include <numeric>
 #include <regex>
+#include <typeinfo>
+#include <limits>
+#include <algorithm>
+#include <boost/uuid/uuid.hpp>
+#include <thread>
+#include <cstring>
+#include <exception>
+#include <chrono>
+#include <cmath>
+#include <atomic>
 
 #include "layer_factory.h"
 #include "neural_network_exception.h"
 #include "neuron_value_set_data_bunch_writer.h"
+#include "average_data_bunch_writer.h"
 #include "network_trainer_sgd.h"
 #include "network_data_peeker_random.h"
 #include "complex_network_data_pusher.h"
@@ -38,9 +49,14 @@
 #include "validate_progress_network_data_pusher.h"
 #include "structured_data_stream_writer.h"
 #include "structured_data_bunch_stream_reader.h"
+#include "structured_data_mapped_reader.h"
+#include "structured_data_quantized_reader.h"
+#include "structured_data_quantized_stream_writer.h"
+#include "structured_data_stream_schema.h"
 #include "data_visualizer.h"
 #include "transformed_structured_data_reader.h"
 #include "structured_data_constant_reader.h"
+#include "structured_data_sharded_reader.h"
 #include "structured_data_bunch_mix_reader.h"
 #include "neuron_value_set_data_bunch_reader.h"
 #include "exponential_learning_rate_decay_policy.h"
@@ -48,6 +64,9 @@
 #include "batch_norm_layer.h"
 #include "stat_data_bunch_writer.h"
 #include "training_data_util.h"
+#include "packed_network_data.h"
+#include "network_data_async_writer.h"
+#include "structured_data_bunch_shared_reader.h"
 
 namespace nnforge
 {
@@ -56,11 +75,15 @@ namespace nnforge
 	const char * toolset::debug_subfolder_name = "debug";
 	const char * toolset::profile_subfolder_name = "profile";
 	const char * toolset::dump_data_subfolder_name = "dump_data";
-	const char * toolset::trained_ann_index_extractor_pattern = "^ann_trained_(\\d+)$";
-	const char * toolset::snapshot_ann_index_extractor_pattern = "^ann_trained_(\\d+)_epoch_(\\d+)$";
+	const char * toolset::trained_ann_index_extractor_pattern = "^ann_trained_(\\d+)(\\.nnd)?$";
+	const char * toolset::snapshot_ann_index_extractor_pattern = "^ann_trained_(\\d+)_epoch_(\\d+)(\\.nnd)?$";
 	const char * toolset::ann_snapshot_subfolder_name = "snapshots";
 	const char * toolset::dataset_extractor_pattern = "^%1%_(.+)\\.dt$";
+	const char * toolset::shard_dataset_name_pattern = "%1%-shard%|2$04d|";
+	const char * toolset::sharded_dataset_index_file_name_pattern = "%1%.shards";
 	const char * toolset::dataset_value_data_layer_name = "dataset_value";
+	const unsigned int toolset::shuffle_stream_buffer_size = 1 << 18;
+	const unsigned int toolset::shuffle_max_open_bucket_count = 256;
 
 	toolset::toolset(factory_generator::ptr master_factory)
 		: master_factory(master_factory)
@@ -97,6 +120,10 @@ namespace nnforge
 		{
 			shuffle_data();
 		}
+		else if (!action.compare("quantize_data"))
+		{
+			quantize_data();
+		}
 		else if (!action.compare("dump_data"))
 		{
 			dump_data();
@@ -117,6 +144,10 @@ namespace nnforge
 		{
 			update_bn_weights();
 		}
+		else if (!action.compare("pack_network_data"))
+		{
+			pack_network_data();
+		}
 		else
 		{
 			do_custom_action();
@@ -287,6 +318,10 @@ namespace nnforge
 			std::cout << buffer << std::endl;
 		}
 
+		// The seed picked is dumped with the rest of the settings, so that the run can be reproduced
+		if (data_transformer_seed < 0)
+			data_transformer_seed = static_cast<int>(rnd::get_time_dependent_seed() & 0x7FFFFFFF);
+
 		dump_settings();
 		std::cout << "----------------------------------------" << std::endl;
 
@@ -326,11 +361,13 @@ namespace nnforge
 	{
 		std::vector<string_option> res;
 
-		res.push_back(string_option("action", &action, get_default_action().c_str(), "run action (info, prepare_training_data, prepare_testing_data, shuffle_data, dump_data, dump_schema, create_normalizer, inference, train, save_random_weights, update_bn_weights)"));
+		res.push_back(string_option("action", &action, get_default_action().c_str(), "run action (info, prepare_training_data, prepare_testing_data, shuffle_data, quantize_data, dump_data, dump_schema, create_normalizer, inference, train, save_random_weights, update_bn_weights, pack_network_data)"));
 		res.push_back(string_option("schema", &schema_filename, "schema.txt", "Name of the file with schema of the network, in protobuf format"));
 		res.push_back(string_option("inference_dataset_name", &inference_dataset_name, "validating", "Name of the dataset to be used for inference"));
 		res.push_back(string_option("training_dataset_name", &training_dataset_name, "training", "Name of the dataset to be used for training"));
 		res.push_back(string_option("shuffle_dataset_name", &shuffle_dataset_name, "training", "Name of the dataset to be shuffled"));
+		res.push_back(string_option("quantize_dataset_name", &quantize_dataset_name, "training", "Name of the dataset to be quantized"));
+		res.push_back(string_option("quantized_type", &quantized_type_name, "uint8", "Storage type of quantized data (uint8, fp16)"));
 		res.push_back(string_option("training_algo", &training_algo, "", "Training algorithm (sgd)"));
 		res.push_back(string_option("momentum_type", &momentum_type_str, "vanilla", "Type of the momentum to use (none, vanilla, nesterov, adam)"));
 		res.push_back(string_option("inference_mode", &inference_mode, "report_average_per_entry", "What to do with inference_output_layer_name (report_average_per_nn, dump_average_across_nets)"));
@@ -383,6 +420,7 @@ namespace nnforge
 		res.push_back(bool_option("resume_from_snapshot,R", &resume_from_snapshot, false, "Continue neural network training starting from saved snapshot"));
 		res.push_back(bool_option("dump_snapshot", &dump_snapshot, true, "Dump neural network data after each epoch"));
 		res.push_back(bool_option("dump_data_rgb", &dump_data_rgb, true, "Treat 3 feature map data layer as RGB"));
+		res.push_back(bool_option("map_data_files", &map_data_files, true, "Memory-map structured data files instead of reading them through streams"));
 
 		return res;
 	}
@@ -400,6 +438,7 @@ namespace nnforge
 		res.push_back(float_option("check_gradient_base_step", &check_gradient_base_step, 1.0e-2F, "Base step size for gradient check"));
 		res.push_back(float_option("check_gradient_relative_threshold_warning", &check_gradient_relative_threshold_warning, 0.2F, "Threshold for gradient check"));
 		res.push_back(float_option("check_gradient_relative_threshold_error", &check_gradient_relative_threshold_error, 1.0F, "Threshold for gradient check"));
+		res.push_back(float_option("update_bn_tolerance", &update_bn_tolerance, 0.0F, "Stop updating Batch Normalization weights after the pass which changed both the mean by less than this amount of sigmas and the inverse sigma by less than this relative amount in all the layers, the default 0 disables the check and keeps the statistics exact"));
 
 		return res;
 	}
@@ -412,6 +451,7 @@ namespace nnforge
 		res.push_back(int_option("learning_rate_decay_start_epoch", &learning_rate_decay_start_epoch, 0, "Exponential learning rate decay starts at this epoch"));
 		res.push_back(int_option("batch_size,B", &batch_size, 1, "Training mini-batch size"));
 		res.push_back(int_option("ann_count,N", &ann_count, 1, "Amount of networks to train"));
+		res.push_back(int_option("data_transformer_seed", &data_transformer_seed, -1, "Random data transformations are fully determined by this seed, epoch and entry, negative value means time dependent seed"));
 		res.push_back(int_option("inference_ann_data_index", &inference_ann_data_index, -1, "Index of the dataset to be used for inference"));
 		res.push_back(int_option("batch_offset", &batch_offset, 0, "Shift initial ANN index when batch training"));
 		res.push_back(int_option("dump_data_sample_count", &dump_data_sample_count, 100, "Samples to dump"));
@@ -421,8 +461,15 @@ namespace nnforge
 		res.push_back(int_option("epoch_count_in_validating_dataset", &epoch_count_in_validating_dataset, 1, "Splitting validating dataset in multiple chunks, effectively the first chunk only will be used for inference"));
 		res.push_back(int_option("dump_compact_samples", &dump_compact_samples, 1, "Compact (average) results acrioss samples for inference of type dump_average_across_nets"));
 		res.push_back(int_option("shuffle_block_size", &shuffle_block_size, 0, "The size of contiguous blocks when shuffling training data, 0 indicates no shuffling"));
+		res.push_back(int_option("prepare_shard_count", &prepare_shard_count, 1, "Amount of shards to split datasets into when preparing data, shards are written in parallel"));
+		res.push_back(int_option("shuffle_memory_mb", &shuffle_memory_mb, 2048, "Memory budget of shuffle_data in megabytes including stream buffers, larger datasets are shuffled through temporary bucket files"));
+		res.push_back(int_option("inference_ensemble_chunk_size", &inference_ensemble_chunk_size, 0, "Load all the networks at once and run them on chunks of this amount of entries, so that inference data is read once, the networks split the memory limit among them, 0 runs networks one by one"));
+		res.push_back(int_option("update_bn_pass_count", &update_bn_pass_count, 0, "The maximum amount of passes over the training data when updating Batch Normalization weights. The default 0 matches updating the layers one by one exactly, which costs one pass per level of Batch Normalization layers (the number of them on the longest path), each pass computing the network up to the inputs of its level only. Positive values update all the remaining levels in the last pass, trading the accuracy of the statistics of deeper layers for fewer passes. update_bn_tolerance is the cheap option, it stops once the statistics settle"));
 		res.push_back(int_option("check_gradient_max_weights_per_set", &check_gradient_max_weights_per_set, 20, "The maximum amount of weights to check in the set"));
 		res.push_back(int_option("keep_snapshots_frequency", &keep_snapshots_frequency, 10, "Keep every Nth snapshot"));
+		res.push_back(int_option("training_concurrent_ann_count", &training_concurrent_ann_count, 1, "The amount of networks trained concurrently, each entry of the training data is read once for all of them, the cores and the memory are split among them"));
+		res.push_back(int_option("training_shared_reader_cache_mb", &training_shared_reader_cache_mb, 1024, "Memory budget in megabytes for training entries kept for the networks trained concurrently and for the forward propagations gathering Batch Normalization statistics in one pass, entries beyond it are read separately for each of them"));
+		res.push_back(int_option("snapshot_max_pending_count", &snapshot_max_pending_count, 8, "The maximum amount of snapshot folder writes and removals queued in the background before training waits for them"));
 
 		return res;
 	}
@@ -557,6 +604,9 @@ namespace nnforge
 		std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
 		std::cout << "Running inference for " << ann_data_name_and_folderpath_list.size() << " networks..." << std::endl;
 
+		if (forward_prop->is_schema_with_weights() && (inference_ensemble_chunk_size > 0) && (ann_data_name_and_folderpath_list.size() > 1))
+			return run_fused_ensemble_inference(*schema, *reader, ann_data_name_and_folderpath_list);
+
 		std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> > average_layer_name_to_config_and_value_set_map;
 		unsigned int accumulated_count = 0;
 
@@ -638,13 +688,9 @@ namespace nnforge
 				std::shared_ptr<std::ostream> out(new boost::filesystem::ofstream(file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary));
 				{
 					structured_data_stream_writer dw(out, it->second.first);
-					const std::vector<std::shared_ptr<std::vector<float> > >& data = it->second.second->neuron_value_list;
-					unsigned int entry_id = 0;
-					for(std::vector<std::shared_ptr<std::vector<float> > >::const_iterator data_it = data.begin(); data_it != data.end(); ++data_it, ++entry_id)
-					{
-						const std::vector<float>& dd = **data_it;
-						dw.write(entry_id, &dd[0]);
-					}
+					const neuron_value_set& data = *it->second.second;
+					for(unsigned int entry_id = 0; entry_id < data.get_entry_count(); ++entry_id)
+						dw.write(entry_id, data.get_entry(entry_id));
 				}
 			}
 		}
@@ -658,14 +704,38 @@ namespace nnforge
 		unsigned int multiple_epoch_count,
 		unsigned int shuffle_block_size) const
 	{
-		std::map<std::string, boost::filesystem::path> data_filenames = get_data_filenames(dataset_name);
-
 		std::map<std::string, structured_data_reader::ptr> data_reader_map;
-		for(std::map<std::string, boost::filesystem::path>::const_iterator it = data_filenames.begin(); it != data_filenames.end(); ++it)
+		sharded_dataset_index::ptr index = get_sharded_dataset_index(dataset_name);
+		if (index)
 		{
-			std::shared_ptr<std::istream> in(new boost::filesystem::ifstream(it->second, std::ios_base::in | std::ios_base::binary));
-			structured_data_reader::ptr dr = apply_transformers(get_structured_reader(dataset_name, it->first, usage, in), get_data_transformer_list(dataset_name, it->first, usage));
-			data_reader_map.insert(std::make_pair(it->first, dr));
+			// Shards are expected to have the same set of layers.
+			// Transformers are applied on top of the concatenated shards, so their random streams are keyed with the dataset entry IDs
+			std::map<std::string, boost::filesystem::path> data_filenames = get_data_filenames(get_shard_dataset_name(dataset_name, 0));
+			for(std::map<std::string, boost::filesystem::path>::const_iterator it = data_filenames.begin(); it != data_filenames.end(); ++it)
+			{
+				std::vector<structured_data_reader::ptr> shard_reader_list;
+				for(unsigned int shard_id = 0; shard_id < index->get_shard_count(); ++shard_id)
+				{
+					boost::filesystem::path shard_file_path = get_data_filenames(get_shard_dataset_name(dataset_name, shard_id))[it->first];
+					if (shard_file_path.empty())
+						throw neural_network_exception((boost::format("Data for layer %1% not found in shard %2% of dataset %3%") % it->first % shard_id % dataset_name).str());
+					structured_data_reader::ptr dr = get_layer_data_reader(dataset_name, it->first, usage, shard_file_path, shuffle_block_size > 0);
+					if (dr->get_entry_count() != static_cast<int>(index->get_entry_count(shard_id)))
+						throw neural_network_exception((boost::format("Entry count mismatch for shard %1%: %2% in index and %3% in %4%") % shard_id % index->get_entry_count(shard_id) % dr->get_entry_count() % shard_file_path.string()).str());
+					shard_reader_list.push_back(dr);
+				}
+				structured_data_reader::ptr dr(new structured_data_sharded_reader(shard_reader_list));
+				data_reader_map.insert(std::make_pair(it->first, apply_transformers(dr, get_data_transformer_list(dataset_name, it->first, usage))));
+			}
+		}
+		else
+		{
+			std::map<std::string, boost::filesystem::path> data_filenames = get_data_filenames(dataset_name);
+			for(std::map<std::string, boost::filesystem::path>::const_iterator it = data_filenames.begin(); it != data_filenames.end(); ++it)
+			{
+				structured_data_reader::ptr dr = get_layer_data_reader(dataset_name, it->first, usage, it->second, shuffle_block_size > 0);
+				data_reader_map.insert(std::make_pair(it->first, apply_transformers(dr, get_data_transformer_list(dataset_name, it->first, usage))));
+			}
 		}
 
 		data_reader_map.insert(std::make_pair(
@@ -676,6 +746,23 @@ namespace nnforge
 		return res;
 	}
 
+	structured_data_reader::ptr toolset::get_layer_data_reader(
+		const std::string& dataset_name,
+		const std::string& layer_name,
+		dataset_usage usage,
+		const boost::filesystem::path& file_path,
+		bool random_access) const
+	{
+		std::shared_ptr<std::istream> in(new boost::filesystem::ifstream(file_path, std::ios_base::in | std::ios_base::binary));
+		structured_data_reader::ptr dr = get_structured_reader(dataset_name, layer_name, usage, file_path, in);
+		// Readers customized by derived toolsets are kept as is, only the plain stream ones are replaced
+		if (map_data_files && (typeid(*dr) == typeid(structured_data_stream_reader)))
+			dr = structured_data_reader::ptr(new structured_data_mapped_reader(file_path, random_access));
+		else if (map_data_files && (typeid(*dr) == typeid(structured_data_quantized_reader)))
+			dr = structured_data_reader::ptr(new structured_data_quantized_reader(file_path, random_access));
+		return dr;
+	}
+
 	float toolset::get_dataset_value_data_value(
 		const std::string& dataset_name,
 		dataset_usage usage) const
@@ -690,12 +777,232 @@ namespace nnforge
 		return ann_subfolder_name;
 	}
 
+	std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > toolset::run_fused_ensemble_inference(
+		const network_schema& schema,
+		structured_data_bunch_reader& reader,
+		const std::vector<std::pair<unsigned int, boost::filesystem::path> >& ann_data_name_and_folderpath_list)
+	{
+		std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > res;
+
+		bool dump_average = (inference_mode == "dump_average_across_nets");
+		if (!dump_average && (inference_mode != "report_average_per_entry"))
+			throw neural_network_exception((boost::format("Unknown inference_mode specified: %1%") % inference_mode).str());
+		if (dump_average && ((inference_ensemble_chunk_size % dump_compact_samples) != 0))
+			throw neural_network_exception((boost::format("inference_ensemble_chunk_size %1% is not evenly divisible by dump_compact_samples %2%") % inference_ensemble_chunk_size % dump_compact_samples).str());
+
+		unsigned int ann_count = static_cast<unsigned int>(ann_data_name_and_folderpath_list.size());
+		std::vector<forward_propagation::ptr> forward_prop_list;
+		for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
+		{
+			forward_propagation::ptr current_forward_prop = forward_prop_factory->create_coexisting(schema, inference_output_layer_names, debug, profile, ann_count);
+			network_data data;
+			data.read(it->second);
+			current_forward_prop->set_data(data);
+			forward_prop_list.push_back(current_forward_prop);
+		}
+		std::cout << "Loaded " << ann_count << " networks, running them on chunks of " << inference_ensemble_chunk_size << " entries" << std::endl;
+
+		std::set<std::string> data_layer_names;
+		std::vector<layer::const_ptr> data_layers = schema.get_data_layers();
+		for(std::vector<layer::const_ptr>::const_iterator it = data_layers.begin(); it != data_layers.end(); ++it)
+			data_layer_names.insert((*it)->instance_name);
+		structured_data_bunch_reader::ptr narrow_reader = reader.get_narrow_reader(data_layer_names);
+		structured_data_bunch_reader& input_reader = narrow_reader ? *narrow_reader : reader;
+		std::map<std::string, layer_configuration_specific> input_config_map = input_reader.get_config_map();
+		int total_entry_count = input_reader.get_entry_count();
+
+		std::vector<forward_propagation::stat> stat_list(ann_count);
+		for(std::vector<forward_propagation::stat>::iterator it = stat_list.begin(); it != stat_list.end(); ++it)
+		{
+			it->entry_processed_count = 0;
+			it->flops_per_entry = 0.0F;
+			it->total_seconds = 0.0F;
+			it->idle_seconds = 0.0F;
+		}
+		// Per network sums of the output values across all the entries
+		std::vector<std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > sum_layer_map_list(ann_count);
+		std::vector<unsigned long long> output_entry_count_list(ann_count, 0);
+
+		std::string dataset_name = inference_output_dataset_name.empty() ? inference_dataset_name : inference_output_dataset_name;
+		std::map<std::string, std::shared_ptr<structured_data_stream_writer> > dump_writer_map;
+		unsigned int dump_entry_count = 0;
+
+		float read_seconds = 0.0F;
+		unsigned int read_entry_count = 0;
+		while ((total_entry_count < 0) || (read_entry_count < static_cast<unsigned int>(total_entry_count)))
+		{
+			unsigned int chunk_entry_count = static_cast<unsigned int>(inference_ensemble_chunk_size);
+			if (total_entry_count >= 0)
+				chunk_entry_count = std::min(chunk_entry_count, static_cast<unsigned int>(total_entry_count) - read_entry_count);
+
+			std::chrono::high_resolution_clock::time_point read_start = std::chrono::high_resolution_clock::now();
+			std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> > input_layer_name_to_config_and_value_set_map;
+			for(std::map<std::string, layer_configuration_specific>::const_iterator it = input_config_map.begin(); it != input_config_map.end(); ++it)
+				input_layer_name_to_config_and_value_set_map.insert(std::make_pair(it->first, std::make_pair(it->second, neuron_value_set::ptr(new neuron_value_set(it->second.get_neuron_count(), chunk_entry_count)))));
+			unsigned int chunk_read_entry_count = read_entries(input_reader, input_layer_name_to_config_and_value_set_map, read_entry_count, chunk_entry_count);
+			std::chrono::duration<float> read_sec = std::chrono::high_resolution_clock::now() - read_start;
+			read_seconds += read_sec.count();
+			if (chunk_read_entry_count == 0)
+				break;
+			if (dump_average && ((chunk_read_entry_count % dump_compact_samples) != 0))
+				throw neural_network_exception((boost::format("Entry count %1% is not evenly divisible by dump_compact_samples %2%") % (read_entry_count + chunk_read_entry_count) % dump_compact_samples).str());
+			read_entry_count += chunk_read_entry_count;
+
+			neuron_value_set_data_bunch_reader chunk_reader(input_layer_name_to_config_and_value_set_map);
+			std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> > average_layer_name_to_config_and_value_set_map;
+			for(unsigned int ann_id = 0; ann_id < ann_count; ++ann_id)
+			{
+				neuron_value_set_data_bunch_writer writer;
+				forward_propagation::stat st = forward_prop_list[ann_id]->run(chunk_reader, writer);
+				stat_list[ann_id].entry_processed_count += st.entry_processed_count;
+				stat_list[ann_id].flops_per_entry = st.flops_per_entry;
+				stat_list[ann_id].total_seconds += st.total_seconds;
+				stat_list[ann_id].idle_seconds += st.idle_seconds;
+
+				for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::iterator it = writer.layer_name_to_config_and_value_set_map.begin(); it != writer.layer_name_to_config_and_value_set_map.end(); ++it)
+				{
+					unsigned int output_entry_count = it->second.second->get_entry_count();
+					std::shared_ptr<std::vector<double> > average_list = it->second.second->get_average();
+					std::pair<layer_configuration_specific, std::vector<double> >& sum = sum_layer_map_list[ann_id][it->first];
+					if (sum.second.empty())
+						sum = std::make_pair(it->second.first, std::vector<double>(average_list->size(), 0.0));
+					for(unsigned int i = 0; i < static_cast<unsigned int>(average_list->size()); ++i)
+						sum.second[i] += average_list->at(i) * static_cast<double>(output_entry_count);
+					if (it == writer.layer_name_to_config_and_value_set_map.begin())
+						output_entry_count_list[ann_id] += output_entry_count;
+
+					if (dump_average)
+					{
+						it->second.second->compact(dump_compact_samples);
+
+						if (ann_id == 0)
+							average_layer_name_to_config_and_value_set_map.insert(*it);
+						else
+						{
+							float alpha = 1.0F / static_cast<float>(ann_id + 1);
+							float beta = 1.0F - alpha;
+							average_layer_name_to_config_and_value_set_map[it->first].second->add(*it->second.second, alpha, beta);
+						}
+					}
+				}
+			}
+
+			if (dump_average)
+			{
+				unsigned int chunk_dump_entry_count = 0;
+				for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = average_layer_name_to_config_and_value_set_map.begin(); it != average_layer_name_to_config_and_value_set_map.end(); ++it)
+				{
+					std::shared_ptr<structured_data_stream_writer>& dw = dump_writer_map[it->first];
+					if (!dw)
+					{
+						std::string file_name = (boost::format("%1%_%2%.dt") % dataset_name % it->first).str();
+						boost::filesystem::path file_path = get_working_data_folder() / file_name;
+						std::cout << "Writing " << file_path.string() << std::endl;
+						std::shared_ptr<std::ostream> out(new boost::filesystem::ofstream(file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary));
+						dw = std::shared_ptr<structured_data_stream_writer>(new structured_data_stream_writer(out, it->second.first));
+					}
+
+					const neuron_value_set& data = *it->second.second;
+					for(unsigned int entry_id = 0; entry_id < data.get_entry_count(); ++entry_id)
+						dw->write(dump_entry_count + entry_id, data.get_entry(entry_id));
+					chunk_dump_entry_count = data.get_entry_count();
+				}
+				dump_entry_count += chunk_dump_entry_count;
+			}
+
+			if (chunk_read_entry_count < chunk_entry_count)
+				break;
+		}
+		// Writers complete their files when destroyed
+		dump_writer_map.clear();
+
+		std::cout << (boost::format("Read %1% entries once for %2% networks in %|3$.2f| seconds") % read_entry_count % ann_count % read_seconds).str() << std::endl;
+		for(unsigned int ann_id = 0; ann_id < ann_count; ++ann_id)
+		{
+			std::cout << "NN # " << ann_data_name_and_folderpath_list[ann_id].first << " - " << stat_list[ann_id] << std::endl;
+
+			std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > >& res_layer_map = res[ann_data_name_and_folderpath_list[ann_id].first];
+			double mult = 1.0 / static_cast<double>(output_entry_count_list[ann_id]);
+			for(std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > >::const_iterator it = sum_layer_map_list[ann_id].begin(); it != sum_layer_map_list[ann_id].end(); ++it)
+			{
+				std::vector<double> average_list(it->second.second);
+				for(std::vector<double>::iterator it2 = average_list.begin(); it2 != average_list.end(); ++it2)
+					*it2 *= mult;
+				res_layer_map.insert(std::make_pair(it->first, std::make_pair(it->second.first, average_list)));
+
+				if (!dump_average)
+					std::cout << schema.get_layer(it->first)->get_string_for_average_data(it->second.first, average_list) << std::endl;
+			}
+		}
+
+		return res;
+	}
+
+	unsigned int toolset::read_entries(
+		structured_data_bunch_reader& reader,
+		const std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >& layer_name_to_config_and_value_set_map,
+		unsigned int first_entry_id,
+		unsigned int entry_count) const
+	{
+		std::atomic<unsigned int> next_entry_id(0);
+		std::atomic<unsigned int> read_entry_count(entry_count);
+		unsigned int thread_count = std::max(std::min(std::thread::hardware_concurrency(), entry_count), 1U);
+		std::vector<std::exception_ptr> error_list(thread_count);
+		{
+			std::vector<std::thread> thread_list;
+			for(unsigned int thread_id = 0; thread_id < thread_count; ++thread_id)
+			{
+				thread_list.push_back(std::thread([&, thread_id] ()
+				{
+					try
+					{
+						std::map<std::string, float *> data_map;
+						while (true)
+						{
+							unsigned int entry_id = next_entry_id++;
+							if (entry_id >= read_entry_count)
+								break;
+
+							for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = layer_name_to_config_and_value_set_map.begin(); it != layer_name_to_config_and_value_set_map.end(); ++it)
+								data_map[it->first] = it->second.second->get_entry(entry_id);
+							if (!reader.read(first_entry_id + entry_id, data_map))
+							{
+								// Keep the lowest entry which cannot be read, everything starting from it is discarded
+								unsigned int current_read_entry_count = read_entry_count;
+								while ((entry_id < current_read_entry_count) && !read_entry_count.compare_exchange_weak(current_read_entry_count, entry_id))
+								{
+								}
+								break;
+							}
+						}
+					}
+					catch (...)
+					{
+						error_list[thread_id] = std::current_exception();
+					}
+				}));
+			}
+			for(std::vector<std::thread>::iterator it = thread_list.begin(); it != thread_list.end(); ++it)
+				it->join();
+		}
+		for(std::vector<std::exception_ptr>::const_iterator it = error_list.begin(); it != error_list.end(); ++it)
+			if (*it)
+				std::rethrow_exception(*it);
+
+		for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = layer_name_to_config_and_value_set_map.begin(); it != layer_name_to_config_and_value_set_map.end(); ++it)
+			it->second.second->resize(read_entry_count);
+
+		return read_entry_count;
+	}
+
 	std::vector<std::pair<unsigned int, boost::filesystem::path> > toolset::get_ann_data_index_and_folderpath_list() const
 	{
 		std::vector<std::pair<unsigned int, boost::filesystem::path> > res;
 
 		boost::filesystem::path trained_data_folder = get_working_data_folder() / get_ann_subfolder_name();
 
+		// Packed file takes precedence over the folder of the same network
+		std::map<unsigned int, std::pair<bool, boost::filesystem::path> > ann_data_index_to_packed_and_path_map;
 		std::regex expression(trained_ann_index_extractor_pattern);
 		std::cmatch what;
 		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(trained_data_folder); it != boost::filesystem::directory_iterator(); ++it)
@@ -709,10 +1016,18 @@ namespace nnforge
 				if ((inference_ann_data_index != -1) && (inference_ann_data_index != ann_data_index))
 					continue;
 
-				res.push_back(std::make_pair(ann_data_index, folder_path));
+				bool packed = what[2].matched;
+				std::map<unsigned int, std::pair<bool, boost::filesystem::path> >::iterator it2 = ann_data_index_to_packed_and_path_map.find(ann_data_index);
+				if (it2 == ann_data_index_to_packed_and_path_map.end())
+					ann_data_index_to_packed_and_path_map.insert(std::make_pair(ann_data_index, std::make_pair(packed, folder_path)));
+				else if (packed)
+					it2->second = std::make_pair(packed, folder_path);
 			}
 		}
 
+		for(std::map<unsigned int, std::pair<bool, boost::filesystem::path> >::const_iterator it = ann_data_index_to_packed_and_path_map.begin(); it != ann_data_index_to_packed_and_path_map.end(); ++it)
+			res.push_back(std::make_pair(it->first, it->second.second));
+
 		return res;
 	}
 
@@ -754,14 +1069,16 @@ namespace nnforge
 		std::vector<network_data_pusher::ptr> train_modifiers_before_snapshot = get_train_modifiers_before_snapshot(get_schema(schema_usage_train));
 		progress.insert(progress.end(), train_modifiers_before_snapshot.begin(), train_modifiers_before_snapshot.end());
 
+		network_data_async_writer::ptr snapshot_writer;
 		if (dump_snapshot)
 		{
-			progress.push_back(network_data_pusher::ptr(new save_snapshot_network_data_pusher(batch_snapshot_folder)));
+			snapshot_writer = network_data_async_writer::ptr(new network_data_async_writer(snapshot_max_pending_count));
+			progress.push_back(network_data_pusher::ptr(new save_snapshot_network_data_pusher(batch_snapshot_folder, snapshot_writer)));
 		}
 
 		if (keep_snapshots_frequency > 1)
 		{
-			progress.push_back(network_data_pusher::ptr(new clean_snapshots_network_data_pusher(batch_snapshot_folder, keep_snapshots_frequency)));
+			progress.push_back(network_data_pusher::ptr(new clean_snapshots_network_data_pusher(batch_snapshot_folder, keep_snapshots_frequency, snapshot_writer)));
 		}
 
 		std::vector<network_data_pusher::ptr> validators_for_training = get_validators_for_training(get_schema(schema_usage_validate_when_train));
@@ -782,6 +1099,9 @@ namespace nnforge
 			*peeker,
 			progress,
 			res);
+
+		if (snapshot_writer)
+			snapshot_writer->wait();
 	}
 
 	std::vector<network_data_pusher::ptr> toolset::get_validators_for_training(network_schema::const_ptr schema)
@@ -851,14 +1171,17 @@ namespace nnforge
 			
 			{
 				std::string folder_name = (boost::format("ann_trained_%|1$03d|_epoch_%|2$05d|") % new_item.index % new_item.start_epoch).str();
-				boost::filesystem::path folder_path = snapshot_ann_folder_path / folder_name;
+				boost::filesystem::path folder_path = network_data_async_writer::get_recovered_folder_path(snapshot_ann_folder_path / folder_name);
+				// The snapshot might have been packed by pack_network_data
+				if (!boost::filesystem::exists(folder_path))
+					folder_path += packed_network_data::file_extension;
 				new_item.data = network_data::ptr(new network_data());
 				new_item.data->read(folder_path);
 			}
 
 			{
 				std::string momentum_folder_name = (boost::format("momentum_%|1$03d|") % new_item.index).str();
-				boost::filesystem::path momentum_folder_path = snapshot_ann_folder_path / momentum_folder_name;
+				boost::filesystem::path momentum_folder_path = network_data_async_writer::get_recovered_folder_path(snapshot_ann_folder_path / momentum_folder_name);
 				if (boost::filesystem::exists(momentum_folder_path))
 				{
 					new_item.momentum_data = network_data::ptr(new network_data());
@@ -868,7 +1191,7 @@ namespace nnforge
 
 			{
 				std::string momentum2_folder_name = (boost::format("momentum2_%|1$03d|") % new_item.index).str();
-				boost::filesystem::path momentum2_folder_path = snapshot_ann_folder_path / momentum2_folder_name;
+				boost::filesystem::path momentum2_folder_path = network_data_async_writer::get_recovered_folder_path(snapshot_ann_folder_path / momentum2_folder_name);
 				if (boost::filesystem::exists(momentum2_folder_path))
 				{
 					new_item.momentum_data2 = network_data::ptr(new network_data());
@@ -902,11 +1225,15 @@ namespace nnforge
 
 		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(snapshot_ann_folder_path); it != boost::filesystem::directory_iterator(); ++it)
 		{
-			if (it->status().type() == boost::filesystem::directory_file)
+			if ((it->status().type() == boost::filesystem::directory_file) || (it->status().type() == boost::filesystem::regular_file))
 			{
 				boost::filesystem::path folder_path = it->path();
 				std::string folder_name = folder_path.filename().string();
 
+				// The old folder stands for the final one when the snapshot writer was interrupted replacing it
+				if ((folder_path.extension() == ".old") && !boost::filesystem::exists(folder_path.parent_path() / folder_path.stem()))
+					folder_name = folder_path.stem().string();
+
 				if (std::regex_search(folder_name.c_str(), what, expression))
 				{
 					unsigned int index = static_cast<unsigned int>(atol(std::string(what[1].first, what[1].second).c_str()));
@@ -937,7 +1264,7 @@ namespace nnforge
 
 		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(trained_ann_folder_path); it != boost::filesystem::directory_iterator(); ++it)
 		{
-			if (it->status().type() == boost::filesystem::directory_file)
+			if ((it->status().type() == boost::filesystem::directory_file) || (it->status().type() == boost::filesystem::regular_file))
 			{
 				boost::filesystem::path folder_path = it->path();
 				std::string folder_name = folder_path.filename().string();
@@ -959,13 +1286,17 @@ namespace nnforge
 
 		network_schema::ptr schema = get_schema(schema_usage_train);
 
-		backward_propagation::ptr backprop = backward_prop_factory->create(
-			*schema,
-			training_output_layer_names,
-			training_error_source_layer_names,
-			training_exclude_data_update_layer_names,
-			debug,
-			profile);
+		std::vector<backward_propagation::ptr> backprop_list;
+		unsigned int concurrent_ann_count = static_cast<unsigned int>(std::max(training_concurrent_ann_count, 1));
+		for(unsigned int i = 0; i < concurrent_ann_count; ++i)
+			backprop_list.push_back(backward_prop_factory->create_concurrent(
+				*schema,
+				training_output_layer_names,
+				training_error_source_layer_names,
+				training_exclude_data_update_layer_names,
+				debug,
+				profile,
+				concurrent_ann_count));
 
 		if (training_algo == "sgd")
 		{
@@ -975,7 +1306,7 @@ namespace nnforge
 					training_output_layer_names,
 					training_error_source_layer_names,
 					training_exclude_data_update_layer_names,
-					backprop));
+					backprop_list));
 
 			res = typed_res;
 		}
@@ -987,6 +1318,7 @@ namespace nnforge
 		res->lr_policy = lr_policy;
 		res->weight_decay = weight_decay;
 		res->batch_size = batch_size;
+		res->shared_reader_max_cache_mb = static_cast<unsigned int>(std::max(training_shared_reader_cache_mb, 0));
 		res->momentum = training_momentum(momentum_type_str, momentum_val, momentum_val2);
 
 		return res;
@@ -1004,14 +1336,17 @@ namespace nnforge
 
 	void toolset::shuffle_data()
 	{
+		if (get_sharded_dataset_index(shuffle_dataset_name))
+			throw neural_network_exception((boost::format("Shuffling sharded dataset %1% is not supported, prepare it shuffled instead") % shuffle_dataset_name).str());
+
 		std::map<std::string, boost::filesystem::path> data_filenames = get_data_filenames(shuffle_dataset_name);
 
 		int entry_count = -1;
 		for(std::map<std::string, boost::filesystem::path>::const_iterator it = data_filenames.begin(); it != data_filenames.end(); ++it)
 		{
 			std::shared_ptr<std::istream> in(new boost::filesystem::ifstream(it->second, std::ios_base::in | std::ios_base::binary));
-			structured_data_stream_reader dr(in);
-			int new_entry_count = dr.get_entry_count();
+			raw_data_reader::ptr dr = get_raw_reader(shuffle_dataset_name, it->first, dataset_usage_shuffle_data, it->second, in);
+			int new_entry_count = dr->get_entry_count();
 			if (new_entry_count < 0)
 				throw std::runtime_error((boost::format("Unknown entry count in %1%") % it->second.string()).str());
 			if (entry_count < 0)
@@ -1027,41 +1362,390 @@ namespace nnforge
 			return;
 		}
 
-		std::cout << "Shuffling " << entry_count << " entries in " << shuffle_dataset_name << " dataset" << std::endl;
-
-		std::vector<unsigned int> shuffled_indexes(entry_count);
+		unsigned long long total_size = 0;
+		for(std::map<std::string, boost::filesystem::path>::const_iterator it = data_filenames.begin(); it != data_filenames.end(); ++it)
+			total_size += static_cast<unsigned long long>(boost::filesystem::file_size(it->second));
+
+		// Files are shuffled concurrently. When scattering, each of them reads one file and writes at most max_open_bucket_count ones,
+		// stream buffers of these take half of the budget at most. When gathering, each of them keeps a single bucket in memory,
+		// bucket sizes vary, leave some headroom
+		unsigned long long memory_budget = static_cast<unsigned long long>(std::max(shuffle_memory_mb, 1)) * 1024ULL * 1024ULL;
+		unsigned long long file_count = static_cast<unsigned long long>(data_filenames.size());
+		unsigned int max_open_stream_count = static_cast<unsigned int>(std::min(
+			memory_budget / 2 / file_count / shuffle_stream_buffer_size,
+			static_cast<unsigned long long>(shuffle_max_open_bucket_count) + 1));
+		if (max_open_stream_count < 3)
+			throw neural_network_exception((boost::format("shuffle_memory_mb = %1% is too small to shuffle %2% files, at least %3% MB is required")
+				% shuffle_memory_mb % file_count % ((6ULL * shuffle_stream_buffer_size * file_count + 1024ULL * 1024ULL - 1ULL) / (1024ULL * 1024ULL))).str());
+		unsigned int max_open_bucket_count = max_open_stream_count - 1;
+		unsigned long long gather_memory_budget = memory_budget - static_cast<unsigned long long>(max_open_stream_count) * shuffle_stream_buffer_size * file_count;
+		unsigned int bucket_count = static_cast<unsigned int>(std::min((total_size + total_size / 4) / gather_memory_budget + 1, static_cast<unsigned long long>(entry_count)));
+		unsigned int scatter_pass_count = 1;
+		for(unsigned long long span = max_open_bucket_count; span < bucket_count; span *= max_open_bucket_count)
+			++scatter_pass_count;
+
+		std::cout << "Shuffling " << entry_count << " entries in " << shuffle_dataset_name << " dataset, " << data_filenames.size() << " files, "
+			<< (total_size / (1024 * 1024)) << " MB, " << bucket_count << " buckets, " << scatter_pass_count << " scatter passes" << std::endl;
+
+		// Each entry goes to the random bucket, entries within each bucket are randomly permuted then.
+		// Concatenating buckets results in uniformly distributed permutation
+		std::vector<unsigned int> bucket_id_list(entry_count);
+		std::vector<std::vector<unsigned int> > bucket_permutation_list(bucket_count);
 		{
-			for(unsigned int i = 0; i < static_cast<unsigned int>(entry_count); ++i)
-				shuffled_indexes[i] = i;
 			random_generator rnd = rnd::get_random_generator();
-			for(unsigned int i = static_cast<unsigned int>(entry_count) - 1; i > 0; --i)
+			std::uniform_int_distribution<unsigned int> bucket_dist(0, bucket_count - 1);
+			std::vector<unsigned int> bucket_entry_count_list(bucket_count, 0);
+			for(unsigned int i = 0; i < static_cast<unsigned int>(entry_count); ++i)
+			{
+				unsigned int bucket_id = bucket_dist(rnd);
+				bucket_id_list[i] = bucket_id;
+				++bucket_entry_count_list[bucket_id];
+			}
+			for(unsigned int bucket_id = 0; bucket_id < bucket_count; ++bucket_id)
 			{
-				std::uniform_int_distribution<unsigned int> dist(0, i);
-				unsigned int index = dist(rnd);
-				std::swap(shuffled_indexes[i], shuffled_indexes[index]);
+				std::vector<unsigned int>& permutation = bucket_permutation_list[bucket_id];
+				permutation.resize(bucket_entry_count_list[bucket_id]);
+				for(unsigned int i = 0; i < static_cast<unsigned int>(permutation.size()); ++i)
+					permutation[i] = i;
+				for(unsigned int i = static_cast<unsigned int>(permutation.size()); i > 1; --i)
+				{
+					std::uniform_int_distribution<unsigned int> dist(0, i - 1);
+					unsigned int index = dist(rnd);
+					std::swap(permutation[i - 1], permutation[index]);
+				}
 			}
 		}
 
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		std::vector<std::string> layer_name_list;
+		std::vector<boost::filesystem::path> file_path_list;
 		for(std::map<std::string, boost::filesystem::path>::const_iterator it = data_filenames.begin(); it != data_filenames.end(); ++it)
+		{
+			layer_name_list.push_back(it->first);
+			file_path_list.push_back(it->second);
+		}
+		std::vector<unsigned long long> bytes_processed_list(file_path_list.size(), 0);
+		std::vector<float> scatter_seconds_list(file_path_list.size(), 0.0F);
+		std::vector<float> gather_seconds_list(file_path_list.size(), 0.0F);
+		std::vector<std::exception_ptr> error_list(file_path_list.size());
+		{
+			std::vector<std::thread> thread_list;
+			for(unsigned int file_id = 0; file_id < static_cast<unsigned int>(file_path_list.size()); ++file_id)
+			{
+				thread_list.push_back(std::thread([&, file_id] ()
+				{
+					try
+					{
+						shuffle_data_file(
+							layer_name_list[file_id],
+							file_path_list[file_id],
+							bucket_id_list,
+							bucket_permutation_list,
+							max_open_bucket_count,
+							bytes_processed_list[file_id],
+							scatter_seconds_list[file_id],
+							gather_seconds_list[file_id]);
+					}
+					catch (...)
+					{
+						error_list[file_id] = std::current_exception();
+					}
+				}));
+			}
+			for(std::vector<std::thread>::iterator it = thread_list.begin(); it != thread_list.end(); ++it)
+				it->join();
+		}
+		for(std::vector<std::exception_ptr>::const_iterator it = error_list.begin(); it != error_list.end(); ++it)
+			if (*it)
+				std::rethrow_exception(*it);
+		std::chrono::duration<float> sec = std::chrono::high_resolution_clock::now() - start;
+
+		unsigned long long total_bytes_processed = 0;
+		for(unsigned int file_id = 0; file_id < static_cast<unsigned int>(file_path_list.size()); ++file_id)
+		{
+			float mb = static_cast<float>(bytes_processed_list[file_id]) / (1024.0F * 1024.0F);
+			std::cout << (boost::format("%1%: %|2$.1f| MB, scatter %|3$.1f| seconds (%|4$.1f| MB/s), gather %|5$.1f| seconds (%|6$.1f| MB/s)")
+				% file_path_list[file_id].filename().string() % mb
+				% scatter_seconds_list[file_id] % (mb / std::max(scatter_seconds_list[file_id], 1.0e-6F))
+				% gather_seconds_list[file_id] % (mb / std::max(gather_seconds_list[file_id], 1.0e-6F))).str() << std::endl;
+			total_bytes_processed += bytes_processed_list[file_id];
+		}
+		float total_mb = static_cast<float>(total_bytes_processed) / (1024.0F * 1024.0F);
+		std::cout << (boost::format("Shuffled %|1$.1f| MB in %|2$.1f| seconds, %|3$.1f| MB/s, %|4$.0f| entries/s")
+			% total_mb % sec.count() % (total_mb / std::max(sec.count(), 1.0e-6F)) % (static_cast<float>(entry_count) / std::max(sec.count(), 1.0e-6F))).str() << std::endl;
+	}
+
+	void toolset::shuffle_data_file(
+		const std::string& layer_name,
+		const boost::filesystem::path& file_path,
+		const std::vector<unsigned int>& bucket_id_list,
+		const std::vector<std::vector<unsigned int> >& bucket_permutation_list,
+		unsigned int max_open_bucket_count,
+		unsigned long long& bytes_processed,
+		float& scatter_seconds,
+		float& gather_seconds)
+	{
+		unsigned int bucket_count = static_cast<unsigned int>(bucket_permutation_list.size());
+		std::vector<boost::filesystem::path> bucket_file_path_list;
+		for(unsigned int bucket_id = 0; bucket_id < bucket_count; ++bucket_id)
+		{
+			boost::filesystem::path bucket_file_path = file_path;
+			bucket_file_path += (boost::format(".bucket%1%.tmp") % bucket_id).str();
+			bucket_file_path_list.push_back(bucket_file_path);
+		}
+
+		// Buckets are split into at most max_open_bucket_count groups of consecutive ones, entries are appended to the files of their groups.
+		// Groups of several buckets are split the same way until each group is a single bucket, starting with the source file holding all of them.
+		// Entries in group files are prefixed with bucket IDs and sizes, entries in bucket files are prefixed with sizes only.
+		// Each file keeps entries in the order of the source file
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		bytes_processed = 0;
+		{
+			std::vector<char> in_stream_buffer(shuffle_stream_buffer_size);
+			std::vector<std::vector<char> > out_stream_buffer_list(max_open_bucket_count, std::vector<char>(shuffle_stream_buffer_size));
+			std::vector<std::shared_ptr<boost::filesystem::ofstream> > out_list;
+			std::vector<boost::filesystem::path> out_file_path_list;
+			std::vector<bool> out_is_bucket_list;
+			unsigned int out_first_bucket_id = 0;
+			unsigned long long out_span = 1;
+			// Groups written to their own files and not split yet: first bucket ID, bucket ID end and the group file
+			std::vector<std::pair<std::pair<unsigned int, unsigned int>, boost::filesystem::path> > pending_group_list;
+
+			auto open_out_list = [&] (unsigned int first_bucket_id, unsigned int bucket_id_end)
+			{
+				out_first_bucket_id = first_bucket_id;
+				out_span = 1;
+				while (out_span * max_open_bucket_count < bucket_id_end - first_bucket_id)
+					out_span *= max_open_bucket_count;
+				out_list.clear();
+				out_file_path_list.clear();
+				out_is_bucket_list.clear();
+				for(unsigned long long group_first_bucket_id = first_bucket_id; group_first_bucket_id < bucket_id_end; group_first_bucket_id += out_span)
+				{
+					unsigned int group_bucket_id_end = static_cast<unsigned int>(std::min(group_first_bucket_id + out_span, static_cast<unsigned long long>(bucket_id_end)));
+					bool is_bucket = (group_bucket_id_end - group_first_bucket_id == 1);
+					boost::filesystem::path group_file_path = bucket_file_path_list[group_first_bucket_id];
+					if (!is_bucket)
+					{
+						group_file_path = file_path;
+						group_file_path += (boost::format(".bucket%1%-%2%.tmp") % group_first_bucket_id % (group_bucket_id_end - 1)).str();
+						pending_group_list.push_back(std::make_pair(std::make_pair(static_cast<unsigned int>(group_first_bucket_id), group_bucket_id_end), group_file_path));
+					}
+
+					std::shared_ptr<boost::filesystem::ofstream> out(new boost::filesystem::ofstream());
+					out->rdbuf()->pubsetbuf(&out_stream_buffer_list[out_list.size()][0], shuffle_stream_buffer_size);
+					out->open(group_file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+					if (!out->good())
+						throw neural_network_exception((boost::format("Unable to create %1%") % group_file_path.string()).str());
+					out_list.push_back(out);
+					out_file_path_list.push_back(group_file_path);
+					out_is_bucket_list.push_back(is_bucket);
+				}
+			};
+
+			auto write_entry = [&] (unsigned int bucket_id, const std::vector<unsigned char>& dt)
+			{
+				unsigned int out_id = static_cast<unsigned int>((bucket_id - out_first_bucket_id) / out_span);
+				unsigned long long entry_size = static_cast<unsigned long long>(dt.size());
+				boost::filesystem::ofstream& out = *out_list[out_id];
+				if (!out_is_bucket_list[out_id])
+					out.write(reinterpret_cast<const char *>(&bucket_id), sizeof(bucket_id));
+				out.write(reinterpret_cast<const char *>(&entry_size), sizeof(entry_size));
+				if (!dt.empty())
+					out.write(reinterpret_cast<const char *>(&dt[0]), dt.size());
+			};
+
+			auto close_out_list = [&] ()
+			{
+				for(unsigned int out_id = 0; out_id < static_cast<unsigned int>(out_list.size()); ++out_id)
+				{
+					out_list[out_id]->close();
+					if (out_list[out_id]->fail())
+						throw neural_network_exception((boost::format("Error writing %1%") % out_file_path_list[out_id].string()).str());
+				}
+				out_list.clear();
+			};
+
+			std::vector<unsigned char> dt;
+			{
+				std::shared_ptr<boost::filesystem::ifstream> in(new boost::filesystem::ifstream());
+				in->rdbuf()->pubsetbuf(&in_stream_buffer[0], shuffle_stream_buffer_size);
+				in->open(file_path, std::ios_base::in | std::ios_base::binary);
+				raw_data_reader::ptr dr = get_raw_reader(shuffle_dataset_name, layer_name, dataset_usage_shuffle_data, file_path, in);
+
+				open_out_list(0, bucket_count);
+				for(unsigned int entry_id = 0; entry_id < static_cast<unsigned int>(bucket_id_list.size()); ++entry_id)
+				{
+					if (!dr->raw_read(entry_id, dt))
+						throw neural_network_exception((boost::format("Unable to read entry %1% from %2%") % entry_id % file_path.string()).str());
+					write_entry(bucket_id_list[entry_id], dt);
+					bytes_processed += static_cast<unsigned long long>(dt.size());
+				}
+				close_out_list();
+			}
+
+			while (!pending_group_list.empty())
+			{
+				std::pair<std::pair<unsigned int, unsigned int>, boost::filesystem::path> group = pending_group_list.back();
+				pending_group_list.pop_back();
+				{
+					boost::filesystem::ifstream group_in;
+					group_in.rdbuf()->pubsetbuf(&in_stream_buffer[0], shuffle_stream_buffer_size);
+					group_in.open(group.second, std::ios_base::in | std::ios_base::binary);
+					if (!group_in.good())
+						throw neural_network_exception((boost::format("Unable to open %1%") % group.second.string()).str());
+
+					open_out_list(group.first.first, group.first.second);
+					while (true)
+					{
+						unsigned int bucket_id;
+						group_in.read(reinterpret_cast<char *>(&bucket_id), sizeof(bucket_id));
+						if (group_in.eof() && (group_in.gcount() == 0))
+							break;
+						unsigned long long entry_size;
+						group_in.read(reinterpret_cast<char *>(&entry_size), sizeof(entry_size));
+						dt.resize(static_cast<size_t>(entry_size));
+						if (!dt.empty())
+							group_in.read(reinterpret_cast<char *>(&dt[0]), dt.size());
+						if (!group_in.good())
+							throw neural_network_exception((boost::format("Error reading %1%") % group.second.string()).str());
+						write_entry(bucket_id, dt);
+					}
+					close_out_list();
+				}
+				boost::filesystem::remove(group.second);
+			}
+		}
+		std::chrono::high_resolution_clock::time_point scatter_end = std::chrono::high_resolution_clock::now();
+		scatter_seconds = std::chrono::duration<float>(scatter_end - start).count();
+
+		// Each bucket is loaded entirely, entries are written in the order of bucket permutation
+		boost::filesystem::path temp_file_path = file_path;
+		temp_file_path += ".tmp";
+		{
+			std::shared_ptr<std::istream> in(new boost::filesystem::ifstream(file_path, std::ios_base::in | std::ios_base::binary));
+			std::shared_ptr<std::ostream> out(new boost::filesystem::ofstream(temp_file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary));
+			raw_data_reader::ptr dr = get_raw_reader(shuffle_dataset_name, layer_name, dataset_usage_shuffle_data, file_path, in);
+			raw_data_writer::ptr dw = dr->get_writer(out);
+
+			unsigned int output_entry_id = 0;
+			std::vector<unsigned char> bucket_data;
+			std::vector<size_t> entry_offset_list;
+			std::vector<size_t> entry_size_list;
+			for(unsigned int bucket_id = 0; bucket_id < bucket_count; ++bucket_id)
+			{
+				const boost::filesystem::path& bucket_file_path = bucket_file_path_list[bucket_id];
+				size_t bucket_size = static_cast<size_t>(boost::filesystem::file_size(bucket_file_path));
+				bucket_data.resize(bucket_size);
+				{
+					boost::filesystem::ifstream bucket_in(bucket_file_path, std::ios_base::in | std::ios_base::binary);
+					if (bucket_size > 0)
+						bucket_in.read(reinterpret_cast<char *>(&bucket_data[0]), bucket_size);
+					if (!bucket_in.good())
+						throw neural_network_exception((boost::format("Error reading %1%") % bucket_file_path.string()).str());
+				}
+
+				entry_offset_list.clear();
+				entry_size_list.clear();
+				for(size_t offset = 0; offset < bucket_size; )
+				{
+					unsigned long long entry_size;
+					memcpy(&entry_size, &bucket_data[offset], sizeof(entry_size));
+					offset += sizeof(entry_size);
+					entry_offset_list.push_back(offset);
+					entry_size_list.push_back(static_cast<size_t>(entry_size));
+					offset += static_cast<size_t>(entry_size);
+				}
+
+				const std::vector<unsigned int>& permutation = bucket_permutation_list[bucket_id];
+				if (permutation.size() != entry_offset_list.size())
+					throw neural_network_exception((boost::format("Bucket %1% contains %2% entries while %3% are expected") % bucket_file_path.string() % entry_offset_list.size() % permutation.size()).str());
+				for(std::vector<unsigned int>::const_iterator it = permutation.begin(); it != permutation.end(); ++it, ++output_entry_id)
+					dw->raw_write(output_entry_id, (entry_size_list[*it] > 0) ? &bucket_data[entry_offset_list[*it]] : 0, entry_size_list[*it]);
+
+				boost::filesystem::remove(bucket_file_path);
+			}
+		}
+		gather_seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - scatter_end).count();
+
+		std::cout << (boost::format("Renaming %1% to %2%\n") % temp_file_path.string() % file_path.string()).str() << std::flush;
+		boost::filesystem::rename(temp_file_path, file_path);
+	}
+
+	void toolset::quantize_data()
+	{
+		quantization_util::quantized_type type = quantization_util::get_quantized_type(quantized_type_name);
+
+		// Each shard of the sharded dataset is quantized independently
+		std::vector<std::pair<std::string, boost::filesystem::path> > data_filenames;
+		sharded_dataset_index::ptr index = get_sharded_dataset_index(quantize_dataset_name);
+		for(unsigned int shard_id = 0; shard_id < (index ? index->get_shard_count() : 1); ++shard_id)
+		{
+			std::map<std::string, boost::filesystem::path> shard_data_filenames = get_data_filenames(index ? get_shard_dataset_name(quantize_dataset_name, shard_id) : quantize_dataset_name);
+			data_filenames.insert(data_filenames.end(), shard_data_filenames.begin(), shard_data_filenames.end());
+		}
+		if (data_filenames.empty())
+			throw std::runtime_error((boost::format("No data found for dataset %1%") % quantize_dataset_name).str());
+
+		for(std::vector<std::pair<std::string, boost::filesystem::path> >::const_iterator it = data_filenames.begin(); it != data_filenames.end(); ++it)
 		{
 			const boost::filesystem::path& file_path = it->second;
+
+			// Varying and already quantized data are left as is
+			{
+				boost::filesystem::ifstream in(file_path, std::ios_base::in | std::ios_base::binary);
+				boost::uuids::uuid guid_read;
+				in.read(reinterpret_cast<char*>(guid_read.data), sizeof(guid_read.data));
+				if ((!in) || (guid_read != structured_data_stream_schema::structured_data_stream_guid))
+				{
+					std::cout << "Skipping " << file_path.string() << " as it doesn't contain float structured data" << std::endl;
+					continue;
+				}
+			}
+
 			boost::filesystem::path temp_file_path = file_path;
 			temp_file_path += ".tmp";
 			{
-				std::cout << "Shuffling from " << file_path.string() << " to " << temp_file_path.string() << std::endl;
-				std::shared_ptr<std::istream> in(new boost::filesystem::ifstream(file_path, std::ios_base::in | std::ios_base::binary));
-				std::shared_ptr<std::ostream> out(new boost::filesystem::ofstream(temp_file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary));
+				std::cout << "Quantizing " << file_path.string() << " to " << quantization_util::get_quantized_type_name(type) << " in " << temp_file_path.string() << std::endl;
+				structured_data_mapped_reader dr(file_path);
+				layer_configuration_specific config = dr.get_configuration();
+				unsigned int entry_count = static_cast<unsigned int>(dr.get_entry_count());
+				unsigned int neuron_count_per_feature_map = config.get_neuron_count_per_feature_map();
+
+				std::vector<float> scale_list(config.feature_map_count, 1.0F);
+				std::vector<float> offset_list(config.feature_map_count, 0.0F);
+				if (type == quantization_util::quantized_type_uint8)
 				{
-					raw_data_reader::ptr dr = get_raw_reader(shuffle_dataset_name, it->first, dataset_usage_shuffle_data, in);
-					raw_data_writer::ptr dw = dr->get_writer(out);
-					std::vector<unsigned char> dt;
-					for(unsigned int i = 0; i < static_cast<unsigned int>(entry_count); ++i)
+					// uint8 covers the whole range of each feature map
+					std::vector<float> min_list(config.feature_map_count, std::numeric_limits<float>::max());
+					std::vector<float> max_list(config.feature_map_count, -std::numeric_limits<float>::max());
+					for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+					{
+						const float * entry = dr.get_entry(entry_id);
+						for(unsigned int feature_map_id = 0; feature_map_id < config.feature_map_count; ++feature_map_id)
+						{
+							const float * feature_map = entry + feature_map_id * neuron_count_per_feature_map;
+							std::pair<const float *, const float *> minmax_it = std::minmax_element(feature_map, feature_map + neuron_count_per_feature_map);
+							min_list[feature_map_id] = std::min(min_list[feature_map_id], *minmax_it.first);
+							max_list[feature_map_id] = std::max(max_list[feature_map_id], *minmax_it.second);
+						}
+					}
+					for(unsigned int feature_map_id = 0; feature_map_id < config.feature_map_count; ++feature_map_id)
 					{
-						dr->raw_read(shuffled_indexes[i], dt);
-						dw->raw_write(i, &dt[0], dt.size());
+						if (max_list[feature_map_id] < min_list[feature_map_id])
+							continue;
+						offset_list[feature_map_id] = min_list[feature_map_id];
+						if (max_list[feature_map_id] > min_list[feature_map_id])
+							scale_list[feature_map_id] = (max_list[feature_map_id] - min_list[feature_map_id]) * (1.0F / 255.0F);
 					}
 				}
+
+				std::shared_ptr<std::ostream> out(new boost::filesystem::ofstream(temp_file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary));
+				structured_data_quantized_stream_writer dw(out, config, type, scale_list, offset_list);
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+					dw.write(entry_id, dr.get_entry(entry_id));
 			}
+			std::cout << (boost::format("%1% bytes reduced to %2% bytes") % boost::filesystem::file_size(file_path) % boost::filesystem::file_size(temp_file_path)).str() << std::endl;
 			std::cout << "Renaming " << temp_file_path.string() << " to " << file_path.string() << std::endl;
 			boost::filesystem::rename(temp_file_path, file_path);
 		}
@@ -1071,17 +1755,21 @@ namespace nnforge
 		const std::string& dataset_name,
 		const std::string& layer_name,
 		dataset_usage usage,
+		const boost::filesystem::path& file_path,
 		std::shared_ptr<std::istream> in) const
 	{
-		return get_structured_reader(dataset_name, layer_name, usage, in);
+		return get_structured_reader(dataset_name, layer_name, usage, file_path, in);
 	}
 
 	structured_data_reader::ptr toolset::get_structured_reader(
 		const std::string& dataset_name,
 		const std::string& layer_name,
 		dataset_usage usage,
+		const boost::filesystem::path& file_path,
 		std::shared_ptr<std::istream> in) const
 	{
+		if (structured_data_quantized_reader::is_quantized(*in))
+			return structured_data_reader::ptr(new structured_data_quantized_reader(in));
 		return structured_data_reader::ptr(new structured_data_stream_reader(in));
 	}
 
@@ -1111,6 +1799,45 @@ namespace nnforge
 		return res;
 	}
 
+	boost::filesystem::path toolset::get_sharded_dataset_index_file_path(const std::string& dataset_name) const
+	{
+		return get_working_data_folder() / (boost::format(sharded_dataset_index_file_name_pattern) % dataset_name).str();
+	}
+
+	std::string toolset::get_shard_dataset_name(
+		const std::string& dataset_name,
+		unsigned int shard_id) const
+	{
+		return (boost::format(shard_dataset_name_pattern) % dataset_name % shard_id).str();
+	}
+
+	void toolset::write_sharded_dataset_index(
+		const std::string& dataset_name,
+		const std::vector<unsigned int>& shard_entry_count_list) const
+	{
+		// Write to the temporary file first, so that the partially written index is never picked up
+		boost::filesystem::path index_file_path = get_sharded_dataset_index_file_path(dataset_name);
+		boost::filesystem::path temp_file_path = index_file_path;
+		temp_file_path += ".tmp";
+		{
+			boost::filesystem::ofstream out(temp_file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+			sharded_dataset_index(shard_entry_count_list).write(out);
+		}
+		boost::filesystem::rename(temp_file_path, index_file_path);
+	}
+
+	sharded_dataset_index::ptr toolset::get_sharded_dataset_index(const std::string& dataset_name) const
+	{
+		boost::filesystem::path index_file_path = get_sharded_dataset_index_file_path(dataset_name);
+		if (!boost::filesystem::exists(index_file_path))
+			return sharded_dataset_index::ptr();
+
+		sharded_dataset_index::ptr res(new sharded_dataset_index());
+		boost::filesystem::ifstream in(index_file_path, std::ios_base::in | std::ios_base::binary);
+		res->read(in);
+		return res;
+	}
+
 	void toolset::dump_data_visual(structured_data_bunch_reader::ptr dr)
 	{
 		boost::filesystem::path dump_data_folder = get_working_data_folder() / dump_data_subfolder_name;
@@ -1192,6 +1919,42 @@ namespace nnforge
 		}
 	}
 
+	void toolset::pack_network_data()
+	{
+		std::vector<boost::filesystem::path> folder_path_list;
+		std::cmatch what;
+
+		boost::filesystem::path batch_folder = get_working_data_folder() / get_ann_subfolder_name();
+		std::regex trained_expression(trained_ann_index_extractor_pattern);
+		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(batch_folder); it != boost::filesystem::directory_iterator(); ++it)
+		{
+			if ((it->status().type() == boost::filesystem::directory_file) && std::regex_search(it->path().filename().string().c_str(), what, trained_expression))
+				folder_path_list.push_back(it->path());
+		}
+
+		boost::filesystem::path snapshot_ann_folder_path = batch_folder / ann_snapshot_subfolder_name;
+		if (boost::filesystem::exists(snapshot_ann_folder_path))
+		{
+			std::regex snapshot_expression(snapshot_ann_index_extractor_pattern);
+			for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(snapshot_ann_folder_path); it != boost::filesystem::directory_iterator(); ++it)
+			{
+				if ((it->status().type() == boost::filesystem::directory_file) && std::regex_search(it->path().filename().string().c_str(), what, snapshot_expression))
+					folder_path_list.push_back(it->path());
+			}
+		}
+
+		for(std::vector<boost::filesystem::path>::const_iterator it = folder_path_list.begin(); it != folder_path_list.end(); ++it)
+		{
+			boost::filesystem::path file_path = *it;
+			file_path += packed_network_data::file_extension;
+			std::cout << "Packing " << it->string() << " to " << file_path.string() << std::endl;
+
+			network_data data;
+			data.read(*it);
+			packed_network_data::write(data, file_path);
+		}
+	}
+
 	void toolset::dump_data()
 	{
 		structured_data_bunch_reader::ptr reader = get_structured_data_bunch_reader(dump_dataset_name, dataset_usage_dump_data, 1, 0);
@@ -1231,13 +1994,10 @@ namespace nnforge
 		structured_data_reader::ptr original_reader,
 		const std::vector<data_transformer::ptr>& data_transformer_list) const
 	{
-		structured_data_reader::ptr current_reader = original_reader;
-		for(std::vector<data_transformer::ptr>::const_iterator it = data_transformer_list.begin(); it != data_transformer_list.end(); ++it)
-		{
-			structured_data_reader::ptr new_reader(new transformed_structured_data_reader(current_reader, *it));
-			current_reader = new_reader;
-		}
-		return current_reader;
+		if (data_transformer_list.empty())
+			return original_reader;
+
+		return structured_data_reader::ptr(new transformed_structured_data_reader(original_reader, data_transformer_list, static_cast<unsigned int>(data_transformer_seed)));
 	}
 
 	void toolset::create_normalizer()
@@ -1410,7 +2170,7 @@ namespace nnforge
 				double original_error = 0.0;
 				std::vector<float> gradient_backprops(weight_id_list.size());
 				{
-					neuron_value_set_data_bunch_writer writer;
+					average_data_bunch_writer writer;
 					backprop->run(
 						*reader,
 						writer,
@@ -1424,7 +2184,7 @@ namespace nnforge
 						0);
 					for(std::vector<std::string>::const_iterator it = training_error_source_layer_names.begin(); it != training_error_source_layer_names.end(); ++it)
 					{
-						std::shared_ptr<std::vector<double> > averages = writer.layer_name_to_config_and_value_set_map.find(*it)->second.second->get_average();
+						std::shared_ptr<std::vector<double> > averages = writer.get_average_map().find(*it)->second.second;
 						original_error += std::accumulate(averages->begin(), averages->end(), 0.0);
 					}
 					for(int weight_index = 0; weight_index < static_cast<int>(weight_id_list.size()); ++weight_index)
@@ -1440,7 +2200,7 @@ namespace nnforge
 					double minus_error = 0.0;
 					{
 						weight_list[weight_id] -= check_gradient_base_step;
-						neuron_value_set_data_bunch_writer writer;
+						average_data_bunch_writer writer;
 						backprop->run(
 							*reader,
 							writer,
@@ -1454,7 +2214,7 @@ namespace nnforge
 							0);
 						for(std::vector<std::string>::const_iterator it = training_error_source_layer_names.begin(); it != training_error_source_layer_names.end(); ++it)
 						{
-							std::shared_ptr<std::vector<double> > averages = writer.layer_name_to_config_and_value_set_map.find(*it)->second.second->get_average();
+							std::shared_ptr<std::vector<double> > averages = writer.get_average_map().find(*it)->second.second;
 							minus_error += std::accumulate(averages->begin(), averages->end(), 0.0);
 						}
 					}
@@ -1463,7 +2223,7 @@ namespace nnforge
 					double plus_error = 0.0;
 					{
 						weight_list[weight_id] += check_gradient_base_step;
-						neuron_value_set_data_bunch_writer writer;
+						average_data_bunch_writer writer;
 						backprop->run(
 							*reader,
 							writer,
@@ -1477,7 +2237,7 @@ namespace nnforge
 							0);
 						for(std::vector<std::string>::const_iterator it = training_error_source_layer_names.begin(); it != training_error_source_layer_names.end(); ++it)
 						{
-							std::shared_ptr<std::vector<double> > averages = writer.layer_name_to_config_and_value_set_map.find(*it)->second.second->get_average();
+							std::shared_ptr<std::vector<double> > averages = writer.get_average_map().find(*it)->second.second;
 							plus_error += std::accumulate(averages->begin(), averages->end(), 0.0);
 						}
 					}
@@ -1553,26 +2313,113 @@ namespace nnforge
 		data->write(weights_folder);
 	}
 
+	std::map<std::string, std::vector<feature_map_data_stat> > toolset::gather_layer_stat(
+		const network_schema& schema,
+		const std::set<std::string>& layer_names,
+		const network_data& data,
+		structured_data_bunch_reader& reader) const
+	{
+		std::map<std::string, unsigned int> cumulative_tiling_factor_map = schema.get_cumulative_tiling_factor_map();
+		std::map<unsigned int, std::vector<std::string> > tiling_factor_to_layer_names_map;
+		for(std::set<std::string>::const_iterator it = layer_names.begin(); it != layer_names.end(); ++it)
+			tiling_factor_to_layer_names_map[cumulative_tiling_factor_map[*it]].push_back(*it);
+
+		unsigned int group_count = static_cast<unsigned int>(tiling_factor_to_layer_names_map.size());
+		std::vector<forward_propagation::ptr> forward_prop_list;
+		for(std::map<unsigned int, std::vector<std::string> >::const_iterator it = tiling_factor_to_layer_names_map.begin(); it != tiling_factor_to_layer_names_map.end(); ++it)
+		{
+			forward_propagation::ptr forward_prop = forward_prop_factory->create_concurrent(schema, it->second, debug, profile, group_count);
+			forward_prop->set_data(data);
+			forward_prop_list.push_back(forward_prop);
+		}
+
+		std::vector<stat_data_bunch_writer> writer_list(group_count);
+		if (group_count == 1)
+		{
+			forward_prop_list.front()->run(reader, writer_list.front());
+		}
+		else
+		{
+			structured_data_bunch_shared_reader shared_reader(reader, group_count, static_cast<unsigned int>(std::max(training_shared_reader_cache_mb, 0)));
+			shared_reader.set_epoch(0);
+
+			std::vector<std::exception_ptr> error_list(group_count);
+			{
+				std::vector<std::thread> thread_list;
+				for(unsigned int i = 0; i < group_count; ++i)
+				{
+					thread_list.push_back(std::thread([&, i] ()
+					{
+						try
+						{
+							structured_data_bunch_reader::ptr consumer_reader = shared_reader.get_consumer_reader(i);
+							forward_prop_list[i]->run(*consumer_reader, writer_list[i]);
+						}
+						catch (...)
+						{
+							error_list[i] = std::current_exception();
+						}
+					}));
+				}
+				for(std::vector<std::thread>::iterator it = thread_list.begin(); it != thread_list.end(); ++it)
+					it->join();
+			}
+			for(std::vector<std::exception_ptr>::const_iterator it = error_list.begin(); it != error_list.end(); ++it)
+				if (*it)
+					std::rethrow_exception(*it);
+
+			std::pair<unsigned int, unsigned int> read_count = shared_reader.get_read_count();
+			std::cout << (boost::format("%1% groups of layers with different tiling factors, %2% entries read for %3% entries consumed") % group_count % read_count.first % read_count.second).str() << std::endl;
+		}
+
+		std::map<std::string, std::vector<feature_map_data_stat> > res;
+		for(std::vector<stat_data_bunch_writer>::const_iterator it = writer_list.begin(); it != writer_list.end(); ++it)
+		{
+			std::map<std::string, std::vector<feature_map_data_stat> > stat_map = it->get_stat();
+			res.insert(stat_map.begin(), stat_map.end());
+		}
+
+		return res;
+	}
+
 	void toolset::update_bn_weights()
 	{
 		network_schema::ptr schema = get_schema(schema_usage_inference);
 		structured_data_bunch_reader::ptr reader = get_structured_data_bunch_reader(training_dataset_name, dataset_usage_update_bn_weights, epoch_count_in_training_dataset, 0);
 		std::vector<layer::const_ptr> layers = schema->get_layers_in_forward_propagation_order();
 
+		// Each pass makes one more level of layers exact:
+		// level of the layer is the number of batch_norm layers on the longest path to it, the layer itself included
 		std::vector<std::string> bn_layes;
+		std::map<std::string, unsigned int> layer_name_to_bn_level_map;
+		unsigned int bn_level_count = 0;
 		std::cout << "Updating Batch Normalization weights for these layers: ";
 		for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
 		{
+			unsigned int bn_level = 0;
+			for(std::vector<std::string>::const_iterator it2 = (*it)->input_layer_instance_names.begin(); it2 != (*it)->input_layer_instance_names.end(); ++it2)
+				bn_level = std::max(bn_level, layer_name_to_bn_level_map[*it2]);
 			if ((*it)->get_type_name() == batch_norm_layer::layer_type_name)
 			{
+				++bn_level;
+				bn_level_count = std::max(bn_level_count, bn_level);
 				bn_layes.push_back((*it)->instance_name);
 				if (bn_layes.size() > 1)
 					std::cout << ", ";
 				std::cout << (*it)->instance_name;
 			}
+			layer_name_to_bn_level_map[(*it)->instance_name] = bn_level;
 		}
 		std::cout << std::endl;
 
+		if (bn_layes.empty())
+			return;
+
+		unsigned int pass_count = bn_level_count;
+		if (update_bn_pass_count > 0)
+			pass_count = std::min(pass_count, static_cast<unsigned int>(update_bn_pass_count));
+		std::cout << "Running " << ((update_bn_tolerance > 0.0F) ? "up to " : "") << pass_count << " passes over the data per network, " << bn_level_count << " passes would match updating the layers one by one exactly" << std::endl;
+
 		std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
 		std::cout << "Updating Batch Normalization weights for " << ann_data_name_and_folderpath_list.size() << " networks..." << std::endl;
 		for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
@@ -1582,44 +2429,84 @@ namespace nnforge
 
 			std::cout << "Working on network # " << it->first << std::endl;
 
-			for(std::vector<std::string>::const_iterator it2 = bn_layes.begin(); it2 != bn_layes.end(); ++it2)
+			// Levels below first_level are exact already, so pass p updates level p only and computes the network up to the inputs of that level.
+			// The last pass of the capped run updates all the remaining levels, as does each pass when update_bn_tolerance is set:
+			// weights of each level depend on the statistics gathered with the weights of shallower levels,
+			// the pass which barely changed any of them leaves the inputs of the next pass the same, so further passes are skipped
+			std::map<std::string, std::vector<feature_map_data_stat> > stat_map;
+			for(unsigned int pass_id = 0; pass_id < pass_count; ++pass_id)
 			{
-				const std::string& layer_name = *it2;
-				std::cout << layer_name << std::endl;
+				unsigned int first_level = pass_id + 1;
+				unsigned int last_level = ((pass_id == pass_count - 1) || (update_bn_tolerance > 0.0F)) ? bn_level_count : first_level;
+				std::vector<std::string> pass_bn_layer_names;
+				std::set<std::string> pass_bn_input_layer_names;
+				for(std::vector<std::string>::const_iterator it2 = bn_layes.begin(); it2 != bn_layes.end(); ++it2)
+				{
+					unsigned int bn_level = layer_name_to_bn_level_map[*it2];
+					if ((bn_level >= first_level) && (bn_level <= last_level))
+					{
+						pass_bn_layer_names.push_back(*it2);
+						pass_bn_input_layer_names.insert(schema->get_layer(*it2)->input_layer_instance_names.front());
+					}
+				}
 
-				forward_propagation::ptr forward_prop = forward_prop_factory->create(*schema, std::vector<std::string>(1, layer_name), debug, profile);
+				std::map<std::string, std::vector<feature_map_data_stat> > pass_stat_map = gather_layer_stat(*schema, pass_bn_input_layer_names, data, *reader);
+				for(std::map<std::string, std::vector<feature_map_data_stat> >::const_iterator it2 = pass_stat_map.begin(); it2 != pass_stat_map.end(); ++it2)
+					stat_map[it2->first] = it2->second;
 
-				layer_data::ptr dt = data.data_list.get(layer_name);
-				std::vector<float> gamma_saved = dt->at(0);
-				std::vector<float> beta_saved = dt->at(1);
-				std::fill_n(dt->at(0).begin(), dt->at(0).size(), 1.0F);
-				std::fill_n(dt->at(1).begin(), dt->at(1).size(), 0.0F);
+				// Batch norm output with gamma = 1 and beta = 0 is (x - mean) * inverse_sigma, it is normalized when mean and inverse_sigma match the statistics of x
+				float max_mean_change = 0.0F;
+				float max_inverse_sigma_relative_change = 0.0F;
+				for(std::vector<std::string>::const_iterator it2 = pass_bn_layer_names.begin(); it2 != pass_bn_layer_names.end(); ++it2)
+				{
+					const std::string& layer_name = *it2;
+					const std::vector<feature_map_data_stat>& stat = pass_stat_map.find(schema->get_layer(layer_name)->input_layer_instance_names.front())->second;
+					layer_data::ptr dt = data.data_list.get(layer_name);
 
-				forward_prop->set_data(data);
+					for(unsigned int feature_map_id = 0; feature_map_id < static_cast<unsigned int>(stat.size()); ++feature_map_id)
+					{
+						float old_mean = dt->at(2)[feature_map_id];
+						float old_invsigma = dt->at(3)[feature_map_id];
+						float new_mean = stat[feature_map_id].average;
+						float new_invsigma = 1.0F / stat[feature_map_id].std_dev;
+						max_mean_change = std::max(max_mean_change, fabsf(new_mean - old_mean) * new_invsigma);
+						max_inverse_sigma_relative_change = std::max(max_inverse_sigma_relative_change, fabsf(new_invsigma - old_invsigma) / new_invsigma);
+						dt->at(2)[feature_map_id] = new_mean;
+						dt->at(3)[feature_map_id] = new_invsigma;
+					}
+				}
 
-				stat_data_bunch_writer writer;
-				forward_prop->run(*reader, writer);
+				std::cout << (boost::format("Pass %1%, levels %2%-%3%: max mean change %|4$.6f| sigmas, max inverse sigma change %|5$.6f|%%") % (pass_id + 1) % first_level % last_level % max_mean_change % (max_inverse_sigma_relative_change * 100.0F)).str() << std::endl;
 
-				std::map<std::string, std::vector<feature_map_data_stat> > stat_map = writer.get_stat();
-				const std::vector<feature_map_data_stat>& stat = stat_map.find(layer_name)->second;
+				if ((max_mean_change < update_bn_tolerance) && (max_inverse_sigma_relative_change < update_bn_tolerance))
+				{
+					std::cout << "Changes are below the tolerance, the rest of the passes are skipped" << std::endl;
+					break;
+				}
+			}
 
+			for(std::vector<std::string>::const_iterator it2 = bn_layes.begin(); it2 != bn_layes.end(); ++it2)
+			{
+				const std::string& layer_name = *it2;
+				const std::vector<feature_map_data_stat>& stat = stat_map.find(schema->get_layer(layer_name)->input_layer_instance_names.front())->second;
+				std::cout << layer_name << " input" << std::endl;
 				for(unsigned int feature_map_id = 0; feature_map_id < static_cast<unsigned int>(stat.size()); ++feature_map_id)
-				{
 					std::cout << feature_map_id << ": " << stat[feature_map_id] << std::endl;
+			}
 
-					float old_mean = dt->at(2)[feature_map_id];
-					float old_invsigma = dt->at(3)[feature_map_id];
-					float new_invsigma = old_invsigma / stat[feature_map_id].std_dev;
-					float new_mean = old_mean + stat[feature_map_id].average / old_invsigma;
-					dt->at(2)[feature_map_id] = new_mean;
-					dt->at(3)[feature_map_id] = new_invsigma;
-				}
+			if (packed_network_data::is_packed(it->second))
+			{
+				packed_network_data::write(data, it->second);
 
-				std::copy(gamma_saved.begin(), gamma_saved.end(), dt->at(0).begin());
-				std::copy(beta_saved.begin(), beta_saved.end(), dt->at(1).begin());
+				// Keep the folder the file was packed from consistent with it
+				boost::filesystem::path folder_path = it->second.parent_path() / it->second.stem();
+				if (boost::filesystem::is_directory(folder_path))
+					data.write(folder_path);
+			}
+			else
+			{
+				data.write(it->second);
 			}
-
-			data.write(it->second);
 		}
 	}
 }
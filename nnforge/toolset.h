@@ -23,6 +23,8 @@
 #include "structured_data_stream_reader.h"
 #include "data_transformer.h"
 #include "normalize_data_transformer.h"
+#include "sharded_dataset_index.h"
+#include "feature_map_data_stat.h"
 
 #include <vector>
 #include <string>
@@ -111,6 +113,12 @@ namespace nnforge
 
 		virtual void shuffle_data();
 
+		// Converts float structured data files of the dataset to uint8 or fp16 storage
+		virtual void quantize_data();
+
+		// Packs trained networks and snapshots, each network data folder is written to a single file next to it
+		virtual void pack_network_data();
+
 		virtual void dump_data();
 
 		virtual void dump_data_visual(structured_data_bunch_reader::ptr dr);
@@ -131,16 +139,20 @@ namespace nnforge
 			unsigned int multiple_epoch_count,
 			unsigned int shuffle_block_size) const;
 
+		// in is opened from file_path, which is either the layer data file of the dataset or of one of its shards
 		virtual raw_data_reader::ptr get_raw_reader(
 			const std::string& dataset_name,
 			const std::string& layer_name,
 			dataset_usage usage,
+			const boost::filesystem::path& file_path,
 			std::shared_ptr<std::istream> in) const;
 
+		// in is opened from file_path, which is either the layer data file of the dataset or of one of its shards
 		virtual structured_data_reader::ptr get_structured_reader(
 			const std::string& dataset_name,
 			const std::string& layer_name,
 			dataset_usage usage,
+			const boost::filesystem::path& file_path,
 			std::shared_ptr<std::istream> in) const;
 
 		virtual std::vector<unsigned int> get_dump_data_dimension_list(unsigned int original_dimension_count) const;
@@ -163,11 +175,54 @@ namespace nnforge
 		// Returns empty smart pointer if no normalize_data_transformer exists for the layer specified
 		normalize_data_transformer::ptr get_normalize_data_transformer(const std::string& layer_name) const;
 
+		// Maps layer names to data files of the dataset
+		std::map<std::string, boost::filesystem::path> get_data_filenames(const std::string& dataset_name) const;
+
+		// Sharded dataset consists of the index file and shards, each of them is a regular dataset named with get_shard_dataset_name.
+		// The index takes precedence over the regular data files of the dataset
+		boost::filesystem::path get_sharded_dataset_index_file_path(const std::string& dataset_name) const;
+
+		std::string get_shard_dataset_name(
+			const std::string& dataset_name,
+			unsigned int shard_id) const;
+
+		// Should be called once all the shards are written
+		void write_sharded_dataset_index(
+			const std::string& dataset_name,
+			const std::vector<unsigned int>& shard_entry_count_list) const;
+
+		// Returns empty pointer if the dataset is not sharded
+		sharded_dataset_index::ptr get_sharded_dataset_index(const std::string& dataset_name) const;
+
 	private:
 		void dump_settings();
 
 		std::vector<std::pair<unsigned int, boost::filesystem::path> > get_ann_data_index_and_folderpath_list() const;
 
+		// All the networks are loaded at once, each chunk of inference_ensemble_chunk_size entries is read once and run through all of them.
+		// The networks split the memory limit among them
+		std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > run_fused_ensemble_inference(
+			const network_schema& schema,
+			structured_data_bunch_reader& reader,
+			const std::vector<std::pair<unsigned int, boost::filesystem::path> >& ann_data_name_and_folderpath_list);
+
+		// Runs a single pass over the data and returns the statistics of the layers.
+		// Forward propagation requires the same cumulative tiling factor for all its outputs, so layers are grouped by it
+		// and the groups run concurrently, reading the data once through structured_data_bunch_shared_reader
+		std::map<std::string, std::vector<feature_map_data_stat> > gather_layer_stat(
+			const network_schema& schema,
+			const std::set<std::string>& layer_names,
+			const network_data& data,
+			structured_data_bunch_reader& reader) const;
+
+		// Reads entries [first_entry_id, first_entry_id + entry_count) in parallel into the sets, which are shrunk to the entries actually read.
+		// Returns the number of entries read
+		unsigned int read_entries(
+			structured_data_bunch_reader& reader,
+			const std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >& layer_name_to_config_and_value_set_map,
+			unsigned int first_entry_id,
+			unsigned int entry_count) const;
+
 		std::vector<network_data_peek_entry> get_snapshot_ann_list_entry_list() const;
 
 		std::set<unsigned int> get_trained_ann_list() const;
@@ -178,7 +233,25 @@ namespace nnforge
 
 		static bool compare_entry(network_data_peek_entry i, network_data_peek_entry j);
 
-		std::map<std::string, boost::filesystem::path> get_data_filenames(const std::string& dataset_name) const;
+		// Creates the reader of the single layer data file, transformers are not applied
+		structured_data_reader::ptr get_layer_data_reader(
+			const std::string& dataset_name,
+			const std::string& layer_name,
+			dataset_usage usage,
+			const boost::filesystem::path& file_path,
+			bool random_access) const;
+
+		// Scatters entries of the file into bucket files according to bucket_id_list, writing at most max_open_bucket_count files at a time,
+		// then loads buckets one by one, reorders entries according to bucket_permutation_list and writes them out
+		void shuffle_data_file(
+			const std::string& layer_name,
+			const boost::filesystem::path& file_path,
+			const std::vector<unsigned int>& bucket_id_list,
+			const std::vector<std::vector<unsigned int> >& bucket_permutation_list,
+			unsigned int max_open_bucket_count,
+			unsigned long long& bytes_processed,
+			float& scatter_seconds,
+			float& gather_seconds);
 
 	protected:
 		factory_generator::ptr master_factory;
@@ -200,6 +273,8 @@ namespace nnforge
 		std::string inference_dataset_name;
 		std::string training_dataset_name;
 		std::string shuffle_dataset_name;
+		std::string quantize_dataset_name;
+		std::string quantized_type_name;
 		std::string normalizer_dataset_name;
 		int inference_ann_data_index;
 		bool debug_mode;
@@ -222,7 +297,11 @@ namespace nnforge
 		bool resume_from_snapshot;
 		bool dump_snapshot;
 		int keep_snapshots_frequency;
+		int snapshot_max_pending_count;
+		int training_concurrent_ann_count;
+		int training_shared_reader_cache_mb;
 		int ann_count;
+		int data_transformer_seed;
 		int batch_offset;
 		std::string inference_mode;
 		std::string inference_output_dataset_name;
@@ -233,6 +312,7 @@ namespace nnforge
 		std::string dump_extension_image;
 		std::string dump_extension_video;
 		bool dump_data_rgb;
+		bool map_data_files;
 		int dump_data_scale;
 		int dump_data_video_fps;
 		int epoch_count_in_training_dataset;
@@ -242,6 +322,11 @@ namespace nnforge
 		float training_mix_validating_ratio;
 		std::string dump_format;
 		int shuffle_block_size;
+		int shuffle_memory_mb;
+		int prepare_shard_count;
+		int inference_ensemble_chunk_size;
+		int update_bn_pass_count;
+		float update_bn_tolerance;
 		std::string check_gradient_weights;
 		int check_gradient_max_weights_per_set;
 		float check_gradient_base_step;
@@ -261,8 +346,12 @@ namespace nnforge
 		static const char * snapshot_ann_index_extractor_pattern;
 		static const char * ann_snapshot_subfolder_name;
 		static const char * dataset_extractor_pattern;
+		static const char * shard_dataset_name_pattern;
+		static const char * sharded_dataset_index_file_name_pattern;
 		static const char * dump_data_subfolder_name;
 		static const char * dataset_value_data_layer_name;
+		static const unsigned int shuffle_stream_buffer_size;
+		static const unsigned int shuffle_max_open_bucket_count;
 
 		std::string default_config_path;
 
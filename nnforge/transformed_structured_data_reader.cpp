@@ -16,44 +16,298 @@
 
 #include "transformed_structured_data_reader.h"
 
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <deque>
+#include <algorithm>
+
 namespace nnforge
 {
+	struct transformed_structured_data_reader::scratch_frame
+	{
+		struct noise_source
+		{
+			counter_random_generator gen;
+			std::uniform_real_distribution<float> distribution;
+			// Multipliers of the transformers following the noise one, per feature map
+			std::vector<float> mult_list;
+		};
+
+		// Ping-pong buffers for intermediate results
+		std::vector<float> buffers[2];
+		// Entry ID each transformer is applied to
+		std::vector<unsigned int> entry_id_list;
+		// Composed elementwise affine map
+		std::vector<float> mult_list;
+		std::vector<float> add_list;
+		// Map of the current transformer
+		elementwise_affine_map map;
+		// The first noise_source_count elements are used, the rest keep their buffers for the following entries
+		std::vector<noise_source> noise_source_list;
+		unsigned int noise_source_count;
+	};
+
+	// Takes the scratch frame of the current thread. Readers chained on top of each other
+	// take consecutive frames, deque keeps the frames in place when it grows
+	class transformed_structured_data_reader::scratch_scope
+	{
+	public:
+		scratch_scope(size_t elem_count)
+			: frame_id(depth)
+		{
+			++depth;
+			if (frames.size() < depth)
+				frames.resize(depth);
+			for(unsigned int i = 0; i < 2; ++i)
+				if (frames[frame_id].buffers[i].size() < elem_count)
+					frames[frame_id].buffers[i].resize(elem_count);
+		}
+
+		~scratch_scope()
+		{
+			--depth;
+		}
+
+		scratch_frame& get_frame()
+		{
+			return frames[frame_id];
+		}
+
+		float * get_buffer(unsigned int buffer_id)
+		{
+			return &frames[frame_id].buffers[buffer_id][0];
+		}
+
+	private:
+		unsigned int frame_id;
+
+		static thread_local std::deque<scratch_frame> frames;
+		static thread_local unsigned int depth;
+
+	private:
+		scratch_scope(const scratch_scope&) = delete;
+		scratch_scope& operator =(const scratch_scope&) = delete;
+	};
+
+	thread_local std::deque<transformed_structured_data_reader::scratch_frame> transformed_structured_data_reader::scratch_scope::frames;
+	thread_local unsigned int transformed_structured_data_reader::scratch_scope::depth = 0;
+
 	transformed_structured_data_reader::transformed_structured_data_reader(
 		structured_data_reader::ptr original_reader,
-		data_transformer::ptr transformer)
+		data_transformer::ptr transformer,
+		unsigned int seed)
 		: original_reader(original_reader)
-		, transformer(transformer)
-		, transformer_sample_count(transformer->get_sample_count())
-		, original_config(original_reader->get_configuration())
+		, transformer_list(1, transformer)
+		, seed(seed)
+		, epoch_id(0)
+		, first_entry_id(0)
+		, original_first_entry_id(0)
 	{
+		init();
+	}
+
+	transformed_structured_data_reader::transformed_structured_data_reader(
+		structured_data_reader::ptr original_reader,
+		const std::vector<data_transformer::ptr>& transformer_list,
+		unsigned int seed)
+		: original_reader(original_reader)
+		, transformer_list(transformer_list)
+		, seed(seed)
+		, epoch_id(0)
+		, first_entry_id(0)
+		, original_first_entry_id(0)
+	{
+		init();
+	}
+
+	void transformed_structured_data_reader::init()
+	{
+		if (transformer_list.empty())
+			throw neural_network_exception("No transformers specified for transformed_structured_data_reader");
+
+		// Stream 0 is left for the readers decoding raw data, see structured_from_raw_data_reader
+		stream_id = 1;
+		std::shared_ptr<transformed_structured_data_reader> original_transformed_reader = std::dynamic_pointer_cast<transformed_structured_data_reader>(original_reader);
+		if (original_transformed_reader)
+			stream_id = original_transformed_reader->stream_id + static_cast<unsigned int>(original_transformed_reader->transformer_list.size());
+
+		config_list.push_back(original_reader->get_configuration());
+		max_intermediate_neuron_count = config_list.back().get_neuron_count();
+		for(std::vector<data_transformer::ptr>::const_iterator it = transformer_list.begin(); it != transformer_list.end(); ++it)
+		{
+			transformer_sample_count_list.push_back((*it)->get_sample_count());
+
+			counter_random_generator gen(seed);
+			elementwise_affine_map map;
+			transformer_is_affine_list.push_back((*it)->get_elementwise_affine_map(config_list.back(), gen, map));
+
+			config_list.push_back((*it)->get_transformed_configuration(config_list.back()));
+			max_intermediate_neuron_count = std::max(max_intermediate_neuron_count, config_list.back().get_neuron_count());
+		}
 	}
 
 	bool transformed_structured_data_reader::read(
 		unsigned int entry_id,
 		float * data)
 	{
-		std::vector<float> original_data(original_config.get_neuron_count());
+		unsigned int transformer_count = static_cast<unsigned int>(transformer_list.size());
+
+		scratch_scope scratch(max_intermediate_neuron_count);
+		unsigned int src_buffer_id = 0;
+
+		// Entry ID each transformer is applied to, the same ones chained readers would see
+		std::vector<unsigned int>& entry_id_list = scratch.get_frame().entry_id_list;
+		entry_id_list.resize(transformer_count);
+		entry_id_list[transformer_count - 1] = first_entry_id + entry_id;
+		for(unsigned int transformer_id = transformer_count - 1; transformer_id > 0; --transformer_id)
+			entry_id_list[transformer_id - 1] = entry_id_list[transformer_id] / transformer_sample_count_list[transformer_id];
 
-		if (!original_reader->read(entry_id / transformer_sample_count, &original_data[0]))
+		if (!original_reader->read(entry_id_list[0] / transformer_sample_count_list[0] - original_first_entry_id, scratch.get_buffer(src_buffer_id)))
 			return false;
 
-		transformer->transform(
-			&original_data[0],
-			data,
-			original_config,
-			entry_id % transformer_sample_count);
+		unsigned int transformer_id = 0;
+		while (transformer_id < transformer_count)
+		{
+			unsigned int transformer_id_end = transformer_id + 1;
+			if (transformer_is_affine_list[transformer_id])
+			{
+				while ((transformer_id_end < transformer_count) && transformer_is_affine_list[transformer_id_end])
+					++transformer_id_end;
+			}
+
+			float * dst = (transformer_id_end == transformer_count) ? data : scratch.get_buffer(1 - src_buffer_id);
+			if (transformer_is_affine_list[transformer_id])
+			{
+				apply_affine_transformers(
+					scratch.get_buffer(src_buffer_id),
+					dst,
+					transformer_id,
+					transformer_id_end,
+					scratch.get_frame());
+			}
+			else
+			{
+				counter_random_generator gen(seed, epoch_id, entry_id_list[transformer_id], stream_id + transformer_id);
+				transformer_list[transformer_id]->transform(
+					scratch.get_buffer(src_buffer_id),
+					dst,
+					config_list[transformer_id],
+					entry_id_list[transformer_id] % transformer_sample_count_list[transformer_id],
+					gen);
+			}
+
+			src_buffer_id = 1 - src_buffer_id;
+			transformer_id = transformer_id_end;
+		}
 
 		return true;
 	}
 
+	void transformed_structured_data_reader::apply_affine_transformers(
+		const float * data,
+		float * data_transformed,
+		unsigned int transformer_id_start,
+		unsigned int transformer_id_end,
+		scratch_frame& scratch)
+	{
+		const layer_configuration_specific& config = config_list[transformer_id_start];
+		unsigned int feature_map_count = config.feature_map_count;
+		const std::vector<unsigned int>& entry_id_list = scratch.entry_id_list;
+
+		// Compose the maps into a single one, noise added by a transformer is scaled by the multipliers of the following ones
+		std::vector<float>& mult_list = scratch.mult_list;
+		std::vector<float>& add_list = scratch.add_list;
+		elementwise_affine_map& map = scratch.map;
+		std::vector<scratch_frame::noise_source>& noise_source_list = scratch.noise_source_list;
+		unsigned int& noise_source_count = scratch.noise_source_count;
+		mult_list.assign(feature_map_count, 1.0F);
+		add_list.assign(feature_map_count, 0.0F);
+		noise_source_count = 0;
+		for(unsigned int transformer_id = transformer_id_start; transformer_id < transformer_id_end; ++transformer_id)
+		{
+			counter_random_generator gen(seed, epoch_id, entry_id_list[transformer_id], stream_id + transformer_id);
+			transformer_list[transformer_id]->get_elementwise_affine_map(config, gen, map);
+
+			for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+			{
+				float mult = map.mult_list[feature_map_id];
+				mult_list[feature_map_id] *= mult;
+				add_list[feature_map_id] = add_list[feature_map_id] * mult + map.add_list[feature_map_id];
+				for(unsigned int noise_source_id = 0; noise_source_id < noise_source_count; ++noise_source_id)
+					noise_source_list[noise_source_id].mult_list[feature_map_id] *= mult;
+			}
+
+			if (map.apply_noise)
+			{
+				if (noise_source_count == noise_source_list.size())
+				{
+					scratch_frame::noise_source new_noise_source = { gen, map.noise_distribution, std::vector<float>() };
+					noise_source_list.push_back(new_noise_source);
+				}
+				scratch_frame::noise_source& current_noise_source = noise_source_list[noise_source_count];
+				current_noise_source.gen = gen;
+				current_noise_source.distribution = map.noise_distribution;
+				current_noise_source.mult_list.assign(feature_map_count, 1.0F);
+				++noise_source_count;
+			}
+		}
+
+		unsigned int neuron_count_per_feature_map = config.get_neuron_count_per_feature_map();
+		for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+		{
+			float mult = mult_list[feature_map_id];
+			float add = add_list[feature_map_id];
+			const float * src_data = data + feature_map_id * neuron_count_per_feature_map;
+			float * dest_data = data_transformed + feature_map_id * neuron_count_per_feature_map;
+			if (noise_source_count == 0)
+			{
+				for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+					dest_data[i] = src_data[i] * mult + add;
+			}
+			else
+			{
+				for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+				{
+					float val = src_data[i] * mult + add;
+					for(unsigned int noise_source_id = 0; noise_source_id < noise_source_count; ++noise_source_id)
+						val += noise_source_list[noise_source_id].distribution(noise_source_list[noise_source_id].gen) * noise_source_list[noise_source_id].mult_list[feature_map_id];
+					dest_data[i] = val;
+				}
+			}
+		}
+	}
+
 	layer_configuration_specific transformed_structured_data_reader::get_configuration() const
 	{
-		return transformer->get_transformed_configuration(original_config);
+		return config_list.back();
 	}
 
 	int transformed_structured_data_reader::get_entry_count() const
 	{
-		return original_reader->get_entry_count() * transformer_sample_count;
+		int entry_count = original_reader->get_entry_count();
+		for(std::vector<unsigned int>::const_iterator it = transformer_sample_count_list.begin(); it != transformer_sample_count_list.end(); ++it)
+			entry_count *= static_cast<int>(*it);
+		return entry_count;
+	}
+
+	void transformed_structured_data_reader::set_epoch(unsigned int epoch_id)
+	{
+		this->epoch_id = epoch_id;
+		original_reader->set_epoch(epoch_id);
+	}
+
+	void transformed_structured_data_reader::set_first_entry_id(unsigned int first_entry_id)
+	{
+		unsigned int sample_count = 1;
+		for(std::vector<unsigned int>::const_iterator it = transformer_sample_count_list.begin(); it != transformer_sample_count_list.end(); ++it)
+			sample_count *= *it;
+		if ((first_entry_id % sample_count) != 0)
+			throw neural_network_exception((boost::format("First entry ID %1% is not a multiple of sample count %2% of transformed_structured_data_reader") % first_entry_id % sample_count).str());
+
+		this->first_entry_id = first_entry_id;
+		original_first_entry_id = first_entry_id / sample_count;
+		original_reader->set_first_entry_id(original_first_entry_id);
 	}
 
 	bool transformed_structured_data_reader::raw_read(
@@ -20,15 +20,27 @@
 #include "data_transformer.h"
 
 #include <memory>
+#include <vector>
 
 namespace nnforge
 {
 	class transformed_structured_data_reader : public structured_data_reader
 	{
 	public:
+		// Random parameters of each entry are drawn from the stream keyed with (seed, epoch, entry_id),
+		// so the data doesn't depend on the order entries are read in
 		transformed_structured_data_reader(
 			structured_data_reader::ptr original_reader,
-			data_transformer::ptr transformer);
+			data_transformer::ptr transformer,
+			unsigned int seed = 0);
+
+		// Applies transformers one after another, producing the same data as the chain of single transformer readers.
+		// Intermediate results are kept in per-thread scratch buffers,
+		// consecutive transformers providing elementwise affine map are applied in a single pass
+		transformed_structured_data_reader(
+			structured_data_reader::ptr original_reader,
+			const std::vector<data_transformer::ptr>& transformer_list,
+			unsigned int seed = 0);
 
 		virtual ~transformed_structured_data_reader() = default;
 
@@ -44,16 +56,46 @@ namespace nnforge
 
 		virtual int get_entry_count() const;
 
+		virtual void set_epoch(unsigned int epoch_id);
+
+		virtual void set_first_entry_id(unsigned int first_entry_id);
+
 		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
 
 	protected:
 		transformed_structured_data_reader() = default;
 
+	private:
+		// Per-thread data reused across entries, so reading an entry doesn't allocate
+		struct scratch_frame;
+		class scratch_scope;
+
+		void init();
+
+		// Applies transformers [transformer_id_start, transformer_id_end) in a single pass, all of them provide elementwise affine maps
+		void apply_affine_transformers(
+			const float * data,
+			float * data_transformed,
+			unsigned int transformer_id_start,
+			unsigned int transformer_id_end,
+			scratch_frame& scratch);
+
 	protected:
 		structured_data_reader::ptr original_reader;
-		data_transformer::ptr transformer;
-		unsigned int transformer_sample_count;
-		layer_configuration_specific original_config;
+		std::vector<data_transformer::ptr> transformer_list;
+		std::vector<unsigned int> transformer_sample_count_list;
+		std::vector<bool> transformer_is_affine_list;
+		// Input configuration of each transformer, followed by the output configuration of the last one
+		std::vector<layer_configuration_specific> config_list;
+		// Size of each scratch buffer
+		unsigned int max_intermediate_neuron_count;
+		unsigned int seed;
+		// Distinguishes transformers chained on top of each other and the reader decoding raw data below them
+		unsigned int stream_id;
+		unsigned int epoch_id;
+		// Entry IDs the random streams are keyed with are offset by first_entry_id, the ones of the original reader by original_first_entry_id
+		unsigned int first_entry_id;
+		unsigned int original_first_entry_id;
 
 	private:
 		transformed_structured_data_reader(const transformed_structured_data_reader&) = delete;
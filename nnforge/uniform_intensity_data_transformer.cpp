@@ -27,8 +27,6 @@ namespace nnforge
 		const std::vector<float>& min_shift_list,
 		const std::vector<float>& max_shift_list)
 	{
-		generator = rnd::get_random_generator();
-
 		for(unsigned int i = 0; i < min_shift_list.size(); ++i)
 		{
 			bool apply = (min_shift_list[i] < max_shift_list[i]);
@@ -42,22 +40,29 @@ namespace nnforge
 		float * data_transformed,
 		const layer_configuration_specific& original_config,
 		unsigned int sample_id)
+	{
+		counter_random_generator gen = rnd::get_counter_random_generator();
+		transform(data, data_transformed, original_config, sample_id, gen);
+	}
+
+	void uniform_intensity_data_transformer::transform(
+		const float * data,
+		float * data_transformed,
+		const layer_configuration_specific& original_config,
+		unsigned int sample_id,
+		counter_random_generator& gen)
 	{
 		if (original_config.feature_map_count != shift_distribution_list.size())
 			throw neural_network_exception((boost::format("uniform_intensity_data_transformer was initialized with %1% distributions and data provided has %2% feature maps") % shift_distribution_list.size() % original_config.feature_map_count).str());
 
 		std::vector<float> shift_list(original_config.feature_map_count);
+		for(unsigned int feature_map_id = 0; feature_map_id < original_config.feature_map_count; ++feature_map_id)
 		{
-			std::lock_guard<std::mutex> lock(gen_stream_mutex);
-
-			for(unsigned int feature_map_id = 0; feature_map_id < original_config.feature_map_count; ++feature_map_id)
-			{
-				std::uniform_real_distribution<float>& dist = shift_distribution_list[feature_map_id];
-				float shift = dist.min();
-				if (apply_shift_distribution_list[feature_map_id])
-					shift = dist(generator);
-				shift_list[feature_map_id] = shift;
-			}
+			std::uniform_real_distribution<float>& dist = shift_distribution_list[feature_map_id];
+			float shift = dist.min();
+			if (apply_shift_distribution_list[feature_map_id])
+				shift = dist(gen);
+			shift_list[feature_map_id] = shift;
 		}
 
 		unsigned int neuron_count_per_feature_map = original_config.get_neuron_count_per_feature_map();
@@ -70,4 +75,27 @@ namespace nnforge
 				dest_data[i] = src_data[i] + shift;
 		}
 	}
+
+	bool uniform_intensity_data_transformer::get_elementwise_affine_map(
+		const layer_configuration_specific& original_config,
+		counter_random_generator& gen,
+		elementwise_affine_map& map) const
+	{
+		if (original_config.feature_map_count != shift_distribution_list.size())
+			throw neural_network_exception((boost::format("uniform_intensity_data_transformer was initialized with %1% distributions and data provided has %2% feature maps") % shift_distribution_list.size() % original_config.feature_map_count).str());
+
+		map.mult_list.assign(original_config.feature_map_count, 1.0F);
+		map.add_list.resize(original_config.feature_map_count);
+		for(unsigned int feature_map_id = 0; feature_map_id < original_config.feature_map_count; ++feature_map_id)
+		{
+			std::uniform_real_distribution<float> dist(shift_distribution_list[feature_map_id].param());
+			float shift = dist.min();
+			if (apply_shift_distribution_list[feature_map_id])
+				shift = dist(gen);
+			map.add_list[feature_map_id] = shift;
+		}
+		map.apply_noise = false;
+
+		return true;
+	}
 }
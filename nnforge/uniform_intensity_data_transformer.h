@@ -20,7 +20,6 @@
 #include "rnd.h"
 
 #include <vector>
-#include <mutex>
 #include <random>
 
 namespace nnforge
@@ -39,11 +38,20 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual void transform(
+			const float * data,
+			float * data_transformed,
+			const layer_configuration_specific& original_config,
+			unsigned int sample_id,
+			counter_random_generator& gen);
+
+		virtual bool get_elementwise_affine_map(
+			const layer_configuration_specific& original_config,
+			counter_random_generator& gen,
+			elementwise_affine_map& map) const;
 			
 	protected:
-		random_generator generator;
-		std::mutex gen_stream_mutex;
-
 		std::vector<bool> apply_shift_distribution_list;
 		std::vector<std::uniform_real_distribution<float> > shift_distribution_list;
 	};
@@ -16,7 +16,7 @@
 
 #include "validate_progress_network_data_pusher.h"
 
-#include "neuron_value_set_data_bunch_writer.h"
+#include "average_data_bunch_writer.h"
 
 #include <stdio.h>
 #include <boost/format.hpp>
@@ -42,7 +42,7 @@ namespace nnforge
 		{
 			forward_prop->set_data(*task_state.data);
 
-			neuron_value_set_data_bunch_writer writer;
+			average_data_bunch_writer writer;
 			forward_propagation::stat st = forward_prop->run(*reader, writer);
 
 			forward_prop->clear_data();
@@ -52,8 +52,9 @@ namespace nnforge
 			std::cout << "----- Validating -----" << std::endl;
 			std::cout << st << std::endl;
 
-			for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = writer.layer_name_to_config_and_value_set_map.begin(); it != writer.layer_name_to_config_and_value_set_map.end(); ++it)
-				std::cout << schema.get_layer(it->first)->get_string_for_average_data(it->second.first, *it->second.second->get_average()) << std::endl;
+			std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > average_map = writer.get_average_map();
+			for(std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > >::const_iterator it = average_map.begin(); it != average_map.end(); ++it)
+				std::cout << schema.get_layer(it->first)->get_string_for_average_data(it->second.first, *it->second.second) << std::endl;
 		}
 	}
 }
@@ -0,0 +1,102 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "varying_data_mapped_reader.h"
+
+#include "neural_network_exception.h"
+#include "varying_data_stream_schema.h"
+#include "varying_data_stream_writer.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <boost/format.hpp>
+#include <cstring>
+
+namespace nnforge
+{
+	varying_data_mapped_reader::varying_data_mapped_reader(
+		const boost::filesystem::path& file_path,
+		bool random_access)
+	{
+		const size_t header_size = sizeof(boost::uuids::uuid) + sizeof(unsigned int);
+		unsigned long long file_size = static_cast<unsigned long long>(boost::filesystem::file_size(file_path));
+		if (file_size < header_size)
+			throw neural_network_exception((boost::format("File %1% is truncated: %2% bytes") % file_path.string() % file_size).str());
+
+		mapping = boost::interprocess::file_mapping(file_path.string().c_str(), boost::interprocess::read_only);
+		region = boost::interprocess::mapped_region(mapping, boost::interprocess::read_only);
+		region.advise(random_access ? boost::interprocess::mapped_region::advice_random : boost::interprocess::mapped_region::advice_sequential);
+
+		const unsigned char * file_begin = static_cast<const unsigned char *>(region.get_address());
+
+		boost::uuids::uuid guid_read;
+		memcpy(guid_read.data, file_begin, sizeof(guid_read.data));
+		if (guid_read != varying_data_stream_schema::varying_data_stream_guid)
+			throw neural_network_exception((boost::format("Unknown varying data GUID encountered in file %1%: %2%") % file_path.string() % guid_read).str());
+
+		memcpy(&entry_count, file_begin + sizeof(guid_read.data), sizeof(entry_count));
+		entries_begin = file_begin + header_size;
+
+		// Entry offsets, relative to the end of the header, are stored at the very end of the file, they are not necessarily aligned there
+		unsigned long long offsets_size = (static_cast<unsigned long long>(entry_count) + 1) * sizeof(unsigned long long);
+		if (file_size < header_size + offsets_size)
+			throw neural_network_exception((boost::format("File %1% is truncated: %2% bytes while %3% entry offsets require %4% bytes") % file_path.string() % file_size % (entry_count + 1) % (header_size + offsets_size)).str());
+		entry_offsets.resize(entry_count + 1);
+		memcpy(&entry_offsets[0], file_begin + static_cast<size_t>(file_size - offsets_size), static_cast<size_t>(offsets_size));
+
+		if (header_size + entry_offsets[entry_count] + offsets_size > file_size)
+			throw neural_network_exception((boost::format("File %1% is truncated: %2% bytes while %3% entries require %4% bytes") % file_path.string() % file_size % entry_count % (header_size + entry_offsets[entry_count] + offsets_size)).str());
+	}
+
+	bool varying_data_mapped_reader::raw_read(
+		unsigned int entry_id,
+		std::vector<unsigned char>& all_elems)
+	{
+		const unsigned char * data;
+		size_t data_length;
+		if (!raw_read(entry_id, data, data_length))
+			return false;
+
+		all_elems.assign(data, data + data_length);
+
+		return true;
+	}
+
+	bool varying_data_mapped_reader::raw_read(
+		unsigned int entry_id,
+		const unsigned char *& data,
+		size_t& data_length)
+	{
+		if (entry_id >= entry_count)
+			return false;
+
+		data = entries_begin + static_cast<size_t>(entry_offsets[entry_id]);
+		data_length = static_cast<size_t>(entry_offsets[entry_id + 1] - entry_offsets[entry_id]);
+
+		return true;
+	}
+
+	int varying_data_mapped_reader::get_entry_count() const
+	{
+		return static_cast<int>(entry_count);
+	}
+
+	raw_data_writer::ptr varying_data_mapped_reader::get_writer(std::shared_ptr<std::ostream> out) const
+	{
+		return raw_data_writer::ptr(new varying_data_stream_writer(out));
+	}
+}
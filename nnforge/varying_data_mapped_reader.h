@@ -0,0 +1,69 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "raw_data_reader.h"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <vector>
+#include <memory>
+
+namespace nnforge
+{
+	// Reads the same format as varying_data_stream_reader does, but through a read-only memory mapping of the file.
+	// Entries are served straight from the mapping without locking, so the reader may be used from multiple threads concurrently
+	class varying_data_mapped_reader : public raw_data_reader
+	{
+	public:
+		typedef std::shared_ptr<varying_data_mapped_reader> ptr;
+
+		// Set random_access when entries are going to be read in shuffled order, OS read-ahead is disabled then
+		varying_data_mapped_reader(
+			const boost::filesystem::path& file_path,
+			bool random_access = false);
+
+		virtual ~varying_data_mapped_reader() = default;
+
+		// The method returns false in case the entry cannot be read
+		virtual bool raw_read(
+			unsigned int entry_id,
+			std::vector<unsigned char>& all_elems);
+
+		// The method returns false in case the entry cannot be read
+		virtual bool raw_read(
+			unsigned int entry_id,
+			const unsigned char *& data,
+			size_t& data_length);
+
+		virtual int get_entry_count() const;
+
+		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
+
+	protected:
+		boost::interprocess::file_mapping mapping;
+		boost::interprocess::mapped_region region;
+		const unsigned char * entries_begin;
+		std::vector<unsigned long long> entry_offsets;
+		unsigned int entry_count;
+
+	private:
+		varying_data_mapped_reader(const varying_data_mapped_reader&) = delete;
+		varying_data_mapped_reader& operator =(const varying_data_mapped_reader&) = delete;
+	};
+}